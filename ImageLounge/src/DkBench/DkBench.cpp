@@ -0,0 +1,578 @@
+/*******************************************************************************************************
+ DkBench.cpp
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkBench.h"
+#include "DkBasicLoader.h"
+#include "DkImageContainer.h"
+#include "DkImageLoader.h"
+#include "DkImageStorage.h"
+#include "DkManipulators.h"
+#include "DkManipulatorsIpl.h"
+#include "DkMetaData.h"
+#include "DkMetaDataIndex.h"
+#include "DkSettings.h"
+#include "DkThumbs.h"
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <QThread>
+
+#include <algorithm>
+#include <numeric>
+#pragma warning(pop) // no warnings from includes - end
+
+namespace nmc
+{
+
+/**
+ * Exposes the scaling of DkImageStorage (it is protected since the viewport only
+ * triggers it asynchronously).
+ **/
+class DkBenchImageStorage : public DkImageStorage
+{
+public:
+    DkBenchImageStorage(const QImage &img)
+        : DkImageStorage(img)
+    {
+    }
+
+    QImage compute(const QSize &size)
+    {
+        return computeIntern(mImg, size);
+    }
+};
+
+// DkBench --------------------------------------------------------------------
+DkBench::DkBench(const QString &fixtureDir)
+    : mFixtureDir(fixtureDir)
+{
+}
+
+void DkBench::setRuns(int runs)
+{
+    mRuns = qMax(runs, 1);
+}
+
+/**
+ * Quick runs use smaller images and skip the largest directories.
+ **/
+void DkBench::setQuick(bool quick)
+{
+    mQuick = quick;
+}
+
+/**
+ * Only benchmarks whose name matches the filter are run.
+ * @param filter a regular expression (e.g. "^load/" or "resize|storage").
+ **/
+void DkBench::setFilter(const QString &filter)
+{
+    mFilter = QRegularExpression(filter);
+}
+
+/**
+ * The tag is written to the results (e.g. the commit hash).
+ **/
+void DkBench::setTag(const QString &tag)
+{
+    mTag = tag;
+}
+
+/**
+ * Creates a reproducible test image.
+ * It has smooth gradients, hard edges and noise - so that codecs and
+ * kernels do not hit trivial fast paths.
+ * @param size the image size.
+ * @param seed the seed of the noise.
+ * @return QImage an RGB32 image.
+ **/
+QImage DkBench::syntheticImage(const QSize &size, quint32 seed)
+{
+    QImage img(size, QImage::Format_RGB32);
+
+    if (img.isNull())
+        return img;
+
+    quint32 state = seed ? seed : 1;
+    int w = img.width();
+    int h = img.height();
+
+    for (int y = 0; y < h; y++) {
+        QRgb *ptr = reinterpret_cast<QRgb *>(img.scanLine(y));
+
+        for (int x = 0; x < w; x++) {
+            // xorshift32
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            int noise = (int)(state % 17) - 8;
+            bool tile = ((x / 64) + (y / 64)) % 2 == 0;
+
+            int r = x * 255 / w + noise;
+            int g = y * 255 / h + noise;
+            int b = (tile ? 200 : 40) + noise;
+
+            ptr[x] = qRgb(qBound(0, r, 255), qBound(0, g, 255), qBound(0, b, 255));
+        }
+    }
+
+    return img;
+}
+
+/**
+ * Runs all selected benchmarks.
+ * @return bool false if the benchmark data could not be created.
+ **/
+bool DkBench::run()
+{
+    if (!mTmpDir.isValid()) {
+        qWarning() << "[DkBench] could not create a temporary directory";
+        return false;
+    }
+
+    mImg = syntheticImage(mQuick ? QSize(1920, 1080) : QSize(6000, 4000));
+    mSmallImg = syntheticImage(QSize(1920, 1080), 7);
+
+    // write the synthetic image in all formats we can write
+    QList<QByteArray> formats = QImageWriter::supportedImageFormats();
+    for (const QByteArray &fmt : QList<QByteArray>() << "jpg" << "png" << "tif" << "bmp" << "webp") {
+        if (!formats.contains(fmt))
+            continue;
+
+        QString fp = mTmpDir.filePath("bench." + QString::fromLatin1(fmt));
+
+        if (mImg.save(fp, fmt.constData(), fmt == "jpg" ? 90 : -1))
+            mFiles << fp;
+        else
+            qWarning() << "[DkBench] could not write" << fp;
+    }
+
+    qInfo() << "[DkBench] running with" << mRuns << "runs on" << QThread::idealThreadCount() << "threads";
+
+    benchLoaders();
+    benchThumbnails();
+    benchResize();
+    benchManipulators();
+    benchImageStorage();
+    benchMetaData();
+    benchDirectories();
+
+    return true;
+}
+
+QJsonObject DkBench::results() const
+{
+    QJsonObject r;
+    r["tag"] = mTag;
+    r["version"] = QCoreApplication::applicationVersion();
+    r["qt"] = QString(qVersion());
+    r["os"] = QSysInfo::prettyProductName();
+    r["cpu"] = QSysInfo::currentCpuArchitecture();
+    r["threads"] = QThread::idealThreadCount();
+    r["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    r["quick"] = mQuick;
+    r["results"] = mResults;
+
+    return r;
+}
+
+bool DkBench::save(const QString &filePath) const
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[DkBench] could not open" << filePath;
+        return false;
+    }
+
+    QByteArray json = QJsonDocument(results()).toJson();
+
+    // a truncated file would be parsed as a broken baseline
+    if (file.write(json) != json.size() || !file.flush()) {
+        qWarning() << "[DkBench] could not write" << filePath << "-" << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Times a benchmark.
+ * The function is run once before timing - so that lazy initializations are not measured.
+ * @param name the benchmark name (it is matched against the filter).
+ * @param fn the function that is timed.
+ * @param params additional parameters that are written to the results.
+ * @param runs the number of timed runs (-1 uses the default).
+ **/
+void DkBench::measure(const QString &name, const std::function<void()> &fn, const QVariantMap &params, int runs)
+{
+    if (!isSelected(name))
+        return;
+
+    if (runs < 0)
+        runs = mRuns;
+
+    // warm up
+    fn();
+
+    QVector<double> times;
+    QElapsedTimer t;
+
+    for (int idx = 0; idx < runs; idx++) {
+        t.start();
+        fn();
+        times << t.nsecsElapsed() / 1e6;
+    }
+
+    std::sort(times.begin(), times.end());
+    double mean = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+
+    QJsonObject r;
+    r["name"] = name;
+    r["params"] = QJsonObject::fromVariantMap(params);
+    r["runs"] = runs;
+    r["min_ms"] = times.first();
+    r["median_ms"] = times[times.size() / 2];
+    r["mean_ms"] = mean;
+    r["max_ms"] = times.last();
+    mResults.append(r);
+
+    qInfo().noquote() << QString("%1 %2 ms").arg(name, -48).arg(times[times.size() / 2], 10, 'f', 2);
+}
+
+bool DkBench::isSelected(const QString &name) const
+{
+    return mFilter.pattern().isEmpty() || mFilter.match(name).hasMatch();
+}
+
+/**
+ * Returns the synthetic files and all fixtures.
+ **/
+QStringList DkBench::imageFiles() const
+{
+    QStringList files = mFiles;
+
+    if (!mFixtureDir.isEmpty()) {
+        QFileInfoList fixtures = QDir(mFixtureDir).entryInfoList(QDir::Files, QDir::Name);
+
+        for (const QFileInfo &fi : fixtures)
+            files << fi.absoluteFilePath();
+    }
+
+    return files;
+}
+
+QString DkBench::sizeString(const QSize &size) const
+{
+    return QString::number(size.width()) + "x" + QString::number(size.height());
+}
+
+void DkBench::benchLoaders()
+{
+    for (const QString &fp : imageFiles()) {
+        QFileInfo fi(fp);
+
+        DkBasicLoader probe;
+        if (!probe.loadGeneral(fp, QSharedPointer<QByteArray>(), true, false)) {
+            qWarning() << "[DkBench] skipping" << fi.fileName() << "- it cannot be loaded";
+            continue;
+        }
+
+        QVariantMap params;
+        params["file"] = fi.fileName();
+        params["bytes"] = fi.size();
+        params["size"] = sizeString(probe.image().size());
+
+        measure("load/" + fi.fileName(),
+                [&]() {
+                    DkBasicLoader loader;
+                    loader.loadGeneral(fp, QSharedPointer<QByteArray>(), true, false);
+                },
+                params);
+    }
+}
+
+void DkBench::benchThumbnails()
+{
+    for (const QString &fp : imageFiles()) {
+        QFileInfo fi(fp);
+        QVariantMap params;
+        params["file"] = fi.fileName();
+        params["max_size"] = max_thumb_size;
+
+        measure("thumb/" + fi.fileName(),
+                [&]() {
+                    DkThumbNail::computeIntern(fp, QSharedPointer<QByteArray>(), DkThumbNail::do_not_force, max_thumb_size);
+                },
+                params);
+    }
+}
+
+void DkBench::benchResize()
+{
+    QStringList names;
+    names << "nearest"
+          << "area"
+          << "linear"
+          << "cubic"
+          << "lanczos";
+
+    QSize dstSize = mImg.size() / 4;
+
+    for (int ipl = DkImage::ipl_nearest; ipl < DkImage::ipl_end; ipl++) {
+        for (bool gamma : {false, true}) {
+            QVariantMap params;
+            params["src"] = sizeString(mImg.size());
+            params["dst"] = sizeString(dstSize);
+            params["gamma"] = gamma;
+
+            measure("resize/" + names[ipl] + (gamma ? "-gamma" : ""),
+                    [&]() {
+                        DkImage::resizeImage(mImg, dstSize, 1.0, ipl, gamma);
+                    },
+                    params);
+        }
+    }
+}
+
+void DkBench::benchManipulators()
+{
+    DkManipulatorManager mm;
+    mm.createManipulators(0);
+
+    // defaults of some manipulators do nothing
+    auto rotate = qSharedPointerDynamicCast<DkRotateManipulator>(mm.manipulatorExt(DkManipulatorManager::m_rotate));
+    if (rotate)
+        rotate->setAngle(15);
+
+    auto resize = qSharedPointerDynamicCast<DkResizeManipulator>(mm.manipulatorExt(DkManipulatorManager::m_resize));
+    if (resize)
+        resize->setScaleFactor(0.5);
+
+    auto hue = qSharedPointerDynamicCast<DkHueManipulator>(mm.manipulatorExt(DkManipulatorManager::m_hue));
+    if (hue) {
+        hue->setHue(20);
+        hue->setSaturation(20);
+        hue->setValue(10);
+    }
+
+    auto exposure = qSharedPointerDynamicCast<DkExposureManipulator>(mm.manipulatorExt(DkManipulatorManager::m_exposure));
+    if (exposure)
+        exposure->setExposure(0.5);
+
+    for (const QSharedPointer<DkBaseManipulator> &m : mm.manipulators()) {
+        QVariantMap params;
+        params["size"] = sizeString(mImg.size());
+
+        QString name = m->name().toLower().replace(" ", "-");
+
+        measure("manipulator/" + name,
+                [&]() {
+                    m->apply(mImg);
+                },
+                params);
+    }
+}
+
+void DkBench::benchImageStorage()
+{
+    DkBenchImageStorage storage(mImg);
+
+    // typical zoom levels of a large image on a screen
+    for (double f : {0.5, 0.25, 0.1}) {
+        QSize size = mImg.size() * f;
+
+        QVariantMap params;
+        params["src"] = sizeString(mImg.size());
+        params["dst"] = sizeString(size);
+
+        measure("storage/" + QString::number(f),
+                [&]() {
+                    storage.compute(size);
+                },
+                params);
+    }
+}
+
+void DkBench::benchMetaData()
+{
+    QString src = mTmpDir.filePath("bench.jpg");
+    if (!QFileInfo(src).exists())
+        return;
+
+    QString dst = mTmpDir.filePath("bench-metadata.jpg");
+    QFile::copy(src, dst);
+
+    measure("metadata/read", [&]() {
+        DkMetaDataT md;
+        md.readMetaData(dst);
+    });
+
+    int idx = 0;
+    measure("metadata/write", [&]() {
+        DkMetaDataT md;
+        md.readMetaData(dst);
+        md.setDescription("nomacs bench " + QString::number(idx++));
+        md.saveMetaData(dst, true);
+    });
+}
+
+/**
+ * Creates a folder with empty image files and distinct modification dates.
+ * @param numFiles the number of files.
+ * @return QString the folder path.
+ **/
+QString DkBench::createDirectory(int numFiles) const
+{
+    QString dirPath = mTmpDir.filePath("dir-" + QString::number(numFiles));
+    QDir().mkpath(dirPath);
+
+    QDateTime start(QDate(2020, 1, 1), QTime(0, 0), Qt::UTC);
+    quint32 state = 42;
+
+    for (int idx = 0; idx < numFiles; idx++) {
+        QFile file(dirPath + "/img_" + QString("%1").arg(idx, 6, 10, QChar('0')) + ".jpg");
+
+        if (!file.open(QIODevice::WriteOnly))
+            return QString();
+
+        // lcg - the modification order differs from the filename order
+        state = state * 1664525u + 1013904223u;
+        file.setFileTime(start.addSecs(state % (365 * 24 * 3600)), QFileDevice::FileModificationTime);
+    }
+
+    return dirPath;
+}
+
+void DkBench::benchDirectories()
+{
+    QVector<int> counts;
+    counts << 1000 << 10000;
+
+    if (!mQuick)
+        counts << 100000;
+
+    int sortMode = DkSettingsManager::param().global().sortMode;
+
+    for (int n : counts) {
+        QString ns = QString::number(n);
+
+        if (!isSelected("dir/index/" + ns) && !isSelected("dir/containers/" + ns) && !isSelected("dir/sort/filename/" + ns)
+            && !isSelected("dir/sort/modified/" + ns) && !isSelected("dir/sort/taken/" + ns))
+            continue;
+
+        QString dirPath = createDirectory(n);
+        if (dirPath.isEmpty()) {
+            qWarning() << "[DkBench] could not create" << n << "files";
+            continue;
+        }
+
+        // large folders are slow - a few runs are enough
+        int runs = n >= 100000 ? qMin(mRuns, 3) : -1;
+
+        DkImageLoader loader;
+        QFileInfoList files;
+
+        measure(
+            "dir/index/" + ns,
+            [&]() {
+                files = loader.getFilteredFileInfoList(dirPath);
+            },
+            QVariantMap(),
+            runs);
+
+        if (files.empty())
+            files = loader.getFilteredFileInfoList(dirPath);
+
+        QVector<QSharedPointer<DkImageContainerT>> images;
+
+        measure(
+            "dir/containers/" + ns,
+            [&]() {
+                images.clear();
+                for (const QFileInfo &f : files)
+                    images << QSharedPointer<DkImageContainerT>(new DkImageContainerT(f.absoluteFilePath()));
+            },
+            QVariantMap(),
+            runs);
+
+        if (images.empty()) {
+            for (const QFileInfo &f : files)
+                images << QSharedPointer<DkImageContainerT>(new DkImageContainerT(f.absoluteFilePath()));
+        }
+
+        DkSettingsManager::param().global().sortMode = DkSettings::sort_filename;
+        measure(
+            "dir/sort/filename/" + ns,
+            [&]() {
+                QVector<QSharedPointer<DkImageContainerT>> sorted = images;
+                sortImageContainers(sorted);
+            },
+            QVariantMap(),
+            runs);
+
+        DkSettingsManager::param().global().sortMode = DkSettings::sort_date_modified;
+        measure(
+            "dir/sort/modified/" + ns,
+            [&]() {
+                QVector<QSharedPointer<DkImageContainerT>> sorted = images;
+                sortImageContainers(sorted);
+            },
+            QVariantMap(),
+            runs);
+
+        // sorting by metadata must only query the index
+        if (isSelected("dir/sort/taken/" + ns)) {
+            for (const QFileInfo &f : files)
+                DkMetaDataIndex::instance().insert(DkMetaDataIndex::key(f), DkMetaDataEntry::read(f));
+        }
+
+        DkSettingsManager::param().global().sortMode = DkSettings::sort_date_taken;
+        measure(
+            "dir/sort/taken/" + ns,
+            [&]() {
+                QVector<QSharedPointer<DkImageContainerT>> sorted = images;
+                sortImageContainers(sorted);
+            },
+            QVariantMap(),
+            runs);
+    }
+
+    DkSettingsManager::param().global().sortMode = sortMode;
+}
+
+}
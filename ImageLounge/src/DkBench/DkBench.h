@@ -0,0 +1,97 @@
+/*******************************************************************************************************
+ DkBench.h
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QVariantMap>
+
+#include <functional>
+#pragma warning(pop) // no warnings from includes - end
+
+namespace nmc
+{
+
+/**
+ * DkBench runs micro-benchmarks of the DkCore image kernels and loaders.
+ * All inputs are either synthetic (seeded - so they are identical on every run)
+ * or taken from a fixture directory. Results are written as JSON so that
+ * runs of different commits can be compared.
+ **/
+class DkBench
+{
+public:
+    DkBench(const QString &fixtureDir = QString());
+
+    void setRuns(int runs);
+    void setQuick(bool quick);
+    void setFilter(const QString &filter);
+    void setTag(const QString &tag);
+
+    bool run();
+    QJsonObject results() const;
+    bool save(const QString &filePath) const;
+
+    static QImage syntheticImage(const QSize &size, quint32 seed = 42);
+
+protected:
+    void measure(const QString &name, const std::function<void()> &fn, const QVariantMap &params = QVariantMap(), int runs = -1);
+    bool isSelected(const QString &name) const;
+
+    void benchLoaders();
+    void benchThumbnails();
+    void benchResize();
+    void benchManipulators();
+    void benchImageStorage();
+    void benchMetaData();
+    void benchDirectories();
+
+    QStringList imageFiles() const;
+    QString createDirectory(int numFiles) const;
+    QString sizeString(const QSize &size) const;
+
+    QString mFixtureDir;
+    QTemporaryDir mTmpDir;
+    QImage mImg;
+    QImage mSmallImg;
+    QStringList mFiles;
+
+    int mRuns = 5;
+    bool mQuick = false;
+    QRegularExpression mFilter;
+    QString mTag;
+
+    QJsonArray mResults;
+};
+
+}
@@ -0,0 +1,101 @@
+/*******************************************************************************************************
+ main.cpp
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkBench.h"
+#include "DkMetaData.h"
+#include "DkSettings.h"
+#include "DkVersion.h"
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+
+#include <iostream>
+#pragma warning(pop) // no warnings from includes - end
+
+// usage: nomacs_bench [--quick] [--runs 5] [--filter "^load/"] [--fixtures dir] [--out results.json]
+int main(int argc, char *argv[])
+{
+    // the manipulators need widgets - but nothing is shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    // keep caches & settings apart from the viewer's
+    QCoreApplication::setOrganizationName("nomacs");
+    QCoreApplication::setApplicationName("nomacs_bench");
+    QCoreApplication::setApplicationVersion(NOMACS_VERSION_STR);
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Micro-benchmarks of the nomacs image kernels and loaders.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption outOpt(QStringList() << "o" << "out", "Write the JSON results to <file> (default: stdout).", "file");
+    QCommandLineOption fixturesOpt(QStringList() << "fixtures", "Additionally benchmark all images in <dir>.", "dir");
+    QCommandLineOption runsOpt(QStringList() << "r" << "runs", "Number of timed runs per benchmark (default: 5).", "runs", "5");
+    QCommandLineOption filterOpt(QStringList() << "f" << "filter", "Only run benchmarks matching <regex>.", "regex");
+    QCommandLineOption tagOpt(QStringList() << "tag", "Tag written to the results (default: the git commit).", "tag", NOMACS_GIT_TAG);
+    QCommandLineOption quickOpt(QStringList() << "quick", "Use small images and skip the largest folders.");
+
+    parser.addOption(outOpt);
+    parser.addOption(fixturesOpt);
+    parser.addOption(runsOpt);
+    parser.addOption(filterOpt);
+    parser.addOption(tagOpt);
+    parser.addOption(quickOpt);
+    parser.process(app);
+
+    // the kernels are chatty
+    QLoggingCategory::setFilterRules("*.debug=false");
+
+    // benchmarks must not depend on the user's settings
+    nmc::DkSettingsManager::param().setToDefaultSettings();
+    nmc::DkSettingsManager::param().initFileFilters();
+    nmc::DkMetaDataHelper::initialize();
+
+    nmc::DkBench bench(parser.value(fixturesOpt));
+    bench.setRuns(parser.value(runsOpt).toInt());
+    bench.setQuick(parser.isSet(quickOpt));
+    bench.setTag(parser.value(tagOpt));
+
+    if (parser.isSet(filterOpt))
+        bench.setFilter(parser.value(filterOpt));
+
+    if (!bench.run())
+        return 1;
+
+    if (parser.isSet(outOpt))
+        return bench.save(parser.value(outOpt)) ? 0 : 1;
+
+    std::cout << QJsonDocument(bench.results()).toJson().constData() << std::flush;
+
+    return std::cout.good() ? 0 : 1;
+}
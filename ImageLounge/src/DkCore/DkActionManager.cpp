@@ -383,6 +383,7 @@ QMenu *DkActionManager::createFileMenu(QWidget *parent /* = 0 */)
     // add sort menu
     mFileMenu->addMenu(sortMenu());
     mFileMenu->addAction(mFileActions[menu_file_recursive]);
+    mFileMenu->addAction(mFileActions[menu_file_follow_new]);
     mFileMenu->addAction(mFileActions[menu_file_goto]);
     mFileMenu->addAction(mFileActions[menu_file_find]);
     mFileMenu->addAction(mFileActions[menu_file_reload]);
@@ -425,6 +426,11 @@ QMenu *DkActionManager::createSortMenu(QWidget *parent)
     mSortMenu->addAction(mSortActions[menu_sort_date_created]);
     mSortMenu->addAction(mSortActions[menu_sort_date_modified]);
     mSortMenu->addAction(mSortActions[menu_sort_random]);
+    mSortMenu->addAction(mSortActions[menu_sort_sharpness]);
+    mSortMenu->addAction(mSortActions[menu_sort_clipping]);
+    mSortMenu->addAction(mSortActions[menu_sort_date_taken]);
+    mSortMenu->addAction(mSortActions[menu_sort_rating]);
+    mSortMenu->addAction(mSortActions[menu_sort_camera]);
     mSortMenu->addSeparator();
     mSortMenu->addAction(mSortActions[menu_sort_ascending]);
     mSortMenu->addAction(mSortActions[menu_sort_descending]);
@@ -946,42 +952,40 @@ void DkActionManager::init()
 void DkActionManager::createIcons()
 {
     mFileIcons.resize(icon_file_end);
-    mFileIcons[icon_file_dir] = DkImage::loadIcon(":/nomacs/img/dir.svg");
-    mFileIcons[icon_file_open] = DkImage::loadIcon(":/nomacs/img/open.svg");
-    mFileIcons[icon_file_save] = DkImage::loadIcon(":/nomacs/img/save.svg");
-    mFileIcons[icon_file_print] = DkImage::loadIcon(":/nomacs/img/print.svg");
+    mFileIcons[icon_file_dir] = DkImage::loadIconDeferred(":/nomacs/img/dir.svg");
+    mFileIcons[icon_file_open] = DkImage::loadIconDeferred(":/nomacs/img/open.svg");
+    mFileIcons[icon_file_save] = DkImage::loadIconDeferred(":/nomacs/img/save.svg");
+    mFileIcons[icon_file_print] = DkImage::loadIconDeferred(":/nomacs/img/print.svg");
     mFileIcons[icon_file_open_large] = QIcon(":/nomacs/img/open.svg");
     mFileIcons[icon_file_dir_large] = QIcon(":/nomacs/img/dir.svg");
-    mFileIcons[icon_file_prev] = DkImage::loadIcon(":/nomacs/img/previous.svg");
-    mFileIcons[icon_file_next] = DkImage::loadIcon(":/nomacs/img/next.svg");
-    mFileIcons[icon_file_filter] = DkImage::loadIcon();
-    mFileIcons[icon_file_filter].addPixmap(DkImage::loadIcon(":/nomacs/img/filter.svg"), QIcon::Normal, QIcon::On);
-    mFileIcons[icon_file_filter].addPixmap(DkImage::loadIcon(":/nomacs/img/filter-disabled.svg"), QIcon::Normal, QIcon::Off);
-    mFileIcons[icon_file_find] = DkImage::loadIcon(":/nomacs/img/find.svg");
+    mFileIcons[icon_file_prev] = DkImage::loadIconDeferred(":/nomacs/img/previous.svg");
+    mFileIcons[icon_file_next] = DkImage::loadIconDeferred(":/nomacs/img/next.svg");
+    mFileIcons[icon_file_filter] = DkImage::loadIconDeferred(":/nomacs/img/filter.svg");
+    mFileIcons[icon_file_filter].addFile(":/nomacs/img/filter-disabled.svg", QSize(), QIcon::Normal, QIcon::Off);
+    mFileIcons[icon_file_find] = DkImage::loadIconDeferred(":/nomacs/img/find.svg");
 
     mEditIcons.resize(icon_edit_end);
-    mEditIcons[icon_edit_image] = DkImage::loadIcon(":/nomacs/img/sliders.svg");
-    mEditIcons[icon_edit_rotate_cw] = DkImage::loadIcon(":/nomacs/img/rotate-cw.svg");
-    mEditIcons[icon_edit_rotate_ccw] = DkImage::loadIcon(":/nomacs/img/rotate-cc.svg");
-    mEditIcons[icon_edit_crop] = DkImage::loadIcon(":/nomacs/img/crop.svg");
-    mEditIcons[icon_edit_resize] = DkImage::loadIcon(":/nomacs/img/resize.svg");
-    mEditIcons[icon_edit_copy] = DkImage::loadIcon(":/nomacs/img/copy.svg");
-    mEditIcons[icon_edit_paste] = DkImage::loadIcon(":/nomacs/img/paste.svg");
-    mEditIcons[icon_edit_delete] = DkImage::loadIcon(":/nomacs/img/trash.svg");
+    mEditIcons[icon_edit_image] = DkImage::loadIconDeferred(":/nomacs/img/sliders.svg");
+    mEditIcons[icon_edit_rotate_cw] = DkImage::loadIconDeferred(":/nomacs/img/rotate-cw.svg");
+    mEditIcons[icon_edit_rotate_ccw] = DkImage::loadIconDeferred(":/nomacs/img/rotate-cc.svg");
+    mEditIcons[icon_edit_crop] = DkImage::loadIconDeferred(":/nomacs/img/crop.svg");
+    mEditIcons[icon_edit_resize] = DkImage::loadIconDeferred(":/nomacs/img/resize.svg");
+    mEditIcons[icon_edit_copy] = DkImage::loadIconDeferred(":/nomacs/img/copy.svg");
+    mEditIcons[icon_edit_paste] = DkImage::loadIconDeferred(":/nomacs/img/paste.svg");
+    mEditIcons[icon_edit_delete] = DkImage::loadIconDeferred(":/nomacs/img/trash.svg");
 
     mViewIcons.resize(icon_view_end);
-    mViewIcons[icon_view_fullscreen] = DkImage::loadIcon(":/nomacs/img/fullscreen.svg");
-    mViewIcons[icon_view_reset] = DkImage::loadIcon(":/nomacs/img/zoom-reset.svg");
-    mViewIcons[icon_view_100] = DkImage::loadIcon(":/nomacs/img/zoom-100.svg");
-    mViewIcons[icon_view_gps] = DkImage::loadIcon(":/nomacs/img/location.svg");
-    mViewIcons[icon_view_zoom_in] = DkImage::loadIcon(":/nomacs/img/zoom-in.svg");
-    mViewIcons[icon_view_zoom_out] = DkImage::loadIcon(":/nomacs/img/zoom-out.svg");
+    mViewIcons[icon_view_fullscreen] = DkImage::loadIconDeferred(":/nomacs/img/fullscreen.svg");
+    mViewIcons[icon_view_reset] = DkImage::loadIconDeferred(":/nomacs/img/zoom-reset.svg");
+    mViewIcons[icon_view_100] = DkImage::loadIconDeferred(":/nomacs/img/zoom-100.svg");
+    mViewIcons[icon_view_gps] = DkImage::loadIconDeferred(":/nomacs/img/location.svg");
+    mViewIcons[icon_view_zoom_in] = DkImage::loadIconDeferred(":/nomacs/img/zoom-in.svg");
+    mViewIcons[icon_view_zoom_out] = DkImage::loadIconDeferred(":/nomacs/img/zoom-out.svg");
 
-    mViewIcons[icon_view_movie_play] = DkImage::loadIcon(":/nomacs/img/play.svg");
-    mViewIcons[icon_view_movie_play].addPixmap(DkImage::loadIcon(":/nomacs/img/play.svg"), QIcon::Normal, QIcon::On);
-    mViewIcons[icon_view_movie_play].addPixmap(DkImage::loadIcon(":/nomacs/img/pause.svg"), QIcon::Normal, QIcon::Off);
-    mViewIcons[icon_view_movie_prev] = DkImage::loadIcon(":/nomacs/img/previous.svg");
-    mViewIcons[icon_view_movie_next] = DkImage::loadIcon(":/nomacs/img/next.svg");
+    mViewIcons[icon_view_movie_play] = DkImage::loadIconDeferred(":/nomacs/img/play.svg");
+    mViewIcons[icon_view_movie_play].addFile(":/nomacs/img/pause.svg", QSize(), QIcon::Normal, QIcon::Off);
+    mViewIcons[icon_view_movie_prev] = DkImage::loadIconDeferred(":/nomacs/img/previous.svg");
+    mViewIcons[icon_view_movie_next] = DkImage::loadIconDeferred(":/nomacs/img/next.svg");
 }
 
 void DkActionManager::createActions(QWidget *parent)
@@ -1079,6 +1083,11 @@ void DkActionManager::createActions(QWidget *parent)
     mFileActions[menu_file_recursive]->setCheckable(true);
     mFileActions[menu_file_recursive]->setChecked(DkSettingsManager::param().global().scanSubFolders);
 
+    mFileActions[menu_file_follow_new] = new QAction(QObject::tr("&Follow New Files"), parent);
+    mFileActions[menu_file_follow_new]->setStatusTip(QObject::tr("Display images as soon as they are added to the current folder"));
+    mFileActions[menu_file_follow_new]->setCheckable(true);
+    mFileActions[menu_file_follow_new]->setChecked(DkSettingsManager::param().global().followNewFiles);
+
     mFileActions[menu_file_exit] = new QAction(QObject::tr("&Exit"), parent);
     mFileActions[menu_file_exit]->setStatusTip(QObject::tr("Exit"));
 
@@ -1109,6 +1118,36 @@ void DkActionManager::createActions(QWidget *parent)
     mSortActions[menu_sort_random]->setCheckable(true);
     mSortActions[menu_sort_random]->setChecked(DkSettingsManager::param().global().sortMode == DkSettings::sort_random);
 
+    mSortActions[menu_sort_sharpness] = new QAction(QObject::tr("by &Sharpness"), parent);
+    mSortActions[menu_sort_sharpness]->setObjectName("menu_sort_sharpness");
+    mSortActions[menu_sort_sharpness]->setStatusTip(QObject::tr("Sort by Sharpness - images are scored in the background"));
+    mSortActions[menu_sort_sharpness]->setCheckable(true);
+    mSortActions[menu_sort_sharpness]->setChecked(DkSettingsManager::param().global().sortMode == DkSettings::sort_sharpness);
+
+    mSortActions[menu_sort_clipping] = new QAction(QObject::tr("by &Clipping"), parent);
+    mSortActions[menu_sort_clipping]->setObjectName("menu_sort_clipping");
+    mSortActions[menu_sort_clipping]->setStatusTip(QObject::tr("Sort by Clipped Shadows and Highlights - images are scored in the background"));
+    mSortActions[menu_sort_clipping]->setCheckable(true);
+    mSortActions[menu_sort_clipping]->setChecked(DkSettingsManager::param().global().sortMode == DkSettings::sort_clipping);
+
+    mSortActions[menu_sort_date_taken] = new QAction(QObject::tr("by Date &Taken"), parent);
+    mSortActions[menu_sort_date_taken]->setObjectName("menu_sort_date_taken");
+    mSortActions[menu_sort_date_taken]->setStatusTip(QObject::tr("Sort by Date Taken - metadata is indexed in the background"));
+    mSortActions[menu_sort_date_taken]->setCheckable(true);
+    mSortActions[menu_sort_date_taken]->setChecked(DkSettingsManager::param().global().sortMode == DkSettings::sort_date_taken);
+
+    mSortActions[menu_sort_rating] = new QAction(QObject::tr("by &Rating"), parent);
+    mSortActions[menu_sort_rating]->setObjectName("menu_sort_rating");
+    mSortActions[menu_sort_rating]->setStatusTip(QObject::tr("Sort by Rating - metadata is indexed in the background"));
+    mSortActions[menu_sort_rating]->setCheckable(true);
+    mSortActions[menu_sort_rating]->setChecked(DkSettingsManager::param().global().sortMode == DkSettings::sort_rating);
+
+    mSortActions[menu_sort_camera] = new QAction(QObject::tr("by Ca&mera"), parent);
+    mSortActions[menu_sort_camera]->setObjectName("menu_sort_camera");
+    mSortActions[menu_sort_camera]->setStatusTip(QObject::tr("Sort by Camera Model - metadata is indexed in the background"));
+    mSortActions[menu_sort_camera]->setCheckable(true);
+    mSortActions[menu_sort_camera]->setChecked(DkSettingsManager::param().global().sortMode == DkSettings::sort_camera);
+
     mSortActions[menu_sort_ascending] = new QAction(QObject::tr("&Ascending"), parent);
     mSortActions[menu_sort_ascending]->setObjectName("menu_sort_ascending");
     mSortActions[menu_sort_ascending]->setStatusTip(QObject::tr("Sort in Ascending Order"));
@@ -1507,40 +1546,59 @@ void DkActionManager::createActions(QWidget *parent)
     mPreviewActions[preview_select_all]->setShortcut(QKeySequence::SelectAll);
     mPreviewActions[preview_select_all]->setCheckable(true);
 
-    mPreviewActions[preview_zoom_in] = new QAction(DkImage::loadIcon(":/nomacs/img/zoom-in.svg"), QObject::tr("Zoom &In"), parent);
+    mPreviewActions[preview_zoom_in] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/zoom-in.svg"), QObject::tr("Zoom &In"), parent);
     mPreviewActions[preview_zoom_in]->setShortcut(QKeySequence::ZoomIn);
 
-    mPreviewActions[preview_zoom_out] = new QAction(DkImage::loadIcon(":/nomacs/img/zoom-out.svg"), QObject::tr("Zoom &Out"), parent);
+    mPreviewActions[preview_zoom_out] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/zoom-out.svg"), QObject::tr("Zoom &Out"), parent);
     mPreviewActions[preview_zoom_out]->setShortcut(QKeySequence::ZoomOut);
 
-    mPreviewActions[preview_display_squares] = new QAction(DkImage::loadIcon(":/nomacs/img/rects.svg"), QObject::tr("Display &Squares"), parent);
+    mPreviewActions[preview_display_squares] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/rects.svg"), QObject::tr("Display &Squares"), parent);
     mPreviewActions[preview_display_squares]->setCheckable(true);
     mPreviewActions[preview_display_squares]->setChecked(DkSettingsManager::param().display().displaySquaredThumbs);
 
-    mPreviewActions[preview_show_labels] = new QAction(DkImage::loadIcon(":/nomacs/img/show-filename.svg"), QObject::tr("Show &Filename"), parent);
+    mPreviewActions[preview_show_labels] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/show-filename.svg"), QObject::tr("Show &Filename"), parent);
     mPreviewActions[preview_show_labels]->setCheckable(true);
     mPreviewActions[preview_show_labels]->setChecked(DkSettingsManager::param().display().showThumbLabel);
 
+    mPreviewActions[preview_show_scores] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/star-off.svg"), QObject::tr("Show Sc&ores"), parent);
+    mPreviewActions[preview_show_scores]->setStatusTip(QObject::tr("Show sharpness and clipping of the images"));
+    mPreviewActions[preview_show_scores]->setCheckable(true);
+    mPreviewActions[preview_show_scores]->setChecked(DkSettingsManager::param().display().showThumbScores);
+
+    mPreviewActions[preview_group_similar] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/thumbs-move.svg"), QObject::tr("&Group Similar"), parent);
+    mPreviewActions[preview_group_similar]->setStatusTip(QObject::tr("Show similar images next to each other"));
+    mPreviewActions[preview_group_similar]->setCheckable(true);
+    mPreviewActions[preview_group_similar]->setChecked(DkSettingsManager::param().display().groupSimilarThumbs);
+
+    mPreviewActions[preview_collapse_bursts] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/bars.svg"), QObject::tr("&Collapse Bursts"), parent);
+    mPreviewActions[preview_collapse_bursts]->setStatusTip(QObject::tr("Show only the first image of consecutive similar images"));
+    mPreviewActions[preview_collapse_bursts]->setCheckable(true);
+    mPreviewActions[preview_collapse_bursts]->setChecked(DkSettingsManager::param().display().collapseBursts);
+
+    mPreviewActions[preview_next_distinct] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/next.svg"), QObject::tr("&Next Non-Duplicate"), parent);
+    mPreviewActions[preview_next_distinct]->setStatusTip(QObject::tr("Select the next image that is not similar to the selected one"));
+    mPreviewActions[preview_next_distinct]->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_Right));
+
     mPreviewActions[preview_filter] = new QAction(QObject::tr("&Filter"), parent);
     mPreviewActions[preview_filter]->setShortcut(QKeySequence::Find);
 
-    mPreviewActions[preview_delete] = new QAction(DkImage::loadIcon(":/nomacs/img/trash.svg"), QObject::tr("&Delete"), parent);
+    mPreviewActions[preview_delete] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/trash.svg"), QObject::tr("&Delete"), parent);
     mPreviewActions[preview_delete]->setShortcut(QKeySequence::Delete);
 
-    mPreviewActions[preview_copy] = new QAction(DkImage::loadIcon(":/nomacs/img/copy.svg"), QObject::tr("&Copy"), parent);
+    mPreviewActions[preview_copy] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/copy.svg"), QObject::tr("&Copy"), parent);
     mPreviewActions[preview_copy]->setShortcut(QKeySequence::Copy);
 
-    mPreviewActions[preview_paste] = new QAction(DkImage::loadIcon(":/nomacs/img/paste.svg"), QObject::tr("&Paste"), parent);
+    mPreviewActions[preview_paste] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/paste.svg"), QObject::tr("&Paste"), parent);
     mPreviewActions[preview_paste]->setShortcut(QKeySequence::Paste);
 
-    mPreviewActions[preview_rename] = new QAction(DkImage::loadIcon(":/nomacs/img/rename.svg"), QObject::tr("&Rename"), parent);
+    mPreviewActions[preview_rename] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/rename.svg"), QObject::tr("&Rename"), parent);
     mPreviewActions[preview_rename]->setShortcut(QKeySequence(Qt::Key_F2));
 
-    mPreviewActions[preview_batch] = new QAction(DkImage::loadIcon(":/nomacs/img/batch-processing.svg"), QObject::tr("&Batch Process"), parent);
+    mPreviewActions[preview_batch] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/batch-processing.svg"), QObject::tr("&Batch Process"), parent);
     mPreviewActions[preview_batch]->setToolTip(QObject::tr("Adds selected files to batch processing."));
     mPreviewActions[preview_batch]->setShortcut(QKeySequence(Qt::Key_B));
 
-    mPreviewActions[preview_print] = new QAction(DkImage::loadIcon(":/nomacs/img/print.svg"), QObject::tr("&Batch Print"), parent);
+    mPreviewActions[preview_print] = new QAction(DkImage::loadIconDeferred(":/nomacs/img/print.svg"), QObject::tr("&Batch Print"), parent);
     mPreviewActions[preview_print]->setToolTip(QObject::tr("Prints selected files."));
     mPreviewActions[preview_print]->setShortcut(QKeySequence::Print);
 
@@ -129,6 +129,7 @@ public:
         menu_file_goto,
         menu_file_find,
         menu_file_recursive,
+        menu_file_follow_new,
         menu_file_show_recent,
         menu_file_print,
         menu_file_reload,
@@ -147,6 +148,11 @@ public:
         menu_sort_date_created,
         menu_sort_date_modified,
         menu_sort_random,
+        menu_sort_sharpness,
+        menu_sort_clipping,
+        menu_sort_date_taken,
+        menu_sort_rating,
+        menu_sort_camera,
         menu_sort_ascending,
         menu_sort_descending,
 
@@ -309,6 +315,10 @@ public:
         preview_zoom_out,
         preview_display_squares,
         preview_show_labels,
+        preview_show_scores,
+        preview_group_similar,
+        preview_collapse_bursts,
+        preview_next_distinct,
         preview_copy,
         preview_paste,
         preview_rename,
@@ -33,11 +33,13 @@
 #include "DkMetaData.h"
 #include "DkSettings.h"
 #include "DkTimer.h"
+#include "DkTrace.h"
 #include "DkUtils.h" // just needed for qInfo() #ifdef
 
 #pragma warning(push, 0)
 #include <QBuffer>
 #include <QDebug>
+#include <QFile>
 #include <QFileInfo>
 #include <QIcon>
 #include <QImage>
@@ -184,6 +186,29 @@ int DkEditImage::size() const
     return qRound(DkImage::getBufferSizeFloat(mImg.size(), mImg.depth()));
 }
 
+// DkSaveOutput --------------------------------------------------------------------
+DkSaveOutput::DkSaveOutput(const QString &filePath, int compression, const QSize &size)
+    : mFilePath(filePath)
+    , mCompression(compression)
+    , mSize(size)
+{
+}
+
+QString DkSaveOutput::filePath() const
+{
+    return mFilePath;
+}
+
+int DkSaveOutput::compression() const
+{
+    return mCompression;
+}
+
+QSize DkSaveOutput::size() const
+{
+    return mSize;
+}
+
 // Basic loader and image edit class --------------------------------------------------------------------
 DkBasicLoader::DkBasicLoader(int mode)
 {
@@ -208,7 +233,8 @@ bool DkBasicLoader::loadGeneral(const QString &filePath, bool loadMetaData, bool
  **/
 bool DkBasicLoader::loadGeneral(const QString &filePath, QSharedPointer<QByteArray> ba, bool loadMetaData, bool fast)
 {
-    DkTimer dt;
+    DkTraceSpan span("decode", "load", true);
+    span.setDetail(filePath);
     bool imgLoaded = false;
 
     mFile = DkUtils::resolveSymLink(filePath);
@@ -266,10 +292,14 @@ bool DkBasicLoader::loadGeneral(const QString &filePath, QSharedPointer<QByteArr
     // default Qt loader
     // here we just try those formats that are officially supported
     if (!imgLoaded && qtFormats.contains(suf.toStdString().c_str()) || suf.isEmpty()) {
+        // decode at a reduced resolution if the caller does not need the full image
+        if (mDecodeSize.isValid())
+            imgLoaded = loadScaledFile(mFile, img, ba);
+
         // if image has Indexed8 + alpha channel -> we crash... sorry for that
-        if (!ba || ba->isEmpty())
+        if (!imgLoaded && (!ba || ba->isEmpty()))
             imgLoaded = img.load(mFile, suf.toStdString().c_str());
-        else
+        else if (!imgLoaded)
             imgLoaded = img.loadFromData(*ba.data(), suf.toStdString().c_str()); // toStdString() in order get 1 byte per char
 
         if (imgLoaded)
@@ -294,8 +324,8 @@ bool DkBasicLoader::loadGeneral(const QString &filePath, QSharedPointer<QByteArr
     // RAW loader
     if (!imgLoaded && !qtFormats.contains(suf.toStdString().c_str())) {
         // TODO: sometimes (e.g. _DSC6289.tif) strange opencv errors are thrown - catch them!
-        // load raw files
-        imgLoaded = loadRawFile(mFile, img, ba, fast);
+        // load raw files (the embedded preview is enough for reduced resolution requests)
+        imgLoaded = loadRawFile(mFile, img, ba, fast || mDecodeSize.isValid());
         if (imgLoaded)
             mLoader = raw_loader;
     }
@@ -376,13 +406,132 @@ bool DkBasicLoader::loadGeneral(const QString &filePath, QSharedPointer<QByteArr
         setEditImage(img, tr("Original Image"));
 
     if (imgLoaded)
-        qInfo() << "[Basic Loader]" << filePath << "loaded in" << dt;
+        qInfo() << "[Basic Loader]" << filePath << "loaded in" << qPrintable(span.elapsed());
     else
         qWarning() << "[Basic Loader] could not load" << filePath;
 
     return imgLoaded;
 }
 
+/**
+ * Takes over an image that was already decoded (e.g. by another tab).
+ * Only the metadata is read from the file, the image is not decoded again.
+ * @param filePath the image file
+ * @param ba the file buffer (can be empty)
+ * @param img the decoded image (with exif orientation applied)
+ * @return bool true if the image was adopted
+ **/
+bool DkBasicLoader::adoptImage(const QString &filePath, const QSharedPointer<QByteArray> ba, const QImage &img)
+{
+    if (img.isNull())
+        return false;
+
+    mFile = DkUtils::resolveSymLink(filePath);
+    release();
+
+    if (mMetaData) {
+        try {
+            mMetaData->readMetaData(filePath, ba);
+            mMetaData->setQtValues(img);
+        } catch (...) {
+        } // ignore if we cannot read the metadata
+    }
+
+    // only single page images are shared
+    mNumPages = 1;
+    mPageIdx = 1;
+    mPageIdxDirty = false;
+
+    setEditImage(img, tr("Original Image"));
+    qInfo() << "[Basic Loader]" << filePath << "adopted from the image cache";
+
+    return true;
+}
+
+/**
+ * Requests images that only need to be at least as large as size.
+ * JPEGs are then decoded with 1/2, 1/4 or 1/8 IDCT scaling and
+ * other formats that support it are decoded at the reduced size.
+ * @param size the size the image is displayed with (invalid -> full resolution)
+ * @param mode Qt::KeepAspectRatio if the image is fit into size,
+ * Qt::KeepAspectRatioByExpanding if it needs to cover size
+ **/
+void DkBasicLoader::setDecodeSize(const QSize &size, Qt::AspectRatioMode mode)
+{
+    mDecodeSize = size;
+    mDecodeSizeMode = mode;
+}
+
+QSize DkBasicLoader::decodeSize() const
+{
+    return mDecodeSize;
+}
+
+/**
+ * Decodes an image with at least the target size if the format's reader supports scaled decoding.
+ * @param filePath the image file
+ * @param img the decoded image
+ * @param ba the file buffer (can be empty)
+ * @return bool false if the image was not decoded (the caller then loads the full image)
+ **/
+bool DkBasicLoader::loadScaledFile(const QString &filePath, QImage &img, QSharedPointer<QByteArray> ba) const
+{
+    QByteArray format = QFileInfo(filePath).suffix().toLower().toLatin1();
+    QBuffer buffer;
+    QImageReader reader;
+
+    if (ba && !ba->isEmpty()) {
+        buffer.setBuffer(ba.data());
+        buffer.open(QIODevice::ReadOnly);
+        reader.setDevice(&buffer);
+        reader.setFormat(format);
+    } else {
+        reader.setFileName(filePath);
+        reader.setFormat(format);
+    }
+
+    if (!reader.supportsOption(QImageIOHandler::ScaledSize))
+        return false;
+
+    QSize fullSize = reader.size();
+    if (!fullSize.isValid())
+        return false;
+
+    QSize minSize = fullSize.scaled(mDecodeSize, mDecodeSizeMode);
+
+    // nothing to gain
+    if (minSize.width() >= fullSize.width() || minSize.height() >= fullSize.height())
+        return false;
+
+    QSize scaledSize = minSize;
+
+    if (reader.format() == "jpeg" || reader.format() == "jpg") {
+        // use the strongest IDCT scaling that still yields the target size (Qt picks it by integer division)
+        scaledSize = QSize();
+        for (int denom = 8; denom > 1; denom /= 2) {
+            QSize s(fullSize.width() / denom, fullSize.height() / denom);
+
+            if (s.width() >= minSize.width() && s.height() >= minSize.height()) {
+                scaledSize = s;
+                break;
+            }
+        }
+
+        if (scaledSize.isEmpty())
+            return false;
+    }
+
+    reader.setScaledSize(scaledSize);
+    img = reader.read();
+
+    if (img.isNull())
+        return false;
+
+    qDebug() << "[Basic Loader] decoded" << fullSize << "at" << img.size();
+
+    return true;
+}
+
 /**
  * Loads special RAW files that are generated by the Hamamatsu camera.
  * @param fileName the filename of the file to be loaded.
@@ -596,156 +745,231 @@ bool DkBasicLoader::loadTIFFile(const QString &filePath, QImage &img, QSharedPoi
 #define DRIF_IMAGE_IMPL
 #include "drif_image.h"
 
-bool isQtFmtCompatible(uint32_t f)
+/**
+ * Returns the format drif frames are converted to.
+ * Formats that Qt supports are kept, all others are converted to RGB888.
+ **/
+static QImage::Format drifImageFormat(uint32_t f)
 {
     switch (f) {
-    case DRIF_FMT_RGB888:
     case DRIF_FMT_RGBA8888:
+        return QImage::Format_RGBA8888;
     case DRIF_FMT_GRAY:
-        return true;
+        return QImage::Format_Grayscale8;
     }
 
-    return false;
+    return QImage::Format_RGB888;
 }
 
-uint32_t drif2qtfmt(uint32_t f)
+static inline uchar drifClamp(int val)
 {
-    switch (f) {
-    case DRIF_FMT_RGB888:
-        return QImage::Format_RGB888;
-    case DRIF_FMT_RGBA8888:
-        return QImage::Format_RGBA8888;
-    case DRIF_FMT_GRAY:
-        return QImage::Format_Grayscale8;
-    }
+    return (uchar)(val < 0 ? 0 : (val > 255 ? 255 : val));
+}
+
+// BT.601 (video range) in 16 bit fixed point - these are the coefficients OpenCV uses for I420, YV12, NV12 & NV21
+static inline void drifYuv2Rgb(int y, int u, int v, uchar *dst)
+{
+    int c = 76284 * qMax(y - 16, 0);
+    u -= 128;
+    v -= 128;
 
-    return QImage::Format_Invalid;
+    dst[0] = drifClamp((c + 104595 * v + 32768) >> 16);
+    dst[1] = drifClamp((c - 53281 * v - 25625 * u + 32768) >> 16);
+    dst[2] = drifClamp((c + 132252 * u + 32768) >> 16);
 }
 
-bool DkBasicLoader::loadDrifFile(const QString &filePath, QImage &img, QSharedPointer<QByteArray> ba) const
+/**
+ * Converts one row of a drif frame.
+ * Only every step-th pixel is converted - hence, large frames are never converted at full resolution
+ * if they are displayed smaller.
+ * @param src the frame data
+ * @param w the frame width
+ * @param h the frame height
+ * @param f the drif format
+ * @param step the subsampling step (1 for full resolution)
+ * @param row the row of the converted image
+ * @param dst the converted image's scan line (see drifImageFormat)
+ * @param dstWidth the converted image's width
+ **/
+static void drifConvertRow(const uchar *src, int w, int h, uint32_t f, int step, int row, uchar *dst, int dstWidth)
 {
-    bool success = false;
+    int y = row * step;
+    int planeSize = w * h;
 
-    uint32_t w;
-    uint32_t h;
-    uint32_t f;
+    switch (f) {
+    case DRIF_FMT_GRAY: {
+        const uchar *s = src + y * w;
 
-    uint8_t *imgBytes = drifLoadImg(filePath.toLatin1(), &w, &h, &f);
+        for (int x = 0; x < dstWidth; x++)
+            dst[x] = s[x * step];
+    } break;
 
-    if (!imgBytes)
-        return success;
+    case DRIF_FMT_RGB888:
+    case DRIF_FMT_BGR888: {
+        const uchar *s = src + y * w * 3;
+        int ri = f == DRIF_FMT_BGR888 ? 2 : 0;
+
+        for (int x = 0; x < dstWidth; x++, dst += 3) {
+            const uchar *p = s + x * step * 3;
+            dst[0] = p[ri];
+            dst[1] = p[1];
+            dst[2] = p[2 - ri];
+        }
+    } break;
 
-    if (isQtFmtCompatible(f)) {
-        img = QImage((int)w, (int)h, (QImage::Format)drif2qtfmt(f));
-        memcpy(reinterpret_cast<void *>(img.bits()), imgBytes, drifGetSize(w, h, f));
+    case DRIF_FMT_RGBA8888:
+    case DRIF_FMT_BGRA8888: {
+        const uchar *s = src + y * w * 4;
 
-        success = true;
-    }
-#ifdef WITH_OPENCV
-    else {
-        img = QImage((int)w, (int)h, QImage::Format_RGB888);
+        for (int x = 0; x < dstWidth; x++) {
+            const uchar *p = s + x * step * 4;
 
-        switch (f) {
-        case DRIF_FMT_BGR888: {
-            cv::Mat imgMat = cv::Mat((int)h, (int)w, CV_8UC3, imgBytes);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
-            cv::cvtColor(imgMat, rgbMat, CV_BGR2RGB);
+            // RGBA is kept, the alpha channel of BGRA is dropped
+            if (f == DRIF_FMT_RGBA8888) {
+                memcpy(dst, p, 4);
+                dst += 4;
+            } else {
+                dst[0] = p[2];
+                dst[1] = p[1];
+                dst[2] = p[0];
+                dst += 3;
+            }
+        }
+    } break;
+
+    case DRIF_FMT_RGB888P:
+    case DRIF_FMT_RGBA8888P:
+    case DRIF_FMT_BGR888P:
+    case DRIF_FMT_BGRA8888P: {
+        bool bgr = f == DRIF_FMT_BGR888P || f == DRIF_FMT_BGRA8888P;
+        const uchar *r = src + (bgr ? 2 : 0) * planeSize + y * w;
+        const uchar *g = src + planeSize + y * w;
+        const uchar *b = src + (bgr ? 0 : 2) * planeSize + y * w;
+
+        for (int x = 0; x < dstWidth; x++, dst += 3) {
+            int sx = x * step;
+            dst[0] = r[sx];
+            dst[1] = g[sx];
+            dst[2] = b[sx];
+        }
+    } break;
 
-            success = true;
-        } break;
+    case DRIF_FMT_YUV420P:
+    case DRIF_FMT_YVU420P: {
+        const uchar *ys = src + y * w;
+        const uchar *us = src + planeSize + (y / 2) * (w / 2);
+        const uchar *vs = us + planeSize / 4;
 
-        case DRIF_FMT_RGB888P:
-        case DRIF_FMT_RGBA8888P: {
-            cv::Mat imgMatR = cv::Mat((int)h, (int)w, CV_8UC1, imgBytes);
-            cv::Mat imgMatG = cv::Mat((int)h, (int)w, CV_8UC1, imgBytes + w * h);
-            cv::Mat imgMatB = cv::Mat((int)h, (int)w, CV_8UC1, imgBytes + 2 * w * h);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
+        if (f == DRIF_FMT_YVU420P)
+            std::swap(us, vs);
 
-            std::vector<cv::Mat> imgMat{imgMatR, imgMatG, imgMatB};
-            cv::merge(imgMat, rgbMat);
+        for (int x = 0; x < dstWidth; x++, dst += 3) {
+            int sx = x * step;
+            drifYuv2Rgb(ys[sx], us[sx / 2], vs[sx / 2], dst);
+        }
+    } break;
+
+    case DRIF_FMT_NV12:
+    case DRIF_FMT_NV21: {
+        const uchar *ys = src + y * w;
+        const uchar *uv = src + planeSize + (y / 2) * w;
+        int ui = f == DRIF_FMT_NV12 ? 0 : 1;
+
+        for (int x = 0; x < dstWidth; x++, dst += 3) {
+            int sx = x * step;
+            int cx = sx & ~1;
+            drifYuv2Rgb(ys[sx], uv[cx + ui], uv[cx + 1 - ui], dst);
+        }
+    } break;
+    }
+}
 
-            success = true;
-        } break;
+/**
+ * Checks if a file is a drif frame (e.g. frames dumped by a camera pipeline).
+ * Only the footer of the file is read.
+ * @param filePath the file
+ * @return bool true if the file is a drif frame
+ **/
+bool DkBasicLoader::isDrifFile(const QString &filePath)
+{
+    QString suffix = QFileInfo(filePath).suffix().toLower();
 
-        case DRIF_FMT_BGR888P:
-        case DRIF_FMT_BGRA8888P: {
-            cv::Mat imgMatB = cv::Mat((int)h, (int)w, CV_8UC1, imgBytes);
-            cv::Mat imgMatG = cv::Mat((int)h, (int)w, CV_8UC1, imgBytes + w * h);
-            cv::Mat imgMatR = cv::Mat((int)h, (int)w, CV_8UC1, imgBytes + 2 * w * h);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
+    if (suffix != "drif" && suffix != "yuv" && suffix != "raw")
+        return false;
 
-            std::vector<cv::Mat> imgMat{imgMatR, imgMatG, imgMatB};
-            cv::merge(imgMat, rgbMat);
+    QFile file(filePath);
 
-            success = true;
-        } break;
+    if (!file.open(QIODevice::ReadOnly) || file.size() < DRIF_FOOTER_SZ || !file.seek(file.size() - DRIF_FOOTER_SZ))
+        return false;
 
-        case DRIF_FMT_BGRA8888: {
-            cv::Mat imgMat = cv::Mat((int)h, (int)w, CV_8UC4, imgBytes);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
-            cv::cvtColor(imgMat, rgbMat, CV_BGR2RGB, 3);
+    uint32_t magic = 0;
 
-            success = true;
-        } break;
+    return file.read(reinterpret_cast<char *>(&magic), sizeof(magic)) == sizeof(magic) && magic == DRIF_MAGIC;
+}
 
-        case DRIF_FMT_RGBA8888: {
-            cv::Mat imgMat = cv::Mat((int)h, (int)w, CV_8UC4, imgBytes);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
-            cv::cvtColor(imgMat, rgbMat, CV_RGBA2RGB, 3);
+/**
+ * Loads drif frames.
+ * The frame is read from the file buffer - or the file is memory mapped if there is no buffer.
+ * If a decode size is set (see setDecodeSize), the frame is subsampled while it is converted.
+ * @param filePath the frame's file path
+ * @param img the converted frame
+ * @param ba the file buffer (can be empty)
+ * @return bool true if the frame was loaded
+ **/
+bool DkBasicLoader::loadDrifFile(const QString &filePath, QImage &img, QSharedPointer<QByteArray> ba) const
+{
+    QFile file(filePath);
+    const uchar *data = 0;
+    qint64 size = 0;
 
-            success = true;
-        } break;
+    if (ba && !ba->isEmpty()) {
+        data = reinterpret_cast<const uchar *>(ba->constData());
+        size = ba->size();
+    } else if (file.open(QIODevice::ReadOnly)) {
+        size = file.size();
+        data = file.map(0, size);
+    }
 
-        case DRIF_FMT_GRAY: {
-            cv::Mat imgMat = cv::Mat((int)h, (int)w, CV_8UC1, imgBytes);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
-            cv::cvtColor(imgMat, rgbMat, CV_GRAY2RGB);
+    if (!data || size < DRIF_FOOTER_SZ)
+        return false;
 
-            success = true;
-        } break;
+    drif_footer_t footer;
+    memcpy(&footer, data + size - DRIF_FOOTER_SZ, sizeof(footer));
 
-        case DRIF_FMT_YUV420P: {
-            cv::Mat imgMat = cv::Mat((int)h + h / 2, (int)w, CV_8UC1, imgBytes);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
-            cv::cvtColor(imgMat, rgbMat, CV_YUV2RGB_I420);
+    if (footer.magic != DRIF_MAGIC || !isDrifFmtValid(footer.f))
+        return false;
 
-            success = true;
-        } break;
+    // the max size is excluded since w * h * 4 would overflow
+    if (footer.w < DRIF_MIN_W || footer.h < DRIF_MIN_H || footer.w >= DRIF_MAX_W || footer.h >= DRIF_MAX_H)
+        return false;
 
-        case DRIF_FMT_YVU420P: {
-            cv::Mat imgMat = cv::Mat((int)h + h / 2, (int)w, CV_8UC1, imgBytes);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
-            cv::cvtColor(imgMat, rgbMat, CV_YUV2RGB_YV12);
+    if ((qint64)drifGetSize(footer.w, footer.h, footer.f) > size - DRIF_FOOTER_SZ)
+        return false;
 
-            success = true;
-        } break;
+    int w = (int)footer.w;
+    int h = (int)footer.h;
+    int step = 1;
 
-        case DRIF_FMT_NV12: {
-            cv::Mat imgMat = cv::Mat((int)h + h / 2, (int)w, CV_8UC1, imgBytes);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
-            cv::cvtColor(imgMat, rgbMat, CV_YUV2RGB_NV12);
+    // subsample frames that are larger than needed
+    if (mDecodeSize.isValid()) {
+        QSize minSize = QSize(w, h).scaled(mDecodeSize, mDecodeSizeMode);
 
-            success = true;
-        } break;
+        while (w / (step * 2) >= minSize.width() && h / (step * 2) >= minSize.height())
+            step *= 2;
+    }
 
-        case DRIF_FMT_NV21: {
-            cv::Mat imgMat = cv::Mat((int)h + h / 2, (int)w, CV_8UC1, imgBytes);
-            cv::Mat rgbMat = cv::Mat((int)h, (int)w, CV_8UC3, reinterpret_cast<uint8_t *>(img.bits()));
-            cv::cvtColor(imgMat, rgbMat, CV_YUV2RGB_NV21);
+    img = QImage((w + step - 1) / step, (h + step - 1) / step, drifImageFormat(footer.f));
 
-            success = true;
-        } break;
+    if (img.isNull())
+        return false;
 
-        default:
-            success = false;
-            break;
-        }
-    }
-#endif
+    for (int row = 0; row < img.height(); row++)
+        drifConvertRow(data, w, h, footer.f, step, row, img.scanLine(row), img.width());
 
-    drifFreeImg(imgBytes);
+    if (step > 1)
+        qDebug() << "[Basic Loader] drif frame" << QSize(w, h) << "converted at" << img.size();
 
-    return success;
+    return true;
 }
 
 void DkBasicLoader::setImage(const QImage &img, const QString &editName, const QString &file)
@@ -1237,14 +1461,47 @@ void DkBasicLoader::convert32BitOrder(void *buffer, int width) const
  *
  * @param filePath target path to image file
  * @param img source image to be written to file (may be converted along the way)
- * @param compression compression flag for QImageWriter
+ * @param compression compression flag for QImageWriter (see targetSizeCompression() for a file size limit)
  */
 QString DkBasicLoader::save(const QString &filePath, const QImage &img, int compression)
 {
     QSharedPointer<QByteArray> ba;
 
     DkTimer dt;
-    if (saveToBuffer(filePath, img, ba, compression) && ba) {
+    qint64 maxBytes = (qint64)targetSize(compression) * 1024;
+
+    if (maxBytes > 0 && supportsTargetSize(filePath)) {
+        int quality = targetQuality(compression);
+
+        // the quality found before (e.g. by the save dialog) is kept if the file fits with its metadata
+        if (quality >= 0 && (!saveToBuffer(filePath, img, ba, quality) || !ba || ba->size() > maxBytes)) {
+            quality = -1;
+            ba.clear();
+        }
+
+        if (quality >= 0)
+            compression = quality;
+        else {
+            qint64 encodedSize = 0;
+            compression = qualityForSize(filePath, img, maxBytes, &encodedSize);
+
+            if (!saveToBuffer(filePath, img, ba, compression) || !ba)
+                return QString();
+
+            // the quality search does not know about metadata - reserve its size if it breaks the limit
+            qint64 overhead = ba->size() - encodedSize;
+            if (ba->size() > maxBytes && overhead > 0 && overhead < maxBytes) {
+                compression = qualityForSize(filePath, img, maxBytes - overhead);
+                ba.clear();
+            }
+        }
+
+        qInfo() << "target size" << DkUtils::readableByte((float)maxBytes) << "-> quality" << compression;
+    } else if (maxBytes > 0) {
+        compression = -1;
+    }
+
+    if ((ba || saveToBuffer(filePath, img, ba, compression)) && ba) {
         if (writeBufferToFile(filePath, ba)) {
             qInfo() << "saved to" << filePath << "in" << dt;
             return filePath;
@@ -1254,6 +1511,135 @@ QString DkBasicLoader::save(const QString &filePath, const QImage &img, int comp
     return QString();
 }
 
+/**
+ * @brief saves img to several files (sizes x formats) at once.
+ *
+ * Each size is computed once and all outputs are encoded concurrently.
+ * JPEG outputs get the metadata as pre-encoded segments instead of
+ * re-parsing the encoded file. The outputs are written in order while
+ * the remaining ones are still being encoded.
+ *
+ * @param img the image to be saved
+ * @param outputs the files to be written
+ * @return QStringList the file paths that were saved
+ */
+QStringList DkBasicLoader::save(const QImage &img, const QVector<DkSaveOutput> &outputs)
+{
+    DkTimer dt;
+
+    // see saveToBuffer() - mMetaData may be reset in the background
+    QSharedPointer<DkMetaDataT> metaData = mMetaData;
+    bool hasMetaData = metaData && metaData->isLoaded() && metaData->hasMetaData();
+
+    QVector<QSize> sizes;
+    for (const DkSaveOutput &o : outputs) {
+        QSize s = o.size().isEmpty() ? img.size() : o.size();
+        if (!sizes.contains(s))
+            sizes << s;
+    }
+
+    QVector<QFuture<QImage>> resized;
+    for (const QSize &s : sizes) {
+        if (s == img.size())
+            resized << QFuture<QImage>();
+        else
+            resized << QtConcurrent::run(&DkImage::resizeImage, img, s, 1.0, (int)DkImage::ipl_area, true);
+    }
+
+    QVector<QImage> imgs;
+    QVector<QByteArray> segments;
+    for (int idx = 0; idx < sizes.size(); idx++) {
+        imgs << (sizes[idx] == img.size() ? img : resized[idx].result());
+        segments << (hasMetaData ? metaData->jpegSegments(imgs.last()) : QByteArray());
+    }
+
+    QVector<QFuture<QSharedPointer<QByteArray>>> encoded;
+    QVector<int> sizeIdx;
+    for (const DkSaveOutput &o : outputs) {
+        int sIdx = sizes.indexOf(o.size().isEmpty() ? img.size() : o.size());
+        QString suffix = QFileInfo(o.filePath()).suffix();
+        bool isJpg = suffix.contains(QRegExp("^(jpg|jpeg)$", Qt::CaseInsensitive));
+        sizeIdx << sIdx;
+
+        // icons are written with saveWindowsIcon() on this thread (it needs a QPixmap)
+        if (suffix.contains("ico", Qt::CaseInsensitive)) {
+            encoded << QFuture<QSharedPointer<QByteArray>>();
+            continue;
+        }
+
+        // other formats (or metadata that does not fit into segments) are updated on a copy
+        QSharedPointer<DkMetaDataT> mdCopy;
+        if (hasMetaData && (!isJpg || segments[sIdx].isEmpty()))
+            mdCopy = metaData->copy();
+
+        encoded << QtConcurrent::run(&DkBasicLoader::encodeOutput,
+                                     o.filePath(),
+                                     imgs[sIdx],
+                                     o.compression(),
+                                     isJpg ? segments[sIdx] : QByteArray(),
+                                     mdCopy);
+    }
+
+    // write while the next outputs are encoded
+    QStringList saved;
+    for (int idx = 0; idx < outputs.size(); idx++) {
+        const QString &filePath = outputs[idx].filePath();
+        QSharedPointer<QByteArray> ba;
+
+        if (QFileInfo(filePath).suffix().contains("ico", Qt::CaseInsensitive)) {
+            if (!saveWindowsIcon(imgs[sizeIdx[idx]], ba))
+                ba.clear();
+        } else
+            ba = encoded[idx].result();
+
+        if (ba && writeBufferToFile(filePath, ba))
+            saved << filePath;
+        else
+            emit errorDialogSignal(tr("Sorry, I could not save: %1").arg(QFileInfo(filePath).fileName()));
+    }
+
+    qInfo() << saved.size() << "of" << outputs.size() << "outputs saved in" << dt;
+
+    return saved;
+}
+
+/**
+ * Encodes one output of save(const QImage &, const QVector<DkSaveOutput> &).
+ * If jpegSegments are given, they are inserted after the JFIF header.
+ * Otherwise, the (copied) metaData is written to the encoded buffer.
+ **/
+QSharedPointer<QByteArray>
+DkBasicLoader::encodeOutput(const QString &filePath, const QImage &img, int compression, const QByteArray &jpegSegments, QSharedPointer<DkMetaDataT> metaData)
+{
+    qint64 maxBytes = (qint64)targetSize(compression) * 1024;
+
+    if (maxBytes > 0)
+        compression = supportsTargetSize(filePath) ? qualityForSize(filePath, img, qMax(maxBytes - jpegSegments.size(), (qint64)1)) : -1;
+
+    QSharedPointer<QByteArray> ba(new QByteArray());
+    if (!encodeImage(filePath, img, *ba, compression))
+        return QSharedPointer<QByteArray>();
+
+    if (!jpegSegments.isEmpty()) {
+        // SOI, followed by an optional APP0 (JFIF) segment that has to stay first
+        int pos = 2;
+        if (ba->size() > 6 && (uchar)ba->at(2) == 0xFF && (uchar)ba->at(3) == 0xE0)
+            pos = 4 + (((uchar)ba->at(4) << 8) | (uchar)ba->at(5));
+
+        if (ba->size() > 2 && (uchar)ba->at(0) == 0xFF && (uchar)ba->at(1) == 0xD8 && pos <= ba->size())
+            ba->insert(pos, jpegSegments);
+    } else if (metaData) {
+        try {
+            metaData->updateImageMetaData(img, false);
+            metaData->saveMetaData(ba, true);
+        } catch (...) {
+            qInfo() << "Sorry, I could not save the meta data...";
+        }
+    }
+
+    return ba;
+}
+
 /**
  * @brief saveToBuffer() writes the image matrix img to the file buffer.
  *
@@ -1283,41 +1669,7 @@ bool DkBasicLoader::saveToBuffer(const QString &filePath, const QImage &img, QSh
     if (fInfo.suffix().contains("ico", Qt::CaseInsensitive)) {
         saved = saveWindowsIcon(img, ba);
     } else {
-        bool hasAlpha = DkImage::alphaChannelUsed(img);
-        QImage sImg = img;
-
-        // JPEG 2000 can only handle 32 or 8bit images
-        if (!hasAlpha && img.colorTable().empty() && !fInfo.suffix().contains(QRegExp("(avif|j2k|jp2|jpf|jpx|jxl|png)"))) {
-            sImg = sImg.convertToFormat(QImage::Format_RGB888);
-        } else if (fInfo.suffix().contains(QRegExp("(j2k|jp2|jpf|jpx)")) && sImg.depth() != 32 && sImg.depth() != 8) {
-            if (sImg.hasAlphaChannel()) {
-                sImg = sImg.convertToFormat(QImage::Format_ARGB32);
-            } else {
-                sImg = sImg.convertToFormat(QImage::Format_RGB32);
-            }
-        }
-
-        if (fInfo.suffix().contains(QRegExp("(png)")))
-            compression = -1;
-
-        QBuffer fileBuffer(ba.data());
-        // size_t s = fileBuffer.size();
-        fileBuffer.open(QIODevice::WriteOnly);
-        QImageWriter *imgWriter = new QImageWriter(&fileBuffer, fInfo.suffix().toStdString().c_str());
-
-        if (compression >= 0) { // -1 -> use Qt's default
-            imgWriter->setCompression(compression);
-            imgWriter->setQuality(compression);
-        }
-        if (compression == -1 && imgWriter->format() == "jpg") {
-            imgWriter->setQuality(DkSettingsManager::instance().settings().app().defaultJpgQuality);
-        }
-
-        imgWriter->setOptimizedWrite(true); // this saves space TODO: user option here?
-        imgWriter->setProgressiveScanWrite(true);
-
-        saved = imgWriter->write(sImg); // hint: release() might run now, resetting mMetaData which is used below [2022-08, pse]
-        delete imgWriter;
+        saved = encodeImage(filePath, img, *ba, compression); // hint: release() might run now, resetting mMetaData which is used below [2022-08, pse]
     }
 
     if (saved && metaData) {
@@ -1353,6 +1705,167 @@ bool DkBasicLoader::saveToBuffer(const QString &filePath, const QImage &img, QSh
     return saved;
 }
 
+/**
+ * @brief encodes img (without metadata) to ba using the format of the filePath's suffix.
+ *
+ * @param filePath path to file to which this image will later be written, the suffix is relevant
+ * @param img image to be encoded
+ * @param ba buffer the encoded image is written to
+ * @param compression compression flag for QImageWriter
+ * @return bool true if the image could be encoded
+ */
+bool DkBasicLoader::encodeImage(const QString &filePath, const QImage &img, QByteArray &ba, int compression)
+{
+    QFileInfo fInfo(filePath);
+
+    bool hasAlpha = DkImage::alphaChannelUsed(img);
+    QImage sImg = img;
+
+    // JPEG 2000 can only handle 32 or 8bit images
+    if (!hasAlpha && img.colorTable().empty() && !fInfo.suffix().contains(QRegExp("(avif|j2k|jp2|jpf|jpx|jxl|png)"))) {
+        sImg = sImg.convertToFormat(QImage::Format_RGB888);
+    } else if (fInfo.suffix().contains(QRegExp("(j2k|jp2|jpf|jpx)")) && sImg.depth() != 32 && sImg.depth() != 8) {
+        if (sImg.hasAlphaChannel()) {
+            sImg = sImg.convertToFormat(QImage::Format_ARGB32);
+        } else {
+            sImg = sImg.convertToFormat(QImage::Format_RGB32);
+        }
+    }
+
+    if (fInfo.suffix().contains(QRegExp("(png)")))
+        compression = -1;
+
+    QBuffer fileBuffer(&ba);
+    fileBuffer.open(QIODevice::WriteOnly);
+    QImageWriter imgWriter(&fileBuffer, fInfo.suffix().toStdString().c_str());
+
+    if (compression >= 0) { // -1 -> use Qt's default
+        imgWriter.setCompression(compression);
+        imgWriter.setQuality(compression);
+    }
+    if (compression == -1 && imgWriter.format() == "jpg") {
+        imgWriter.setQuality(DkSettingsManager::instance().settings().app().defaultJpgQuality);
+    }
+
+    imgWriter.setOptimizedWrite(true); // this saves space TODO: user option here?
+    imgWriter.setProgressiveScanWrite(true);
+
+    return imgWriter.write(sImg);
+}
+
+/**
+ * Returns true if the format of filePath has a quality setting that can be searched for a target file size.
+ **/
+bool DkBasicLoader::supportsTargetSize(const QString &filePath)
+{
+    return QFileInfo(filePath).suffix().contains(QRegExp("^(jpg|jpeg|webp|avif)$", Qt::CaseInsensitive));
+}
+
+/**
+ * Encodes a target file size as compression value.
+ * Values below -1 are not valid qualities, so they can be passed
+ * through the save functions without changing their signatures.
+ * @param kiloBytes the maximal file size in KB
+ * @param quality the quality found for this size before (e.g. by the save dialog) or -1
+ * @return int the compression value that makes save() search for the quality
+ **/
+int DkBasicLoader::targetSizeCompression(int kiloBytes, int quality)
+{
+    if (kiloBytes <= 0)
+        return -1;
+
+    // the lower 7 bits keep the quality (+1) so that save() does not need to search again
+    int q = (quality >= 0 && quality <= 100) ? quality + 1 : 0;
+
+    return -(kiloBytes * 128 + q) - 1;
+}
+
+/**
+ * Returns the target file size in KB encoded in compression or 0 if it is a plain quality.
+ **/
+int DkBasicLoader::targetSize(int compression)
+{
+    return compression < -1 ? (-compression - 1) / 128 : 0;
+}
+
+/**
+ * Returns the quality that was found for the target size encoded in compression or -1.
+ **/
+int DkBasicLoader::targetQuality(int compression)
+{
+    return compression < -1 ? (-compression - 1) % 128 - 1 : -1;
+}
+
+/**
+ * @brief finds the highest quality for which img encodes to at most maxBytes.
+ *
+ * Large images are first searched at a reduced resolution which
+ * seeds the search so that only two or three full encodes are needed.
+ * If even the lowest quality is too large, 0 is returned (and its encoded size).
+ *
+ * @param filePath the file path (its suffix determines the format)
+ * @param img the image to be saved
+ * @param maxBytes the maximal size of the encoded image
+ * @param encodedSize if not null, the encoded size at the quality returned
+ * @return int the quality found
+ */
+int DkBasicLoader::qualityForSize(const QString &filePath, const QImage &img, qint64 maxBytes, qint64 *encodedSize)
+{
+    // bisects the quality range, starting with the probe at seed
+    auto search = [&](const QImage &sImg, qint64 limit, int seed, qint64 *size) -> int {
+        int good = -1; // highest quality known to fit
+        int bad = 101; // lowest quality known to be too large
+        int q = seed;
+
+        while (bad - good > 1) {
+            QByteArray ba;
+            if (!encodeImage(filePath, sImg, ba, q))
+                break;
+
+            if (ba.size() <= limit) {
+                good = q;
+                if (size)
+                    *size = ba.size();
+            } else {
+                bad = q;
+
+                // nothing fits - report the smallest size we can get
+                if (q == 0 && size)
+                    *size = ba.size();
+            }
+
+            // stay close to the seed until the result is bracketed
+            if (good >= 0 && bad <= 100)
+                q = (good + bad) / 2;
+            else if (good < 0)
+                q = qMax(bad - 10, 0);
+            else
+                q = qMin(good + 5, 100);
+        }
+
+        return qMax(good, 0);
+    };
+
+    DkTimer dt;
+    int seed = 75;
+    double pixels = (double)img.width() * img.height();
+    const double trialPixels = 512.0 * 512.0;
+
+    if (pixels > 4 * trialPixels) {
+        double sf = qSqrt(trialPixels / pixels);
+        QImage trialImg = img.scaled(img.size() * sf, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        double trialRatio = (double)trialImg.width() * trialImg.height() / pixels;
+
+        // downsampled images compress worse per pixel, the full encodes correct this
+        seed = search(trialImg, qRound64(maxBytes * trialRatio), seed, nullptr);
+    }
+
+    int quality = search(img, maxBytes, seed, encodedSize);
+    qDebug() << "quality" << quality << "fits" << maxBytes << "bytes, found in" << dt;
+
+    return quality;
+}
+
 void DkBasicLoader::saveThumbToMetaData(const QString &filePath)
 {
     QSharedPointer<QByteArray> ba; // dummy
@@ -2008,7 +2521,7 @@ void DkRawLoader::setLoadFast(bool fast)
 
 bool DkRawLoader::load(const QSharedPointer<QByteArray> ba)
 {
-    DkTimer dt;
+    DkTraceSpan span("decode", "raw", true);
 
     // try fetching the preview
     if (loadPreview(ba))
@@ -2091,7 +2604,7 @@ bool DkRawLoader::load(const QSharedPointer<QByteArray> ba)
         return false;
     }
 
-    qInfo() << "[RAW] loaded in " << dt;
+    qInfo() << "[RAW] loaded in " << qPrintable(span.elapsed());
 
 #endif
 
@@ -122,6 +122,24 @@ protected:
     QSharedPointer<DkMetaDataT> mMetaData;
 };
 
+/**
+ * One file that is written by DkBasicLoader::save(const QImage &, const QVector<DkSaveOutput> &).
+ **/
+class DllCoreExport DkSaveOutput
+{
+public:
+    DkSaveOutput(const QString &filePath = QString(), int compression = -1, const QSize &size = QSize());
+
+    QString filePath() const;
+    int compression() const;
+    QSize size() const;
+
+protected:
+    QString mFilePath;
+    int mCompression = -1;
+    QSize mSize; // empty -> the image is not resized
+};
+
 class DllCoreExport DkRawLoader
 {
 public:
@@ -235,6 +253,7 @@ public:
      * @return bool true if the image was loaded
      **/
     bool loadGeneral(const QString &filePath, const QSharedPointer<QByteArray> ba, bool loadMetaData = false, bool fast = true);
+    bool adoptImage(const QString &filePath, const QSharedPointer<QByteArray> ba, const QImage &img);
 
     /**
      * Loads the page requested (with respect to the current page)
@@ -258,13 +277,22 @@ public:
     void resetPageIdx();
 
     QString save(const QString &filePath, const QImage &img, int compression = -1);
+    QStringList save(const QImage &img, const QVector<DkSaveOutput> &outputs);
     bool saveToBuffer(const QString &filePath, const QImage &img, QSharedPointer<QByteArray> &ba, int compression = -1) const;
+
+    static bool encodeImage(const QString &filePath, const QImage &img, QByteArray &ba, int compression = -1);
+    static bool supportsTargetSize(const QString &filePath);
+    static int targetSizeCompression(int kiloBytes, int quality = -1);
+    static int targetSize(int compression);
+    static int targetQuality(int compression);
+    static int qualityForSize(const QString &filePath, const QImage &img, qint64 maxBytes, qint64 *encodedSize = 0);
     void saveThumbToMetaData(const QString &filePath, QSharedPointer<QByteArray> &ba);
     void saveMetaData(const QString &filePath, QSharedPointer<QByteArray> &ba);
     void saveThumbToMetaData(const QString &filePath);
     void saveMetaData(const QString &filePath);
 
     static bool isContainer(const QString &filePath);
+    static bool isDrifFile(const QString &filePath);
 
     /**
      * Sets a new image (if edited outside the basicLoader class)
@@ -378,6 +406,10 @@ public:
     bool loadPSDFile(const QString &filePath, QImage &img, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>()) const;
     bool loadTIFFile(const QString &filePath, QImage &img, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>()) const;
     bool loadDrifFile(const QString &filePath, QImage &img, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>()) const;
+    bool loadScaledFile(const QString &filePath, QImage &img, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>()) const;
+
+    void setDecodeSize(const QSize &size, Qt::AspectRatioMode mode = Qt::KeepAspectRatio);
+    QSize decodeSize() const;
 
 #ifdef Q_OS_WIN
     bool saveWindowsIcon(const QString &filePath, const QImage &img) const;
@@ -406,12 +438,16 @@ protected:
     bool loadRawFile(const QString &filePath, QImage &img, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>(), bool fast = false) const;
     void indexPages(const QString &filePath, const QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
     void convert32BitOrder(void *buffer, int width) const;
+    static QSharedPointer<QByteArray>
+    encodeOutput(const QString &filePath, const QImage &img, int compression, const QByteArray &jpegSegments, QSharedPointer<DkMetaDataT> metaData);
 
     int mLoader;
     bool mTraining;
     int mMode;
 
     QString mFile;
+    QSize mDecodeSize; // if valid, images may be decoded at a reduced resolution (see loadScaledFile)
+    Qt::AspectRatioMode mDecodeSizeMode = Qt::KeepAspectRatio;
     int mNumPages;
     int mPageIdx;
     bool mPageIdxDirty;
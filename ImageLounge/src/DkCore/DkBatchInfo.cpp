@@ -162,8 +162,7 @@ DkSaveInfo::DkSaveInfo(const QString &filePathIn, const QString &filePathOut)
 
 void DkSaveInfo::createBackupFilePath()
 {
-    QFileInfo buFile(mFilePathOut);
-    mBackupPath = QFileInfo(buFile.absolutePath(), buFile.baseName() + QUuid::createUuid().toString() + "." + buFile.suffix()).absoluteFilePath();
+    mBackupPath = uniqueBackupFilePath(mFilePathOut);
 }
 
 void DkSaveInfo::clearBackupFilePath()
@@ -171,10 +170,17 @@ void DkSaveInfo::clearBackupFilePath()
     mBackupPath = QString();
 }
 
+QString DkSaveInfo::uniqueBackupFilePath(const QString &filePath)
+{
+    QFileInfo buFile(filePath);
+    return QFileInfo(buFile.absolutePath(), buFile.baseName() + QUuid::createUuid().toString() + "." + buFile.suffix()).absoluteFilePath();
+}
+
 void DkSaveInfo::loadSettings(QSettings &settings)
 {
     settings.beginGroup("SaveInfo");
     mCompression = settings.value("Compression", mCompression).toInt();
+    mExtraFormats = settings.value("ExtraFormats", mExtraFormats).toStringList();
     mMode = (DkSaveInfo::OverwriteMode)settings.value("Mode", mMode).toInt();
     mDeleteOriginal = settings.value("DeleteOriginal", mDeleteOriginal).toBool();
     mInputDirIsOutputDir = settings.value("InputDirIsOutputDir", mInputDirIsOutputDir).toBool();
@@ -187,6 +193,7 @@ void DkSaveInfo::saveSettings(QSettings &settings) const
     settings.beginGroup("SaveInfo");
 
     settings.setValue("Compression", mCompression);
+    settings.setValue("ExtraFormats", mExtraFormats);
     settings.setValue("Mode", mMode);
     settings.setValue("DeleteOriginal", mDeleteOriginal);
     settings.setValue("InputDirIsOutputDir", mInputDirIsOutputDir);
@@ -220,6 +227,11 @@ void DkSaveInfo::setCompression(int compression)
     mCompression = compression;
 }
 
+void DkSaveInfo::setExtraFormats(const QStringList &suffixes)
+{
+    mExtraFormats = suffixes;
+}
+
 void DkSaveInfo::setInputDirIsOutputDir(bool isOutputDir)
 {
     mInputDirIsOutputDir = isOutputDir;
@@ -275,4 +287,9 @@ int DkSaveInfo::compression() const
     return mCompression;
 }
 
+QStringList DkSaveInfo::extraFormats() const
+{
+    return mExtraFormats;
+}
+
 }
\ No newline at end of file
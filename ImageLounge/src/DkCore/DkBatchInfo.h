@@ -98,6 +98,7 @@ public:
     void setMode(OverwriteMode mode);
     void setDeleteOriginal(bool deleteOriginal);
     void setCompression(int compression);
+    void setExtraFormats(const QStringList &suffixes);
     void setInputDirIsOutputDir(bool isOutputDir);
 
     QString inputFilePath() const;
@@ -112,9 +113,11 @@ public:
     bool isDeleteOriginal() const;
     bool isInputDirOutputDir() const;
     int compression() const;
+    QStringList extraFormats() const;
 
     void createBackupFilePath();
     void clearBackupFilePath();
+    static QString uniqueBackupFilePath(const QString &filePath);
 
 private:
     QString mFilePathIn;
@@ -122,7 +125,8 @@ private:
     QString mBackupPath;
 
     OverwriteMode mMode = mode_skip_existing;
-    int mCompression = -1;
+    int mCompression = -1; // values below -1 encode a target file size (see DkBasicLoader::targetSizeCompression)
+    QStringList mExtraFormats; // suffixes the output is additionally saved as - optionally with a quality (e.g. webp:80)
     bool mDeleteOriginal = false;
     bool mInputDirIsOutputDir = false;
 };
@@ -0,0 +1,207 @@
+/*******************************************************************************************************
+ DkFileCache.cpp
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkFileCache.h"
+#include "DkTimer.h"
+#include "DkUtils.h"
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#pragma warning(pop) // no warnings from includes - end
+
+namespace nmc
+{
+
+// DkFileCache --------------------------------------------------------------------
+/**
+ * @param name the name that is used for logging (e.g. DkImageScores).
+ * @param fileName the file name in the cache location.
+ * @param maxEntries stale values are dropped when saving more values than this.
+ **/
+DkFileCache::DkFileCache(const QString &name, const QString &fileName, int maxEntries)
+    : mName(name)
+    , mFileName(fileName)
+    , mMaxEntries(maxEntries)
+{
+    mNotifyTimer = new QTimer(this);
+    mNotifyTimer->setSingleShot(true);
+    mNotifyTimer->setInterval(500);
+    connect(mNotifyTimer, SIGNAL(timeout()), this, SLOT(emitUpdates()));
+
+    // the singletons might be created on a pool's thread (e.g. by a thumbnail task)
+    // the timer and signals need the event loop of the main thread though (children are moved too)
+    if (QCoreApplication::instance())
+        moveToThread(QCoreApplication::instance()->thread());
+}
+
+QString DkFileCache::key(const QFileInfo &fileInfo)
+{
+    return fileInfo.absoluteFilePath() + "|" + QString::number(fileInfo.lastModified().toMSecsSinceEpoch());
+}
+
+/**
+ * Returns true if files are pending.
+ **/
+bool DkFileCache::isBusy() const
+{
+    QMutexLocker locker(&mMutex);
+    return !mPending.empty();
+}
+
+/**
+ * Releases the pending state of a file.
+ * Tasks call this when they are deleted - also if they were removed from the pool before they could run.
+ * @param key the file's key.
+ **/
+void DkFileCache::release(const QString &key)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mPending.remove(key);
+    }
+
+    // tasks are released on the pool's threads
+    QMetaObject::invokeMethod(this, "notify", Qt::QueuedConnection);
+}
+
+/**
+ * Collects finished files so that views do not update for every single file.
+ **/
+void DkFileCache::notify()
+{
+    if (!mNotifyTimer->isActive())
+        mNotifyTimer->start();
+}
+
+void DkFileCache::emitUpdates()
+{
+    emit updated();
+
+    if (!isBusy())
+        emit finished();
+}
+
+QString DkFileCache::cacheFilePath() const
+{
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    if (cacheDir.isEmpty() || !QDir().mkpath(cacheDir))
+        return QString();
+
+    return QFileInfo(cacheDir, mFileName).absoluteFilePath();
+}
+
+/**
+ * Reads the cache file if it was written by this version.
+ * This is called with mMutex locked.
+ * @param read reads the values and returns the number of values (or -1 if reading failed).
+ * @return bool true if the values were read.
+ **/
+bool DkFileCache::readCache(const std::function<int(QDataStream &)> &read)
+{
+    QFile file(cacheFilePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    DkTimer dt;
+
+    QDataStream ds(&file);
+    QString version;
+
+    ds >> version;
+
+    if (version != QCoreApplication::applicationVersion()) {
+        qInfoClean() << "[" << mName << "] dropping cache of version " << version;
+        mDirty = true;
+        return false;
+    }
+
+    int numValues = read(ds);
+
+    if (numValues < 0 || ds.status() != QDataStream::Ok) {
+        qWarningClean() << "[" << mName << "] could not read " << file.fileName();
+        mDirty = true;
+        return false;
+    }
+
+    qInfoClean() << "[" << mName << "] " << numValues << " entries loaded in " << dt;
+
+    return true;
+}
+
+/**
+ * Writes the cache file.
+ * @param write writes the values.
+ * @return bool true if the file was written.
+ **/
+bool DkFileCache::writeCache(const std::function<void(QDataStream &)> &write)
+{
+    QString fp = cacheFilePath();
+    if (fp.isEmpty())
+        return false;
+
+    QSaveFile file(fp);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarningClean() << "[" << mName << "] could not open " << fp;
+        return false;
+    }
+
+    QDataStream ds(&file);
+    ds << QCoreApplication::applicationVersion();
+    write(ds);
+
+    return file.commit();
+}
+
+/**
+ * Returns the keys of files that were removed or changed.
+ * This checks every file - so do not call it with mMutex locked.
+ * @param keys the keys to check.
+ * @return QStringList the stale keys.
+ **/
+QStringList DkFileCache::staleKeys(const QStringList &keys)
+{
+    QStringList stale;
+
+    for (const QString &k : keys) {
+        QString filePath = k.section("|", 0, -2);
+
+        if (key(QFileInfo(filePath)) != k)
+            stale << k;
+    }
+
+    return stale;
+}
+
+}
@@ -0,0 +1,240 @@
+/*******************************************************************************************************
+ DkFileCache.h
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QDataStream>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+
+#include <functional>
+#pragma warning(pop) // no warnings from includes - end
+
+#pragma warning(disable : 4251) // TODO: remove
+
+#ifndef DllCoreExport
+#ifdef DK_CORE_DLL_EXPORT
+#define DllCoreExport Q_DECL_EXPORT
+#elif DK_DLL_IMPORT
+#define DllCoreExport Q_DECL_IMPORT
+#else
+#define DllCoreExport Q_DECL_IMPORT
+#endif
+#endif
+
+// Qt defines
+class QTimer;
+
+namespace nmc
+{
+
+/**
+ * DkFileCache is the base of caches that keep per-file values computed in the background
+ * (see DkImageScores, DkImageHashes, DkMetaDataIndex).
+ * Values are keyed by file path and modification date and persisted between sessions.
+ * Files that are being computed are pending - finished files are collected
+ * so that views do not update for every single file.
+ **/
+class DllCoreExport DkFileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static QString key(const QFileInfo &fileInfo);
+
+    bool isBusy() const;
+
+    // called by the tasks (from the pool's threads)
+    void release(const QString &key);
+
+signals:
+    void updated() const;
+    void finished() const;
+
+protected slots:
+    void notify();
+    void emitUpdates();
+
+protected:
+    DkFileCache(const QString &name, const QString &fileName, int maxEntries);
+
+    QString cacheFilePath() const;
+    bool readCache(const std::function<int(QDataStream &)> &read);
+    bool writeCache(const std::function<void(QDataStream &)> &write);
+    static QStringList staleKeys(const QStringList &keys);
+
+    mutable QMutex mMutex;
+    QSet<QString> mPending;
+    QTimer *mNotifyTimer = 0;
+    bool mLoaded = false;
+    bool mDirty = false;
+
+    QString mName;
+    QString mFileName;
+    int mMaxEntries;
+};
+
+/**
+ * Typed storage of DkFileCache.
+ * T needs a default constructor (returned for files that are not cached)
+ * and QDataStream operators.
+ **/
+template <typename T>
+class DkFileCacheT : public DkFileCache
+{
+public:
+    T value(const QFileInfo &fileInfo)
+    {
+        load();
+
+        QString k = key(fileInfo);
+
+        QMutexLocker locker(&mMutex);
+        return mItems.value(k);
+    }
+
+    bool contains(const QString &key)
+    {
+        load();
+
+        QMutexLocker locker(&mMutex);
+        return mItems.contains(key);
+    }
+
+    void insert(const QString &key, const T &item)
+    {
+        QMutexLocker locker(&mMutex);
+        mItems.insert(key, item);
+        mDirty = true;
+    }
+
+    /**
+     * Loads the values of previous sessions.
+     **/
+    void load()
+    {
+        QMutexLocker locker(&mMutex);
+
+        if (mLoaded)
+            return;
+
+        mLoaded = true;
+
+        readCache([&](QDataStream &ds) {
+            QHash<QString, T> items;
+            ds >> items;
+
+            if (ds.status() != QDataStream::Ok)
+                return -1;
+
+            for (auto it = items.constBegin(); it != items.constEnd(); it++)
+                mItems.insert(it.key(), it.value());
+
+            return mItems.size();
+        });
+    }
+
+    /**
+     * Writes all values to the disk.
+     * Values of files that were removed or changed are dropped if the cache grows too large.
+     * The files are checked and written without blocking the tasks.
+     **/
+    void save()
+    {
+        QHash<QString, T> items;
+
+        {
+            QMutexLocker locker(&mMutex);
+
+            if (!mDirty)
+                return;
+
+            items = mItems; // implicitly shared
+            mDirty = false;
+        }
+
+        if (items.size() > mMaxEntries) {
+            QStringList stale = staleKeys(items.keys());
+
+            QMutexLocker locker(&mMutex);
+            for (const QString &k : stale) {
+                items.remove(k);
+                mItems.remove(k);
+            }
+        }
+
+        if (!writeCache([&](QDataStream &ds) {
+                ds << items;
+            })) {
+            QMutexLocker locker(&mMutex);
+            mDirty = true;
+        }
+    }
+
+protected:
+    DkFileCacheT(const QString &name, const QString &fileName, int maxEntries)
+        : DkFileCache(name, fileName, maxEntries)
+    {
+    }
+
+    /**
+     * Marks all files that are not cached yet as pending.
+     * @param files the files to be computed.
+     * @return (file path, key) of the files that need to be computed.
+     **/
+    QList<QPair<QString, QString>> queue(const QList<QFileInfo> &files)
+    {
+        load();
+
+        QList<QPair<QString, QString>> queued;
+
+        QMutexLocker locker(&mMutex);
+
+        for (const QFileInfo &fi : files) {
+            QString k = key(fi);
+
+            if (mItems.contains(k) || mPending.contains(k))
+                continue;
+
+            mPending.insert(k);
+            queued << qMakePair(fi.absoluteFilePath(), k);
+        }
+
+        return queued;
+    }
+
+    QHash<QString, T> mItems;
+};
+
+}
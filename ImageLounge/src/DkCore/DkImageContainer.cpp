@@ -27,18 +27,29 @@
 
 #include "DkImageContainer.h"
 #include "DkBasicLoader.h"
+#include "DkImageScores.h"
 #include "DkImageStorage.h"
 #include "DkMetaData.h"
+#include "DkMetaDataIndex.h"
 #include "DkSettings.h"
 #include "DkThumbs.h"
 #include "DkTimer.h"
 #include "DkUtils.h"
 
 #pragma warning(push, 0) // no warnings from includes - begin
+#include <QFileInfo>
+#include <QDateTime>
 #include <QImage>
+#include <QCoreApplication>
+#include <QMutexLocker>
 #include <QObject>
+#include <QPointer>
+#include <QStorageInfo>
+#include <QStringList>
 #include <QtConcurrentRun>
 
+#include <algorithm>
+
 // quazip
 #ifdef WITH_QUAZIP
 #ifdef WITH_QUAZIP1
@@ -119,8 +130,9 @@ void DkImageContainer::clear()
 {
     if (mLoader)
         mLoader->release();
-    if (mFileBuffer)
-        mFileBuffer->clear();
+
+    // don't clear the buffer - it might be shared with other tabs (see DkImageCache)
+    mFileBuffer.clear();
     init();
 }
 
@@ -286,6 +298,15 @@ float DkImageContainer::getMemoryUsage() const
     return memSize;
 }
 
+/**
+ * Returns the memory of the file buffer.
+ * @return float the buffer size in MB
+ **/
+float DkImageContainer::getBufferMemoryUsage() const
+{
+    return mFileBuffer ? mFileBuffer->size() / (1024.0f * 1024.0f) : 0;
+}
+
 float DkImageContainer::getFileSize() const
 {
     return QFileInfo(mFilePath).size() / (1024.0f * 1024.0f);
@@ -458,6 +479,15 @@ bool DkImageContainer::saveImage(const QString &filePath, const QImage saveImg,
     return saveFile.exists() && saveFile.isFile();
 }
 
+/**
+ * Saves the current image to all outputs (see DkBasicLoader::save).
+ * @return QStringList the files that were saved
+ **/
+QStringList DkImageContainer::saveImages(const QVector<DkSaveOutput> &outputs)
+{
+    return getLoader()->save(getLoader()->lastImage(), outputs);
+}
+
 QSharedPointer<QByteArray> DkImageContainer::loadFileToBuffer(const QString &filePath)
 {
     QFileInfo fInfo = filePath;
@@ -474,6 +504,10 @@ QSharedPointer<QByteArray> DkImageContainer::loadFileToBuffer(const QString &fil
         return QSharedPointer<QByteArray>(new QByteArray());
     }
 
+    // drif frames are memory mapped by the loader
+    if (DkBasicLoader::isDrifFile(fInfo.absoluteFilePath()))
+        return QSharedPointer<QByteArray>(new QByteArray());
+
     QFile file(fInfo.absoluteFilePath());
     file.open(QIODevice::ReadOnly);
 
@@ -564,6 +598,83 @@ bool imageContainerLessThanPtr(const QSharedPointer<DkImageContainer> l, const Q
     return imageContainerLessThan(*l, *r);
 }
 
+/**
+ * Sort keys of the modes that query the background caches (see DkImageScores, DkMetaDataIndex).
+ * The caches are updated by pool threads, hence the keys are read once before sorting -
+ * otherwise the order could change while we sort.
+ **/
+struct DkSortKey {
+    QFileInfo file;
+    bool valid = false;
+    double value = 0.0; // score or rating
+    qint64 time = 0;
+    QString camera;
+};
+
+static bool hasSortKey(int sortMode)
+{
+    return sortMode == DkSettings::sort_sharpness || sortMode == DkSettings::sort_clipping || sortMode == DkSettings::sort_date_taken
+        || sortMode == DkSettings::sort_rating || sortMode == DkSettings::sort_camera;
+}
+
+static DkSortKey sortKey(const QFileInfo &file, int sortMode)
+{
+    DkSortKey key;
+    key.file = file;
+
+    if (sortMode == DkSettings::sort_sharpness || sortMode == DkSettings::sort_clipping) {
+        DkImageScore score = DkImageScores::instance().score(file);
+        key.valid = score.isValid();
+        key.value = sortMode == DkSettings::sort_clipping ? score.clipping() : score.sharpness;
+        return key;
+    }
+
+    // images without capture time are sorted by their modification date
+    DkMetaDataEntry entry = DkMetaDataIndex::instance().entry(file);
+    key.valid = entry.isValid();
+    key.time = key.valid ? entry.sortTime() : file.lastModified().toMSecsSinceEpoch();
+    key.value = sortMode == DkSettings::sort_rating ? entry.rating : 0;
+    key.camera = entry.camera;
+
+    return key;
+}
+
+/**
+ * Compares two files by their sort keys.
+ * Images that are not scored or indexed yet (or have no camera) are sorted last.
+ * Ties are sorted by capture time and filename.
+ **/
+static bool compSortKeys(const DkSortKey &l, const DkSortKey &r, int sortMode, bool ascending)
+{
+    if (sortMode == DkSettings::sort_date_taken) {
+        if (l.time != r.time)
+            return ascending ? l.time < r.time : l.time > r.time;
+
+        return DkUtils::compFilename(l.file, r.file);
+    }
+
+    if (l.valid != r.valid)
+        return l.valid;
+
+    if (l.valid && l.value != r.value)
+        return ascending ? l.value < r.value : l.value > r.value;
+
+    if (sortMode == DkSettings::sort_camera) {
+        if (l.camera.isEmpty() != r.camera.isEmpty())
+            return !l.camera.isEmpty();
+
+        int c = l.camera.compare(r.camera, Qt::CaseInsensitive);
+
+        if (c != 0)
+            return ascending ? c < 0 : c > 0;
+    }
+
+    if (l.time != r.time)
+        return l.time < r.time;
+
+    return DkUtils::compFilename(l.file, r.file);
+}
+
 bool imageContainerLessThan(const DkImageContainer &l, const DkImageContainer &r)
 {
     switch (DkSettingsManager::param().global().sortMode) {
@@ -607,30 +718,140 @@ bool imageContainerLessThan(const DkImageContainer &l, const DkImageContainer &r
     case DkSettings::sort_random:
         return DkUtils::compRandom(l.fileInfo(), r.fileInfo());
 
+    // use sortImageContainers() for lists - it reads these keys only once
+    case DkSettings::sort_sharpness:
+    case DkSettings::sort_clipping:
+    case DkSettings::sort_date_taken:
+    case DkSettings::sort_rating:
+    case DkSettings::sort_camera: {
+        int sortMode = DkSettingsManager::param().global().sortMode;
+        return compSortKeys(sortKey(l.fileInfo(), sortMode),
+                            sortKey(r.fileInfo(), sortMode),
+                            sortMode,
+                            DkSettingsManager::param().global().sortDir == DkSettings::sort_ascending);
+    }
+
     default:
         // filename
         return DkUtils::compFilename(l.fileInfo(), r.fileInfo());
     }
 }
 
+/**
+ * Sorts images according to the current sort mode.
+ * Scores and metadata are read once before sorting (see DkSortKey).
+ * @param images the images to sort
+ * @return bool true if the order changed
+ **/
+bool sortImageContainers(QVector<QSharedPointer<DkImageContainerT>> &images)
+{
+    int sortMode = DkSettingsManager::param().global().sortMode;
+
+    if (!hasSortKey(sortMode)) {
+        QVector<QSharedPointer<DkImageContainerT>> sorted = images;
+        qSort(sorted.begin(), sorted.end(), imageContainerLessThanPtr);
+
+        bool changed = sorted != images;
+        images = sorted;
+        return changed;
+    }
+
+    bool ascending = DkSettingsManager::param().global().sortDir == DkSettings::sort_ascending;
+
+    QVector<QPair<DkSortKey, int>> keys;
+    keys.reserve(images.size());
+    for (int idx = 0; idx < images.size(); idx++)
+        keys << qMakePair(sortKey(images[idx]->fileInfo(), sortMode), idx);
+
+    std::sort(keys.begin(), keys.end(), [&](const QPair<DkSortKey, int> &l, const QPair<DkSortKey, int> &r) {
+        return compSortKeys(l.first, r.first, sortMode, ascending);
+    });
+
+    QVector<QSharedPointer<DkImageContainerT>> sorted;
+    sorted.reserve(images.size());
+    bool changed = false;
+
+    for (int idx = 0; idx < keys.size(); idx++) {
+        sorted << images[keys[idx].second];
+        changed |= keys[idx].second != idx;
+    }
+
+    images = sorted;
+    return changed;
+}
+
+/**
+ * Inserts images at their sorted position (e.g. new files of the current folder).
+ * Like sortImageContainers, scores and metadata are read once - also those of the sorted images.
+ * Images are appended if the folder is sorted randomly.
+ * @param images images that are sorted according to the current sort mode
+ * @param newImages the images to insert
+ * @return QVector<int> the index of every new image at the time it was inserted
+ **/
+QVector<int> insertImageContainers(QVector<QSharedPointer<DkImageContainerT>> &images, const QVector<QSharedPointer<DkImageContainerT>> &newImages)
+{
+    int sortMode = DkSettingsManager::param().global().sortMode;
+    QVector<int> indexes;
+    indexes.reserve(newImages.size());
+
+    if (newImages.empty())
+        return indexes;
+
+    if (!hasSortKey(sortMode)) {
+        for (const QSharedPointer<DkImageContainerT> &img : newImages) {
+            int idx = images.size();
+
+            if (sortMode != DkSettings::sort_random)
+                idx = (int)(std::upper_bound(images.begin(), images.end(), img, imageContainerLessThanPtr) - images.begin());
+
+            images.insert(idx, img);
+            indexes << idx;
+        }
+
+        return indexes;
+    }
+
+    bool ascending = DkSettingsManager::param().global().sortDir == DkSettings::sort_ascending;
+    auto lessThan = [&](const DkSortKey &l, const DkSortKey &r) {
+        return compSortKeys(l, r, sortMode, ascending);
+    };
+
+    QVector<DkSortKey> keys;
+    keys.reserve(images.size() + newImages.size());
+    for (const QSharedPointer<DkImageContainerT> &img : images)
+        keys << sortKey(img->fileInfo(), sortMode);
+
+    for (const QSharedPointer<DkImageContainerT> &img : newImages) {
+        DkSortKey key = sortKey(img->fileInfo(), sortMode);
+        int idx = (int)(std::upper_bound(keys.begin(), keys.end(), key, lessThan) - keys.begin());
+
+        keys.insert(idx, key);
+        images.insert(idx, img);
+        indexes << idx;
+    }
+
+    return indexes;
+}
+
 // DkImageContainerT --------------------------------------------------------------------
 DkImageContainerT::DkImageContainerT(const QString &filePath)
     : DkImageContainer(filePath)
 {
-    // our file watcher
-    mFileUpdateTimer.setSingleShot(false);
-    mFileUpdateTimer.setInterval(500);
-
-    connect(&mFileUpdateTimer, SIGNAL(timeout()), this, SLOT(checkForFileUpdates()), Qt::UniqueConnection);
+    mCacheConsumer = tr("Viewer");
+    connect(&mScaleWatcher, SIGNAL(finished()), this, SLOT(scaledImageComputed()));
     // connect(&metaDataWatcher, SIGNAL(finished()), this, SLOT(metaDataLoaded()));
 }
 
 DkImageContainerT::~DkImageContainerT()
 {
+    DkFileWatcher::instance().unwatch(this);
+    DkImageCache::instance().release(this);
+
     mBufferWatcher.blockSignals(true);
     mBufferWatcher.cancel();
     mImageWatcher.blockSignals(true);
     mImageWatcher.cancel();
+    mScaleWatcher.blockSignals(true);
 
     // This dtor is where saveMetaData() used to be called, which called the "dangerous" overload of saveMetaData(),
     // which is dangerous because it updates the file. We consider this to be a bug.
@@ -651,6 +872,72 @@ void DkImageContainerT::clear()
         return;
 
     DkImageContainer::clear();
+    DkImageCache::instance().release(this);
+    mScaledImgs.clear();
+}
+
+/**
+ * Releases the decoded image but keeps the file buffer.
+ * Hence, the image can be decoded again without reading the file.
+ * @return bool true if the image was released
+ **/
+bool DkImageContainerT::releaseImage()
+{
+    if (mFetchingImage || mFetchingBuffer || mEdited || mLoadState != loaded)
+        return false;
+
+    if (mLoader)
+        mLoader->release();
+
+    DkImageCache::instance().releaseImage(this);
+    mScaledImgs.clear();
+    mLoadState = not_loaded;
+    return true;
+}
+
+/**
+ * Releases the file buffer but keeps the decoded image.
+ * @return bool true if the buffer was released
+ **/
+bool DkImageContainerT::releaseFileBuffer()
+{
+    if (mFetchingImage || mFetchingBuffer || !mFileBuffer || mFileBuffer->isEmpty())
+        return false;
+
+    // don't clear the buffer - it might be shared with a thread that saves metadata
+    mFileBuffer = QSharedPointer<QByteArray>();
+    DkImageCache::instance().releaseBuffer(this);
+    return true;
+}
+
+/**
+ * Decodes the image at a reduced resolution (e.g. while frame sequences are played).
+ * Images that were decoded at a reduced resolution are released if the full resolution is requested.
+ * @param size the size the image is displayed with - an invalid size decodes the full resolution
+ * @return bool true if a reduced image was released and needs to be loaded again
+ **/
+bool DkImageContainerT::setDecodeSize(const QSize &size)
+{
+    mDecodeSize = size;
+
+    // the image was decoded at a reduced resolution - but we need the full resolution now
+    if (!size.isValid() && mLoadState == loaded && getLoader()->decodeSize().isValid())
+        return releaseImage();
+
+    return false;
+}
+
+/**
+ * Sets the consumer (e.g. the tab) the cached image and buffer are accounted to.
+ * @param consumer the consumer's name
+ **/
+void DkImageContainerT::setCacheConsumer(const QString &consumer)
+{
+    if (mCacheConsumer == consumer)
+        return;
+
+    mCacheConsumer = consumer;
+    DkImageCache::instance().setConsumer(this, consumer);
 }
 
 void DkImageContainerT::checkForFileUpdates()
@@ -679,7 +966,7 @@ void DkImageContainerT::checkForFileUpdates()
 #endif
 
     if (changed) {
-        mFileUpdateTimer.stop();
+        DkFileWatcher::instance().unwatch(this);
         if (DkSettingsManager::param().global().askToSaveDeletedFiles) {
             mEdited = changed;
             emit fileLoadedSignal(true);
@@ -687,11 +974,7 @@ void DkImageContainerT::checkForFileUpdates()
         return;
     }
 
-    // we use our own file watcher, since the qt watcher
-    // uses locks to check for updates. this might
-    // be more accurate. however, the locks are pretty nasty
-    // if the user e.g. wants to delete the file while watching
-    // it in nomacs
+    // DkFileWatcher only calls us once the file stopped changing
     if (mWaitForUpdate == update_pending && mFileInfo.isReadable()) {
         mWaitForUpdate = update_loading;
 
@@ -764,6 +1047,19 @@ void DkImageContainerT::fetchFile()
         return;
     }
 
+    // another tab might have loaded the file already
+    mCacheKey = DkImageCache::cacheKey(filePath());
+    QSharedPointer<QByteArray> cachedBuffer = DkImageCache::instance().buffer(mCacheKey);
+
+    if (cachedBuffer || !DkImageCache::instance().image(mCacheKey).isNull()) {
+        if (cachedBuffer)
+            mFileBuffer = DkImageCache::instance().insertBuffer(this, mCacheConsumer, mCacheKey, cachedBuffer);
+
+        if (getLoadState() == loading)
+            fetchImage();
+        return;
+    }
+
     mFetchingBuffer = true; // saves the threaded call
     connect(&mBufferWatcher, SIGNAL(finished()), this, SLOT(bufferLoaded()), Qt::UniqueConnection);
 
@@ -775,7 +1071,7 @@ void DkImageContainerT::bufferLoaded()
     mFetchingBuffer = false;
 
     if (!mBufferWatcher.isCanceled())
-        mFileBuffer = mBufferWatcher.result();
+        mFileBuffer = DkImageCache::instance().insertBuffer(this, mCacheConsumer, mCacheKey, mBufferWatcher.result());
 
     if (getLoadState() == loading)
         fetchImage();
@@ -806,7 +1102,16 @@ void DkImageContainerT::fetchImage()
 
     connect(&mImageWatcher, SIGNAL(finished()), this, SLOT(imageLoaded()), Qt::UniqueConnection);
 
-    mImageWatcher.setFuture(QtConcurrent::run(this, &nmc::DkImageContainerT::loadImageIntern, filePath(), mLoader, mFileBuffer));
+    // the image is already decoded (e.g. in another tab)
+    QImage cachedImg = DkImageCache::instance().image(mCacheKey);
+
+    if (!cachedImg.isNull() && !mLoader->isDirty()) {
+        mLoader->setDecodeSize(QSize());
+        mImageWatcher.setFuture(QtConcurrent::run(this, &nmc::DkImageContainerT::adoptImageIntern, filePath(), mLoader, mFileBuffer, cachedImg));
+    } else {
+        mLoader->setDecodeSize(mDecodeSize);
+        mImageWatcher.setFuture(QtConcurrent::run(this, &nmc::DkImageContainerT::loadImageIntern, filePath(), mLoader, mFileBuffer));
+    }
 }
 
 void DkImageContainerT::imageLoaded()
@@ -841,6 +1146,7 @@ void DkImageContainerT::loadingFinished()
             mWaitForUpdate = update_pending;
             mLoadState = not_loaded;
             qInfo() << "could not load while updating - is somebody writing to the file?";
+            DkFileWatcher::instance().recheck(this);
             return;
         } else {
             emit showInfoSignal(tr("updated..."));
@@ -849,7 +1155,7 @@ void DkImageContainerT::loadingFinished()
     }
 
     if (!getLoader()->hasImage()) {
-        mFileUpdateTimer.stop();
+        DkFileWatcher::instance().unwatch(this);
         mEdited = false;
         QString msg = tr("Sorry, I could not load: %1").arg(fileName());
         emit showInfoSignal(msg);
@@ -866,7 +1172,16 @@ void DkImageContainerT::loadingFinished()
 
         // if the file buffer is more than 5MB - we check if we need to delete it
         if (bs > 5 && bs > DkSettingsManager::param().resources().cacheMemory * 0.5f)
-            mFileBuffer->clear();
+            releaseFileBuffer();
+    }
+
+    // share the original image with other tabs (but not if it was decoded at a reduced resolution)
+    if (getLoader()->history()->size() == 1 && getLoader()->getNumPages() <= 1 && !getLoader()->decodeSize().isValid()) {
+        QImage img = DkImageCache::instance().insertImage(this, mCacheConsumer, mCacheKey, getLoader()->image());
+
+        // another tab decoded the same image in the meantime - keep one copy only
+        if (img.cacheKey() != getLoader()->image().cacheKey())
+            getLoader()->history()->first().setImage(img);
     }
 
     mLoadState = loaded;
@@ -936,14 +1251,14 @@ void DkImageContainerT::receiveUpdates(QObject *obj, bool connectSignals /* = tr
         connect(this, SIGNAL(showInfoSignal(const QString &, int, int)), obj, SIGNAL(showInfoSignal(const QString &, int, int)), Qt::UniqueConnection);
         connect(this, SIGNAL(fileSavedSignal(const QString &, bool, bool)), obj, SLOT(imageSaved(const QString &, bool, bool)), Qt::UniqueConnection);
         connect(this, SIGNAL(imageUpdatedSignal()), obj, SLOT(currentImageUpdated()), Qt::UniqueConnection);
-        mFileUpdateTimer.start();
+        DkFileWatcher::instance().watch(this);
     } else if (!connectSignals) {
         disconnect(this, SIGNAL(errorDialogSignal(const QString &)), obj, SLOT(errorDialog(const QString &)));
         disconnect(this, SIGNAL(fileLoadedSignal(bool)), obj, SLOT(imageLoaded(bool)));
         disconnect(this, SIGNAL(showInfoSignal(const QString &, int, int)), obj, SIGNAL(showInfoSignal(const QString &, int, int)));
         disconnect(this, SIGNAL(fileSavedSignal(const QString &, bool, bool)), obj, SLOT(imageSaved(const QString &, bool, bool)));
         disconnect(this, SIGNAL(imageUpdatedSignal()), obj, SLOT(currentImageUpdated()));
-        mFileUpdateTimer.stop();
+        DkFileWatcher::instance().unwatch(this);
     }
 
     mSelected = connectSignals;
@@ -954,7 +1269,7 @@ void DkImageContainerT::saveMetaDataThreaded(const QString &filePath)
     if (!exists() || (getLoader()->getMetaData() && !getLoader()->getMetaData()->isDirty()))
         return;
 
-    mFileUpdateTimer.stop();
+    DkFileWatcher::instance().unwatch(this);
     QFuture<void> future = QtConcurrent::run(this, &nmc::DkImageContainerT::saveMetaDataIntern, filePath, getLoader(), getFileBuffer());
 }
 
@@ -992,7 +1307,7 @@ bool DkImageContainerT::saveImageThreaded(const QString &filePath, const QImage
 
     qDebug() << "attempting to save: " << filePath;
 
-    mFileUpdateTimer.stop();
+    DkFileWatcher::instance().unwatch(this);
     connect(&mSaveImageWatcher, SIGNAL(finished()), this, SLOT(savingFinished()), Qt::UniqueConnection);
 
     mSaveImageWatcher.setFuture(QtConcurrent::run(this, &nmc::DkImageContainerT::saveImageIntern, filePath, mLoader, saveImg, compression));
@@ -1029,7 +1344,7 @@ void DkImageContainerT::savingFinished()
         mDownloaded = false;
         if (mSelected) {
             loadImageThreaded(true); // force a reload
-            mFileUpdateTimer.start();
+            DkFileWatcher::instance().watch(this);
         }
     }
 }
@@ -1045,6 +1360,20 @@ DkImageContainerT::loadImageIntern(const QString &filePath, QSharedPointer<DkBas
     return DkImageContainer::loadImageIntern(filePath, loader, fileBuffer);
 }
 
+QSharedPointer<DkBasicLoader> DkImageContainerT::adoptImageIntern(const QString &filePath,
+                                                                  QSharedPointer<DkBasicLoader> loader,
+                                                                  const QSharedPointer<QByteArray> fileBuffer,
+                                                                  const QImage img)
+{
+    try {
+        loader->adoptImage(filePath, fileBuffer, img);
+    } catch (...) {
+        qWarning() << "Unknown error in DkImageContainerT::adoptImageIntern";
+    }
+
+    return loader;
+}
+
 QString DkImageContainerT::saveImageIntern(const QString &filePath, QSharedPointer<DkBasicLoader> loader, QImage saveImg, int compression)
 {
     return DkImageContainer::saveImageIntern(filePath, loader, saveImg, compression);
@@ -1080,6 +1409,82 @@ bool DkImageContainerT::isFileDownloaded() const
     return mDownloaded;
 }
 
+/**
+ * Returns the current image scaled to height (e.g. for the film strip).
+ * In contrast to imageScaledToHeight, the image is scaled in the background.
+ * A null image is returned until the scaled image is ready - scaledImageReady() is emitted then.
+ * Images that are smaller than height are returned without scaling.
+ * The last few heights are cached, so the viewport (fit height) and the
+ * film strip (thumbnail height) do not overwrite each other's image.
+ * @param height the requested height
+ * @return QImage the scaled image or a null image if it is not computed yet
+ **/
+QImage DkImageContainerT::scaledImage(int height)
+{
+    if (!hasImage() || height <= 0)
+        return QImage();
+
+    QImage img = pixmap();
+
+    if (img.height() <= height)
+        return img;
+
+    // the image might be edited in the meantime
+    if (mScaledSrcKey != img.cacheKey()) {
+        mScaledImgs.clear();
+        mScaledSrcKey = img.cacheKey();
+    }
+
+    for (int idx = 0; idx < mScaledImgs.size(); idx++) {
+        if (mScaledImgs[idx].first == height) {
+            mScaledImgs.move(idx, 0);
+            return mScaledImgs.first().second;
+        }
+    }
+
+    if (!mScaleWatcher.isRunning()) {
+        mScaleHeight = height;
+        mScaleJobSrcKey = img.cacheKey();
+        mScaleWatcher.setFuture(QtConcurrent::run(&nmc::DkImageContainerT::scaleToHeight, img, height));
+    } else if (mScaleHeight != height)
+        mNextScaleHeight = height; // scaled once the current one is done
+
+    return QImage();
+}
+
+QImage DkImageContainerT::scaleToHeight(const QImage &img, int height)
+{
+    QSize s(qMax(qRound(img.width() * (double)height / img.height()), 1), height);
+    return DkImage::resizeImage(img, s, 1.0, DkImage::ipl_area, false);
+}
+
+void DkImageContainerT::scaledImageComputed()
+{
+    int nextHeight = mNextScaleHeight;
+    mNextScaleHeight = 0;
+
+    // the image was released while we were scaling
+    if (!hasImage())
+        return;
+
+    QImage sImg = mScaleWatcher.result();
+
+    // the image was edited while we were scaling - scale the edited image again
+    if (pixmap().cacheKey() != mScaleJobSrcKey)
+        scaledImage(mScaleHeight);
+    else if (!sImg.isNull()) {
+        mScaledImgs.prepend(qMakePair(mScaleHeight, sImg));
+
+        while (mScaledImgs.size() > 3)
+            mScaledImgs.removeLast();
+    }
+
+    if (nextHeight > 0)
+        scaledImage(nextHeight);
+
+    emit scaledImageReady();
+}
+
 void DkImageContainerT::undo()
 {
     DkImageContainer::undo();
@@ -1098,4 +1503,496 @@ void DkImageContainerT::setHistoryIndex(int idx)
     emit imageUpdatedSignal();
 }
 
+// DkFileWatcher --------------------------------------------------------------------
+DkFileWatcher::DkFileWatcher(QObject *parent)
+    : QObject(parent)
+{
+    // files are reloaded once they did not change for this period
+    mDebounceTimer.setSingleShot(true);
+    mDebounceTimer.setInterval(300);
+
+    mPollTimer.setInterval(1000);
+
+    connect(&mWatcher, SIGNAL(fileChanged(const QString &)), this, SLOT(fileChanged(const QString &)));
+    connect(&mDebounceTimer, SIGNAL(timeout()), this, SLOT(checkPending()));
+    connect(&mPollTimer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+DkFileWatcher &DkFileWatcher::instance()
+{
+    // the application owns the watcher - so its timers are not destroyed after the application
+    static QPointer<DkFileWatcher> inst;
+
+    if (!inst)
+        inst = new DkFileWatcher(QCoreApplication::instance());
+
+    return *inst;
+}
+
+/**
+ * Starts watching the file of an image.
+ * Several images (e.g. in different tabs) can watch the same file.
+ * @param img the image to be notified if its file changes.
+ **/
+void DkFileWatcher::watch(DkImageContainerT *img)
+{
+    if (!img)
+        return;
+
+    QString fp = img->filePath();
+
+#ifdef WITH_QUAZIP
+    if (img->isFromZip() && img->getZipData())
+        fp = img->getZipData()->getZipFilePath();
+#endif
+
+    if (mPaths.contains(img) && mPaths.value(img) == fp)
+        return;
+
+    unwatch(img);
+
+    if (fp.isEmpty() || !QFileInfo::exists(fp))
+        return;
+
+    bool watched = mImages.contains(fp);
+    mPaths.insert(img, fp);
+    mImages.insert(fp, img);
+
+    if (watched)
+        return;
+
+    if (needsPolling(fp) || !mWatcher.addPath(fp)) {
+        mPolled.insert(fp, fileState(fp));
+
+        if (!mPollTimer.isActive())
+            mPollTimer.start();
+
+        qDebug() << "[DkFileWatcher] no change events for" << fp << "- polling";
+    }
+}
+
+void DkFileWatcher::unwatch(DkImageContainerT *img)
+{
+    if (!mPaths.contains(img))
+        return;
+
+    QString fp = mPaths.take(img);
+    mImages.remove(fp, img);
+
+    // still watched by another image
+    if (mImages.contains(fp))
+        return;
+
+    if (!mPolled.remove(fp) && mWatcher.files().contains(fp))
+        mWatcher.removePath(fp);
+
+    mPending.remove(fp);
+
+    if (mPolled.isEmpty())
+        mPollTimer.stop();
+}
+
+/**
+ * Checks the image's file again after the debounce interval.
+ * This is needed if the file could not be read (e.g. it is still written).
+ **/
+void DkFileWatcher::recheck(DkImageContainerT *img)
+{
+    if (mPaths.contains(img))
+        fileChanged(mPaths.value(img));
+}
+
+void DkFileWatcher::fileChanged(const QString &filePath)
+{
+    if (!mImages.contains(filePath))
+        return;
+
+    mPending.insert(filePath, fileState(filePath));
+    mDebounceTimer.start();
+}
+
+void DkFileWatcher::checkPending()
+{
+    // notifying images might change our state
+    QHash<QString, FileState> pending = mPending;
+    mPending.clear();
+
+    for (auto it = pending.constBegin(); it != pending.constEnd(); it++) {
+        const QString &fp = it.key();
+        FileState cs = fileState(fp);
+
+        // the file is still written - wait for the next round
+        if (cs != it.value()) {
+            mPending.insert(fp, cs);
+            continue;
+        }
+
+        if (mPolled.contains(fp))
+            mPolled[fp] = cs;
+        // files that are replaced (e.g. atomic saves) are removed from the watcher
+        else if (cs.exists && !mWatcher.files().contains(fp))
+            mWatcher.addPath(fp);
+
+        for (DkImageContainerT *img : mImages.values(fp))
+            img->checkForFileUpdates();
+    }
+
+    if (!mPending.isEmpty())
+        mDebounceTimer.start();
+}
+
+void DkFileWatcher::poll()
+{
+    for (auto it = mPolled.begin(); it != mPolled.end(); it++) {
+        FileState cs = fileState(it.key());
+
+        if (cs != it.value()) {
+            it.value() = cs;
+            mPending.insert(it.key(), cs);
+            mDebounceTimer.start();
+        }
+    }
+}
+
+DkFileWatcher::FileState DkFileWatcher::fileState(const QString &filePath)
+{
+    QFileInfo fi(filePath);
+
+    FileState s;
+    s.exists = fi.exists();
+
+    if (s.exists) {
+        s.size = fi.size();
+        s.modified = fi.lastModified();
+    }
+
+    return s;
+}
+
+bool DkFileWatcher::needsPolling(const QString &filePath)
+{
+    // changes of other clients are not reported on network file systems
+    static const QStringList remoteFs = QStringList() << "nfs"
+                                                      << "nfs4"
+                                                      << "cifs"
+                                                      << "smbfs"
+                                                      << "smb2"
+                                                      << "fuse.sshfs"
+                                                      << "9p"
+                                                      << "afpfs"
+                                                      << "davfs";
+
+    if (filePath.startsWith("//") || filePath.startsWith("\\\\"))
+        return true;
+
+    QStorageInfo si(QFileInfo(filePath).absolutePath());
+    return remoteFs.contains(QString::fromLatin1(si.fileSystemType()).toLower());
+}
+
+bool DkFileWatcher::FileState::operator!=(const FileState &o) const
+{
+    return exists != o.exists || size != o.size || modified != o.modified;
+}
+
+// DkImageCache --------------------------------------------------------------------
+DkImageCache::DkImageCache()
+{
+}
+
+DkImageCache &DkImageCache::instance()
+{
+    static DkImageCache inst;
+    return inst;
+}
+
+/**
+ * Returns the key of a file.
+ * @param filePath the file path
+ * @return QString the canonical path and modification date - empty if the file does not exist
+ **/
+QString DkImageCache::cacheKey(const QString &filePath)
+{
+    QFileInfo fi(filePath);
+    QString cp = fi.canonicalFilePath();
+
+    if (cp.isEmpty())
+        return QString();
+
+    return cp + "|" + QString::number(fi.lastModified().toMSecsSinceEpoch());
+}
+
+/**
+ * Adds a decoded image to the cache.
+ * If another owner already cached the image, its copy is returned
+ * so that the caller can drop its own copy.
+ * @param owner the owner (e.g. the image container)
+ * @param consumer the consumer the owner belongs to (e.g. the tab name)
+ * @param key the key (see cacheKey)
+ * @param img the decoded image
+ * @return QImage the shared image
+ **/
+QImage DkImageCache::insertImage(const void *owner, const QString &consumer, const QString &key, const QImage &img)
+{
+    QMutexLocker locker(&mMutex);
+
+    Entry *e = insert(kind_image, owner, consumer, key);
+
+    if (!e)
+        return img;
+
+    if (e->image.isNull())
+        e->image = img;
+
+    return e->image;
+}
+
+/**
+ * Adds a file buffer to the cache.
+ * @param owner the owner (e.g. the image container)
+ * @param consumer the consumer the owner belongs to (e.g. the tab name)
+ * @param key the key (see cacheKey)
+ * @param buffer the file buffer
+ * @return QSharedPointer<QByteArray> the shared buffer
+ **/
+QSharedPointer<QByteArray> DkImageCache::insertBuffer(const void *owner, const QString &consumer, const QString &key, QSharedPointer<QByteArray> buffer)
+{
+    QMutexLocker locker(&mMutex);
+
+    Entry *e = insert(kind_buffer, owner, consumer, key);
+
+    if (!e || !buffer || buffer->isEmpty())
+        return buffer;
+
+    if (!e->buffer || e->buffer->isEmpty())
+        e->buffer = buffer;
+
+    return e->buffer;
+}
+
+/**
+ * Adds a thumbnail to the cache.
+ * Thumbnails are accounted to the consumer "Thumbnails".
+ * @param owner the thumbnail
+ * @param key the key - it should contain the thumbnail size
+ * @param img the thumbnail image
+ * @return QImage the shared thumbnail
+ **/
+QImage DkImageCache::insertThumb(const void *owner, const QString &key, const QImage &img)
+{
+    QMutexLocker locker(&mMutex);
+
+    Entry *e = insert(kind_thumb, owner, QObject::tr("Thumbnails"), key);
+
+    if (!e)
+        return img;
+
+    if (e->image.isNull())
+        e->image = img;
+
+    return e->image;
+}
+
+QImage DkImageCache::image(const QString &key) const
+{
+    QMutexLocker locker(&mMutex);
+    return mEntries[kind_image].value(key).image;
+}
+
+QSharedPointer<QByteArray> DkImageCache::buffer(const QString &key) const
+{
+    QMutexLocker locker(&mMutex);
+    return mEntries[kind_buffer].value(key).buffer;
+}
+
+QImage DkImageCache::thumb(const QString &key) const
+{
+    QMutexLocker locker(&mMutex);
+    return mEntries[kind_thumb].value(key).image;
+}
+
+void DkImageCache::releaseImage(const void *owner)
+{
+    QMutexLocker locker(&mMutex);
+    release(kind_image, owner);
+}
+
+void DkImageCache::releaseBuffer(const void *owner)
+{
+    QMutexLocker locker(&mMutex);
+    release(kind_buffer, owner);
+}
+
+void DkImageCache::releaseThumb(const void *owner)
+{
+    QMutexLocker locker(&mMutex);
+    release(kind_thumb, owner);
+}
+
+/**
+ * Releases everything the owner references.
+ * Call this before the owner is deleted.
+ * @param owner the owner
+ **/
+void DkImageCache::release(const void *owner)
+{
+    QMutexLocker locker(&mMutex);
+
+    for (int idx = 0; idx < kind_end; idx++)
+        release(idx, owner);
+}
+
+/**
+ * Changes the consumer an owner's entries are accounted to.
+ * @param owner the owner
+ * @param consumer the new consumer
+ **/
+void DkImageCache::setConsumer(const void *owner, const QString &consumer)
+{
+    QMutexLocker locker(&mMutex);
+
+    for (int idx = 0; idx < kind_end; idx++) {
+        auto kIt = mKeys[idx].constFind(owner);
+
+        if (kIt == mKeys[idx].constEnd())
+            continue;
+
+        auto eIt = mEntries[idx].find(kIt.value());
+
+        if (eIt != mEntries[idx].end())
+            eIt->owners.insert(owner, consumer);
+    }
+}
+
+/**
+ * Returns the memory of all cached images, buffers and thumbnails.
+ * Entries that are shared by several owners are counted once.
+ * @return float the memory in MB
+ **/
+float DkImageCache::memoryUsage() const
+{
+    QMutexLocker locker(&mMutex);
+
+    qint64 bytes = 0;
+
+    for (int idx = 0; idx < kind_end; idx++) {
+        for (const Entry &e : mEntries[idx])
+            bytes += e.bytes();
+    }
+
+    return bytes / (1024.0f * 1024.0f);
+}
+
+/**
+ * Returns the memory of images and buffers that are not referenced by the consumer.
+ * This is the part of the global cache budget that is occupied by other tabs.
+ * Thumbnails are not counted since they have their own budget.
+ * @param consumer the consumer
+ * @return float the memory in MB
+ **/
+float DkImageCache::foreignMemoryUsage(const QString &consumer) const
+{
+    QMutexLocker locker(&mMutex);
+
+    qint64 bytes = 0;
+
+    for (int idx = kind_image; idx <= kind_buffer; idx++) {
+        for (const Entry &e : mEntries[idx]) {
+            if (!e.owners.values().contains(consumer))
+                bytes += e.bytes();
+        }
+    }
+
+    return bytes / (1024.0f * 1024.0f);
+}
+
+/**
+ * Returns the memory that is referenced by each consumer.
+ * Entries that are shared are accounted to every consumer that references them.
+ * @return QMap<QString, float> the memory in MB per consumer
+ **/
+QMap<QString, float> DkImageCache::consumerUsage() const
+{
+    QMutexLocker locker(&mMutex);
+
+    QMap<QString, float> usage;
+
+    for (int idx = 0; idx < kind_end; idx++) {
+        for (const Entry &e : mEntries[idx]) {
+            float mem = e.bytes() / (1024.0f * 1024.0f);
+
+            QStringList consumers = e.owners.values();
+            consumers.removeDuplicates();
+
+            for (const QString &c : consumers)
+                usage[c] += mem;
+        }
+    }
+
+    return usage;
+}
+
+/**
+ * Returns a human readable summary of the cache usage.
+ * @return QString e.g. "120 MB (Tab 1: 80 MB, Tab 2: 60 MB)"
+ **/
+QString DkImageCache::usageString() const
+{
+    QMap<QString, float> usage = consumerUsage();
+    QStringList consumers;
+
+    for (auto it = usage.constBegin(); it != usage.constEnd(); it++)
+        consumers << QString("%1: %2 MB").arg(it.key()).arg(qRound(it.value()));
+
+    QString s = QString("%1 MB").arg(qRound(memoryUsage()));
+
+    if (!consumers.isEmpty())
+        s += " (" + consumers.join(", ") + ")";
+
+    return s;
+}
+
+DkImageCache::Entry *DkImageCache::insert(int kind, const void *owner, const QString &consumer, const QString &key)
+{
+    if (!owner || key.isEmpty())
+        return 0;
+
+    if (mKeys[kind].value(owner) != key) {
+        release(kind, owner);
+        mKeys[kind].insert(owner, key);
+    }
+
+    Entry *e = &mEntries[kind][key];
+    e->owners.insert(owner, consumer);
+
+    return e;
+}
+
+void DkImageCache::release(int kind, const void *owner)
+{
+    if (!mKeys[kind].contains(owner))
+        return;
+
+    QString key = mKeys[kind].take(owner);
+    auto it = mEntries[kind].find(key);
+
+    if (it == mEntries[kind].end())
+        return;
+
+    it->owners.remove(owner);
+
+    // nobody needs it anymore
+    if (it->owners.isEmpty())
+        mEntries[kind].erase(it);
+}
+
+qint64 DkImageCache::Entry::bytes() const
+{
+    qint64 b = image.sizeInBytes();
+
+    if (buffer)
+        b += buffer->size();
+
+    return b;
+}
+
 }
@@ -28,7 +28,14 @@
 #pragma once
 
 #pragma warning(push, 0) // no warnings from includes - begin
+#include <QDateTime>
+#include <QFileSystemWatcher>
 #include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QMap>
+#include <QMultiHash>
+#include <QMutex>
 #include <QSharedPointer>
 #include <QTimer>
 #pragma warning(pop) // no warnings from includes - end
@@ -52,6 +59,7 @@ namespace nmc
 
 // nomacs defines
 class DkBasicLoader;
+class DkSaveOutput;
 class DkMetaDataT;
 class DkZipContainer;
 class FileDownloader;
@@ -96,6 +104,7 @@ public:
     void setEdited(bool edited = true);
     QString getTitleAttribute() const;
     float getMemoryUsage() const;
+    float getBufferMemoryUsage() const;
     float getFileSize() const;
 
     virtual QSharedPointer<DkBasicLoader> getLoader();
@@ -121,6 +130,7 @@ public:
     void setMetaData(const QString &editName);
     bool saveImage(const QString &filePath, const QImage saveImg, int compression = -1);
     bool saveImage(const QString &filePath, int compression = -1);
+    QStringList saveImages(const QVector<DkSaveOutput> &outputs);
     void saveMetaData();
     virtual void clear();
     virtual void undo();
@@ -174,6 +184,10 @@ public:
     void fetchFile();
     void cancel();
     void clear() override;
+    bool releaseImage();
+    bool releaseFileBuffer();
+    void setCacheConsumer(const QString &consumer);
+    bool setDecodeSize(const QSize &size);
     void receiveUpdates(QObject *obj, bool connectSignals = true);
     void downloadFile(const QUrl &url);
 
@@ -183,6 +197,7 @@ public:
     void saveMetaDataThreaded(const QString &filePath);
     void saveMetaDataThreaded();
     bool isFileDownloaded() const;
+    QImage scaledImage(int height);
 
     virtual QSharedPointer<DkBasicLoader> getLoader() override;
     virtual QSharedPointer<DkThumbNailT> getThumb() override;
@@ -199,6 +214,7 @@ signals:
     void errorDialogSignal(const QString &msg) const;
     void thumbLoadedSignal(bool loaded = true) const;
     void imageUpdatedSignal() const;
+    void scaledImageReady() const;
 
 public slots:
     void checkForFileUpdates();
@@ -209,19 +225,24 @@ protected slots:
     void savingFinished();
     void loadingFinished();
     void fileDownloaded(const QString &filePath);
+    void scaledImageComputed();
 
 protected:
     void fetchImage();
 
     QSharedPointer<QByteArray> loadFileToBuffer(const QString &filePath);
     QSharedPointer<DkBasicLoader> loadImageIntern(const QString &filePath, QSharedPointer<DkBasicLoader> loader, const QSharedPointer<QByteArray> fileBuffer);
+    QSharedPointer<DkBasicLoader>
+    adoptImageIntern(const QString &filePath, QSharedPointer<DkBasicLoader> loader, const QSharedPointer<QByteArray> fileBuffer, const QImage img);
     QString saveImageIntern(const QString &filePath, QSharedPointer<DkBasicLoader> loader, QImage saveImg, int compression);
     void saveMetaDataIntern(const QString &filePath, QSharedPointer<DkBasicLoader> loader, QSharedPointer<QByteArray> fileBuffer);
+    static QImage scaleToHeight(const QImage &img, int height);
 
     QFutureWatcher<QSharedPointer<QByteArray>> mBufferWatcher;
     QFutureWatcher<QSharedPointer<DkBasicLoader>> mImageWatcher;
     QFutureWatcher<QString> mSaveImageWatcher;
     QFutureWatcher<bool> mSaveMetaDataWatcher;
+    QFutureWatcher<QImage> mScaleWatcher;
 
     QSharedPointer<FileDownloader> mFileDownloader;
 
@@ -239,7 +260,130 @@ protected:
     bool mFetchingBuffer = false;
     bool mDownloaded = false;
 
-    QTimer mFileUpdateTimer;
+    QString mCacheKey; // see DkImageCache
+    QString mCacheConsumer;
+
+    QList<QPair<int, QImage>> mScaledImgs; // see scaledImage (height, image) - most recently used first
+    qint64 mScaledSrcKey = 0; // source of mScaledImgs
+    qint64 mScaleJobSrcKey = 0; // source of the image that is currently scaled
+    int mScaleHeight = 0; // height that is currently scaled
+    int mNextScaleHeight = 0; // height that was requested while scaling
+
+    QSize mDecodeSize; // see setDecodeSize
+};
+
+DllCoreExport bool sortImageContainers(QVector<QSharedPointer<DkImageContainerT>> &images);
+DllCoreExport QVector<int> insertImageContainers(QVector<QSharedPointer<DkImageContainerT>> &images, const QVector<QSharedPointer<DkImageContainerT>> &newImages);
+
+/**
+ * Watches the files of all selected images (of all tabs).
+ * One QFileSystemWatcher is shared by all containers. Files on
+ * network shares (which do not deliver change events) are polled.
+ * Containers are only notified once a file stopped changing,
+ * so that images are not reloaded while they are written.
+ **/
+class DllCoreExport DkFileWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DkFileWatcher &instance();
+
+    void watch(DkImageContainerT *img);
+    void unwatch(DkImageContainerT *img);
+    void recheck(DkImageContainerT *img);
+
+protected slots:
+    void fileChanged(const QString &filePath);
+    void checkPending();
+    void poll();
+
+private:
+    DkFileWatcher(QObject *parent = 0);
+    DkFileWatcher(const DkFileWatcher &);
+
+    struct FileState {
+        bool exists = false;
+        qint64 size = -1;
+        QDateTime modified;
+
+        bool operator!=(const FileState &o) const;
+    };
+
+    static FileState fileState(const QString &filePath);
+    static bool needsPolling(const QString &filePath);
+
+    QFileSystemWatcher mWatcher;
+    QTimer mDebounceTimer;
+    QTimer mPollTimer;
+
+    QHash<DkImageContainerT *, QString> mPaths;
+    QMultiHash<QString, DkImageContainerT *> mImages;
+    QHash<QString, FileState> mPolled;
+    QHash<QString, FileState> mPending;
+};
+
+/**
+ * Shares decoded images, file buffers and thumbnails between all loaders
+ * (tabs, viewports, thumbnail previews and the film strip).
+ * Entries are keyed by the canonical file path and its modification date,
+ * hence files that changed on disk are never served from the cache.
+ * Each entry is referenced by its owners (e.g. image containers) and dropped
+ * once the last owner released it. Since QImages are implicitly shared, an
+ * image that is open in several tabs is kept in memory only once.
+ * The cache can be used from any thread.
+ **/
+class DllCoreExport DkImageCache
+{
+public:
+    static DkImageCache &instance();
+    static QString cacheKey(const QString &filePath);
+
+    QImage insertImage(const void *owner, const QString &consumer, const QString &key, const QImage &img);
+    QSharedPointer<QByteArray> insertBuffer(const void *owner, const QString &consumer, const QString &key, QSharedPointer<QByteArray> buffer);
+    QImage insertThumb(const void *owner, const QString &key, const QImage &img);
+
+    QImage image(const QString &key) const;
+    QSharedPointer<QByteArray> buffer(const QString &key) const;
+    QImage thumb(const QString &key) const;
+
+    void releaseImage(const void *owner);
+    void releaseBuffer(const void *owner);
+    void releaseThumb(const void *owner);
+    void release(const void *owner);
+    void setConsumer(const void *owner, const QString &consumer);
+
+    float memoryUsage() const;
+    float foreignMemoryUsage(const QString &consumer) const;
+    QMap<QString, float> consumerUsage() const;
+    QString usageString() const;
+
+private:
+    DkImageCache();
+    DkImageCache(const DkImageCache &);
+
+    enum Kind {
+        kind_image = 0,
+        kind_buffer,
+        kind_thumb,
+
+        kind_end
+    };
+
+    struct Entry {
+        QImage image;
+        QSharedPointer<QByteArray> buffer;
+        QHash<const void *, QString> owners; // owner -> consumer
+
+        qint64 bytes() const;
+    };
+
+    Entry *insert(int kind, const void *owner, const QString &consumer, const QString &key);
+    void release(int kind, const void *owner);
+
+    mutable QMutex mMutex;
+    QHash<QString, Entry> mEntries[kind_end];
+    QHash<const void *, QString> mKeys[kind_end]; // owner -> key
 };
 
 }
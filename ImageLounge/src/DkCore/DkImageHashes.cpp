@@ -0,0 +1,450 @@
+/*******************************************************************************************************
+ DkImageHashes.cpp
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkImageHashes.h"
+#include "DkImageStorage.h"
+#include "DkSettings.h"
+#include "DkThumbs.h"
+#include "DkTimer.h"
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QDebug>
+#include <QImage>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QtAlgorithms>
+#include <qmath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+#pragma warning(pop) // no warnings from includes - end
+
+namespace nmc
+{
+
+// DkImageHash --------------------------------------------------------------------
+/**
+ * Computes the pHash and the dHash of an image.
+ * pHash: the 8x8 lowest frequencies of the DCT of a 32x32 gray image are compared to their median.
+ * dHash: neighboring pixels of a 9x8 gray image are compared.
+ * @param img the image (typically its thumbnail).
+ * @return the hash - invalid if the image is empty.
+ **/
+DkImageHash DkImageHash::compute(const QImage &img)
+{
+    DkImageHash h;
+
+    if (img.isNull())
+        return h;
+
+    const int ps = 32;
+    const int nf = 8;
+
+    QImage im = img.scaled(ps, ps, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).convertToFormat(QImage::Format_RGB32);
+    QImage imd = im.scaled(nf + 1, nf, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    // pHash - the DCT basis is computed once (thread-safe static initialization)
+    static const std::vector<double> cosTable = [&]() {
+        std::vector<double> t(nf * ps);
+        for (int u = 0; u < nf; u++)
+            for (int x = 0; x < ps; x++)
+                t[u * ps + x] = std::cos((2 * x + 1) * u * M_PI / (2.0 * ps));
+        return t;
+    }();
+
+    double gray[ps][ps];
+
+    for (int y = 0; y < ps; y++) {
+        const QRgb *ptr = reinterpret_cast<const QRgb *>(im.constScanLine(y));
+
+        for (int x = 0; x < ps; x++)
+            gray[y][x] = qGray(ptr[x]);
+    }
+
+    // separable DCT - we only need the lowest frequencies
+    double rows[ps][nf];
+
+    for (int y = 0; y < ps; y++) {
+        for (int u = 0; u < nf; u++) {
+            double s = 0;
+            for (int x = 0; x < ps; x++)
+                s += cosTable[u * ps + x] * gray[y][x];
+            rows[y][u] = s;
+        }
+    }
+
+    double dct[nf * nf];
+
+    for (int v = 0; v < nf; v++) {
+        for (int u = 0; u < nf; u++) {
+            double s = 0;
+            for (int y = 0; y < ps; y++)
+                s += cosTable[v * ps + y] * rows[y][u];
+            dct[v * nf + u] = s;
+        }
+    }
+
+    // the DC term only encodes the brightness
+    std::vector<double> ac(dct + 1, dct + nf * nf);
+    std::nth_element(ac.begin(), ac.begin() + ac.size() / 2, ac.end());
+    double median = ac[ac.size() / 2];
+
+    for (int idx = 1; idx < nf * nf; idx++) {
+        if (dct[idx] > median)
+            h.pHash |= (quint64)1 << idx;
+    }
+
+    // dHash
+    for (int y = 0; y < nf; y++) {
+        const QRgb *ptr = reinterpret_cast<const QRgb *>(imd.constScanLine(y));
+
+        for (int x = 0; x < nf; x++) {
+            if (qGray(ptr[x]) < qGray(ptr[x + 1]))
+                h.dHash |= (quint64)1 << (y * nf + x);
+        }
+    }
+
+    h.valid = true;
+
+    return h;
+}
+
+bool DkImageHash::isValid() const
+{
+    return valid;
+}
+
+/**
+ * Returns the Hamming distance of the pHashes.
+ **/
+int DkImageHash::distance(const DkImageHash &o) const
+{
+    return (int)qPopulationCount(pHash ^ o.pHash);
+}
+
+/**
+ * Two images are similar if their pHashes are close.
+ * The dHash is checked too since it rejects images with a similar layout but different gradients.
+ * @param o the other hash.
+ * @param maxDistance the maximal pHash distance.
+ * @return bool true if both hashes are valid and similar.
+ **/
+bool DkImageHash::isSimilar(const DkImageHash &o, int maxDistance) const
+{
+    if (!valid || !o.valid)
+        return false;
+
+    return distance(o) <= maxDistance && (int)qPopulationCount(dHash ^ o.dHash) <= 2 * maxDistance;
+}
+
+QDataStream &operator<<(QDataStream &s, const DkImageHash &hash)
+{
+    s << hash.pHash << hash.dHash << hash.valid;
+    return s;
+}
+
+QDataStream &operator>>(QDataStream &s, DkImageHash &hash)
+{
+    s >> hash.pHash >> hash.dHash >> hash.valid;
+    return s;
+}
+
+// DkHashIndex --------------------------------------------------------------------
+DkHashIndex::DkHashIndex(const QVector<quint64> &hashes)
+    : mHashes(hashes)
+{
+    for (int bIdx = 0; bIdx < num_blocks; bIdx++) {
+        // counting sort of all hashes by their block value
+        QVector<int> &offsets = mOffsets[bIdx];
+        offsets = QVector<int>(65536 + 1, 0);
+
+        for (quint64 h : mHashes)
+            offsets[block(h, bIdx) + 1]++;
+
+        for (int idx = 1; idx < offsets.size(); idx++)
+            offsets[idx] += offsets[idx - 1];
+
+        QVector<int> pos = offsets;
+        QVector<int> &ids = mIds[bIdx];
+        ids.resize(mHashes.size());
+
+        for (int idx = 0; idx < mHashes.size(); idx++)
+            ids[pos[block(mHashes[idx], bIdx)]++] = idx;
+    }
+}
+
+quint16 DkHashIndex::block(quint64 hash, int bIdx)
+{
+    return (quint16)(hash >> (bIdx * 16));
+}
+
+int DkHashIndex::size() const
+{
+    return mHashes.size();
+}
+
+/**
+ * Finds all hashes within a Hamming distance.
+ * @param hash the query.
+ * @param maxDistance the maximal distance - it is clamped to max_distance.
+ * @param candidates the ids of all hashes with distance <= maxDistance (sorted).
+ **/
+void DkHashIndex::find(quint64 hash, int maxDistance, QVector<int> &candidates) const
+{
+    candidates.clear();
+
+    if (mHashes.empty())
+        return;
+
+    maxDistance = qBound(0, maxDistance, (int)max_distance);
+    int radius = maxDistance / num_blocks;
+
+    for (int bIdx = 0; bIdx < num_blocks; bIdx++) {
+        const QVector<int> &offsets = mOffsets[bIdx];
+        const QVector<int> &ids = mIds[bIdx];
+
+        auto visit = [&](quint16 key) {
+            for (int idx = offsets[key]; idx < offsets[key + 1]; idx++) {
+                int id = ids[idx];
+
+                if ((int)qPopulationCount(mHashes[id] ^ hash) <= maxDistance)
+                    candidates << id;
+            }
+        };
+
+        quint16 q = block(hash, bIdx);
+        visit(q);
+
+        for (int i = 0; i < 16 && radius > 0; i++) {
+            quint16 qi = q ^ (quint16)(1 << i);
+            visit(qi);
+
+            for (int j = i + 1; j < 16 && radius > 1; j++)
+                visit(qi ^ (quint16)(1 << j));
+        }
+    }
+
+    // hashes are found in every block they match
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+}
+
+// DkImageHashTask --------------------------------------------------------------------
+/**
+ * Computes the thumbnail of an image - which hashes it.
+ * The pending state is released when the task is deleted - also if it
+ * was removed from the pool before it could run.
+ **/
+class DkImageHashTask : public QRunnable
+{
+public:
+    DkImageHashTask(const QString &filePath, const QString &key)
+        : mFilePath(filePath)
+        , mKey(key)
+    {
+    }
+
+    ~DkImageHashTask()
+    {
+        DkImageHashes::instance().release(mKey);
+    }
+
+    void run() override
+    {
+        QImage thumb;
+
+        try {
+            thumb = DkThumbNail::computeIntern(mFilePath, QSharedPointer<QByteArray>(), DkThumbNail::do_not_force, max_thumb_size);
+        } catch (...) {
+            qWarning() << "[DkImageHashes] could not load" << mFilePath;
+        }
+
+        // failed images are kept too - so that we do not try again
+        if (thumb.isNull())
+            DkImageHashes::instance().insert(mKey, DkImageHash());
+    }
+
+protected:
+    QString mFilePath;
+    QString mKey;
+};
+
+// DkImageHashes --------------------------------------------------------------------
+DkImageHashes::DkImageHashes()
+    : DkFileCacheT<DkImageHash>("DkImageHashes", "hashes.cache", 200000)
+{
+}
+
+DkImageHashes::~DkImageHashes()
+{
+}
+
+DkImageHashes &DkImageHashes::instance()
+{
+    static DkImageHashes inst;
+    return inst;
+}
+
+/**
+ * Returns true if similar images are currently grouped or collapsed.
+ **/
+bool DkImageHashes::isNeeded()
+{
+    return DkSettingsManager::param().display().groupSimilarThumbs || DkSettingsManager::param().display().collapseBursts;
+}
+
+/**
+ * Groups similar images.
+ * Similar pairs are found with a multi-index search (in parallel) and merged
+ * transitively - so a burst that slowly pans ends up in one group.
+ * @param hashes the hashes of all images.
+ * @param maxDistance the maximal pHash distance of similar images.
+ * @return QVector<int> the group of each image which is the index of the group's first image.
+ **/
+QVector<int> DkImageHashes::group(const QVector<DkImageHash> &hashes, int maxDistance)
+{
+    DkTimer dt;
+
+    QVector<int> groups(hashes.size());
+    QVector<int> validIdx;
+    QVector<quint64> pHashes;
+
+    for (int idx = 0; idx < hashes.size(); idx++) {
+        groups[idx] = idx;
+
+        if (hashes[idx].isValid()) {
+            validIdx << idx;
+            pHashes << hashes[idx].pHash;
+        }
+    }
+
+    if (validIdx.size() < 2)
+        return groups;
+
+    DkHashIndex index(pHashes);
+
+    int numBands = validIdx.size() > 2000 ? 2 * QThread::idealThreadCount() : 1;
+    std::vector<std::vector<std::pair<int, int>>> edges(qMax(numBands, 1));
+
+    DkImage::mapRowBands(validIdx.size(), numBands, [&](int band, int from, int to) {
+        QVector<int> candidates;
+
+        for (int li = from; li < to; li++) {
+            const DkImageHash &h = hashes[validIdx[li]];
+            index.find(h.pHash, maxDistance, candidates);
+
+            for (int lj : candidates) {
+                if (lj > li && h.isSimilar(hashes[validIdx[lj]], maxDistance))
+                    edges[band].push_back(std::make_pair(li, lj));
+            }
+        }
+    });
+
+    // union-find - the root is always the first image of a group
+    QVector<int> parent(validIdx.size());
+    for (int idx = 0; idx < parent.size(); idx++)
+        parent[idx] = idx;
+
+    auto root = [&](int idx) {
+        while (parent[idx] != idx) {
+            parent[idx] = parent[parent[idx]];
+            idx = parent[idx];
+        }
+        return idx;
+    };
+
+    int numEdges = 0;
+    for (const auto &be : edges) {
+        for (const auto &e : be) {
+            int ra = root(e.first);
+            int rb = root(e.second);
+
+            if (ra != rb)
+                parent[qMax(ra, rb)] = qMin(ra, rb);
+        }
+        numEdges += (int)be.size();
+    }
+
+    for (int li = 0; li < validIdx.size(); li++)
+        groups[validIdx[li]] = validIdx[root(li)];
+
+    qDebug() << "[DkImageHashes]" << hashes.size() << "images grouped (" << numEdges << "similar pairs) in" << dt;
+
+    return groups;
+}
+
+/**
+ * Returns the hash of a file.
+ * @param fileInfo the file - its modification date must match the hashed file.
+ * @return the hash or an invalid hash if the file was not hashed yet.
+ **/
+DkImageHash DkImageHashes::hash(const QFileInfo &fileInfo)
+{
+    return value(fileInfo);
+}
+
+/**
+ * Hashes a freshly computed thumbnail (if the file is not hashed yet).
+ * This is called from the thumbnail threads.
+ * @param fileInfo the image file.
+ * @param thumb its thumbnail.
+ **/
+void DkImageHashes::addThumbnail(const QFileInfo &fileInfo, const QImage &thumb)
+{
+    if (thumb.isNull())
+        return;
+
+    QString k = key(fileInfo);
+
+    if (!contains(k))
+        insert(k, DkImageHash::compute(thumb));
+}
+
+/**
+ * Queues all files that are not hashed yet.
+ * Hashes are computed with the lowest priority on the thumbnail pool.
+ * @param files the files to be hashed (in the order they should be hashed).
+ **/
+void DkImageHashes::request(const QList<QFileInfo> &files)
+{
+    QList<QPair<QString, QString>> queued = queue(files);
+
+    if (queued.empty())
+        return;
+
+    qInfo() << "[DkImageHashes] hashing" << queued.size() << "images";
+
+    // thumbnails use priorities <= 0 - they always come first
+    for (const QPair<QString, QString> &q : queued)
+        DkThumbsThreadPool::pool()->start(new DkImageHashTask(q.first, q.second), std::numeric_limits<int>::min());
+}
+
+}
@@ -0,0 +1,137 @@
+/*******************************************************************************************************
+ DkImageHashes.h
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#include "DkFileCache.h"
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QVector>
+#pragma warning(pop) // no warnings from includes - end
+
+#pragma warning(disable : 4251) // TODO: remove
+
+#ifndef DllCoreExport
+#ifdef DK_CORE_DLL_EXPORT
+#define DllCoreExport Q_DECL_EXPORT
+#elif DK_DLL_IMPORT
+#define DllCoreExport Q_DECL_IMPORT
+#else
+#define DllCoreExport Q_DECL_IMPORT
+#endif
+#endif
+
+// Qt defines
+class QImage;
+
+namespace nmc
+{
+
+/**
+ * Perceptual hashes of an image.
+ * Near-duplicates (bursts, re-encoded or slightly cropped images) have hashes
+ * with a small Hamming distance.
+ **/
+class DllCoreExport DkImageHash
+{
+public:
+    enum {
+        // maximal pHash distance of similar images (out of 63 bits)
+        default_distance = 10,
+    };
+
+    static DkImageHash compute(const QImage &img);
+
+    bool isValid() const;
+    int distance(const DkImageHash &o) const;
+    bool isSimilar(const DkImageHash &o, int maxDistance = default_distance) const;
+
+    // low frequencies of the DCT (compared to their median)
+    quint64 pHash = 0;
+    // gradients of a 9x8 thumbnail
+    quint64 dHash = 0;
+    bool valid = false;
+};
+
+DllCoreExport QDataStream &operator<<(QDataStream &s, const DkImageHash &hash);
+DllCoreExport QDataStream &operator>>(QDataStream &s, DkImageHash &hash);
+
+/**
+ * Multi-index hashing for Hamming searches.
+ * The 64 bit hashes are split into 4 blocks of 16 bits. If two hashes differ
+ * in at most 4 * (r + 1) - 1 bits, at least one block differs in at most r bits.
+ * Hence, only buckets close to the query's blocks are visited instead of all hashes.
+ **/
+class DllCoreExport DkHashIndex
+{
+public:
+    enum {
+        num_blocks = 4,
+        max_distance = 11, // block radius 2
+    };
+
+    DkHashIndex(const QVector<quint64> &hashes = QVector<quint64>());
+
+    void find(quint64 hash, int maxDistance, QVector<int> &candidates) const;
+    int size() const;
+
+private:
+    static quint16 block(quint64 hash, int bIdx);
+
+    QVector<quint64> mHashes;
+    QVector<int> mOffsets[num_blocks];
+    QVector<int> mIds[num_blocks];
+};
+
+/**
+ * DkImageHashes keeps perceptual hashes of images for culling bursts.
+ * Hashes are computed whenever a thumbnail is created - so browsing a folder
+ * indexes it. Missing hashes are computed on the thumbnail pool with the lowest priority.
+ * Hashes are keyed by file path and modification date and persisted between sessions (see DkFileCache).
+ **/
+class DllCoreExport DkImageHashes : public DkFileCacheT<DkImageHash>
+{
+public:
+    static DkImageHashes &instance();
+    ~DkImageHashes();
+
+    // singleton
+    DkImageHashes(DkImageHashes const &) = delete;
+    void operator=(DkImageHashes const &) = delete;
+
+    static bool isNeeded();
+    static QVector<int> group(const QVector<DkImageHash> &hashes, int maxDistance = DkImageHash::default_distance);
+
+    DkImageHash hash(const QFileInfo &fileInfo);
+    void addThumbnail(const QFileInfo &fileInfo, const QImage &thumb);
+    void request(const QList<QFileInfo> &files);
+
+private:
+    DkImageHashes();
+};
+
+}
@@ -31,6 +31,8 @@
 #include "DkBasicLoader.h"
 #include "DkDialog.h"
 #include "DkImageContainer.h"
+#include "DkImageScores.h"
+#include "DkMetaDataIndex.h"
 #include "DkImageStorage.h"
 #include "DkMessageBox.h"
 #include "DkMetaData.h"
@@ -39,6 +41,7 @@
 #include "DkStatusBar.h"
 #include "DkThumbs.h"
 #include "DkTimer.h"
+#include "DkTrace.h"
 #include "DkUtils.h"
 
 #pragma warning(push, 0) // no warnings from includes - begin
@@ -46,6 +49,7 @@
 #include <QBuffer>
 #include <QByteArray>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QDesktopServices>
 #include <QDir>
@@ -65,6 +69,7 @@
 #include <QProgressDialog>
 #include <QReadLocker>
 #include <QReadWriteLock>
+#include <QSet>
 #include <QSettings>
 #include <QStandardPaths>
 #include <QStringBuilder>
@@ -74,6 +79,8 @@
 #include <QWidget>
 #include <QWriteLocker>
 #include <QtConcurrentRun>
+#include <algorithm>
+#include <limits>
 #include <qmath.h>
 
 // quazip
@@ -104,6 +111,327 @@
 namespace nmc
 {
 
+// DkImageCacher --------------------------------------------------------------------
+DkImageCacher::DkImageCacher()
+{
+    mConsumer = QObject::tr("Viewer");
+}
+
+/**
+ * Updates the navigation prediction.
+ * @param oldIdx the index of the previous image (-1 if unknown)
+ * @param newIdx the index of the new image
+ **/
+void DkImageCacher::navigated(int oldIdx, int newIdx)
+{
+    if (oldIdx == -1 || newIdx == -1 || oldIdx == newIdx) {
+        mNavigationTimer.invalidate();
+        return;
+    }
+
+    int step = newIdx - oldIdx;
+    mDirection = step > 0 ? 1 : -1;
+
+    // jumps (e.g. with the folder scrollbar) tell us the direction - but not the speed
+    if (qAbs(step) > 1 || !mNavigationTimer.isValid()) {
+        mStepsPerSecond *= 0.5f;
+    } else {
+        float sec = qMax(mNavigationTimer.elapsed() / 1000.0f, 0.01f);
+        mStepsPerSecond = 0.5f * mStepsPerSecond + 0.5f * (1.0f / sec);
+    }
+
+    mNavigationTimer.restart();
+}
+
+/**
+ * Counts cache hits and misses.
+ * Call this before the image is loaded.
+ * @param imgC the image that will be displayed next
+ **/
+void DkImageCacher::accessed(QSharedPointer<DkImageContainerT> imgC)
+{
+    if (!imgC)
+        return;
+
+    if (imgC->getLoadState() == DkImageContainer::loaded || imgC->getLoadState() == DkImageContainer::loading)
+        mHits++;
+    else if (imgC->getBufferMemoryUsage() > 0)
+        mBufferHits++;
+    else
+        mMisses++;
+}
+
+/**
+ * Sets the slideshow interval.
+ * @param sec the interval in seconds - 0 if the slideshow is stopped
+ **/
+void DkImageCacher::setSlideshowInterval(float sec)
+{
+    mSlideshowInterval = sec;
+
+    if (sec > 0)
+        mDirection = 1;
+}
+
+/**
+ * Sets the frame rate of frame sequences (e.g. drif dumps) that are played like videos.
+ * The frames are decoded at the display size and prefetched one second ahead.
+ * @param fps the target frame rate - 0 if no sequence is played
+ * @param decodeSize the size frames are displayed with
+ **/
+void DkImageCacher::setFrameSequence(float fps, const QSize &decodeSize)
+{
+    mFrameRate = fps;
+    mDecodeSize = decodeSize;
+
+    if (fps > 0)
+        mDirection = 1;
+}
+
+QSize DkImageCacher::decodeSize() const
+{
+    return mDecodeSize;
+}
+
+/**
+ * Resets the navigation prediction (e.g. if a new folder is opened).
+ **/
+void DkImageCacher::reset()
+{
+    mDirection = 1;
+    mStepsPerSecond = 0.0f;
+    mNavigationTimer.invalidate();
+}
+
+/**
+ * Sets the name the cached images are accounted to in the DkImageCache.
+ * @param consumer the consumer (e.g. the tab name)
+ **/
+void DkImageCacher::setConsumer(const QString &consumer)
+{
+    mConsumer = consumer;
+}
+
+QString DkImageCacher::consumer() const
+{
+    return mConsumer;
+}
+
+/**
+ * Returns the ratio of images that were decoded or buffered when they were requested.
+ * @return float the hit rate [0 1]
+ **/
+float DkImageCacher::hitRate() const
+{
+    int total = mHits + mBufferHits + mMisses;
+
+    return total > 0 ? (float)(mHits + mBufferHits) / total : 0.0f;
+}
+
+float DkImageCacher::stepsPerSecond() const
+{
+    float sps = mStepsPerSecond;
+
+    // the user stopped navigating - the speed decays
+    if (mNavigationTimer.isValid() && mNavigationTimer.elapsed() > 5000)
+        sps = 0.0f;
+
+    if (mSlideshowInterval > 0)
+        sps = qMax(sps, 1.0f / mSlideshowInterval);
+
+    if (mFrameRate > 0)
+        sps = qMax(sps, mFrameRate);
+
+    return sps;
+}
+
+/**
+ * Estimates how expensive it is to load the image again.
+ * RAW and TIFF files decode much slower than JPGs and large files are slower than small ones.
+ * @param imgC the image
+ * @return float the relative reload cost
+ **/
+float DkImageCacher::reloadCost(QSharedPointer<DkImageContainerT> imgC) const
+{
+    QString suffix = "*." + imgC->fileInfo().suffix().toLower();
+    float factor = 1.0f;
+
+    if (DkSettingsManager::param().app().rawFilters.join(" ").contains(suffix))
+        factor = 8.0f;
+    else if (QString("*.tif *.tiff *.psd *.exr *.hdr *.jp2 *.heic *.heif *.avif").contains(suffix))
+        factor = 4.0f;
+
+    return factor * (1.0f + imgC->fileInfo().size() / (1024.0f * 1024.0f));
+}
+
+/**
+ * Prefetches images that will be displayed soon and evicts images if the budget is exceeded.
+ * @param images the images of the current folder
+ * @param cIdx the index of the current image
+ **/
+void DkImageCacher::update(const QVector<QSharedPointer<DkImageContainerT>> &images, int cIdx)
+{
+    DkTraceSpan span("cache", "update", true);
+
+    for (auto cImg : images)
+        cImg->setCacheConsumer(mConsumer);
+
+    // all tabs share one budget - images that are only cached by other tabs are subtracted
+    float budget = DkSettingsManager::param().resources().cacheMemory;
+    budget = qMax(budget - DkImageCache::instance().foreignMemoryUsage(mConsumer), 0.0f);
+    float imageBudget = budget * 0.75f; // decoded images are more valuable than buffers
+    float bufferBudget = budget - imageBudget;
+    int maxCached = qMax(DkSettingsManager::param().resources().maxImagesCached, 1);
+
+    // prefetch the images that will be visited within the next 3 seconds
+    int ahead = qBound(1, qCeil(stepsPerSecond() * 3.0f), maxCached);
+    int decodeAhead = qMax(1, ahead / 2);
+    int behind = qMax(1, ahead / 4);
+
+    // frame sequences: decode one second ahead - the frames are small since they are decoded at the display size
+    if (mFrameRate > 0) {
+        ahead = qCeil(mFrameRate);
+        decodeAhead = ahead;
+    }
+
+    float imageMem = 0;
+    float bufferMem = 0;
+
+    // the prefetch candidates ordered by priority
+    QVector<int> decodeIdx;
+    QVector<int> bufferIdx;
+
+    for (int idx = 1; idx <= ahead; idx++) {
+        int fIdx = cIdx + idx * mDirection;
+
+        if (fIdx < 0 || fIdx >= images.size())
+            break;
+
+        if (idx <= decodeAhead)
+            decodeIdx << fIdx;
+        else
+            bufferIdx << fIdx;
+    }
+
+    for (int idx = 1; idx <= behind; idx++) {
+        int bIdx = cIdx - idx * mDirection;
+
+        if (bIdx < 0 || bIdx >= images.size())
+            break;
+
+        bufferIdx << bIdx;
+    }
+
+    // eviction candidates - the least valuable images first
+    QVector<QPair<float, int>> imageCandidates;
+    QVector<QPair<float, int>> bufferCandidates;
+
+    for (int idx = 0; idx < images.size(); idx++) {
+        auto cImg = images.at(idx);
+
+        if (idx == cIdx)
+            continue;
+
+        // clear images if they are edited
+        if (cImg->isEdited()) {
+            cImg->clear();
+            continue;
+        }
+
+        float bm = cImg->getBufferMemoryUsage();
+        float im = qMax(cImg->getMemoryUsage() - bm, 0.0f);
+
+        if (im <= 0 && bm <= 0)
+            continue;
+
+        // images in navigation direction are worth more than those behind
+        int dist = (idx - cIdx) * mDirection;
+        float value = reloadCost(cImg) / (dist > 0 ? dist : 2 * qAbs(dist));
+
+        if (decodeIdx.contains(idx))
+            value = std::numeric_limits<float>::max();
+
+        if (im > 0)
+            imageCandidates << qMakePair(value, idx);
+        if (bm > 0)
+            bufferCandidates << qMakePair(decodeIdx.contains(idx) || bufferIdx.contains(idx) ? std::numeric_limits<float>::max() : value, idx);
+
+        imageMem += im;
+        bufferMem += bm;
+    }
+
+    std::sort(imageCandidates.begin(), imageCandidates.end());
+    std::sort(bufferCandidates.begin(), bufferCandidates.end());
+
+    int numEvicted = 0;
+
+    for (const QPair<float, int> &c : imageCandidates) {
+        if (imageMem <= imageBudget)
+            break;
+
+        auto cImg = images.at(c.second);
+        float im = qMax(cImg->getMemoryUsage() - cImg->getBufferMemoryUsage(), 0.0f);
+
+        if (cImg->releaseImage()) {
+            imageMem -= im;
+            numEvicted++;
+        }
+    }
+
+    for (const QPair<float, int> &c : bufferCandidates) {
+        if (bufferMem <= bufferBudget)
+            break;
+
+        auto cImg = images.at(c.second);
+        float bm = cImg->getBufferMemoryUsage();
+
+        if (cImg->releaseFileBuffer()) {
+            bufferMem -= bm;
+            numEvicted++;
+        }
+    }
+
+    // prefetch
+    for (int idx : decodeIdx) {
+        auto cImg = images.at(idx);
+
+        if (imageMem >= imageBudget)
+            break;
+
+        if (cImg->getLoadState() == DkImageContainerT::not_loaded) {
+            cImg->setDecodeSize(mDecodeSize);
+            cImg->loadImageThreaded();
+
+            // we don't know the image's size yet
+            if (mDecodeSize.isValid())
+                imageMem += DkImage::getBufferSizeFloat(mDecodeSize, 32);
+
+            qDebug() << "[Cacher]" << cImg->filePath() << "fully cached...";
+        }
+    }
+
+    for (int idx : bufferIdx) {
+        auto cImg = images.at(idx);
+
+        if (bufferMem >= bufferBudget)
+            break;
+
+        if (cImg->getLoadState() == DkImageContainerT::not_loaded && cImg->getBufferMemoryUsage() == 0) {
+            cImg->fetchFile();
+            bufferMem += cImg->getFileSize();
+            qDebug() << "[Cacher]" << cImg->filePath() << "file fetched...";
+        }
+    }
+
+    DK_TRACE_COUNTER("cache", "images [MB]", imageMem);
+    DK_TRACE_COUNTER("cache", "buffers [MB]", bufferMem);
+    DK_TRACE_COUNTER("cache", "hit rate [%]", qRound(hitRate() * 100));
+
+    qDebug().nospace() << "[Cacher] updated in " << qPrintable(span.elapsed()) << " - images: " << imageMem << " MB, buffers: " << bufferMem << " MB, " << numEvicted
+                       << " evicted, hit rate: " << qRound(hitRate() * 100) << "% (" << mHits << " decoded, " << mBufferHits << " buffered, "
+                       << mMisses << " missed), shared cache: " << DkImageCache::instance().usageString();
+}
+
 // DkImageLoader -> is nomacs file handling routine --------------------------------------------------------------------
 /**
  * Default constructor.
@@ -124,6 +452,8 @@ DkImageLoader::DkImageLoader(const QString &filePath)
 
     mDelayedUpdateTimer.setSingleShot(true);
     connect(&mDelayedUpdateTimer, SIGNAL(timeout()), this, SLOT(directoryChanged()));
+    connect(&DkImageScores::instance(), SIGNAL(finished()), this, SLOT(imagesScored()));
+    connect(&DkMetaDataIndex::instance(), SIGNAL(finished()), this, SLOT(metaDataIndexed()));
 
     connect(DkActionManager::instance().action(DkActionManager::menu_file_save_copy), SIGNAL(triggered()), this, SLOT(copyUserFile()));
     connect(DkActionManager::instance().action(DkActionManager::menu_edit_undo), SIGNAL(triggered()), this, SLOT(undo()));
@@ -228,7 +558,8 @@ bool DkImageLoader::loadDir(const QString &newDirPath, bool scanRecursive)
     //	return false;
     // }
 
-    DkTimer dt;
+    DkTraceSpan span("folder", "index", true);
+    span.setDetail(newDirPath);
 
     // folder changed signal was emitted
     if (mFolderUpdated && newDirPath == mCurrentDir) {
@@ -266,6 +597,7 @@ bool DkImageLoader::loadDir(const QString &newDirPath, bool scanRecursive)
         // update save directory
         mCurrentDir = newDirPath;
         mFolderUpdated = false;
+        mCacher.reset(); // the navigation pattern is folder specific
 
         mFolderFilterString.clear(); // delete key words -> otherwise user may be confused
 
@@ -297,7 +629,7 @@ bool DkImageLoader::loadDir(const QString &newDirPath, bool scanRecursive)
         // else
         createImages(files, true);
 
-        qInfoClean() << newDirPath << " [" << mImages.size() << "] indexed in " << dt;
+        qInfoClean() << newDirPath << " [" << mImages.size() << "] indexed in " << qPrintable(span.elapsed());
     }
     // else
     //	qDebug() << "ignoring... old dir: " << dir.absolutePath() << " newDir: " << newDir << " file size: " << images.size();
@@ -344,7 +676,7 @@ void DkImageLoader::imagesSorted()
 void DkImageLoader::createImages(const QFileInfoList &files, bool sort)
 {
     // TODO: change files to QStringList
-    DkTimer dt;
+    DkTraceSpan span("folder", "create images", true);
     QVector<QSharedPointer<DkImageContainerT>> oldImages = mImages;
     mImages.clear();
 
@@ -358,11 +690,12 @@ void DkImageLoader::createImages(const QFileInfoList &files, bool sort)
         // however, that did not detect file changes & slowed down the process - so I removed it...
         mImages << ((oIdx != -1) ? oldImages.at(oIdx) : QSharedPointer<DkImageContainerT>(new DkImageContainerT(fp)));
     }
-    qInfo() << "[DkImageLoader]" << mImages.size() << "containers created in" << dt;
+    qInfo() << "[DkImageLoader]" << mImages.size() << "containers created in" << qPrintable(span.elapsed());
 
     if (sort) {
-        qSort(mImages.begin(), mImages.end(), imageContainerLessThanPtr);
-        qInfo() << "[DkImageLoader] after sorting: " << dt;
+        DK_TRACE_SCOPE("folder", "sort");
+        sortImageContainers(mImages);
+        qInfo() << "[DkImageLoader] after sorting: " << qPrintable(span.elapsed());
 
         emit updateDirSignal(mImages);
 
@@ -372,11 +705,116 @@ void DkImageLoader::createImages(const QFileInfoList &files, bool sort)
             mDirWatcher->addPath(mCurrentDir);
         }
     }
+
+    scoreImages();
+    indexMetaData();
+}
+
+/**
+ * Applies changes of the current folder without rebuilding the file list.
+ * Only the files that were added or removed since the last scan are touched,
+ * existing containers (and their thumbnails/caches) are kept and the views are
+ * notified per file. This keeps hot folders (e.g. tethered shooting) responsive.
+ * @return bool false if a full rescan is needed.
+ **/
+bool DkImageLoader::updateDirIncremental()
+{
+    if (mImages.empty() || mSortingImages || mCurrentDir.isEmpty())
+        return false;
+
+    DkTraceSpan span("folder", "update", true);
+    QFileInfoList files = getFilteredFileInfoList(mCurrentDir, mIgnoreKeywords, mKeywords, mFolderFilterString);
+
+    // let loadDir handle empty folders
+    if (files.empty())
+        return false;
+
+    QSet<QString> newPaths;
+    for (const QFileInfo &f : files)
+        newPaths.insert(f.absoluteFilePath());
+
+    QSet<QString> oldPaths;
+    for (const QSharedPointer<DkImageContainerT> &img : mImages)
+        oldPaths.insert(img->filePath());
+
+    // if the current file was removed, we continue with its successor (or predecessor)
+    QSharedPointer<DkImageContainerT> neighbor;
+    bool currentRemoved = false;
+
+    if (mCurrentImage && oldPaths.contains(mCurrentImage->filePath()) && !newPaths.contains(mCurrentImage->filePath())) {
+        int cIdx = findFileIdx(mCurrentImage->filePath(), mImages);
+        currentRemoved = true;
+
+        for (int idx = cIdx + 1; idx < mImages.size() && !neighbor; idx++) {
+            if (newPaths.contains(mImages[idx]->filePath()))
+                neighbor = mImages[idx];
+        }
+
+        for (int idx = cIdx - 1; idx >= 0 && !neighbor; idx--) {
+            if (newPaths.contains(mImages[idx]->filePath()))
+                neighbor = mImages[idx];
+        }
+    }
+
+    // remove deleted files (backwards - so that the indexes stay valid)
+    int numRemoved = 0;
+    for (int idx = mImages.size() - 1; idx >= 0; idx--) {
+        if (!newPaths.contains(mImages[idx]->filePath())) {
+            mImages.remove(idx);
+            emit imageRemovedSignal(idx);
+            numRemoved++;
+        }
+    }
+
+    // insert new files at their sorted position
+    QVector<QSharedPointer<DkImageContainerT>> newImages;
+    QSharedPointer<DkImageContainerT> newest;
+    QDateTime newestDate;
+
+    for (const QFileInfo &f : files) {
+        if (oldPaths.contains(f.absoluteFilePath()))
+            continue;
+
+        QSharedPointer<DkImageContainerT> img(new DkImageContainerT(f.absoluteFilePath()));
+        newImages << img;
+
+        if (!newest || f.lastModified() > newestDate) {
+            newest = img;
+            newestDate = f.lastModified();
+        }
+    }
+
+    // the sort keys of the folder are read once for all new files
+    QVector<int> indexes = insertImageContainers(mImages, newImages);
+
+    for (int idx = 0; idx < indexes.size(); idx++)
+        emit imageInsertedSignal(indexes[idx], newImages[idx]);
+
+    int numInserted = newImages.size();
+
+    mFolderUpdated = false;
+
+    if (numInserted == 0 && numRemoved == 0)
+        return true;
+
+    if (numInserted > 0) {
+        scoreImages();
+        indexMetaData();
+    }
+
+    qInfo() << "[DkImageLoader]" << mCurrentDir << "updated:" << numInserted << "added," << numRemoved << "removed in" << qPrintable(span.elapsed());
+
+    if (newest && DkSettingsManager::param().global().followNewFiles)
+        load(newest);
+    else if (currentRemoved)
+        load(neighbor ? neighbor : mImages.first());
+
+    return true;
 }
 
 QVector<QSharedPointer<DkImageContainerT>> DkImageLoader::sortImages(QVector<QSharedPointer<DkImageContainerT>> images) const
 {
-    qSort(images.begin(), images.end(), imageContainerLessThanPtr);
+    sortImageContainers(images);
     return images;
 }
 
@@ -835,8 +1273,10 @@ void DkImageLoader::setCurrentImage(QSharedPointer<DkImageContainerT> newImg)
 
     mCurrentImage = newImg;
 
-    if (mCurrentImage)
+    if (mCurrentImage) {
+        mCurrentImage->setCacheConsumer(mCacher.consumer());
         mCurrentImage->receiveUpdates(this);
+    }
 }
 
 void DkImageLoader::reloadImage()
@@ -905,11 +1345,18 @@ void DkImageLoader::load(QSharedPointer<DkImageContainerT> image /* = QSharedPoi
     }
 #endif
 
+    if (mCurrentImage != image) {
+        mCacher.navigated(findFileIdx(mCurrentImage ? mCurrentImage->filePath() : QString(), mImages), findFileIdx(image->filePath(), mImages));
+        mCacher.accessed(image);
+    }
+
     setCurrentImage(image);
 
     if (mCurrentImage && mCurrentImage->getLoadState() == DkImageContainerT::loading)
         return;
 
+    mCurrentImage->setDecodeSize(mCacher.decodeSize());
+
     emit updateSpinnerSignalDelayed(true);
     bool loaded = mCurrentImage->loadImageThreaded(); // loads file threaded
 
@@ -943,7 +1390,10 @@ void DkImageLoader::imageLoaded(bool loaded /* = false */)
     QApplication::sendPostedEvents(); // force an event post here
 
     updateCacher(mCurrentImage);
-    updateHistory();
+
+    // don't write the recent files for every frame of a sequence
+    if (!mCacher.decodeSize().isValid())
+        updateHistory();
 
     if (mCurrentImage)
         emit imageHasGPSSignal(DkMetaDataHelper::getInstance().hasGPS(mCurrentImage->getMetaData()));
@@ -1603,7 +2053,8 @@ void DkImageLoader::directoryChanged(const QString &path)
         // as this could be pretty fast, the thumbsloader (& whoever) would create a
         // greater offset and slow down the system
         if ((path.isEmpty() && mTimerBlockedUpdate) || (!path.isEmpty() && !mDelayedUpdateTimer.isActive())) {
-            loadDir(mCurrentDir, false);
+            if (!updateDirIncremental())
+                loadDir(mCurrentDir, false);
             mTimerBlockedUpdate = false;
 
             if (!path.isEmpty())
@@ -1795,64 +2246,58 @@ void DkImageLoader::updateCacher(QSharedPointer<DkImageContainerT> imgC)
     if (!imgC || !DkSettingsManager::param().resources().cacheMemory)
         return;
 
-    DkTimer dt;
-
-    //// no caching? delete all
-    // if (!DkSettingsManager::param().resources().cacheMemory) {
-    //	for (int idx = 0; idx < images.size(); idx++) {
-    //		images.at(idx)->clear();
-    //	}
-    //	return;
-    // }
-
     int cIdx = findFileIdx(imgC->filePath(), mImages);
-    double mem = 0;
-    double totalMem = 0;
 
     if (cIdx == -1) {
         qWarning() << "WARNING: image not found for caching!";
         return;
     }
 
-    for (int idx = 0; idx < mImages.size(); idx++) {
-        auto cImg = mImages.at(idx);
+    mCacher.update(mImages, cIdx);
+}
 
-        // clear images if they are edited
-        if (idx != cIdx && cImg->isEdited()) {
-            cImg->clear();
-            continue;
-        }
+/**
+ * Tells the cacher that a slideshow is running.
+ * @param playing true if the slideshow is playing
+ **/
+void DkImageLoader::setSlideshowPlaying(bool playing)
+{
+    mCacher.setSlideshowInterval(playing ? DkSettingsManager::param().slideShow().time : 0.0f);
+}
 
-        // do not count the last & the current image
-        if (idx > cIdx && idx <= cIdx + DkSettingsManager::param().resources().maxImagesCached)
-            mem += cImg->getMemoryUsage();
-        else if (abs(cIdx - idx) > 1) {
-            cImg->clear();
-            if (cImg->hasImage())
-                qDebug() << "[Cacher]" << cImg->filePath() << "freed";
+/**
+ * Plays the current folder as frame sequence (or stops playing it).
+ * While playing, images are decoded at the display size.
+ * If the sequence is stopped, the current image is loaded at full resolution again.
+ * @param fps the target frame rate - 0 stops playing
+ * @param decodeSize the size frames are displayed with
+ **/
+void DkImageLoader::setFrameSequence(float fps, const QSize &decodeSize)
+{
+    mCacher.setFrameSequence(fps, decodeSize);
 
-            continue;
-        } else
-            totalMem += cImg->getMemoryUsage();
+    if (fps > 0)
+        return;
 
-        // ignore the last and current one
-        if (idx == cIdx - 1 || idx == cIdx) {
-            continue;
-        }
-        // fully load the next image
-        else if (idx == cIdx + 1 && mem < DkSettingsManager::param().resources().cacheMemory
-                 && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
-            cImg->loadImageThreaded();
-            qDebug() << "[Cacher] " << cImg->filePath() << " fully cached...";
-        } else if (idx > cIdx && idx < cIdx + DkSettingsManager::param().resources().maxImagesCached - 2
-                   && mem < DkSettingsManager::param().resources().cacheMemory && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
-            // dt.getIvl();
-            mImages.at(idx)->fetchFile(); // TODO: crash detected here
-            qDebug() << "[Cacher] " << cImg->filePath() << " file fetched...";
-        }
+    for (auto imgC : mImages) {
+        if (imgC != mCurrentImage)
+            imgC->setDecodeSize(QSize());
     }
 
-    qDebug() << "[Cacher] created in" << dt << "(" << mem + totalMem << "MB)";
+    if (mCurrentImage && mCurrentImage->setDecodeSize(QSize()))
+        load(mCurrentImage);
+}
+
+/**
+ * Sets the name of this loader (e.g. the tab name) in the shared DkImageCache.
+ * @param consumer the consumer's name
+ **/
+void DkImageLoader::setCacheConsumer(const QString &consumer)
+{
+    mCacher.setConsumer(consumer);
+
+    if (mCurrentImage)
+        mCurrentImage->setCacheConsumer(consumer);
 }
 
 /**
@@ -1949,6 +2394,9 @@ QFileInfoList DkImageLoader::getFilteredFileInfoList(const QString &dirPath, QSt
         fileList = fileList.filter(keywords[idx], Qt::CaseInsensitive);
     }
 
+    // metadata terms (e.g. rating>=3) are answered by the index
+    DkMetaDataFilter metaDataFilter = DkMetaDataFilter::parse(folderKeywords, &folderKeywords);
+
     if (folderKeywords != "") {
         QStringList filterList = fileList;
         fileList = DkUtils::filterStringList(folderKeywords, filterList);
@@ -1994,15 +2442,102 @@ QFileInfoList DkImageLoader::getFilteredFileInfoList(const QString &dirPath, QSt
     for (int idx = 0; idx < fileList.size(); idx++)
         fileInfoList.append(QFileInfo(mCurrentDir, fileList.at(idx)));
 
+    if (!metaDataFilter.isEmpty()) {
+        DkMetaDataIndex &index = DkMetaDataIndex::instance();
+
+        // files that are not indexed yet are added once they are (see metaDataIndexed())
+        if (index.request(fileInfoList))
+            mIndexingDir = mCurrentDir;
+
+        QFileInfoList matches;
+        for (const QFileInfo &fi : fileInfoList) {
+            if (metaDataFilter.matches(index.entry(fi)))
+                matches << fi;
+        }
+
+        fileInfoList = matches;
+    }
+
     return fileInfoList;
 }
 
 void DkImageLoader::sort()
 {
-    qSort(mImages.begin(), mImages.end(), imageContainerLessThanPtr);
+    scoreImages();
+    indexMetaData();
+
+    sortImageContainers(mImages);
     emit updateDirSignal(mImages);
 }
 
+/**
+ * Scores all images of the current folder in the background (see DkImageScores).
+ * Nothing is done if the scores are neither displayed nor used for sorting.
+ **/
+void DkImageLoader::scoreImages() const
+{
+    if (!DkImageScores::isNeeded())
+        return;
+
+    QList<QFileInfo> files;
+    for (const QSharedPointer<DkImageContainerT> &img : mImages)
+        files << img->fileInfo();
+
+    DkImageScores::instance().request(files);
+}
+
+/**
+ * Sorts the folder again once all scores are computed.
+ * Until then, images that were not scored yet are sorted last.
+ **/
+void DkImageLoader::imagesScored()
+{
+    int sm = DkSettingsManager::param().global().sortMode;
+
+    if ((sm == DkSettings::sort_sharpness || sm == DkSettings::sort_clipping) && sortImageContainers(mImages))
+        emit updateDirSignal(mImages);
+}
+
+/**
+ * Indexes the metadata of all images in the background (see DkMetaDataIndex).
+ * Nothing is done if the folder is not sorted by metadata.
+ **/
+void DkImageLoader::indexMetaData() const
+{
+    if (!DkMetaDataIndex::isNeeded())
+        return;
+
+    QList<QFileInfo> files;
+    for (const QSharedPointer<DkImageContainerT> &img : mImages)
+        files << img->fileInfo();
+
+    if (DkMetaDataIndex::instance().request(files))
+        mIndexingDir = mCurrentDir;
+}
+
+/**
+ * Applies metadata filters and sorts the folder again once all files are indexed.
+ * Until then, files that were not indexed yet are filtered out.
+ **/
+void DkImageLoader::metaDataIndexed()
+{
+    // the index is shared - ignore files of other tabs (or folders we left)
+    if (mCurrentDir.isEmpty() || mIndexingDir != mCurrentDir)
+        return;
+
+    mIndexingDir.clear();
+
+    if (!DkMetaDataFilter::parse(mFolderFilterString).isEmpty() && !updateDirIncremental()) {
+        mFolderUpdated = true;
+        loadDir(mCurrentDir);
+        return;
+    }
+
+    // only notify the views if the order changed
+    if (DkMetaDataIndex::isNeeded() && sortImageContainers(mImages))
+        emit updateDirSignal(mImages);
+}
+
 void DkImageLoader::currentImageUpdated() const
 {
     if (mCurrentImage.isNull())
@@ -28,6 +28,7 @@
 #pragma once
 
 #pragma warning(push, 0) // no warnings from includes - begin
+#include <QElapsedTimer>
 #include <QImage>
 #include <QTimer>
 #pragma warning(pop) // no warnings from includes - end
@@ -56,6 +57,48 @@ class QUrl;
 namespace nmc
 {
 
+/**
+ * Decides which images of the current folder are kept in memory.
+ * The cache budget (DkSettings::Resources::cacheMemory) is split between decoded images
+ * and file buffers. Images are prefetched in the direction the user navigates to - the faster
+ * the user navigates (or the slideshow plays), the more images are prefetched.
+ * If the budget is exceeded, images that are far away and cheap to reload are evicted first.
+ **/
+class DllCoreExport DkImageCacher
+{
+public:
+    DkImageCacher();
+
+    void navigated(int oldIdx, int newIdx);
+    void accessed(QSharedPointer<DkImageContainerT> imgC);
+    void setSlideshowInterval(float sec);
+    void setFrameSequence(float fps, const QSize &decodeSize);
+    QSize decodeSize() const;
+    void update(const QVector<QSharedPointer<DkImageContainerT>> &images, int cIdx);
+    void reset();
+    void setConsumer(const QString &consumer);
+    QString consumer() const;
+
+    float hitRate() const;
+
+protected:
+    float reloadCost(QSharedPointer<DkImageContainerT> imgC) const;
+    float stepsPerSecond() const;
+
+    int mDirection = 1;
+    float mStepsPerSecond = 0.0f;
+    float mSlideshowInterval = 0.0f;
+    float mFrameRate = 0.0f;
+    QSize mDecodeSize;
+    QElapsedTimer mNavigationTimer;
+
+    int mHits = 0;
+    int mBufferHits = 0;
+    int mMisses = 0;
+
+    QString mConsumer; // the name of the tab in the DkImageCache
+};
+
 /**
  * This class is a basic image loader class.
  * It takes care of the file watches for the current folder,
@@ -91,6 +134,8 @@ public:
     void setImageUpdated();
     void setCurrentImage(QSharedPointer<DkImageContainerT> newImg);
     void sort();
+    void scoreImages() const;
+    void indexMetaData() const;
 
     // file selection
     void firstFile();
@@ -147,6 +192,8 @@ signals:
     void imageLoadedSignal(QSharedPointer<DkImageContainerT> image, bool loaded = true) const;
     void showInfoSignal(const QString &msg, int time = 3000, int position = 0) const;
     void updateDirSignal(QVector<QSharedPointer<DkImageContainerT>> images) const;
+    void imageInsertedSignal(int idx, QSharedPointer<DkImageContainerT> image) const;
+    void imageRemovedSignal(int idx) const;
     void imageHasGPSSignal(bool hasGPS) const;
     void loadImageToTab(const QString &filePath) const;
 
@@ -177,9 +224,14 @@ public slots:
     void imageLoaded(bool loaded = false);
     void imageSaved(const QString &file, bool saved = true, bool loadToTab = true);
     void imagesSorted();
+    void imagesScored();
+    void metaDataIndexed();
     bool unloadFile();
     void reloadImage();
     void showOnMap();
+    void setSlideshowPlaying(bool playing);
+    void setFrameSequence(float fps, const QSize &decodeSize);
+    void setCacheConsumer(const QString &consumer);
 
 protected:
     // functions
@@ -189,6 +241,7 @@ protected:
     void updateHistory();
     void sortImagesThreaded(QVector<QSharedPointer<DkImageContainerT>> images);
     void createImages(const QFileInfoList &files, bool sort = true);
+    bool updateDirIncremental();
     QVector<QSharedPointer<DkImageContainerT>> sortImages(QVector<QSharedPointer<DkImageContainerT>> images) const;
 
     QStringList mIgnoreKeywords;
@@ -198,6 +251,7 @@ protected:
     QTimer mDelayedUpdateTimer;
     bool mTimerBlockedUpdate = false;
     QString mCurrentDir;
+    mutable QString mIndexingDir; // folder whose metadata is indexed (see metaDataIndexed())
     QString mSaveDir;
     QString mCopyDir;
     QFileSystemWatcher *mDirWatcher = 0;
@@ -210,6 +264,7 @@ protected:
     bool mSortingImages = false;
     bool mSortingIsDirty = false;
     QFutureWatcher<QVector<QSharedPointer<DkImageContainerT>>> mCreateImageWatcher;
+    DkImageCacher mCacher;
 };
 
 }
\ No newline at end of file
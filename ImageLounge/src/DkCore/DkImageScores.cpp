@@ -0,0 +1,302 @@
+/*******************************************************************************************************
+ DkImageScores.cpp
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkImageScores.h"
+#include "DkBasicLoader.h"
+#include "DkMath.h"
+#include "DkSettings.h"
+#include "DkThumbs.h"
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QDebug>
+#include <QImage>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#pragma warning(pop) // no warnings from includes - end
+
+namespace nmc
+{
+
+// DkImageScore --------------------------------------------------------------------
+/**
+ * Computes sharpness, clipping and noise of an image.
+ * The image is divided into 8x8 tiles. The sharpness is the mean Laplacian variance
+ * of the 10% most detailed tiles - so a sharp subject in front of a blurred
+ * background is not penalized. The noise is estimated in the 25% flattest tiles.
+ * @param img the image (it is reduced to score_size if it is larger).
+ * @return the score - invalid if the image is empty.
+ **/
+DkImageScore DkImageScore::compute(const QImage &img)
+{
+    DkImageScore s;
+
+    if (img.isNull())
+        return s;
+
+    QImage im = img;
+
+    // scores must not depend on the size of the decoded image
+    if (im.width() > score_size || im.height() > score_size)
+        im = im.scaled(score_size, score_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    im = im.convertToFormat(QImage::Format_RGB32);
+
+    const int w = im.width();
+    const int h = im.height();
+
+    if (w < 3 || h < 3)
+        return s;
+
+    // convert to gray & count clipped pixels
+    std::vector<uchar> gray((size_t)w * h);
+    qint64 numShadows = 0;
+    qint64 numHighlights = 0;
+
+    for (int y = 0; y < h; y++) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(im.constScanLine(y));
+        uchar *gl = &gray[(size_t)y * w];
+
+        for (int x = 0; x < w; x++) {
+            int r = qRed(line[x]);
+            int g = qGreen(line[x]);
+            int b = qBlue(line[x]);
+            int mx = qMax(r, qMax(g, b));
+
+            if (mx >= 254)
+                numHighlights++;
+            else if (mx <= 1)
+                numShadows++;
+
+            gl[x] = (uchar)qGray(r, g, b);
+        }
+    }
+
+    s.clippedShadows = (double)numShadows / ((double)w * h);
+    s.clippedHighlights = (double)numHighlights / ((double)w * h);
+
+    // accumulate Laplacian statistics & noise responses per tile
+    const int numTiles = 8;
+    std::vector<double> lapSum(numTiles * numTiles, 0.0);
+    std::vector<double> lapSqSum(numTiles * numTiles, 0.0);
+    std::vector<double> noiseSum(numTiles * numTiles, 0.0);
+    std::vector<qint64> count(numTiles * numTiles, 0);
+
+    for (int y = 1; y < h - 1; y++) {
+        const uchar *pl = &gray[(size_t)(y - 1) * w];
+        const uchar *cl = &gray[(size_t)y * w];
+        const uchar *nl = &gray[(size_t)(y + 1) * w];
+        int ty = y * numTiles / h;
+
+        for (int x = 1; x < w - 1; x++) {
+            int tIdx = ty * numTiles + x * numTiles / w;
+
+            int cross = cl[x - 1] + cl[x + 1] + pl[x] + nl[x];
+            int diag = pl[x - 1] + pl[x + 1] + nl[x - 1] + nl[x + 1];
+
+            // Laplacian [0 -1 0; -1 4 -1; 0 -1 0]
+            double lap = 4 * cl[x] - cross;
+            // Immerkaer's noise mask [1 -2 1; -2 4 -2; 1 -2 1]
+            int n = 4 * cl[x] - 2 * cross + diag;
+
+            lapSum[tIdx] += lap;
+            lapSqSum[tIdx] += lap * lap;
+            noiseSum[tIdx] += std::abs(n);
+            count[tIdx]++;
+        }
+    }
+
+    // (variance, noise) per tile
+    std::vector<std::pair<double, double>> tiles;
+
+    for (size_t idx = 0; idx < count.size(); idx++) {
+        if (count[idx] == 0)
+            continue;
+
+        double c = (double)count[idx];
+        double mean = lapSum[idx] / c;
+        double var = lapSqSum[idx] / c - mean * mean;
+        double noise = std::sqrt(CV_PI * 0.5) * noiseSum[idx] / (6.0 * c);
+
+        tiles.push_back(std::make_pair(var, noise));
+    }
+
+    if (tiles.empty())
+        return s;
+
+    std::sort(tiles.begin(), tiles.end());
+
+    // sharpness: the most detailed tiles
+    size_t numDetailed = qMax((size_t)1, tiles.size() / 10);
+    double sharpness = 0.0;
+
+    for (size_t idx = tiles.size() - numDetailed; idx < tiles.size(); idx++)
+        sharpness += tiles[idx].first;
+
+    // noise: the flattest tiles (edges would be counted as noise otherwise)
+    size_t numFlat = qMax((size_t)1, tiles.size() / 4);
+    double noise = 0.0;
+
+    for (size_t idx = 0; idx < numFlat; idx++)
+        noise += tiles[idx].second;
+
+    s.sharpness = qMax(sharpness / numDetailed, 0.0);
+    s.noise = noise / numFlat;
+
+    return s;
+}
+
+bool DkImageScore::isValid() const
+{
+    return sharpness >= 0.0;
+}
+
+/**
+ * Returns the fraction of clipped pixels.
+ * @return the fraction of pixels that are either black or white [0 1].
+ **/
+double DkImageScore::clipping() const
+{
+    return clippedShadows + clippedHighlights;
+}
+
+QDataStream &operator<<(QDataStream &s, const DkImageScore &score)
+{
+    s << score.sharpness << score.clippedShadows << score.clippedHighlights << score.noise;
+    return s;
+}
+
+QDataStream &operator>>(QDataStream &s, DkImageScore &score)
+{
+    s >> score.sharpness >> score.clippedShadows >> score.clippedHighlights >> score.noise;
+    return s;
+}
+
+// DkImageScoreTask --------------------------------------------------------------------
+/**
+ * Decodes a reduced version of an image and scores it.
+ * The pending state is released when the task is deleted - also if it
+ * was removed from the pool before it could run.
+ **/
+class DkImageScoreTask : public QRunnable
+{
+public:
+    DkImageScoreTask(const QString &filePath, const QString &key)
+        : mFilePath(filePath)
+        , mKey(key)
+    {
+    }
+
+    ~DkImageScoreTask()
+    {
+        DkImageScores::instance().release(mKey);
+    }
+
+    void run() override
+    {
+        DkImageScore score;
+
+        // a reduced resolution decode (or the embedded preview) is sufficient
+        DkBasicLoader loader;
+        loader.setDecodeSize(QSize(DkImageScore::score_size, DkImageScore::score_size));
+
+        try {
+            if (loader.loadGeneral(mFilePath, QSharedPointer<QByteArray>(), false, true))
+                score = DkImageScore::compute(loader.image());
+        } catch (...) {
+            qWarning() << "[DkImageScores] could not load" << mFilePath;
+        }
+
+        // failed images are kept too - so that we do not try again
+        DkImageScores::instance().insert(mKey, score);
+    }
+
+protected:
+    QString mFilePath;
+    QString mKey;
+};
+
+// DkImageScores --------------------------------------------------------------------
+DkImageScores::DkImageScores()
+    : DkFileCacheT<DkImageScore>("DkImageScores", "scores.cache", 100000)
+{
+}
+
+DkImageScores::~DkImageScores()
+{
+}
+
+DkImageScores &DkImageScores::instance()
+{
+    static DkImageScores inst;
+    return inst;
+}
+
+/**
+ * Returns true if the scores are currently displayed or used for sorting.
+ **/
+bool DkImageScores::isNeeded()
+{
+    int sm = DkSettingsManager::param().global().sortMode;
+
+    return DkSettingsManager::param().display().showThumbScores || sm == DkSettings::sort_sharpness || sm == DkSettings::sort_clipping;
+}
+
+/**
+ * Returns the score of a file.
+ * @param fileInfo the file - its modification date must match the scored file.
+ * @return the score or an invalid score if the file was not scored yet.
+ **/
+DkImageScore DkImageScores::score(const QFileInfo &fileInfo)
+{
+    return value(fileInfo);
+}
+
+/**
+ * Queues all files that are not scored yet.
+ * Scores are computed with the lowest priority on the thumbnail pool.
+ * @param files the files to be scored (in the order they should be scored).
+ **/
+void DkImageScores::request(const QList<QFileInfo> &files)
+{
+    QList<QPair<QString, QString>> queued = queue(files);
+
+    if (queued.empty())
+        return;
+
+    qInfo() << "[DkImageScores] scoring" << queued.size() << "images";
+
+    // thumbnails use priorities <= 0 - they always come first
+    for (const QPair<QString, QString> &q : queued)
+        DkThumbsThreadPool::pool()->start(new DkImageScoreTask(q.first, q.second), std::numeric_limits<int>::min());
+}
+
+}
@@ -0,0 +1,103 @@
+/*******************************************************************************************************
+ DkImageScores.h
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#include "DkFileCache.h"
+
+#pragma warning(disable : 4251) // TODO: remove
+
+#ifndef DllCoreExport
+#ifdef DK_CORE_DLL_EXPORT
+#define DllCoreExport Q_DECL_EXPORT
+#elif DK_DLL_IMPORT
+#define DllCoreExport Q_DECL_IMPORT
+#else
+#define DllCoreExport Q_DECL_IMPORT
+#endif
+#endif
+
+// Qt defines
+class QImage;
+
+namespace nmc
+{
+
+/**
+ * Quality measures of an image that help culling large shoots.
+ * All measures are computed on a reduced version of the image (~1024 px).
+ **/
+class DllCoreExport DkImageScore
+{
+public:
+    enum {
+        score_size = 1024,
+    };
+
+    static DkImageScore compute(const QImage &img);
+
+    bool isValid() const;
+    double clipping() const;
+
+    // variance of the Laplacian in the most detailed regions - higher is sharper
+    double sharpness = -1.0;
+    // fraction of (nearly) black and white pixels [0 1]
+    double clippedShadows = 0.0;
+    double clippedHighlights = 0.0;
+    // standard deviation of the noise in gray values (Immerkaer's estimate)
+    double noise = 0.0;
+};
+
+DllCoreExport QDataStream &operator<<(QDataStream &s, const DkImageScore &score);
+DllCoreExport QDataStream &operator>>(QDataStream &s, DkImageScore &score);
+
+/**
+ * DkImageScores scores images in the background for fast culling.
+ * Images are decoded at a reduced size (or their embedded preview is used)
+ * on the thumbnail pool with the lowest priority - so thumbnails are never delayed.
+ * Scores are keyed by file path and modification date and persisted between sessions (see DkFileCache).
+ **/
+class DllCoreExport DkImageScores : public DkFileCacheT<DkImageScore>
+{
+public:
+    static DkImageScores &instance();
+    ~DkImageScores();
+
+    // singleton
+    DkImageScores(DkImageScores const &) = delete;
+    void operator=(DkImageScores const &) = delete;
+
+    static bool isNeeded();
+
+    DkImageScore score(const QFileInfo &fileInfo);
+    void request(const QList<QFileInfo> &files);
+
+private:
+    DkImageScores();
+};
+
+}
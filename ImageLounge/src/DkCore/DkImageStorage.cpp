@@ -31,16 +31,30 @@
 #include "DkSettings.h"
 #include "DkThumbs.h"
 #include "DkTimer.h"
+#include "DkTrace.h"
 
 #pragma warning(push, 0) // no warnings from includes - begin
+#include <QApplication>
 #include <QBitmap>
+#include <QDataStream>
 #include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QPainter>
 #include <QPixmap>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStyle>
+#include <QStyleOption>
 #include <QSvgRenderer>
+#include <QThread>
 #include <QTimer>
+#include <QtConcurrentMap>
 #include <QtConcurrentRun>
 #include <qmath.h>
+
+#include <algorithm>
 #pragma warning(pop) // no warnings from includes - end
 
 #if defined(Q_OS_WIN) && !defined(SOCK_STREAM)
@@ -100,6 +114,7 @@ float DkImage::getBufferSizeFloat(const QSize &imgSize, const int depth)
 
 /**
  * This function resizes an image according to the interpolation method specified.
+ * 8 bit images are resampled with a cached DkResizeKernel.
  * @param img the image to resize
  * @param newSize the new size
  * @param factor the resize factor
@@ -122,6 +137,10 @@ DkImage::resizeImage(const QImage &img, const QSize &newSize, double factor /* =
         return QImage();
     }
 
+    // 8 bit images are resampled with cached kernels
+    if (DkResizeKernel::supports(img) && interpolation >= ipl_nearest && interpolation < ipl_end)
+        return DkResizeKernel::kernel(img.size(), nSize, interpolation)->apply(img, correctGamma);
+
     Qt::TransformationMode iplQt = Qt::FastTransformation;
     switch (interpolation) {
     case ipl_nearest:
@@ -195,7 +214,7 @@ DkImage::resizeImage(const QImage &img, const QSize &newSize, double factor /* =
 
     if (correctGamma)
         DkImage::gammaToLinear(qImg);
-    qImg.scaled(nSize, Qt::IgnoreAspectRatio, iplQt);
+    qImg = qImg.scaled(nSize, Qt::IgnoreAspectRatio, iplQt);
 
     if (correctGamma)
         DkImage::linearToGamma(qImg);
@@ -234,18 +253,23 @@ QImage DkImage::thresholdImage(const QImage &img, double thr, bool color)
 
     QImage tImg = color ? img.copy() : grayscaleImage(img);
 
+    uchar lut[256];
+    for (int idx = 0; idx < 256; idx++)
+        lut[idx] = idx > thr ? 255 : 0;
+
     // number of bytes per line used
     int bpl = (tImg.width() * tImg.depth() + 7) / 8;
-    int pad = tImg.bytesPerLine() - bpl;
+    int stride = tImg.bytesPerLine();
+    uchar *bits = tImg.bits(); // detach before the bands are processed
 
-    uchar *mPtr = tImg.bits();
+    mapRowBands(tImg.height(), numRowBands(tImg), [&](int, int y0, int y1) {
+        for (int rIdx = y0; rIdx < y1; rIdx++) {
+            uchar *mPtr = bits + (qint64)rIdx * stride;
 
-    for (int rIdx = 0; rIdx < tImg.height(); rIdx++) {
-        for (int cIdx = 0; cIdx < bpl; cIdx++, mPtr++) {
-            *mPtr = *mPtr > thr ? 255 : 0;
+            for (int cIdx = 0; cIdx < bpl; cIdx++)
+                mPtr[cIdx] = lut[mPtr[cIdx]];
         }
-        mPtr += pad;
-    }
+    });
 
     qDebug() << "thresholding takes: " << dt;
 
@@ -394,31 +418,63 @@ void DkImage::mapGammaTable(QImage &img, const QVector<uchar> &gammaTable)
 {
     DkTimer dt;
 
+    // values that are not covered by the table are kept
+    uchar lut[256];
+    for (int idx = 0; idx < 256; idx++)
+        lut[idx] = idx < gammaTable.size() ? gammaTable[idx] : (uchar)idx;
+
     // number of bytes per line used
     int bpl = (img.width() * img.depth() + 7) / 8;
-    int pad = img.bytesPerLine() - bpl;
+    int stride = img.bytesPerLine();
+    uchar *bits = img.bits(); // detach before the bands are processed
 
-    // int channels = (img.hasAlphaChannel() || img.format() == QImage::Format_RGB32) ? 4 : 3;
+    mapRowBands(img.height(), numRowBands(img), [&](int, int y0, int y1) {
+        for (int rIdx = y0; rIdx < y1; rIdx++) {
+            uchar *mPtr = bits + (qint64)rIdx * stride;
 
-    uchar *mPtr = img.bits();
+            for (int cIdx = 0; cIdx < bpl; cIdx++)
+                mPtr[cIdx] = lut[mPtr[cIdx]];
+        }
+    });
 
-    for (int rIdx = 0; rIdx < img.height(); rIdx++) {
-        for (int cIdx = 0; cIdx < bpl; cIdx++, mPtr++) {
-            if (*mPtr < 0 || *mPtr > gammaTable.size()) {
-                qDebug() << "WRONG VALUE: " << *mPtr;
-                continue;
-            }
-            if ((int)gammaTable[*mPtr] < 0 || (int)gammaTable[*mPtr] > USHRT_MAX) {
-                qDebug() << "WRONG VALUE: " << *mPtr;
-                continue;
-            }
+    qDebug() << "gamma computation takes: " << dt;
+}
 
-            *mPtr = gammaTable[*mPtr];
-        }
-        mPtr += pad;
+/**
+ * Returns the number of row bands an image should be processed with.
+ * Small images are not split - distributing them costs more than it gains.
+ * @param img the image to be processed.
+ * @return int the number of bands (>= 1).
+ **/
+int DkImage::numRowBands(const QImage &img)
+{
+    if (img.sizeInBytes() < (1 << 20))
+        return 1;
+
+    return qMax(1, qMin(img.height() / 16, QThread::idealThreadCount() * 2));
+}
+
+/**
+ * Processes the rows [0 numRows) in bands on all cores and waits for them.
+ * Reductions should keep one partial result per band and merge them afterwards.
+ * @param numRows the number of rows (e.g. the image height).
+ * @param numBands the number of bands (see numRowBands).
+ * @param fn is called with the band index, its first row and the row behind its last row.
+ **/
+void DkImage::mapRowBands(int numRows, int numBands, const std::function<void(int, int, int)> &fn)
+{
+    if (numBands <= 1) {
+        fn(0, 0, numRows);
+        return;
     }
 
-    qDebug() << "gamma computation takes: " << dt;
+    QVector<int> bands(numBands);
+    for (int idx = 0; idx < numBands; idx++)
+        bands[idx] = idx;
+
+    QtConcurrent::blockingMap(bands, [&](int &b) {
+        fn(b, b * numRows / numBands, (b + 1) * numRows / numBands);
+    });
 }
 
 QImage DkImage::normImage(const QImage &img)
@@ -431,44 +487,65 @@ QImage DkImage::normImage(const QImage &img)
 
 bool DkImage::normImage(QImage &img)
 {
-    uchar maxVal = 0;
-    uchar minVal = 255;
-
     // number of used bytes per line
     int bpl = (img.width() * img.depth() + 7) / 8;
-    int pad = img.bytesPerLine() - bpl;
-    uchar *mPtr = img.bits();
+    int stride = img.bytesPerLine();
     bool hasAlpha = img.hasAlphaChannel() || img.format() == QImage::Format_RGB32;
+    int numBands = numRowBands(img);
 
-    for (int rIdx = 0; rIdx < img.height(); rIdx++) {
-        for (int cIdx = 0; cIdx < bpl; cIdx++, mPtr++) {
-            if (hasAlpha && cIdx % 4 == 3)
-                continue;
+    // min/max per band
+    QVector<uchar> minVals(numBands, 255);
+    QVector<uchar> maxVals(numBands, 0);
+    uchar *minPtr = minVals.data();
+    uchar *maxPtr = maxVals.data();
+    const uchar *cBits = img.constBits();
 
-            if (*mPtr > maxVal)
-                maxVal = *mPtr;
-            if (*mPtr < minVal)
-                minVal = *mPtr;
+    mapRowBands(img.height(), numBands, [&](int b, int y0, int y1) {
+        uchar minVal = 255;
+        uchar maxVal = 0;
+
+        for (int rIdx = y0; rIdx < y1; rIdx++) {
+            const uchar *mPtr = cBits + (qint64)rIdx * stride;
+
+            for (int cIdx = 0; cIdx < bpl; cIdx++) {
+                if (hasAlpha && cIdx % 4 == 3)
+                    continue;
+
+                if (mPtr[cIdx] > maxVal)
+                    maxVal = mPtr[cIdx];
+                if (mPtr[cIdx] < minVal)
+                    minVal = mPtr[cIdx];
+            }
         }
 
-        mPtr += pad;
-    }
+        minPtr[b] = minVal;
+        maxPtr[b] = maxVal;
+    });
+
+    uchar minVal = *std::min_element(minVals.begin(), minVals.end());
+    uchar maxVal = *std::max_element(maxVals.begin(), maxVals.end());
 
     if ((minVal == 0 && maxVal == 255) || maxVal - minVal == 0)
         return false;
 
-    uchar *ptr = img.bits();
+    uchar lut[256];
+    for (int idx = 0; idx < 256; idx++)
+        lut[idx] = (uchar)qBound(0, qRound(255.0f * (idx - minVal) / (maxVal - minVal)), 255);
 
-    for (int rIdx = 0; rIdx < img.height(); rIdx++) {
-        for (int cIdx = 0; cIdx < bpl; cIdx++, ptr++) {
-            if (hasAlpha && cIdx % 4 == 3)
-                continue;
+    uchar *bits = img.bits(); // detach before the bands are processed
 
-            *ptr = (uchar)qRound(255.0f * (*ptr - minVal) / (maxVal - minVal));
-        }
+    mapRowBands(img.height(), numBands, [&](int, int y0, int y1) {
+        for (int rIdx = y0; rIdx < y1; rIdx++) {
+            uchar *ptr = bits + (qint64)rIdx * stride;
 
-        ptr += pad;
-    }
+            for (int cIdx = 0; cIdx < bpl; cIdx++) {
+                if (hasAlpha && cIdx % 4 == 3)
+                    continue;
+
+                ptr[cIdx] = lut[ptr[cIdx]];
+            }
+        }
+    });
 
     return true;
 }
@@ -500,121 +577,94 @@ bool DkImage::autoAdjustImage(QImage &img)
 
     int channels = (img.hasAlphaChannel() || img.format() == QImage::Format_RGB32) ? 4 : 3;
 
-    uchar maxR = 0, maxG = 0, maxB = 0;
-    uchar minR = 255, minG = 255, minB = 255;
-
     // number of bytes per line used
     int bpl = (img.width() * img.depth() + 7) / 8;
-    int pad = img.bytesPerLine() - bpl;
+    int stride = img.bytesPerLine();
+    int numBands = numRowBands(img);
 
-    uchar *mPtr = img.bits();
-    uchar r, g, b;
+    // histograms per band - min/max values are derived from them
+    QVector<int> bandHists(numBands * 3 * 256, 0);
+    int *histPtr = bandHists.data();
+    const uchar *cBits = img.constBits();
 
-    int histR[256] = {0};
-    int histG[256] = {0};
-    int histB[256] = {0};
+    mapRowBands(img.height(), numBands, [&](int b, int y0, int y1) {
+        int *hist = histPtr + b * 3 * 256;
 
-    for (int rIdx = 0; rIdx < img.height(); rIdx++) {
-        for (int cIdx = 0; cIdx < bpl;) {
-            r = *mPtr;
-            mPtr++;
-            g = *mPtr;
-            mPtr++;
-            b = *mPtr;
-            mPtr++;
-            cIdx += 3;
-
-            if (r > maxR)
-                maxR = r;
-            if (r < minR)
-                minR = r;
-
-            if (g > maxG)
-                maxG = g;
-            if (g < minG)
-                minG = g;
-
-            if (b > maxB)
-                maxB = b;
-            if (b < minB)
-                minB = b;
-
-            histR[r]++;
-            histG[g]++;
-            histB[b]++;
+        for (int rIdx = y0; rIdx < y1; rIdx++) {
+            const uchar *mPtr = cBits + (qint64)rIdx * stride;
 
             // ?? strange but I would expect the alpha channel to be the first (big endian?)
-            if (channels == 4) {
-                mPtr++;
-                cIdx++;
+            for (int cIdx = 0; cIdx + 2 < bpl; cIdx += channels) {
+                hist[mPtr[cIdx]]++;
+                hist[256 + mPtr[cIdx + 1]]++;
+                hist[512 + mPtr[cIdx + 2]]++;
             }
         }
-        mPtr += pad;
+    });
+
+    int hists[3][256] = {{0}};
+    for (int b = 0; b < numBands; b++) {
+        const int *hist = bandHists.constData() + b * 3 * 256;
+
+        for (int c = 0; c < 3; c++)
+            for (int idx = 0; idx < 256; idx++)
+                hists[c][idx] += hist[c * 256 + idx];
     }
 
-    QColor ignoreChannel;
-    bool ignoreR = maxR - minR == 0 || maxR - minR == 255;
-    bool ignoreG = maxR - minR == 0 || maxG - minG == 255;
-    bool ignoreB = maxR - minR == 0 || maxB - minB == 255;
+    uchar minVals[3] = {255, 255, 255};
+    uchar maxVals[3] = {0, 0, 0};
+    bool ignore[3];
 
-    uchar *ptr = img.bits();
+    for (int c = 0; c < 3; c++) {
+        for (int idx = 0; idx < 256; idx++) {
+            if (hists[c][idx] == 0)
+                continue;
 
-    if (ignoreR) {
-        maxR = findHistPeak(histR);
-        ignoreR = maxR - minR == 0 || maxR - minR == 255;
-    }
-    if (ignoreG) {
-        maxG = findHistPeak(histG);
-        ignoreG = maxG - minG == 0 || maxG - minG == 255;
-    }
-    if (ignoreB) {
-        maxB = findHistPeak(histB);
-        ignoreB = maxB - minB == 0 || maxB - minB == 255;
+            minVals[c] = qMin(minVals[c], (uchar)idx);
+            maxVals[c] = (uchar)idx;
+        }
+
+        ignore[c] = maxVals[c] - minVals[c] == 0 || maxVals[c] - minVals[c] == 255;
+
+        if (ignore[c]) {
+            maxVals[c] = findHistPeak(hists[c]);
+            ignore[c] = maxVals[c] - minVals[c] == 0 || maxVals[c] - minVals[c] == 255;
+        }
     }
 
-    // qDebug() << "red max: " << maxR << " min: " << minR << " ignored: " << ignoreR;
-    // qDebug() << "green max: " << maxG << " min: " << minG << " ignored: " << ignoreG;
-    // qDebug() << "blue max: " << maxB << " min: " << minB << " ignored: " << ignoreB;
+    // qDebug() << "red max: " << maxVals[0] << " min: " << minVals[0] << " ignored: " << ignore[0];
     // qDebug() << "computed in: " << dt;
 
-    if (ignoreR && ignoreG && ignoreB) {
+    if (ignore[0] && ignore[1] && ignore[2]) {
         qDebug() << "[Auto Adjust] There is no need to adjust the image";
         return false;
     }
 
-    for (int rIdx = 0; rIdx < img.height(); rIdx++) {
-        for (int cIdx = 0; cIdx < bpl;) {
-            // don't check values - speed (but you see under-/overflows anyway)
-            if (!ignoreR && *ptr < maxR)
-                *ptr = (uchar)qRound(255.0f * ((float)*ptr - minR) / (maxR - minR));
-            else if (!ignoreR)
-                *ptr = 255;
-
-            ptr++;
-            cIdx++;
-
-            if (!ignoreG && *ptr < maxG)
-                *ptr = (uchar)qRound(255.0f * ((float)*ptr - minG) / (maxG - minG));
-            else if (!ignoreG)
-                *ptr = 255;
+    uchar luts[3][256];
+    for (int c = 0; c < 3; c++) {
+        for (int idx = 0; idx < 256; idx++) {
+            if (ignore[c])
+                luts[c][idx] = (uchar)idx;
+            else if (idx < maxVals[c])
+                luts[c][idx] = (uchar)qBound(0, qRound(255.0f * ((float)idx - minVals[c]) / (maxVals[c] - minVals[c])), 255);
+            else
+                luts[c][idx] = 255;
+        }
+    }
 
-            ptr++;
-            cIdx++;
+    uchar *bits = img.bits(); // detach before the bands are processed
 
-            if (!ignoreB && *ptr < maxB)
-                *ptr = (uchar)qRound(255.0f * ((float)*ptr - minB) / (maxB - minB));
-            else if (!ignoreB)
-                *ptr = 255;
-            ptr++;
-            cIdx++;
+    mapRowBands(img.height(), numBands, [&](int, int y0, int y1) {
+        for (int rIdx = y0; rIdx < y1; rIdx++) {
+            uchar *ptr = bits + (qint64)rIdx * stride;
 
-            if (channels == 4) {
-                ptr++;
-                cIdx++;
+            for (int cIdx = 0; cIdx + 2 < bpl; cIdx += channels) {
+                ptr[cIdx] = luts[0][ptr[cIdx]];
+                ptr[cIdx + 1] = luts[1][ptr[cIdx + 1]];
+                ptr[cIdx + 2] = luts[2][ptr[cIdx + 2]];
             }
         }
-        ptr += pad;
-    }
+    });
 
     qDebug() << "[Auto Adjust] image adjusted in: " << dt;
 
@@ -741,63 +791,126 @@ QImage DkImage::cropToImage(const QImage &src, const DkRotatingRect &rect, const
     return img;
 }
 
+/**
+ * Changes hue, saturation and brightness of an image.
+ * The image is processed in 8-bit HSV (hue in [0 180)) on its scanlines -
+ * all adjustments are mapped with look-up tables.
+ * @param src the source image.
+ * @param hue the hue shift in [-180 180].
+ * @param sat the saturation change in percent [-100 100].
+ * @param brightness the brightness change in percent [-100 100].
+ * @return QImage the adjusted image (the alpha channel is kept).
+ **/
 QImage DkImage::hueSaturation(const QImage &src, int hue, int sat, int brightness)
 {
     // nothing to do?
     if (hue == 0 && sat == 0 && brightness == 0)
         return src;
 
-    QImage imgR;
+    if (src.isNull())
+        return src;
 
-#ifdef WITH_OPENCV
+    DkTimer dt;
+
+    QImage imgR = src.convertToFormat(src.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
 
     // normalize brightness/saturation
     int brightnessN = qRound(brightness / 100.0 * 255.0);
     double satN = sat / 100.0 + 1.0;
 
-    cv::Mat hsvImg = DkImage::qImage2Mat(src);
-
-    if (hsvImg.channels() > 3)
-        cv::cvtColor(hsvImg, hsvImg, CV_RGBA2BGR);
-
-    cv::cvtColor(hsvImg, hsvImg, CV_BGR2HSV);
-
-    // apply hue/saturation changes
-    for (int rIdx = 0; rIdx < hsvImg.rows; rIdx++) {
-        unsigned char *iPtr = hsvImg.ptr<unsigned char>(rIdx);
-
-        for (int cIdx = 0; cIdx < hsvImg.cols * 3; cIdx += 3) {
-            // adopt hue
-            int h = iPtr[cIdx] + hue;
-            if (h < 0)
-                h += 180;
-            if (h >= 180)
-                h -= 180;
-
-            iPtr[cIdx] = (unsigned char)h;
-
-            // adopt value
-            int v = iPtr[cIdx + 2] + brightnessN;
-            if (v < 0)
-                v = 0;
-            if (v > 255)
-                v = 255;
-            iPtr[cIdx + 2] = (unsigned char)v;
-
-            // adopt saturation
-            int s = qRound(iPtr[cIdx + 1] * satN);
-            if (s < 0)
-                s = 0;
-            if (s > 255)
-                s = 255;
-            iPtr[cIdx + 1] = (unsigned char)s;
-        }
+    uchar hueLut[180];
+    uchar satLut[256];
+    uchar valLut[256];
+
+    for (int idx = 0; idx < 180; idx++)
+        hueLut[idx] = (uchar)(((idx + hue) % 180 + 180) % 180);
+
+    for (int idx = 0; idx < 256; idx++) {
+        satLut[idx] = (uchar)qBound(0, qRound(idx * satN), 255);
+        valLut[idx] = (uchar)qBound(0, idx + brightnessN, 255);
     }
 
-    cv::cvtColor(hsvImg, hsvImg, CV_HSV2BGR);
-    imgR = DkImage::mat2QImage(hsvImg);
+    // fixed point divisions (Q12) for the RGB -> HSV conversion
+    const int shift = 12;
+    int sDiv[256];
+    int hDiv[256];
 
-#endif // WITH_OPENCV
+    for (int idx = 0; idx < 256; idx++) {
+        sDiv[idx] = idx ? qRound((255 << shift) / (double)idx) : 0;
+        hDiv[idx] = idx ? qRound((30 << shift) / (double)idx) : 0;
+    }
+
+    int stride = imgR.bytesPerLine();
+    uchar *bits = imgR.bits();
+
+    mapRowBands(imgR.height(), numRowBands(imgR), [&](int, int y0, int y1) {
+        for (int rIdx = y0; rIdx < y1; rIdx++) {
+            QRgb *ptr = reinterpret_cast<QRgb *>(bits + (qint64)rIdx * stride);
+
+            for (int cIdx = 0; cIdx < imgR.width(); cIdx++) {
+                int r = qRed(ptr[cIdx]);
+                int g = qGreen(ptr[cIdx]);
+                int b = qBlue(ptr[cIdx]);
+
+                // RGB -> HSV
+                int v = qMax(r, qMax(g, b));
+                int diff = v - qMin(r, qMin(g, b));
+                int s = (diff * sDiv[v] + (1 << (shift - 1))) >> shift;
+                int h = 0;
+
+                if (diff != 0) {
+                    if (v == r)
+                        h = ((g - b) * hDiv[diff] + (1 << (shift - 1))) >> shift;
+                    else if (v == g)
+                        h = 60 + (((b - r) * hDiv[diff] + (1 << (shift - 1))) >> shift);
+                    else
+                        h = 120 + (((r - g) * hDiv[diff] + (1 << (shift - 1))) >> shift);
+
+                    if (h < 0)
+                        h += 180;
+                    if (h >= 180)
+                        h -= 180;
+                }
+
+                // adopt hue, saturation & value
+                h = hueLut[h];
+                s = satLut[s];
+                v = valLut[v];
+
+                // HSV -> RGB
+                int sector = h / 30;
+                int f = h - sector * 30;
+                int p = (v * (255 - s) + 127) / 255;
+                int q = (v * (255 * 30 - s * f) + 3825) / (255 * 30);
+                int t = (v * (255 * 30 - s * (30 - f)) + 3825) / (255 * 30);
+
+                switch (sector) {
+                case 0:
+                    r = v, g = t, b = p;
+                    break;
+                case 1:
+                    r = q, g = v, b = p;
+                    break;
+                case 2:
+                    r = p, g = v, b = t;
+                    break;
+                case 3:
+                    r = p, g = q, b = v;
+                    break;
+                case 4:
+                    r = t, g = p, b = v;
+                    break;
+                default:
+                    r = v, g = p, b = q;
+                    break;
+                }
+
+                ptr[cIdx] = qRgba(r, g, b, qAlpha(ptr[cIdx]));
+            }
+        }
+    });
+
+    qDebug() << "[DkImage] hue/saturation computed in" << dt;
 
     return imgR;
 }
@@ -1058,14 +1171,22 @@ QPixmap DkImage::loadIcon(const QString &filePath, const QSize &size, const QCol
         s = QSize(eis, eis);
     }
 
-    QPixmap icon = loadFromSvg(filePath, s);
-
-    QColor c = (col.isValid()) ? col : DkSettingsManager::param().display().iconColor;
+    return QPixmap::fromImage(DkIconCache::instance().icon(filePath, s, col));
+}
 
-    if (c.alpha() != 0)
-        icon = colorizePixmap(icon, c);
+/**
+ * Returns an icon that is rasterized when it is painted for the first time.
+ * Use this instead of loadIcon if the icon is not shown immediately (e.g. actions).
+ * @param filePath the svg file path
+ * @param col the icon color, if invalid the current icon color is used when painting
+ * @return QIcon an icon backed by the DkSvgIconEngine
+ **/
+QIcon DkImage::loadIconDeferred(const QString &filePath, const QColor &col)
+{
+    if (filePath.isEmpty())
+        return QIcon();
 
-    return icon;
+    return QIcon(new DkSvgIconEngine(filePath, col));
 }
 
 QPixmap DkImage::loadFromSvg(const QString &filePath, const QSize &size)
@@ -1468,6 +1589,588 @@ QColor DkImage::getMeanColor(const QImage &img)
         return DkSettingsManager::param().display().hudBgColor;
 }
 
+// DkResizeKernel --------------------------------------------------------------------
+DkResizeKernel::DkResizeKernel(const QSize &srcSize, const QSize &dstSize, int interpolation)
+    : mSrcSize(srcSize)
+    , mDstSize(dstSize)
+    , mInterpolation(interpolation)
+{
+    mHorizontal = computeAxis(srcSize.width(), dstSize.width(), interpolation);
+    mVertical = computeAxis(srcSize.height(), dstSize.height(), interpolation);
+}
+
+/**
+ * Returns the (cached) kernel that resizes images of srcSize to dstSize.
+ * @param srcSize the size of the input images
+ * @param dstSize the size of the resized images
+ * @param interpolation the interpolation method (DkImage::ipl_nearest ... DkImage::ipl_lanczos)
+ * @return QSharedPointer<DkResizeKernel> the kernel
+ **/
+QSharedPointer<DkResizeKernel> DkResizeKernel::kernel(const QSize &srcSize, const QSize &dstSize, int interpolation)
+{
+    static QMutex mutex;
+    static QList<QSharedPointer<DkResizeKernel>> kernels; // most recently used first
+    const int maxKernels = 8;
+
+    QMutexLocker locker(&mutex);
+
+    for (int idx = 0; idx < kernels.size(); idx++) {
+        QSharedPointer<DkResizeKernel> k = kernels[idx];
+
+        if (k->mSrcSize == srcSize && k->mDstSize == dstSize && k->mInterpolation == interpolation) {
+            kernels.move(idx, 0);
+            return k;
+        }
+    }
+
+    locker.unlock();
+    QSharedPointer<DkResizeKernel> k(new DkResizeKernel(srcSize, dstSize, interpolation));
+    locker.relock();
+
+    kernels.prepend(k);
+    while (kernels.size() > maxKernels)
+        kernels.removeLast();
+
+    return k;
+}
+
+/**
+ * Returns true for the 8 bit formats the kernel resamples without changing the format.
+ * Other formats (e.g. indexed, RGB888 or 10 bit RGB30) are left to Qt/OpenCV.
+ **/
+bool DkResizeKernel::supports(const QImage &img)
+{
+    if (img.isNull())
+        return false;
+
+    switch (img.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_Grayscale8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+DkResizeKernel::Axis DkResizeKernel::computeAxis(int srcLength, int dstLength, int interpolation)
+{
+    Axis axis;
+    double scale = (double)srcLength / dstLength;
+
+    if (interpolation == DkImage::ipl_nearest) {
+        axis.taps = 1;
+        for (int idx = 0; idx < dstLength; idx++) {
+            axis.index << qMin((int)((idx + 0.5) * scale), srcLength - 1);
+            axis.weight << 1.0f;
+        }
+        return axis;
+    }
+
+    // area upsampling is a linear interpolation (as in OpenCV)
+    if (interpolation == DkImage::ipl_area && scale <= 1.0)
+        interpolation = DkImage::ipl_linear;
+
+    // stretch the filter when downsampling so that all source pixels contribute
+    double fScale = qMax(scale, 1.0);
+    double support = filterRadius(interpolation) * fScale;
+    axis.taps = qCeil(support * 2) + 2;
+    axis.index.resize(dstLength * axis.taps);
+    axis.weight.resize(dstLength * axis.taps);
+
+    for (int idx = 0; idx < dstLength; idx++) {
+        double center = (idx + 0.5) * scale;
+        int first = qFloor(center - 0.5 - support);
+        double sum = 0.0;
+
+        for (int t = 0; t < axis.taps; t++) {
+            int sIdx = first + t;
+            double w;
+
+            if (interpolation == DkImage::ipl_area)
+                w = qMax(0.0, qMin(sIdx + 1.0, (idx + 1) * scale) - qMax((double)sIdx, idx * scale));
+            else
+                w = filter((sIdx + 0.5 - center) / fScale, interpolation);
+
+            axis.index[idx * axis.taps + t] = qBound(0, sIdx, srcLength - 1);
+            axis.weight[idx * axis.taps + t] = (float)w;
+            sum += w;
+        }
+
+        if (sum != 0.0) {
+            for (int t = 0; t < axis.taps; t++)
+                axis.weight[idx * axis.taps + t] /= (float)sum;
+        }
+    }
+
+    return axis;
+}
+
+double DkResizeKernel::filter(double x, int interpolation)
+{
+    x = qAbs(x);
+
+    switch (interpolation) {
+    case DkImage::ipl_linear:
+        return x < 1.0 ? 1.0 - x : 0.0;
+    case DkImage::ipl_cubic: {
+        const double a = -0.5;
+        if (x < 1.0)
+            return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+        if (x < 2.0)
+            return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+        return 0.0;
+    }
+    case DkImage::ipl_lanczos: {
+        if (x < 1e-8)
+            return 1.0;
+        if (x >= 4.0)
+            return 0.0;
+        double px = M_PI * x;
+        return 4.0 * qSin(px) * qSin(px / 4.0) / (px * px);
+    }
+    }
+
+    return x <= 0.5 ? 1.0 : 0.0;
+}
+
+double DkResizeKernel::filterRadius(int interpolation)
+{
+    switch (interpolation) {
+    case DkImage::ipl_linear:
+        return 1.0;
+    case DkImage::ipl_cubic:
+        return 2.0;
+    case DkImage::ipl_lanczos:
+        return 4.0;
+    }
+
+    return 0.5;
+}
+
+/**
+ * Resizes img which must have the kernel's source size.
+ * The image is filtered horizontally and then vertically in one
+ * pass per band of target rows, in linear space if correctGamma is true.
+ * @param img the image to be resized
+ * @param correctGamma if true, the image is resampled in linear RGB
+ * @return QImage the resized image (same format as img)
+ **/
+QImage DkResizeKernel::apply(const QImage &img, bool correctGamma) const
+{
+    if (img.size() != mSrcSize || !supports(img))
+        return QImage();
+
+    QImage src = img;
+    int channels = 4;
+
+    if (src.format() == QImage::Format_Grayscale8)
+        channels = 1;
+    else if (src.format() == QImage::Format_ARGB32_Premultiplied)
+        src = src.convertToFormat(QImage::Format_ARGB32);
+
+    QImage dst(mDstSize, src.format());
+    if (dst.isNull())
+        return dst;
+
+    // lookup tables: gamma -> linear for 8 bit input, linear -> gamma with finer steps for the output
+    static const QVector<float> toLinear = []() {
+        QVector<float> lut(256);
+        for (int idx = 0; idx < 256; idx++) {
+            double i = idx / 255.0;
+            lut[idx] = (float)(i <= 0.04045 ? i / 12.92 : qPow((i + 0.055) / 1.055, 2.4));
+        }
+        return lut;
+    }();
+
+    static const int gammaSteps = 1 << 14;
+    static const QVector<uchar> toGamma = []() {
+        QVector<uchar> lut(gammaSteps);
+        for (int idx = 0; idx < gammaSteps; idx++) {
+            double l = idx / (double)(gammaSteps - 1);
+            double i = l <= 0.0031308 ? l * 12.92 : 1.055 * qPow(l, 1.0 / 2.4) - 0.055;
+            lut[idx] = (uchar)qBound(0, qRound(i * 255.0), 255);
+        }
+        return lut;
+    }();
+
+    float plain[256];
+    for (int idx = 0; idx < 256; idx++)
+        plain[idx] = idx / 255.0f;
+
+    const float *colorLut = correctGamma ? toLinear.constData() : plain;
+    const int alphaIdx = (channels == 4) ? (QSysInfo::ByteOrder == QSysInfo::LittleEndian ? 3 : 0) : -1;
+    const int dstW = mDstSize.width();
+    const int rowLength = dstW * channels;
+
+    auto filterRow = [&](int sy, float *out) {
+        const uchar *sp = src.constScanLine(sy);
+        const int taps = mHorizontal.taps;
+        const int *idx = mHorizontal.index.constData();
+        const float *w = mHorizontal.weight.constData();
+
+        for (int x = 0; x < dstW; x++, idx += taps, w += taps) {
+            for (int c = 0; c < channels; c++) {
+                const float *lut = (c == alphaIdx) ? plain : colorLut;
+                float v = 0.0f;
+
+                for (int t = 0; t < taps; t++)
+                    v += w[t] * lut[sp[idx[t] * channels + c]];
+
+                out[x * channels + c] = v;
+            }
+        }
+    };
+
+    auto processBand = [&](int y0, int y1) {
+        // horizontally filtered source rows that are still needed
+        QHash<int, QVector<float>> rows;
+        QVector<float> acc(rowLength);
+        const int taps = mVertical.taps;
+
+        for (int y = y0; y < y1; y++) {
+            acc.fill(0.0f);
+
+            for (int t = 0; t < taps; t++) {
+                float w = mVertical.weight[y * taps + t];
+                if (w == 0.0f)
+                    continue;
+
+                int sy = mVertical.index[y * taps + t];
+                if (!rows.contains(sy)) {
+                    QVector<float> r(rowLength);
+                    filterRow(sy, r.data());
+                    rows.insert(sy, r);
+                }
+
+                const float *rp = rows[sy].constData();
+                float *ap = acc.data();
+                for (int x = 0; x < rowLength; x++)
+                    ap[x] += w * rp[x];
+            }
+
+            uchar *dp = dst.scanLine(y);
+            for (int x = 0; x < rowLength; x++) {
+                float v = acc[x];
+
+                if (correctGamma && x % channels != alphaIdx)
+                    dp[x] = toGamma[qBound(0, qRound(v * (gammaSteps - 1)), gammaSteps - 1)];
+                else
+                    dp[x] = (uchar)qBound(0, qRound(v * 255.0f), 255);
+            }
+
+            // rows above the next target row's support are not needed anymore
+            if (y + 1 < y1) {
+                int firstNeeded = mVertical.index[(y + 1) * taps];
+                for (auto it = rows.begin(); it != rows.end();) {
+                    if (it.key() < firstNeeded)
+                        it = rows.erase(it);
+                    else
+                        ++it;
+                }
+            }
+        }
+    };
+
+    // split target rows across cores
+    int numBands = qMax(1, qMin(mDstSize.height() / 16, QThread::idealThreadCount() * 2));
+    QVector<int> bands(numBands);
+    for (int idx = 0; idx < numBands; idx++)
+        bands[idx] = idx;
+
+    QtConcurrent::blockingMap(bands, [&](int &b) {
+        processBand(b * mDstSize.height() / numBands, (b + 1) * mDstSize.height() / numBands);
+    });
+
+    if (img.format() != dst.format())
+        dst = dst.convertToFormat(img.format());
+
+    return dst;
+}
+
+// DkIconCache --------------------------------------------------------------------
+DkIconCache::DkIconCache()
+{
+}
+
+DkIconCache &DkIconCache::instance()
+{
+    static DkIconCache inst;
+    return inst;
+}
+
+DkIconCache::~DkIconCache()
+{
+}
+
+/**
+ * Returns the rasterized (and colorized) svg icon.
+ * The svg is only rendered if it is not cached yet.
+ * This function is thread-safe.
+ * @param filePath the svg file path
+ * @param size the icon size in device independent pixels
+ * @param col the icon color, if invalid the current icon color is used
+ * @param dpr the device pixel ratio
+ * @return QImage the icon
+ **/
+QImage DkIconCache::icon(const QString &filePath, const QSize &size, const QColor &col, double dpr)
+{
+    if (filePath.isEmpty() || size.isEmpty())
+        return QImage();
+
+    QColor c = (col.isValid()) ? col : DkSettingsManager::param().display().iconColor;
+    QString k = key(filePath, size, c, dpr);
+
+    QMutexLocker locker(&mMutex);
+
+    if (!mLoaded) {
+        locker.unlock();
+        load();
+        locker.relock();
+    }
+
+    QHash<QString, QImage>::const_iterator it = mIcons.constFind(k);
+    if (it != mIcons.constEnd())
+        return it.value();
+
+    QImage img = render(filePath, size * dpr, c);
+    img.setDevicePixelRatio(dpr);
+
+    if (mIcons.size() >= mMaxIcons)
+        mIcons.clear();
+
+    mIcons.insert(k, img);
+    mNumRendered++;
+    mDirty = true;
+
+    return img;
+}
+
+QImage DkIconCache::render(const QString &filePath, const QSize &size, const QColor &col) const
+{
+    QSvgRenderer svg(filePath);
+
+    QImage img(size, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+
+    QPainter p(&img);
+    svg.render(&p);
+
+    // colorize (see DkImage::colorizePixmap)
+    if (col.alpha() != 0) {
+        p.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        p.fillRect(img.rect(), col);
+    }
+
+    return img;
+}
+
+QString DkIconCache::key(const QString &filePath, const QSize &size, const QColor &col, double dpr) const
+{
+    QString k = filePath + "|" + QString::number(size.width()) + "x" + QString::number(size.height()) + "|" + col.name(QColor::HexArgb) + "|"
+        + QString::number(dpr);
+
+    // resources never change within one version, files might
+    if (!filePath.startsWith(":"))
+        k += "|" + QString::number(QFileInfo(filePath).lastModified().toMSecsSinceEpoch());
+
+    return k;
+}
+
+QString DkIconCache::cacheFilePath() const
+{
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    if (cacheDir.isEmpty() || !QDir().mkpath(cacheDir))
+        return QString();
+
+    return QFileInfo(cacheDir, "icons.cache").absoluteFilePath();
+}
+
+/**
+ * Loads previously rendered icons from the disk.
+ * The cache is invalidated if it was written by another nomacs version.
+ **/
+void DkIconCache::load()
+{
+    QMutexLocker locker(&mMutex);
+
+    if (mLoaded)
+        return;
+
+    mLoaded = true;
+
+    QFile file(cacheFilePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    DkTimer dt;
+
+    QDataStream ds(&file);
+    QString version;
+    QHash<QString, QImage> icons;
+
+    ds >> version;
+
+    if (version != QCoreApplication::applicationVersion()) {
+        qInfo() << "[DkIconCache] dropping icon cache of version" << version;
+        mDirty = true;
+        return;
+    }
+
+    ds >> icons;
+
+    if (ds.status() != QDataStream::Ok) {
+        qWarning() << "[DkIconCache] could not read" << file.fileName();
+        mDirty = true;
+        return;
+    }
+
+    for (auto it = icons.constBegin(); it != icons.constEnd(); it++)
+        mIcons.insert(it.key(), it.value());
+
+    qInfo() << "[DkIconCache]" << mIcons.size() << "icons loaded in" << dt;
+}
+
+/**
+ * Writes all rendered icons to the disk.
+ * Nothing is written if no new icons were rendered.
+ **/
+void DkIconCache::save()
+{
+    QMutexLocker locker(&mMutex);
+
+    if (!mDirty)
+        return;
+
+    QString fp = cacheFilePath();
+    if (fp.isEmpty())
+        return;
+
+    QSaveFile file(fp);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[DkIconCache] could not open" << fp;
+        return;
+    }
+
+    QDataStream ds(&file);
+    ds << QCoreApplication::applicationVersion();
+    ds << mIcons;
+
+    if (file.commit())
+        mDirty = false;
+}
+
+void DkIconCache::clear()
+{
+    QMutexLocker locker(&mMutex);
+    mIcons.clear();
+    mDirty = true;
+}
+
+int DkIconCache::numIcons() const
+{
+    QMutexLocker locker(&mMutex);
+    return mIcons.size();
+}
+
+int DkIconCache::numRendered() const
+{
+    QMutexLocker locker(&mMutex);
+    return mNumRendered;
+}
+
+// DkSvgIconEngine --------------------------------------------------------------------
+DkSvgIconEngine::DkSvgIconEngine(const QString &filePath, const QColor &col)
+    : mFilePath(filePath)
+    , mColor(col)
+{
+}
+
+void DkSvgIconEngine::paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state)
+{
+    double dpr = (painter->device()) ? painter->device()->devicePixelRatioF() : 1.0;
+    painter->drawPixmap(rect, pixmap(rect.size(), mode, state, dpr));
+}
+
+QPixmap DkSvgIconEngine::pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state)
+{
+    return pixmap(size, mode, state, 1.0);
+}
+
+/**
+ * Returns the pixmap of the icon.
+ * Pixmaps are kept per engine, so painting does not touch the DkIconCache (or the file) again.
+ **/
+QPixmap DkSvgIconEngine::pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state, double dpr)
+{
+    // the color is part of the key - so theme changes are picked up
+    QColor c = (mColor.isValid()) ? mColor : DkSettingsManager::param().display().iconColor;
+    QString k = QString::number(size.width()) + "x" + QString::number(size.height()) + "|" + QString::number(mode) + "|" + QString::number(state) + "|"
+        + QString::number(dpr) + "|" + QString::number(c.rgba());
+
+    auto it = mPixmaps.constFind(k);
+    if (it != mPixmaps.constEnd())
+        return it.value();
+
+    QPixmap pm = QPixmap::fromImage(DkIconCache::instance().icon(filePath(state), size, c, dpr));
+
+    // mimic QIcon's default behavior for disabled icons
+    if (mode == QIcon::Disabled && !pm.isNull() && qApp) {
+        QStyleOption opt(0);
+        opt.palette = QApplication::palette();
+        pm = QApplication::style()->generatedIconPixmap(mode, pm, &opt);
+    }
+
+    mPixmaps.insert(k, pm);
+
+    return pm;
+}
+
+QSize DkSvgIconEngine::actualSize(const QSize &size, QIcon::Mode, QIcon::State)
+{
+    return size;
+}
+
+void DkSvgIconEngine::addFile(const QString &fileName, const QSize &, QIcon::Mode, QIcon::State state)
+{
+    if (state == QIcon::Off)
+        mFilePathOff = fileName;
+    else
+        mFilePath = fileName;
+
+    mPixmaps.clear();
+}
+
+QIconEngine *DkSvgIconEngine::clone() const
+{
+    return new DkSvgIconEngine(*this);
+}
+
+QString DkSvgIconEngine::key() const
+{
+    return "DkSvgIconEngine";
+}
+
+void DkSvgIconEngine::virtual_hook(int id, void *data)
+{
+    if (id == QIconEngine::IsNullHook) {
+        *reinterpret_cast<bool *>(data) = mFilePath.isEmpty() && mFilePathOff.isEmpty();
+        return;
+    }
+
+    QIconEngine::virtual_hook(id, data);
+}
+
+QString DkSvgIconEngine::filePath(QIcon::State state) const
+{
+    if (state == QIcon::Off && !mFilePathOff.isEmpty())
+        return mFilePathOff;
+
+    return (!mFilePath.isEmpty()) ? mFilePath : mFilePathOff;
+}
+
 // DkImageStorage --------------------------------------------------------------------
 DkImageStorage::DkImageStorage(const QImage &img)
 {
@@ -1504,6 +2207,23 @@ void DkImageStorage::setImage(const QImage &img)
     mComputeState = l_cancelled;
 }
 
+/**
+ * Sets an image that was scaled ahead of time (e.g. the next slide of a slideshow).
+ * Hence, the image can be displayed without waiting for the computation.
+ * @param img the image scaled to the display size
+ **/
+void DkImageStorage::setScaledImage(const QImage &img)
+{
+    // the result of the previous image would replace it
+    if (img.isNull() || img.width() >= mImg.width() || mFutureWatcher.isRunning())
+        return;
+
+    mWaitTimer->stop();
+    mScaledImg = img;
+    mSize = img.size();
+    mComputeState = l_computed;
+}
+
 void DkImageStorage::antiAliasingChanged(bool antiAliasing)
 {
     DkSettingsManager::param().display().antiAliasing = antiAliasing;
@@ -1527,7 +2247,8 @@ QImage DkImageStorage::image(const QSize &size)
     )
         return mImg;
 
-    if (mScaledImg.size() == size)
+    // images scaled ahead of time might differ by a pixel
+    if (!mScaledImg.isNull() && qAbs(mScaledImg.width() - size.width()) <= 1 && qAbs(mScaledImg.height() - size.height()) <= 1)
         return mScaledImg;
 
     if (mComputeState != l_computing) {
@@ -1570,7 +2291,7 @@ QImage DkImageStorage::computeIntern(const QImage &src, const QSize &size)
         return src;
     }
 
-    DkTimer dt;
+    DK_TRACE_SCOPE("scale", "compute");
     QImage resizedImg = src;
 
     if (!DkSettingsManager::param().display().highQualityAntiAliasing) {
@@ -30,10 +30,16 @@
 #pragma warning(push, 0) // no warnings from includes - begin
 #include <QColor>
 #include <QFutureWatcher>
+#include <QHash>
+#include <QIconEngine>
 #include <QImage>
+#include <QMutex>
 #include <QObject>
+#include <QSharedPointer>
 #include <QVector>
 
+#include <functional>
+
 // opencv
 #ifdef WITH_OPENCV
 #include "opencv2/core/core.hpp"
@@ -106,6 +112,8 @@ public:
     static void gammaToLinear(QImage &img);
     static void linearToGamma(QImage &img);
     static void mapGammaTable(QImage &img, const QVector<uchar> &gammaTable);
+    static int numRowBands(const QImage &img);
+    static void mapRowBands(int numRows, int numBands, const std::function<void(int, int, int)> &fn);
     static QImage normImage(const QImage &img);
     static bool normImage(QImage &img);
     static QImage autoAdjustImage(const QImage &img);
@@ -118,6 +126,7 @@ public:
     static QImage grayscaleImage(const QImage &img);
     static QPixmap colorizePixmap(const QPixmap &icon, const QColor &col, float opacity = 1.0f);
     static QPixmap loadIcon(const QString &filePath = QString(), const QSize &size = QSize(), const QColor &col = QColor());
+    static QIcon loadIconDeferred(const QString &filePath, const QColor &col = QColor());
     static QPixmap loadFromSvg(const QString &filePath, const QSize &size);
     static QImage createThumb(const QImage &img, const int maxSize = -1);
     static bool addToImage(QImage &img, unsigned char val = 1);
@@ -147,6 +156,112 @@ private:
     static QImage rotateSimple(const QImage &img, double angle);
 };
 
+/**
+ * DkResizeKernel is a separable resampling filter for one
+ * (source size, target size, interpolation) combination.
+ * The filter weights are computed once and cached, so that
+ * resizing many images of the same size (e.g. in batch jobs)
+ * only pays for the filtering. Gamma correction is done with
+ * lookup tables in the same pass and rows are split across cores.
+ **/
+class DllCoreExport DkResizeKernel
+{
+public:
+    static QSharedPointer<DkResizeKernel> kernel(const QSize &srcSize, const QSize &dstSize, int interpolation);
+    static bool supports(const QImage &img);
+
+    QImage apply(const QImage &img, bool correctGamma = true) const;
+
+protected:
+    DkResizeKernel(const QSize &srcSize, const QSize &dstSize, int interpolation);
+
+    // source indices & weights of all target pixels along one axis
+    struct Axis {
+        int taps = 0;
+        QVector<int> index;
+        QVector<float> weight;
+    };
+
+    static Axis computeAxis(int srcLength, int dstLength, int interpolation);
+    static double filter(double x, int interpolation);
+    static double filterRadius(int interpolation);
+
+    QSize mSrcSize;
+    QSize mDstSize;
+    int mInterpolation;
+    Axis mHorizontal;
+    Axis mVertical;
+};
+
+/**
+ * DkIconCache is a process-wide cache of rasterized svg icons.
+ * Icons are keyed by (svg path, size, color, device pixel ratio)
+ * and the cache can be persisted to disk so that new instances
+ * do not need to render the svgs again.
+ **/
+class DllCoreExport DkIconCache
+{
+public:
+    static DkIconCache &instance();
+    ~DkIconCache();
+
+    // singleton
+    DkIconCache(DkIconCache const &) = delete;
+    void operator=(DkIconCache const &) = delete;
+
+    QImage icon(const QString &filePath, const QSize &size, const QColor &col = QColor(), double dpr = 1.0);
+
+    void load();
+    void save();
+    void clear();
+
+    int numIcons() const;
+    int numRendered() const;
+
+private:
+    DkIconCache();
+
+    QString key(const QString &filePath, const QSize &size, const QColor &col, double dpr) const;
+    QString cacheFilePath() const;
+    QImage render(const QString &filePath, const QSize &size, const QColor &col) const;
+
+    mutable QMutex mMutex;
+    QHash<QString, QImage> mIcons;
+    int mNumRendered = 0;
+    bool mLoaded = false;
+    bool mDirty = false;
+
+    static const int mMaxIcons = 2048;
+};
+
+/**
+ * Icon engine that rasterizes svg icons when they are painted for the first time.
+ * The pixmaps are taken from the DkIconCache and the icon color
+ * is resolved when painting - so theme changes are picked up automatically.
+ **/
+class DllCoreExport DkSvgIconEngine : public QIconEngine
+{
+public:
+    DkSvgIconEngine(const QString &filePath = QString(), const QColor &col = QColor());
+
+    void paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state) override;
+    QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state) override;
+    QSize actualSize(const QSize &size, QIcon::Mode mode, QIcon::State state) override;
+    void addFile(const QString &fileName, const QSize &size, QIcon::Mode mode, QIcon::State state) override;
+    QIconEngine *clone() const override;
+    QString key() const override;
+    void virtual_hook(int id, void *data) override;
+
+protected:
+    QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state, double dpr);
+    QString filePath(QIcon::State state) const;
+
+    QString mFilePath;
+    QString mFilePathOff;
+    QColor mColor;
+    QHash<QString, QPixmap> mPixmaps; // (size, mode, state, dpr, color)
+};
+
 class DllCoreExport DkImageStorage : public QObject
 {
     Q_OBJECT
@@ -175,6 +290,7 @@ public:
     };
 
     void setImage(const QImage &img);
+    void setScaledImage(const QImage &img);
     QImage imageConst() const;
     QImage image(const QSize &size = QSize());
     void cancel();
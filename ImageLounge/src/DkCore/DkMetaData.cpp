@@ -263,6 +263,97 @@ bool DkMetaDataT::saveMetaData(QSharedPointer<QByteArray> &ba, bool force)
     return true;
 }
 
+/**
+ * @brief jpegSegments() encodes the metadata as JPEG APP1 segments.
+ *
+ * The segments can be inserted into a freshly encoded JPEG without
+ * parsing it again (see saveMetaData()). The dimensions and the thumbnail
+ * are updated for img, this object is not changed.
+ * An empty array is returned if there is no metadata or it cannot be
+ * stored in segments (IPTC data or more than 64 KB).
+ *
+ * @param img the image that is saved
+ * @return QByteArray the Exif and XMP segments
+ */
+QByteArray DkMetaDataT::jpegSegments(const QImage &img) const
+{
+    if (mExifState == not_loaded || mExifState == no_data || !mExifImg.get())
+        return QByteArray();
+
+    if (!mExifImg->iptcData().empty())
+        return QByteArray();
+
+    // APP1 marker, length (including itself), identifier, payload
+    auto segment = [](const QByteArray &identifier, const char *data, size_t size) -> QByteArray {
+        QByteArray s;
+        qint64 length = 2 + identifier.size() + (qint64)size;
+
+        if (length > 0xFFFF)
+            return s;
+
+        s.append((char)0xFF).append((char)0xE1);
+        s.append((char)(length >> 8)).append((char)(length & 0xFF));
+        s.append(identifier);
+        s.append(data, (int)size);
+        return s;
+    };
+
+    QByteArray segments;
+
+    try {
+        Exiv2::ExifData exifData = mExifImg->exifData();
+
+        if (!exifData.empty()) {
+            // only update the dimensions - most cameras do not write them to IFD0
+            if (exifData.findKey(Exiv2::ExifKey("Exif.Image.ImageWidth")) != exifData.end())
+                exifData["Exif.Image.ImageWidth"] = (uint32_t)img.width();
+            if (exifData.findKey(Exiv2::ExifKey("Exif.Image.ImageLength")) != exifData.end())
+                exifData["Exif.Image.ImageLength"] = (uint32_t)img.height();
+            exifData["Exif.Image.ProcessingSoftware"] =
+                (qApp->organizationName() + " - " + qApp->applicationName() + " " + qApp->applicationVersion()).toStdString();
+
+            QByteArray thumb;
+            QBuffer buffer(&thumb);
+            buffer.open(QIODevice::WriteOnly);
+            DkImage::createThumb(img, 200).save(&buffer, "JPEG");
+
+            Exiv2::ExifThumb eThumb(exifData);
+            eThumb.erase();
+            eThumb.setJpegThumbnail((Exiv2::byte *)thumb.data(), thumb.size());
+
+            Exiv2::ByteOrder bo = mExifImg->byteOrder();
+            if (bo == Exiv2::invalidByteOrder)
+                bo = Exiv2::littleEndian;
+
+            Exiv2::Blob blob;
+            Exiv2::ExifParser::encode(blob, bo, exifData);
+
+            QByteArray s = segment(QByteArray("Exif\0\0", 6), (const char *)blob.data(), blob.size());
+            if (s.isEmpty())
+                return QByteArray();
+            segments += s;
+        }
+
+        const Exiv2::XmpData &xmpData = mExifImg->xmpData();
+
+        if (!xmpData.empty()) {
+            std::string packet;
+            if (Exiv2::XmpParser::encode(packet, xmpData, Exiv2::XmpParser::useCompactFormat) != 0)
+                return QByteArray();
+
+            QByteArray s = segment(QByteArray("http://ns.adobe.com/xap/1.0/", 29), packet.data(), packet.size());
+            if (s.isEmpty())
+                return QByteArray();
+            segments += s;
+        }
+    } catch (...) {
+        qDebug() << "[DkMetaDataT] could not encode jpeg segments";
+        return QByteArray();
+    }
+
+    return segments;
+}
+
 QString DkMetaDataT::getDescription() const
 {
     QString description;
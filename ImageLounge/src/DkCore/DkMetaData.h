@@ -100,6 +100,7 @@ public:
     void readMetaData(const QString &filePath, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
     bool saveMetaData(const QString &filePath, bool force = false);
     bool saveMetaData(QSharedPointer<QByteArray> &ba, bool force = false);
+    QByteArray jpegSegments(const QImage &img) const;
 
     int getOrientationDegree() const;
     ExifOrientationState checkExifOrientation() const;
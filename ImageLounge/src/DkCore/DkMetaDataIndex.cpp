@@ -0,0 +1,410 @@
+/*******************************************************************************************************
+ DkMetaDataIndex.cpp
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkMetaDataIndex.h"
+#include "DkMetaData.h"
+#include "DkSettings.h"
+#include "DkThumbs.h"
+#include "DkUtils.h"
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QDateTime>
+#include <QDebug>
+#include <QImageReader>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <limits>
+#pragma warning(pop) // no warnings from includes - end
+
+namespace nmc
+{
+
+// DkMetaDataEntry --------------------------------------------------------------------
+/**
+ * Reads the indexed fields of a file.
+ * Only the metadata is parsed - the image is not decoded.
+ * @param fileInfo the image file.
+ * @return DkMetaDataEntry the entry (without metadata if the file has none).
+ **/
+DkMetaDataEntry DkMetaDataEntry::read(const QFileInfo &fileInfo)
+{
+    DkMetaDataEntry e;
+    e.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    DkMetaDataT metaData;
+
+    try {
+        metaData.readMetaData(fileInfo.absoluteFilePath());
+    } catch (...) {
+        qWarning() << "[DkMetaDataIndex] could not read metadata of" << fileInfo.absoluteFilePath();
+    }
+
+    if (metaData.hasMetaData()) {
+        QString date = metaData.getExifValue("DateTimeOriginal");
+
+        if (date.isEmpty())
+            date = metaData.getExifValue("DateTime");
+
+        QDateTime dt = DkUtils::convertDate(date);
+
+        if (dt.isValid())
+            e.captureTime = dt.toMSecsSinceEpoch();
+
+        QString make = metaData.getExifValue("Make").trimmed();
+        QString model = metaData.getExifValue("Model").trimmed();
+
+        // most vendors repeat the make in the model (e.g. Canon / Canon EOS R5)
+        if (make.isEmpty() || model.startsWith(make, Qt::CaseInsensitive))
+            e.camera = model;
+        else
+            e.camera = (make + " " + model).trimmed();
+
+        e.lens = metaData.getNativeExifValue("Exif.Photo.LensModel", false).trimmed();
+
+        if (e.lens.isEmpty())
+            e.lens = metaData.getXmpValue("Xmp.aux.Lens").trimmed();
+
+        // some cameras write a list of ISO values
+        e.iso = metaData.getExifValue("ISOSpeedRatings").section(" ", 0, 0).toInt();
+        e.rating = qMax(metaData.getRating(), 0);
+        e.gps = !metaData.getNativeExifValue("Exif.GPSInfo.GPSLatitude", false).isEmpty();
+
+        QSize s = metaData.getImageSize();
+        e.width = s.width();
+        e.height = s.height();
+    }
+
+    // the header is enough to get the size
+    if (e.width <= 0 || e.height <= 0) {
+        QSize s = QImageReader(fileInfo.absoluteFilePath()).size();
+        e.width = qMax(s.width(), 0);
+        e.height = qMax(s.height(), 0);
+    }
+
+    return e;
+}
+
+bool DkMetaDataEntry::isValid() const
+{
+    return modified != -1;
+}
+
+/**
+ * Returns the capture time or the modification date if the capture time is unknown.
+ **/
+qint64 DkMetaDataEntry::sortTime() const
+{
+    return captureTime != -1 ? captureTime : modified;
+}
+
+QDataStream &operator<<(QDataStream &s, const DkMetaDataEntry &entry)
+{
+    s << entry.modified << entry.captureTime << (qint32)entry.rating << (qint32)entry.iso << (qint32)entry.width << (qint32)entry.height << entry.gps
+      << entry.camera << entry.lens;
+
+    return s;
+}
+
+QDataStream &operator>>(QDataStream &s, DkMetaDataEntry &entry)
+{
+    qint32 rating, iso, width, height;
+
+    s >> entry.modified >> entry.captureTime >> rating >> iso >> width >> height >> entry.gps >> entry.camera >> entry.lens;
+
+    entry.rating = rating;
+    entry.iso = iso;
+    entry.width = width;
+    entry.height = height;
+
+    return s;
+}
+
+// DkMetaDataFilter --------------------------------------------------------------------
+/**
+ * Parses the metadata terms of a filter.
+ * @param query the filter (e.g. "camera:canon rating>=3 holiday").
+ * @param remainder if set, all other words of the query (e.g. "holiday").
+ * @return DkMetaDataFilter the filter which is empty if the query has no metadata terms.
+ **/
+DkMetaDataFilter DkMetaDataFilter::parse(const QString &query, QString *remainder)
+{
+    static const QRegularExpression re("^(camera|lens|rating|iso|taken|width|height)(<=|>=|<|>|:|=)(.+)$", QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression dateRe("^(\\d{4})(?:[-/.](\\d{1,2}))?(?:[-/.](\\d{1,2}))?$");
+
+    DkMetaDataFilter filter;
+    QStringList rest;
+
+    for (const QString &t : query.split(" ", QString::SkipEmptyParts)) {
+        if (t.compare("gps", Qt::CaseInsensitive) == 0 || t.compare("!gps", Qt::CaseInsensitive) == 0) {
+            Term term;
+            term.field = field_gps;
+            term.op = op_eq;
+            term.value = t.startsWith("!") ? 0 : 1;
+            term.valueEnd = 0;
+            filter.mTerms << term;
+            continue;
+        }
+
+        QRegularExpressionMatch m = re.match(t);
+
+        if (!m.hasMatch()) {
+            rest << t;
+            continue;
+        }
+
+        QString field = m.captured(1).toLower();
+        QString op = m.captured(2);
+
+        Term term;
+        term.text = m.captured(3);
+        term.value = 0;
+        term.valueEnd = 0;
+
+        if (op == "<")
+            term.op = op_lt;
+        else if (op == "<=")
+            term.op = op_le;
+        else if (op == ">")
+            term.op = op_gt;
+        else if (op == ">=")
+            term.op = op_ge;
+        else
+            term.op = op_eq;
+
+        bool ok = true;
+
+        if (field == "camera" || field == "lens") {
+            term.field = field == "camera" ? field_camera : field_lens;
+            // text is always matched partially
+            ok = term.op == op_eq;
+        } else if (field == "taken") {
+            term.field = field_taken;
+            QRegularExpressionMatch dm = dateRe.match(term.text);
+            ok = dm.hasMatch();
+
+            if (ok) {
+                int y = dm.captured(1).toInt();
+                int mo = dm.captured(2).isEmpty() ? 0 : dm.captured(2).toInt();
+                int d = dm.captured(3).isEmpty() ? 0 : dm.captured(3).toInt();
+
+                QDate start(y, qMax(mo, 1), qMax(d, 1));
+                QDate end = d ? start.addDays(1) : mo ? start.addMonths(1) : start.addYears(1);
+                ok = start.isValid();
+
+                // capture times are local times (see DkUtils::convertDate)
+                term.value = QDateTime(start, QTime(0, 0)).toMSecsSinceEpoch();
+                term.valueEnd = QDateTime(end, QTime(0, 0)).toMSecsSinceEpoch();
+            }
+        } else {
+            if (field == "rating")
+                term.field = field_rating;
+            else if (field == "iso")
+                term.field = field_iso;
+            else if (field == "width")
+                term.field = field_width;
+            else
+                term.field = field_height;
+
+            term.value = term.text.toLongLong(&ok);
+            term.valueEnd = term.value + 1;
+        }
+
+        if (ok)
+            filter.mTerms << term;
+        else
+            rest << t;
+    }
+
+    if (remainder)
+        *remainder = rest.join(" ");
+
+    return filter;
+}
+
+bool DkMetaDataFilter::isEmpty() const
+{
+    return mTerms.empty();
+}
+
+/**
+ * Returns true if all terms match the entry.
+ * Entries that are not indexed yet never match.
+ **/
+bool DkMetaDataFilter::matches(const DkMetaDataEntry &entry) const
+{
+    if (!entry.isValid())
+        return false;
+
+    for (const Term &t : mTerms) {
+        bool match = false;
+
+        switch (t.field) {
+        case field_camera:
+            match = entry.camera.contains(t.text, Qt::CaseInsensitive);
+            break;
+        case field_lens:
+            match = entry.lens.contains(t.text, Qt::CaseInsensitive);
+            break;
+        case field_rating:
+            match = compare(entry.rating, t.op, t.value, t.valueEnd);
+            break;
+        case field_iso:
+            match = entry.iso > 0 && compare(entry.iso, t.op, t.value, t.valueEnd);
+            break;
+        case field_taken:
+            match = entry.captureTime != -1 && compare(entry.captureTime, t.op, t.value, t.valueEnd);
+            break;
+        case field_width:
+            match = compare(entry.width, t.op, t.value, t.valueEnd);
+            break;
+        case field_height:
+            match = compare(entry.height, t.op, t.value, t.valueEnd);
+            break;
+        case field_gps:
+            match = entry.gps == (t.value != 0);
+            break;
+        }
+
+        if (!match)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Compares v with the range [value valueEnd).
+ * Numbers have a range of 1 - so that both numbers and dates are matched alike.
+ **/
+bool DkMetaDataFilter::compare(qint64 v, Op op, qint64 value, qint64 valueEnd)
+{
+    switch (op) {
+    case op_eq:
+        return v >= value && v < valueEnd;
+    case op_lt:
+        return v < value;
+    case op_le:
+        return v < valueEnd;
+    case op_gt:
+        return v >= valueEnd;
+    case op_ge:
+        return v >= value;
+    }
+
+    return false;
+}
+
+// DkMetaDataIndexTask --------------------------------------------------------------------
+/**
+ * Reads the metadata of a file.
+ * The pending state is released when the task is deleted - also if it
+ * was removed from the pool before it could run.
+ **/
+class DkMetaDataIndexTask : public QRunnable
+{
+public:
+    DkMetaDataIndexTask(const QString &filePath, const QString &key)
+        : mFilePath(filePath)
+        , mKey(key)
+    {
+    }
+
+    ~DkMetaDataIndexTask()
+    {
+        DkMetaDataIndex::instance().release(mKey);
+    }
+
+    void run() override
+    {
+        DkMetaDataIndex::instance().insert(mKey, DkMetaDataEntry::read(QFileInfo(mFilePath)));
+    }
+
+protected:
+    QString mFilePath;
+    QString mKey;
+};
+
+// DkMetaDataIndex --------------------------------------------------------------------
+DkMetaDataIndex::DkMetaDataIndex()
+    : DkFileCacheT<DkMetaDataEntry>("DkMetaDataIndex", "metadata.cache", 200000)
+{
+}
+
+DkMetaDataIndex::~DkMetaDataIndex()
+{
+}
+
+DkMetaDataIndex &DkMetaDataIndex::instance()
+{
+    static DkMetaDataIndex inst;
+    return inst;
+}
+
+/**
+ * Returns true if images are currently sorted by metadata.
+ **/
+bool DkMetaDataIndex::isNeeded()
+{
+    int sm = DkSettingsManager::param().global().sortMode;
+    return sm == DkSettings::sort_date_taken || sm == DkSettings::sort_rating || sm == DkSettings::sort_camera;
+}
+
+/**
+ * Returns the indexed metadata of a file.
+ * This never touches the file - the modification date is cached by QFileInfo.
+ * @param fileInfo the file.
+ * @return the entry or an invalid entry if the file was not indexed yet (or changed since).
+ **/
+DkMetaDataEntry DkMetaDataIndex::entry(const QFileInfo &fileInfo)
+{
+    return value(fileInfo);
+}
+
+/**
+ * Queues all files that are not indexed yet.
+ * Files are indexed on the thumbnail pool - after thumbnails but ahead of scores & hashes.
+ * @param files the files to be indexed (in the order they should be indexed).
+ * @return bool true if files were queued - finished() is emitted once they are indexed.
+ **/
+bool DkMetaDataIndex::request(const QList<QFileInfo> &files)
+{
+    QList<QPair<QString, QString>> queued = queue(files);
+
+    if (queued.empty())
+        return false;
+
+    qInfo() << "[DkMetaDataIndex] indexing" << queued.size() << "images";
+
+    for (const QPair<QString, QString> &q : queued)
+        DkThumbsThreadPool::pool()->start(new DkMetaDataIndexTask(q.first, q.second), std::numeric_limits<int>::min() + 1);
+
+    return true;
+}
+
+}
@@ -0,0 +1,152 @@
+/*******************************************************************************************************
+ DkMetaDataIndex.h
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#include "DkFileCache.h"
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QString>
+#include <QVector>
+#pragma warning(pop) // no warnings from includes - end
+
+#pragma warning(disable : 4251) // TODO: remove
+
+#ifndef DllCoreExport
+#ifdef DK_CORE_DLL_EXPORT
+#define DllCoreExport Q_DECL_EXPORT
+#elif DK_DLL_IMPORT
+#define DllCoreExport Q_DECL_IMPORT
+#else
+#define DllCoreExport Q_DECL_IMPORT
+#endif
+#endif
+
+namespace nmc
+{
+
+/**
+ * The metadata fields of an image that are needed for sorting & filtering.
+ **/
+class DllCoreExport DkMetaDataEntry
+{
+public:
+    static DkMetaDataEntry read(const QFileInfo &fileInfo);
+
+    bool isValid() const;
+    qint64 sortTime() const;
+
+    // the file's modification date (ms since epoch) - entries of changed files are invalid
+    qint64 modified = -1;
+    // DateTimeOriginal (ms since epoch) or -1 if unknown
+    qint64 captureTime = -1;
+    int rating = 0;
+    int iso = 0;
+    int width = 0;
+    int height = 0;
+    bool gps = false;
+    QString camera;
+    QString lens;
+};
+
+DllCoreExport QDataStream &operator<<(QDataStream &s, const DkMetaDataEntry &entry);
+DllCoreExport QDataStream &operator>>(QDataStream &s, DkMetaDataEntry &entry);
+
+/**
+ * Metadata terms of a folder filter.
+ * Supported terms are camera:canon, lens:50mm, rating>=3, iso<=800,
+ * taken:2024-05 (also <, <=, >, >= with yyyy, yyyy-MM or yyyy-MM-dd),
+ * width>=4000, height>=3000, gps and !gps.
+ * All terms must match.
+ **/
+class DllCoreExport DkMetaDataFilter
+{
+public:
+    static DkMetaDataFilter parse(const QString &query, QString *remainder = 0);
+
+    bool isEmpty() const;
+    bool matches(const DkMetaDataEntry &entry) const;
+
+private:
+    enum Field {
+        field_camera,
+        field_lens,
+        field_rating,
+        field_iso,
+        field_taken,
+        field_width,
+        field_height,
+        field_gps,
+    };
+
+    enum Op {
+        op_eq,
+        op_lt,
+        op_le,
+        op_gt,
+        op_ge,
+    };
+
+    struct Term {
+        Field field;
+        Op op;
+        QString text;
+        qint64 value;
+        qint64 valueEnd; // exclusive end of date ranges
+    };
+
+    static bool compare(qint64 v, Op op, qint64 value, qint64 valueEnd);
+
+    QVector<Term> mTerms;
+};
+
+/**
+ * DkMetaDataIndex keeps the metadata fields that are needed for sorting & filtering.
+ * Files are indexed in parallel on the thumbnail pool (ahead of image scores and hashes).
+ * Entries are keyed by file path and modification date and persisted between sessions (see DkFileCache) -
+ * so sorting a folder by capture time does not read any file once it is indexed.
+ **/
+class DllCoreExport DkMetaDataIndex : public DkFileCacheT<DkMetaDataEntry>
+{
+public:
+    static DkMetaDataIndex &instance();
+    ~DkMetaDataIndex();
+
+    // singleton
+    DkMetaDataIndex(DkMetaDataIndex const &) = delete;
+    void operator=(DkMetaDataIndex const &) = delete;
+
+    static bool isNeeded();
+
+    DkMetaDataEntry entry(const QFileInfo &fileInfo);
+    bool request(const QList<QFileInfo> &files);
+
+private:
+    DkMetaDataIndex();
+};
+
+}
@@ -26,6 +26,7 @@
  *******************************************************************************************************/
 
 #include "DkProcess.h"
+#include "DkBasicLoader.h"
 #include "DkImageContainer.h"
 #include "DkImageStorage.h"
 #include "DkManipulators.h"
@@ -788,12 +789,35 @@ bool DkBatchProcess::process()
         mLogStrings.append(QObject::tr("Original filename added to Exif"));
 
     // save the image
-    if (imgC->saveImage(mSaveInfo.outputFilePath(), mSaveInfo.compression())) {
-        mLogStrings.append(QObject::tr("%1 saved...").arg(mSaveInfo.outputFilePath()));
+    QVector<DkSaveOutput> outputs = saveOutputs();
+
+    if (outputs.size() == 1) {
+        if (imgC->saveImage(mSaveInfo.outputFilePath(), mSaveInfo.compression())) {
+            mLogStrings.append(QObject::tr("%1 saved...").arg(mSaveInfo.outputFilePath()));
+        } else {
+            mLogStrings.append(QObject::tr("Could not save: %1").arg(mSaveInfo.outputFilePath()));
+            mFailure++;
+        }
     } else {
-        mLogStrings.append(QObject::tr("Could not save: %1").arg(mSaveInfo.outputFilePath()));
-        mFailure++;
+        // all formats are encoded from the same decoded image
+        QStringList saved = imgC->saveImages(outputs);
+
+        for (const DkSaveOutput &o : outputs) {
+            if (saved.contains(o.filePath())) {
+                mLogStrings.append(QObject::tr("%1 saved...").arg(o.filePath()));
+            } else {
+                mLogStrings.append(QObject::tr("Could not save: %1").arg(o.filePath()));
+                mFailure++;
+            }
+        }
+    }
+
+    // extra outputs that replaced existing files
+    for (const QPair<QString, QString> &b : mExtraBackups) {
+        if (!deleteOrRestoreBackup(b.first, b.second))
+            mFailure++;
     }
+    mExtraBackups.clear();
 
     if (!deleteOrRestoreExisting()) {
         mFailure++;
@@ -803,6 +827,52 @@ bool DkBatchProcess::process()
     return true;
 }
 
+QVector<DkSaveOutput> DkBatchProcess::saveOutputs()
+{
+    QVector<DkSaveOutput> outputs;
+    outputs << DkSaveOutput(mSaveInfo.outputFilePath(), mSaveInfo.compression());
+
+    QFileInfo outInfo = mSaveInfo.outputFileInfo();
+    int targetSize = DkBasicLoader::targetSize(mSaveInfo.compression());
+
+    // extra formats may have their own quality (e.g. webp:80)
+    for (const QString &format : mSaveInfo.extraFormats()) {
+        QString suffix = format.section(":", 0, 0);
+        QString filePath = QFileInfo(outInfo.absolutePath(), outInfo.completeBaseName() + "." + suffix).absoluteFilePath();
+
+        if (filePath == mSaveInfo.outputFilePath())
+            continue;
+
+        if (QFileInfo(filePath).exists()) {
+            if (!(mSaveInfo.mode() & DkSaveInfo::mode_overwrite)) {
+                mLogStrings.append(QObject::tr("%1 already exists -> skipping (check 'overwrite' if you want to overwrite the file)").arg(filePath));
+                continue;
+            }
+
+            // existing files are restored if saving fails - just like the primary output
+            QString backupPath = DkSaveInfo::uniqueBackupFilePath(filePath);
+
+            if (!backupExisting(filePath, backupPath)) {
+                mFailure++;
+                continue;
+            }
+
+            mExtraBackups << qMakePair(filePath, backupPath);
+        }
+
+        // the primary's quality means something else for other formats - so only a file size limit is shared
+        bool ok = false;
+        int compression = format.section(":", 1, 1).toInt(&ok);
+
+        if (!ok)
+            compression = (targetSize > 0 && DkBasicLoader::supportsTargetSize(filePath)) ? DkBasicLoader::targetSizeCompression(targetSize) : -1;
+
+        outputs << DkSaveOutput(filePath, compression);
+    }
+
+    return outputs;
+}
+
 bool DkBatchProcess::renameFile()
 {
     if (QFileInfo(mSaveInfo.outputFilePath()).exists()) {
@@ -894,32 +964,57 @@ bool DkBatchProcess::prepareDeleteExisting()
     if (QFileInfo(mSaveInfo.outputFilePath()).exists() && mSaveInfo.mode() == DkSaveInfo::mode_overwrite) {
         mSaveInfo.createBackupFilePath();
 
-        // check the uniqueness : )
-        if (QFileInfo(mSaveInfo.backupFilePath()).exists()) {
-            mLogStrings.append(QObject::tr("Error: back-up (%1) file already exists").arg(mSaveInfo.backupFilePath()));
+        if (!backupExisting(mSaveInfo.outputFilePath(), mSaveInfo.backupFilePath())) {
             mSaveInfo.clearBackupFilePath();
             return false;
         }
+    }
 
-        QFile file(mSaveInfo.outputFilePath());
+    return true;
+}
 
-        if (!file.rename(mSaveInfo.backupFilePath())) {
-            mLogStrings.append(QObject::tr("Error: could not rename existing file to %1").arg(mSaveInfo.backupFilePath()));
-            mLogStrings.append(file.errorString());
-            mSaveInfo.clearBackupFilePath();
-            return false;
-        }
+bool DkBatchProcess::deleteOrRestoreExisting()
+{
+    return deleteOrRestoreBackup(mSaveInfo.outputFilePath(), mSaveInfo.backupFilePath());
+}
+
+/**
+ * Renames an existing file to its back-up.
+ * @param filePath the file that will be overwritten.
+ * @param backupPath the back-up's path.
+ * @return bool true if the file was renamed.
+ **/
+bool DkBatchProcess::backupExisting(const QString &filePath, const QString &backupPath)
+{
+    // check the uniqueness : )
+    if (QFileInfo(backupPath).exists()) {
+        mLogStrings.append(QObject::tr("Error: back-up (%1) file already exists").arg(backupPath));
+        return false;
+    }
+
+    QFile file(filePath);
+
+    if (!file.rename(backupPath)) {
+        mLogStrings.append(QObject::tr("Error: could not rename existing file to %1").arg(backupPath));
+        mLogStrings.append(file.errorString());
+        return false;
     }
 
     return true;
 }
 
-bool DkBatchProcess::deleteOrRestoreExisting()
+/**
+ * Deletes the back-up if the file was saved - otherwise the back-up is restored.
+ * @param filePath the file that was saved.
+ * @param backupPath the back-up's path.
+ * @return bool false if the back-up could not be deleted or restored.
+ **/
+bool DkBatchProcess::deleteOrRestoreBackup(const QString &filePath, const QString &backupPath)
 {
-    QFileInfo outInfo(mSaveInfo.outputFilePath());
+    QFileInfo outInfo(filePath);
 
-    if (outInfo.exists() && !mSaveInfo.backupFilePath().isEmpty() && mSaveInfo.backupFileInfo().exists()) {
-        QFile file(mSaveInfo.backupFilePath());
+    if (outInfo.exists() && !backupPath.isEmpty() && QFileInfo(backupPath).exists()) {
+        QFile file(backupPath);
 
         if (!file.remove()) {
             mLogStrings.append(QObject::tr("Error: could not delete existing file"));
@@ -929,14 +1024,14 @@ bool DkBatchProcess::deleteOrRestoreExisting()
     }
     // fall-back
     else if (!outInfo.exists()) {
-        QFile file(mSaveInfo.backupFilePath());
+        QFile file(backupPath);
 
-        if (!file.rename(mSaveInfo.outputFilePath())) {
-            mLogStrings.append(QObject::tr("Ui - a lot of things went wrong. Your original file can be found here: %1").arg(mSaveInfo.backupFilePath()));
+        if (!file.rename(filePath)) {
+            mLogStrings.append(QObject::tr("Ui - a lot of things went wrong. Your original file can be found here: %1").arg(backupPath));
             mLogStrings.append(file.errorString());
             return false;
         } else {
-            mLogStrings.append(QObject::tr("I could not save to %1 so I restored the original file.").arg(mSaveInfo.outputFilePath()));
+            mLogStrings.append(QObject::tr("I could not save to %1 so I restored the original file.").arg(filePath));
         }
     }
 
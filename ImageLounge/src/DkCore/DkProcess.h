@@ -63,6 +63,7 @@ class DkImageContainer;
 class DkPluginContainer;
 class DkBaseManipulator;
 class DkMetaDataT;
+class DkSaveOutput;
 
 class DllCoreExport DkAbstractBatch
 {
@@ -243,10 +244,13 @@ protected:
     bool process();
     bool prepareDeleteExisting();
     bool deleteOrRestoreExisting();
+    bool backupExisting(const QString &filePath, const QString &backupPath);
+    bool deleteOrRestoreBackup(const QString &filePath, const QString &backupPath);
     bool deleteOriginalFile();
     bool copyFile();
     bool renameFile();
     bool updateMetaData(DkMetaDataT *md);
+    QVector<DkSaveOutput> saveOutputs();
 
     DkSaveInfo mSaveInfo;
     int mFailure = 0;
@@ -255,6 +259,7 @@ protected:
     QVector<QSharedPointer<DkBatchInfo>> mInfos;
     QVector<QSharedPointer<DkAbstractBatch>> mProcessFunctions;
     QStringList mLogStrings;
+    QVector<QPair<QString, QString>> mExtraBackups; // (extra output, back-up)
 };
 
 class DllCoreExport DkBatchConfig
@@ -44,7 +44,9 @@
 #include <QPushButton>
 #include <QRadioButton>
 #include <QSettings>
+#include <QSpinBox>
 #include <QVBoxLayout>
+#include <QtConcurrentRun>
 #pragma warning(pop) // no warnings from includes - end
 
 namespace nmc
@@ -134,6 +136,9 @@ void DkCompressDialog::saveSettings()
 
     if (mDialogMode != webp_dialog)
         settings.setValue("bgCompressionColor" + QString::number(mDialogMode), getBackgroundColor().rgba());
+
+    settings.setValue("TargetSizeEnabled" + QString::number(mDialogMode), mCbTargetSize->isChecked());
+    settings.setValue("TargetSize" + QString::number(mDialogMode), mSbTargetSize->value());
     settings.endGroup();
 }
 
@@ -147,6 +152,9 @@ void DkCompressDialog::loadSettings()
 
     if (cIdx >= 0 && cIdx < mCompressionCombo->count())
         mCompressionCombo->setCurrentIndex(cIdx);
+
+    mSbTargetSize->setValue(settings.value("TargetSize" + QString::number(mDialogMode), mSbTargetSize->value()).toInt());
+    mCbTargetSize->setChecked(settings.value("TargetSizeEnabled" + QString::number(mDialogMode), false).toBool());
     mColChooser->setColor(mBgCol);
     newBgCol();
     settings.endGroup();
@@ -183,6 +191,8 @@ void DkCompressDialog::init()
         mCbLossless->hide();
         mSizeCombo->hide();
         mCompressionCombo->setEnabled(true);
+        mCbTargetSize->setVisible(mDialogMode == jpg_dialog);
+        mSbTargetSize->setVisible(mDialogMode == jpg_dialog);
     } else if (mDialogMode == webp_dialog) {
         setWindowTitle(tr("WebP Settings"));
         mColChooser->setEnabled(false);
@@ -190,6 +200,8 @@ void DkCompressDialog::init()
         mColChooser->show();
 
         mSizeCombo->hide();
+        mCbTargetSize->show();
+        mSbTargetSize->show();
         losslessCompression(mCbLossless->isChecked());
     } else if (mDialogMode == avif_dialog) {
         setWindowTitle(tr("AVIF Settings"));
@@ -199,6 +211,8 @@ void DkCompressDialog::init()
         mCompressionCombo->setEnabled(true);
         mColChooser->hide();
         mCbLossless->hide();
+        mCbTargetSize->show();
+        mSbTargetSize->show();
         // AVIF use different quality scale
         updateQuality(mAvifImgQuality);
     } else if (mDialogMode == jxl_dialog) {
@@ -209,6 +223,8 @@ void DkCompressDialog::init()
         mCompressionCombo->setEnabled(true);
         mColChooser->hide();
         mCbLossless->hide();
+        mCbTargetSize->hide();
+        mSbTargetSize->hide();
     } else if (mDialogMode == web_dialog) {
         setWindowTitle(tr("Save for Web"));
 
@@ -216,8 +232,11 @@ void DkCompressDialog::init()
         mCompressionCombo->hide();
         mColChooser->hide();
         mCbLossless->hide();
+        mCbTargetSize->hide();
+        mSbTargetSize->hide();
     }
     loadSettings();
+    updateTargetQuality();
 }
 
 void DkCompressDialog::createLayout()
@@ -265,6 +284,20 @@ void DkCompressDialog::createLayout()
     mCbLossless = new QCheckBox(tr("Lossless Compression"), this);
     connect(mCbLossless, SIGNAL(toggled(bool)), this, SLOT(losslessCompression(bool)));
 
+    // target size - the quality is searched in the background
+    connect(&mTargetWatcher, SIGNAL(finished()), this, SLOT(targetQualityFound()));
+
+    mCbTargetSize = new QCheckBox(tr("Limit File Size"), this);
+    connect(mCbTargetSize, SIGNAL(toggled(bool)), this, SLOT(updateTargetQuality()));
+
+    mSbTargetSize = new QSpinBox(this);
+    mSbTargetSize->setRange(10, 1000000);
+    mSbTargetSize->setValue(500);
+    mSbTargetSize->setSuffix(" KB");
+    mSbTargetSize->setKeyboardTracking(false);
+    mSbTargetSize->setEnabled(false);
+    connect(mSbTargetSize, SIGNAL(valueChanged(int)), this, SLOT(updateTargetQuality()));
+
     mPreviewSizeLabel = new QLabel();
     mPreviewSizeLabel->setAlignment(Qt::AlignRight);
 
@@ -288,7 +321,9 @@ void DkCompressDialog::createLayout()
     previewLayout->addWidget(mColChooser, 2, 1, 1, 3);
     previewLayout->addWidget(mCbLossless, 3, 0);
     previewLayout->addWidget(mSizeCombo, 4, 0);
-    previewLayout->addWidget(mPreviewSizeLabel, 5, 1);
+    previewLayout->addWidget(mCbTargetSize, 5, 0);
+    previewLayout->addWidget(mSbTargetSize, 6, 0);
+    previewLayout->addWidget(mPreviewSizeLabel, 7, 1);
 
     // mButtons
     QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal, this);
@@ -340,7 +375,7 @@ void DkCompressDialog::drawPreview()
         QByteArray ba;
         QBuffer buffer(&ba);
         buffer.open(QIODevice::ReadWrite);
-        mNewImg.save(&buffer, "JPG", getCompression());
+        mNewImg.save(&buffer, "JPG", previewCompression());
         mNewImg.loadFromData(ba, "JPG");
         updateFileSizeLabel((float)ba.size(), origImg.size());
     } else if (mDialogMode == j2k_dialog) {
@@ -352,12 +387,12 @@ void DkCompressDialog::drawPreview()
         mNewImg.loadFromData(ba, "J2K");
         updateFileSizeLabel((float)ba.size(), origImg.size());
         qDebug() << "using j2k...";
-    } else if (mDialogMode == webp_dialog && getCompression() != -1) {
+    } else if (mDialogMode == webp_dialog && previewCompression() != -1) {
         // pre-compute the jpg compression
         QByteArray ba;
         QBuffer buffer(&ba);
         buffer.open(QIODevice::ReadWrite);
-        mNewImg.save(&buffer, "WEBP", getCompression());
+        mNewImg.save(&buffer, "WEBP", previewCompression());
         mNewImg.loadFromData(ba, "WEBP");
         updateFileSizeLabel((float)ba.size(), origImg.size());
         qDebug() << "using webp...";
@@ -365,7 +400,7 @@ void DkCompressDialog::drawPreview()
         QByteArray ba;
         QBuffer buffer(&ba);
         buffer.open(QIODevice::WriteOnly);
-        mNewImg.save(&buffer, "AVIF", getCompression());
+        mNewImg.save(&buffer, "AVIF", previewCompression());
         buffer.close();
         mNewImg.loadFromData(ba, "AVIF");
         updateFileSizeLabel((float)ba.size(), origImg.size());
@@ -411,6 +446,20 @@ void DkCompressDialog::drawPreview()
 
 void DkCompressDialog::updateFileSizeLabel(float bufferSize, QSize bufferImgSize, float factor)
 {
+    if (useTargetSize() && !mImg.isNull()) {
+        qint64 maxBytes = (qint64)mSbTargetSize->value() * 1024;
+        mPreviewSizeLabel->setEnabled(mTargetQuality >= 0);
+
+        if (mTargetQuality < 0)
+            mPreviewSizeLabel->setText(tr("File Size: searching..."));
+        else if (mTargetEncodedSize > maxBytes)
+            mPreviewSizeLabel->setText(tr("File Size: ~%1 (the limit cannot be reached)").arg(DkUtils::readableByte((float)mTargetEncodedSize)));
+        else
+            mPreviewSizeLabel->setText(tr("File Size: ~%1 (quality %2)").arg(DkUtils::readableByte((float)mTargetEncodedSize)).arg(mTargetQuality));
+
+        return;
+    }
+
     if (bufferImgSize.isEmpty())
         bufferImgSize = mNewImg.size();
 
@@ -448,7 +497,9 @@ QColor DkCompressDialog::getBackgroundColor() const
 int DkCompressDialog::getCompression()
 {
     int compression = -1;
-    if ((mDialogMode == jpg_dialog || !mCbLossless->isChecked()) && mDialogMode != web_dialog)
+    if (useTargetSize())
+        compression = DkBasicLoader::targetSizeCompression(mSbTargetSize->value(), mTargetQuality);
+    else if ((mDialogMode == jpg_dialog || !mCbLossless->isChecked()) && mDialogMode != web_dialog)
         compression = mCompressionCombo->itemData(mCompressionCombo->currentIndex()).toInt();
     else if (mDialogMode == web_dialog)
         compression = 80;
@@ -456,6 +507,21 @@ int DkCompressDialog::getCompression()
     return compression;
 }
 
+bool DkCompressDialog::useTargetSize() const
+{
+    return mCbTargetSize->isChecked() && (mDialogMode == jpg_dialog || mDialogMode == avif_dialog || (mDialogMode == webp_dialog && !mCbLossless->isChecked()));
+}
+
+/**
+ * Returns the quality that is used for the preview.
+ * If a target size is set, this is the quality found for the full image
+ * (or -1 while it is searched).
+ **/
+int DkCompressDialog::previewCompression()
+{
+    return useTargetSize() ? mTargetQuality : getCompression();
+}
+
 float DkCompressDialog::getResizeFactor()
 {
     float factor = -1;
@@ -472,7 +538,7 @@ void DkCompressDialog::setImage(const QImage &img)
 {
     mImg = img;
     updateSnippets();
-    drawPreview();
+    updateTargetQuality();
 }
 
 void DkCompressDialog::setDialogMode(int dialogMode)
@@ -483,6 +549,12 @@ void DkCompressDialog::setDialogMode(int dialogMode)
 
 void DkCompressDialog::accept()
 {
+    // the search would be repeated when saving anyway
+    if (mTargetWatcher.isRunning() && !mTargetDirty) {
+        mTargetWatcher.waitForFinished();
+        targetQualityFound();
+    }
+
     saveSettings();
 
     QDialog::accept();
@@ -509,6 +581,62 @@ void DkCompressDialog::newBgCol()
 void DkCompressDialog::losslessCompression(bool lossless)
 {
     mCompressionCombo->setEnabled(!lossless);
+    updateTargetQuality();
+}
+
+void DkCompressDialog::updateTargetQuality()
+{
+    bool targetSize = useTargetSize();
+    mSbTargetSize->setEnabled(targetSize);
+    mCompressionCombo->setEnabled(!targetSize && !(mDialogMode == webp_dialog && mCbLossless->isChecked()));
+
+    mTargetQuality = -1;
+    mTargetEncodedSize = -1;
+
+    if (targetSize && !mImg.isNull()) {
+        // restart once the running search is done
+        if (mTargetWatcher.isRunning())
+            mTargetDirty = true;
+        else
+            searchTargetQuality();
+    }
+
+    drawPreview();
+}
+
+/**
+ * Searches the quality of the full image for the target size on a worker thread.
+ * The quality found is passed to the save functions (see getCompression()).
+ **/
+void DkCompressDialog::searchTargetQuality()
+{
+    QString suffix = (mDialogMode == webp_dialog) ? "webp" : (mDialogMode == avif_dialog) ? "avif" : "jpg";
+    QString filePath = "preview." + suffix;
+    QImage img = mImg;
+    qint64 maxBytes = (qint64)mSbTargetSize->value() * 1024;
+
+    mTargetDirty = false;
+    mTargetWatcher.setFuture(QtConcurrent::run([filePath, img, maxBytes]() {
+        qint64 size = -1;
+        int quality = DkBasicLoader::qualityForSize(filePath, img, maxBytes, &size);
+        return qMakePair(quality, size);
+    }));
+}
+
+void DkCompressDialog::targetQualityFound()
+{
+    if (!useTargetSize() || mImg.isNull())
+        return;
+
+    if (mTargetDirty) {
+        searchTargetQuality();
+        return;
+    }
+
+    QPair<int, qint64> result = mTargetWatcher.result();
+    mTargetQuality = result.first;
+    mTargetEncodedSize = result.second;
+
     drawPreview();
 }
 
@@ -29,6 +29,8 @@
 
 #pragma warning(push, 0) // no warnings from includes - begin
 #include <QDialog>
+#include <QFutureWatcher>
+#include <QPair>
 #pragma warning(pop) // no warnings from includes - end
 
 #ifndef DllCoreExport
@@ -48,6 +50,7 @@ class QRadioButton;
 class QCheckBox;
 class QLabel;
 class QComboBox;
+class QSpinBox;
 
 namespace nmc
 {
@@ -109,6 +112,8 @@ protected slots:
     void changeSizeWeb(int);
     void drawPreview();
     void updateFileSizeLabel(float bufferSize = -1, QSize bufferImgSize = QSize(), float factor = -1);
+    void updateTargetQuality();
+    void targetQualityFound();
 
 protected:
     void init();
@@ -117,6 +122,9 @@ protected:
     void saveSettings();
     void loadSettings();
     void resizeEvent(QResizeEvent *ev) override;
+    bool useTargetSize() const;
+    int previewCompression();
+    void searchTargetQuality();
 
     enum {
         best_quality = 0,
@@ -143,6 +151,13 @@ protected:
     DkBaseViewPort *mOrigView = 0;
     QComboBox *mSizeCombo = 0;
     QComboBox *mCompressionCombo = 0;
+    QCheckBox *mCbTargetSize = 0;
+    QSpinBox *mSbTargetSize = 0;
+    // the quality search runs in the background - mTargetQuality is -1 until it is found
+    QFutureWatcher<QPair<int, qint64>> mTargetWatcher;
+    bool mTargetDirty = false;
+    int mTargetQuality = -1;
+    qint64 mTargetEncodedSize = -1;
 
     QImage mImg;
     QImage mNewImg;
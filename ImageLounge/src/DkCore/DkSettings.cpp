@@ -363,6 +363,7 @@ void DkSettings::load(QSettings &settings, bool defaults)
     app_p.hideAllPanels = settings.value("hideAllPanels", app_p.hideAllPanels).toBool();
     app_p.closeOnEsc = settings.value("closeOnEsc", app_p.closeOnEsc).toBool();
     app_p.showRecentFiles = settings.value("showRecentFiles", app_p.showRecentFiles).toBool();
+    app_p.singleInstance = settings.value("singleInstance", app_p.singleInstance).toBool();
     app_p.useLogFile = settings.value("useLogFile", app_p.useLogFile).toBool();
     app_p.defaultJpgQuality = settings.value("defaultJpgQuality", app_p.defaultJpgQuality).toInt();
 
@@ -390,6 +391,7 @@ void DkSettings::load(QSettings &settings, bool defaults)
 
     global_p.loop = settings.value("loop", global_p.loop).toBool();
     global_p.scanSubFolders = settings.value("scanRecursive", global_p.scanSubFolders).toBool();
+    global_p.followNewFiles = settings.value("followNewFiles", global_p.followNewFiles).toBool();
     global_p.lastDir = settings.value("lastDir", global_p.lastDir).toString();
     global_p.searchHistory = settings.value("searchHistory", global_p.searchHistory).toStringList();
     global_p.recentFolders = settings.value("recentFolders", global_p.recentFolders).toStringList();
@@ -437,6 +439,9 @@ void DkSettings::load(QSettings &settings, bool defaults)
     display_p.showBorder = settings.value("showBorder", display_p.showBorder).toBool();
     display_p.displaySquaredThumbs = settings.value("displaySquaredThumbs", display_p.displaySquaredThumbs).toBool();
     display_p.showThumbLabel = settings.value("showThumbLabel", display_p.showThumbLabel).toBool();
+    display_p.showThumbScores = settings.value("showThumbScores", display_p.showThumbScores).toBool();
+    display_p.groupSimilarThumbs = settings.value("groupSimilarThumbs", display_p.groupSimilarThumbs).toBool();
+    display_p.collapseBursts = settings.value("collapseBursts", display_p.collapseBursts).toBool();
     display_p.showScrollBars = settings.value("showScrollBars", display_p.showScrollBars).toBool();
     display_p.animationDuration = settings.value("fadeSec", display_p.animationDuration).toFloat();
     display_p.alwaysAnimate = settings.value("alwaysAnimate", display_p.alwaysAnimate).toBool();
@@ -458,6 +463,7 @@ void DkSettings::load(QSettings &settings, bool defaults)
 
     slideShow_p.filter = settings.value("filter", slideShow_p.filter).toInt();
     slideShow_p.time = settings.value("time", slideShow_p.time).toFloat();
+    slideShow_p.frameRate = settings.value("frameRate", slideShow_p.frameRate).toFloat();
     slideShow_p.showPlayer = settings.value("showPlayer", slideShow_p.showPlayer).toBool();
     slideShow_p.moveSpeed = settings.value("moveSpeed", slideShow_p.moveSpeed).toFloat();
     slideShow_p.backgroundColor = QColor::fromRgba(settings.value("backgroundColorRGBA", slideShow_p.backgroundColor.rgba()).toInt());
@@ -485,6 +491,7 @@ void DkSettings::load(QSettings &settings, bool defaults)
 
     resources_p.cacheMemory = settings.value("cacheMemory", resources_p.cacheMemory).toFloat();
     resources_p.historyMemory = settings.value("historyMemory", resources_p.historyMemory).toFloat();
+    resources_p.thumbMemory = settings.value("thumbMemory", resources_p.thumbMemory).toFloat();
     resources_p.nativeDialog = settings.value("nativeDialog", resources_p.nativeDialog).toBool();
     resources_p.maxImagesCached = settings.value("maxImagesCached", resources_p.maxImagesCached).toInt();
     resources_p.waitForLastImg = settings.value("waitForLastImg", resources_p.waitForLastImg).toBool();
@@ -579,6 +586,8 @@ void DkSettings::save(QSettings &settings, bool force)
         settings.setValue("closeOnEsc", app_p.closeOnEsc);
     if (force || app_p.showRecentFiles != app_d.showRecentFiles)
         settings.setValue("showRecentFiles", app_p.showRecentFiles);
+    if (force || app_p.singleInstance != app_d.singleInstance)
+        settings.setValue("singleInstance", app_p.singleInstance);
     if (force || app_p.useLogFile != app_d.useLogFile)
         settings.setValue("useLogFile", app_p.useLogFile);
     if (force || app_p.browseFilters != app_d.browseFilters)
@@ -605,6 +614,8 @@ void DkSettings::save(QSettings &settings, bool force)
         settings.setValue("loop", global_p.loop);
     if (force || global_p.scanSubFolders != global_d.scanSubFolders)
         settings.setValue("scanRecursive", global_p.scanSubFolders);
+    if (force || global_p.followNewFiles != global_d.followNewFiles)
+        settings.setValue("followNewFiles", global_p.followNewFiles);
     if (force || global_p.lastDir != global_d.lastDir)
         settings.setValue("lastDir", global_p.lastDir);
     if (force || global_p.searchHistory != global_d.searchHistory)
@@ -692,6 +703,12 @@ void DkSettings::save(QSettings &settings, bool force)
         settings.setValue("displaySquaredThumbs", display_p.displaySquaredThumbs);
     if (force || display_p.showThumbLabel != display_d.showThumbLabel)
         settings.setValue("showThumbLabel", display_p.showThumbLabel);
+    if (force || display_p.showThumbScores != display_d.showThumbScores)
+        settings.setValue("showThumbScores", display_p.showThumbScores);
+    if (force || display_p.groupSimilarThumbs != display_d.groupSimilarThumbs)
+        settings.setValue("groupSimilarThumbs", display_p.groupSimilarThumbs);
+    if (force || display_p.collapseBursts != display_d.collapseBursts)
+        settings.setValue("collapseBursts", display_p.collapseBursts);
     if (force || display_p.showScrollBars != display_d.showScrollBars)
         settings.setValue("showScrollBars", display_p.showScrollBars);
     if (force || display_p.alwaysAnimate != display_d.alwaysAnimate)
@@ -724,6 +741,8 @@ void DkSettings::save(QSettings &settings, bool force)
         settings.setValue("filter", slideShow_p.filter);
     if (force || slideShow_p.time != slideShow_d.time)
         settings.setValue("time", slideShow_p.time);
+    if (force || slideShow_p.frameRate != slideShow_d.frameRate)
+        settings.setValue("frameRate", slideShow_p.frameRate);
     if (force || slideShow_p.showPlayer != slideShow_d.showPlayer)
         settings.setValue("showPlayer", slideShow_p.showPlayer);
     if (force || slideShow_p.moveSpeed != slideShow_d.moveSpeed)
@@ -762,6 +781,8 @@ void DkSettings::save(QSettings &settings, bool force)
         settings.setValue("cacheMemory", resources_p.cacheMemory);
     if (force || resources_p.historyMemory != resources_d.historyMemory)
         settings.setValue("historyMemory", resources_p.historyMemory);
+    if (force || resources_p.thumbMemory != resources_d.thumbMemory)
+        settings.setValue("thumbMemory", resources_p.thumbMemory);
     if (force || resources_p.nativeDialog != resources_d.nativeDialog)
         settings.setValue("nativeDialog", resources_p.nativeDialog);
     if (force || resources_p.maxImagesCached != resources_d.maxImagesCached)
@@ -817,6 +838,7 @@ void DkSettings::setToDefaultSettings()
     app_p.closeOnEsc = false;
     app_p.hideAllPanels = false;
     app_p.showRecentFiles = true;
+    app_p.singleInstance = false;
     app_p.browseFilters = QStringList();
     app_p.showMenuBar = true;
     app_p.useLogFile = false;
@@ -835,6 +857,7 @@ void DkSettings::setToDefaultSettings()
     global_p.extendedTabs = false;
     global_p.loop = true;
     global_p.scanSubFolders = false;
+    global_p.followNewFiles = false;
     global_p.lastDir = QString();
     global_p.lastSaveDir = QString();
     global_p.recentFiles = QStringList();
@@ -887,6 +910,9 @@ void DkSettings::setToDefaultSettings()
     display_p.showBorder = false;
     display_p.displaySquaredThumbs = true;
     display_p.showThumbLabel = false;
+    display_p.showThumbScores = false;
+    display_p.groupSimilarThumbs = false;
+    display_p.collapseBursts = false;
     display_p.showScrollBars = false;
     display_p.animationDuration = 0.5f;
     display_p.alwaysAnimate = false;
@@ -897,6 +923,7 @@ void DkSettings::setToDefaultSettings()
 
     slideShow_p.filter = 0;
     slideShow_p.time = 3.0;
+    slideShow_p.frameRate = 25.0f;
     slideShow_p.showPlayer = true;
     slideShow_p.moveSpeed = 0; // TODO: set to 1 for finishing slideshow
     slideShow_p.display = QBitArray(display_end, true);
@@ -915,6 +942,7 @@ void DkSettings::setToDefaultSettings()
 
     resources_p.cacheMemory = 256;
     resources_p.historyMemory = 128;
+    resources_p.thumbMemory = 128;
     resources_p.nativeDialog = true;
     resources_p.maxImagesCached = 5;
     resources_p.filterRawImages = true;
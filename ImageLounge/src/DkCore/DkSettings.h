@@ -124,6 +124,11 @@ public:
         sort_date_created,
         sort_date_modified,
         sort_random,
+        sort_sharpness,
+        sort_clipping,
+        sort_date_taken,
+        sort_rating,
+        sort_camera,
         sort_end,
     };
 
@@ -186,6 +191,7 @@ public:
         QBitArray showHistoryDock;
         QBitArray showLogDock;
         bool showRecentFiles;
+        bool singleInstance;
         bool useLogFile;
         int appMode;
         int currentAppMode;
@@ -238,6 +244,9 @@ public:
         bool showBorder;
         bool displaySquaredThumbs;
         bool showThumbLabel;
+        bool showThumbScores;
+        bool groupSimilarThumbs;
+        bool collapseBursts;
         bool showScrollBars;
 
         TransitionMode transition;
@@ -252,6 +261,7 @@ public:
         int numFiles;
         bool loop;
         bool scanSubFolders;
+        bool followNewFiles;
 
         QString lastDir;
         QString lastSaveDir;
@@ -285,6 +295,7 @@ public:
     struct SlideShow {
         int filter;
         float time;
+        float frameRate; // frame sequences (e.g. drif dumps) are played with this frame rate
         bool showPlayer;
         bool silentFullscreen;
         QBitArray display;
@@ -308,6 +319,7 @@ public:
     struct Resources {
         float cacheMemory;
         float historyMemory;
+        float thumbMemory;
         bool nativeDialog;
         int maxImagesCached;
         bool waitForLastImg;
@@ -67,6 +67,7 @@ public:
         status_filenumber_info,
         status_filesize_info,
         status_time_info,
+        status_fps_info,
 
         status_end,
     };
@@ -27,14 +27,17 @@
 
 #include "DkThumbs.h"
 #include "DkBasicLoader.h"
+#include "DkImageContainer.h"
+#include "DkImageHashes.h"
 #include "DkImageStorage.h"
 #include "DkMetaData.h"
 #include "DkSettings.h"
-#include "DkTimer.h"
+#include "DkTrace.h"
 #include "DkUtils.h"
 
 #pragma warning(push, 0) // no warnings from includes - begin
 #include <QBuffer>
+#include <QCoreApplication>
 #include <QFileInfo>
 #include <QImageReader>
 #include <QMutex>
@@ -55,6 +58,7 @@ namespace nmc
 DkThumbNail::DkThumbNail(const QString &filePath, const QImage &img)
 {
     mImg = DkImage::createThumb(img);
+    mImgSize = mImg.size();
     mFile = filePath;
     mMaxThumbSize = qRound(max_thumb_size * DkSettingsManager::param().dpiScaleFactor());
     mImgExists = true;
@@ -74,6 +78,9 @@ void DkThumbNail::compute(int forceLoad)
     // if we use member vars in the thread and the object gets deleted during thread execution we crash...
     mImg = computeIntern(mFile, QSharedPointer<QByteArray>(), forceLoad, mMaxThumbSize);
     mImg = DkImage::createThumb(mImg);
+
+    if (!mImg.isNull())
+        mImgSize = mImg.size();
 }
 
 /**
@@ -84,13 +91,14 @@ void DkThumbNail::compute(int forceLoad)
  * @param ba the file buffer (can be empty)
  * @param forceLoad the loading flag (e.g. exiv only)
  * @param maxThumbSize the maximal thumbnail size to be loaded
- * @param minThumbSize the minimal thumbnail size to be loaded
+ * @param needsDecode if not null, the full image is not decoded - instead the flag is set if a full decode is needed
  * @return QImage the loaded image. Null if no image
  * could be loaded at all.
  **/
-QImage DkThumbNail::computeIntern(const QString &filePath, const QSharedPointer<QByteArray> ba, int forceLoad, int maxThumbSize)
+QImage DkThumbNail::computeIntern(const QString &filePath, const QSharedPointer<QByteArray> ba, int forceLoad, int maxThumbSize, bool *needsDecode)
 {
-    DkTimer dt;
+    DkTraceSpan span("thumbnail", "compute");
+    span.setDetail(filePath);
     // qDebug() << "[thumb] file: " << filePath;
 
     // see if we can read the thumbnail from the exif data
@@ -99,7 +107,7 @@ QImage DkThumbNail::computeIntern(const QString &filePath, const QSharedPointer<
 
     QSharedPointer<QByteArray> baZip = QSharedPointer<QByteArray>();
 #ifdef WITH_QUAZIP
-    if (QFileInfo(mFile).dir().path().contains(DkZipContainer::zipMarker()))
+    if (QFileInfo(filePath).dir().path().contains(DkZipContainer::zipMarker()))
         baZip = DkZipContainer::extractImage(DkZipContainer::decodeZipFile(filePath), DkZipContainer::decodeImageFile(filePath));
 #endif
     try {
@@ -138,8 +146,15 @@ QImage DkThumbNail::computeIntern(const QString &filePath, const QSharedPointer<
 
     if ((forceLoad != force_exif_thumb || fInfo.size() < 1e5) && (thumb.isNull() || forceLoad == force_full_thumb || forceLoad == force_save_thumb)) { // braces
 
-        // try to read the image
+        // the caller decodes the image on a different thread
+        if (needsDecode) {
+            *needsDecode = true;
+            return QImage();
+        }
+
+        // try to read the image - a reduced resolution decode is sufficient
         DkBasicLoader loader;
+        loader.setDecodeSize(QSize(maxThumbSize, maxThumbSize));
 
         if (baZip && !baZip->isEmpty()) {
             if (loader.loadGeneral(lFilePath, baZip, true, true))
@@ -171,8 +186,9 @@ QImage DkThumbNail::computeIntern(const QString &filePath, const QSharedPointer<
             }
         }
 
-        // scale
-        thumb = thumb.scaled(QSize(w * 2, h * 2), Qt::KeepAspectRatio, Qt::FastTransformation);
+        // scale (reduced resolution decodes are already close to the thumbnail size)
+        if (thumb.width() > w * 2 || thumb.height() > h * 2)
+            thumb = thumb.scaled(QSize(w * 2, h * 2), Qt::KeepAspectRatio, Qt::FastTransformation);
         thumb = thumb.scaled(QSize(w, h), Qt::KeepAspectRatio, Qt::SmoothTransformation);
     }
 
@@ -182,6 +198,10 @@ QImage DkThumbNail::computeIntern(const QString &filePath, const QSharedPointer<
         thumb = thumb.transformed(rotationMatrix);
     }
 
+    // browsing a folder indexes it for near-duplicate searches
+    if (!thumb.isNull())
+        DkImageHashes::instance().addThumbnail(QFileInfo(filePath), thumb);
+
     // save the thumbnail if the caller either forces it, or the save thumb is requested and the image did not have any before
     if (forceLoad == force_save_thumb || (forceLoad == save_thumb && !exifThumb)) {
         try {
@@ -204,10 +224,6 @@ QImage DkThumbNail::computeIntern(const QString &filePath, const QSharedPointer<
             qWarning() << "Sorry, I could not save the metadata";
         }
     }
-    // if (!thumb.isNull())
-    // 	qInfoClean() << "[thumb] " << fInfo.fileName() << " (" << thumb.width() << " x " << thumb.height() << ") loaded in " << dt << ((exifThumb) ? " from
-    // EXIV" : " from File");
-
     return thumb;
 }
 
@@ -271,6 +287,9 @@ void DkThumbNail::removeBlackBorder(QImage &img)
 void DkThumbNail::setImage(const QImage img)
 {
     mImg = DkImage::createThumb(img);
+
+    if (!mImg.isNull())
+        mImgSize = mImg.size();
 }
 
 /**
@@ -287,14 +306,42 @@ DkThumbNailT::DkThumbNailT(const QString &filePath, const QImage &img)
 
 DkThumbNailT::~DkThumbNailT()
 {
-    mThumbWatcher.blockSignals(true);
-    mThumbWatcher.cancel();
+    if (mTask) {
+        mTask->disconnect(this);
+        DkThumbsThreadPool::cancel(mTask);
+    }
+
+    DkThumbCache::instance().remove(this);
+    DkImageCache::instance().releaseThumb(this);
 }
 
-bool DkThumbNailT::fetchThumb(int forceLoad /* = false */, QSharedPointer<QByteArray> ba)
+void DkThumbNailT::setImage(const QImage img)
 {
-    if (forceLoad == force_full_thumb || forceLoad == force_save_thumb || forceLoad == save_thumb)
+    DkThumbNail::setImage(img);
+    DkImageCache::instance().releaseThumb(this);
+
+    // the compressed copy is outdated now
+    mCompressed.clear();
+    touch();
+
+    emit thumbLoadedSignal(true);
+}
+
+/**
+ * Fetches the thumbnail in the background.
+ * @param forceLoad the loading flag (e.g. exif only)
+ * @param ba the file buffer (can be empty)
+ * @param priority the scheduling priority - higher values are loaded first
+ * @return bool true if a new fetch was started
+ **/
+bool DkThumbNailT::fetchThumb(int forceLoad /* = false */, QSharedPointer<QByteArray> ba, int priority)
+{
+    if (forceLoad == force_full_thumb || forceLoad == force_save_thumb || forceLoad == save_thumb) {
         mImg = QImage();
+        mCompressed.clear();
+        DkImageCache::instance().releaseThumb(this);
+        touch();
+    }
 
     if (!mImg.isNull() || !mImgExists || mFetching)
         return false;
@@ -304,48 +351,245 @@ bool DkThumbNailT::fetchThumb(int forceLoad /* = false */, QSharedPointer<QByteA
     if (!DkUtils::hasValidSuffix(getFilePath()) && !QFileInfo(getFilePath()).suffix().isEmpty() && !DkUtils::isValid(getFilePath()))
         return false;
 
+    // another tab (or the film strip) might have loaded the thumbnail already
+    mCacheKey = DkImageCache::cacheKey(getFilePath());
+
+    if (!mCacheKey.isEmpty())
+        mCacheKey += "@" + QString::number(mMaxThumbSize);
+
+    QImage cachedThumb = forceLoad == do_not_force ? DkImageCache::instance().thumb(mCacheKey) : QImage();
+
+    if (!cachedThumb.isNull()) {
+        mImg = DkImageCache::instance().insertThumb(this, mCacheKey, cachedThumb);
+        mImgSize = mImg.size();
+        touch();
+
+        // queued - callers fetch thumbnails in a loop when they receive this signal
+        QMetaObject::invokeMethod(this, "thumbLoadedSignal", Qt::QueuedConnection, Q_ARG(bool, true));
+        return true;
+    }
+
     // we have to do our own bool here
-    // watcher.isRunning() returns false if the thread is waiting in the pool
+    // the task does not run while it is waiting in the pool
     mFetching = true;
     mForceLoad = forceLoad;
+    mBuffer = ba;
+    mPriority = priority;
+
+    // the thumbnail was evicted - restore it from the compressed copy
+    if (!mCompressed.isEmpty() && forceLoad == do_not_force) {
+        mBuffer = QSharedPointer<QByteArray>(new QByteArray(mCompressed));
+        startTask(DkThumbLoadTask::stage_restore);
+        return true;
+    }
 
-    connect(&mThumbWatcher, SIGNAL(finished()), this, SLOT(thumbLoaded()), Qt::UniqueConnection);
-
-    mThumbWatcher.setFuture(QtConcurrent::run(DkThumbsThreadPool::pool(), // load thumbnails on their dedicated pool
-                                              this,
-                                              &nmc::DkThumbNailT::computeCall,
-                                              mFile,
-                                              ba,
-                                              forceLoad,
-                                              mMaxThumbSize));
+    // creating new thumbnails is CPU bound - so we skip the exif stage
+    bool decodeOnly = forceLoad == force_full_thumb || forceLoad == force_save_thumb;
+    startTask(decodeOnly ? DkThumbLoadTask::stage_decode : DkThumbLoadTask::stage_exif);
 
     return true;
 }
 
-QImage DkThumbNailT::computeCall(const QString &filePath, QSharedPointer<QByteArray> ba, int forceLoad, int maxThumbSize)
+/**
+ * Changes the priority of a thumbnail that is waiting to be loaded.
+ * @param priority the new priority - higher values are loaded first
+ **/
+void DkThumbNailT::setPriority(int priority)
+{
+    if (mPriority == priority)
+        return;
+
+    mPriority = priority;
+
+    if (mTask)
+        DkThumbsThreadPool::reschedule(mTask, priority);
+}
+
+/**
+ * Removes the thumbnail from the loading queue.
+ * Thumbnails that are currently loaded are not interrupted.
+ **/
+void DkThumbNailT::cancelFetch()
+{
+    if (mTask)
+        DkThumbsThreadPool::cancel(mTask);
+}
+
+/**
+ * Marks the thumbnail as recently used.
+ * Call this whenever the thumbnail is displayed, so that it is not evicted.
+ **/
+void DkThumbNailT::touch()
+{
+    DkThumbCache::instance().touch(this);
+}
+
+/**
+ * Releases the decoded thumbnail image.
+ * This is called by the DkThumbCache only.
+ **/
+void DkThumbNailT::evict()
+{
+    mImg = QImage();
+    DkImageCache::instance().releaseThumb(this);
+}
+
+/**
+ * Releases the compressed copy of the thumbnail.
+ * This is called by the DkThumbCache only.
+ **/
+void DkThumbNailT::dropCompressed()
+{
+    mCompressed.clear();
+}
+
+int DkThumbNailT::compressedSize() const
 {
-    QImage thumb = DkThumbNail::computeIntern(filePath, ba, forceLoad, maxThumbSize);
-    return DkImage::createThumb(thumb);
+    return mCompressed.size();
 }
 
-void DkThumbNailT::thumbLoaded()
+void DkThumbNailT::startTask(int stage)
 {
-    QFuture<QImage> future = mThumbWatcher.future();
+    mTask = new DkThumbLoadTask(mFile, mBuffer, mForceLoad, mMaxThumbSize, stage);
+    connect(mTask, SIGNAL(finished(const QImage &, const QByteArray &, bool)), this, SLOT(thumbLoaded(const QImage &, const QByteArray &, bool)));
+    connect(mTask, SIGNAL(cancelled()), this, SLOT(fetchCancelled()));
+
+    DkThumbsThreadPool::start(mTask, mPriority);
+}
 
-    mImg = future.result();
+void DkThumbNailT::thumbLoaded(const QImage &img, const QByteArray &compressed, bool needsDecode)
+{
+    // ignore tasks that were replaced in the meantime
+    if (sender() != mTask.data())
+        return;
 
-    if (mImg.isNull() && mForceLoad != force_exif_thumb)
+    // no exif thumbnail - decode the image on the decode pool
+    if (needsDecode) {
+        startTask(DkThumbLoadTask::stage_decode);
+        return;
+    }
+
+    // the compressed copy is corrupt - load the file again
+    if (img.isNull() && mTask->stage() == DkThumbLoadTask::stage_restore) {
+        mCompressed.clear();
+        mBuffer.clear();
+        startTask(DkThumbLoadTask::stage_exif);
+        return;
+    }
+
+    mImg = img;
+
+    // share the thumbnail with other tabs
+    if (!mImg.isNull() && mForceLoad == do_not_force)
+        mImg = DkImageCache::instance().insertThumb(this, mCacheKey, mImg);
+
+    if (!compressed.isEmpty())
+        mCompressed = compressed;
+
+    if (!mImg.isNull())
+        mImgSize = mImg.size();
+    else if (mForceLoad != force_exif_thumb)
         mImgExists = false;
 
+    mTask.clear();
+    mBuffer.clear();
     mFetching = false;
+    touch();
+
     emit thumbLoadedSignal(!mImg.isNull());
 }
 
+void DkThumbNailT::fetchCancelled()
+{
+    if (sender() != mTask.data())
+        return;
+
+    mTask.clear();
+    mBuffer.clear();
+    mFetching = false;
+}
+
+// DkThumbLoadTask --------------------------------------------------------------------
+DkThumbLoadTask::DkThumbLoadTask(const QString &filePath, QSharedPointer<QByteArray> ba, int forceLoad, int maxThumbSize, int stage)
+    : mFilePath(filePath)
+    , mBuffer(ba)
+    , mForceLoad(forceLoad)
+    , mMaxThumbSize(maxThumbSize)
+    , mStage(stage)
+{
+    // the task is deleted in the GUI thread after finishing
+    setAutoDelete(false);
+    connect(this, SIGNAL(finished(const QImage &, const QByteArray &, bool)), this, SLOT(deleteLater()));
+}
+
+DkThumbLoadTask::~DkThumbLoadTask()
+{
+    DkThumbsThreadPool::release(this);
+}
+
+void DkThumbLoadTask::run()
+{
+    // restoring an evicted thumbnail - the compressed copy is already processed
+    if (mStage == stage_restore) {
+        QImage thumb;
+
+        if (mBuffer)
+            thumb.loadFromData(*mBuffer);
+
+        emit finished(thumb, QByteArray(), false);
+        return;
+    }
+
+    // this is so complicated to be thread-safe
+    // if we use member vars of the thumbnail and it gets deleted during thread execution we crash...
+    bool needsDecode = false;
+    QImage thumb = DkThumbNail::computeIntern(mFilePath, mBuffer, mForceLoad, mMaxThumbSize, mStage == stage_exif ? &needsDecode : 0);
+    QByteArray compressed;
+
+    if (!needsDecode) {
+        thumb = DkImage::createThumb(thumb);
+
+        // keep a compressed copy - so the thumbnail can be evicted from memory
+        if (!thumb.isNull()) {
+            QBuffer buffer(&compressed);
+            buffer.open(QIODevice::WriteOnly);
+            thumb.save(&buffer, thumb.hasAlphaChannel() ? "PNG" : "JPG", thumb.hasAlphaChannel() ? -1 : 90);
+        }
+    }
+
+    emit finished(thumb, compressed, needsDecode);
+}
+
+/**
+ * Notifies the thumbnail that this task was removed from the queue and deletes it.
+ * Must only be called if the task is not running.
+ **/
+void DkThumbLoadTask::cancel()
+{
+    emit cancelled();
+    deleteLater();
+}
+
+int DkThumbLoadTask::stage() const
+{
+    return mStage;
+}
+
+QThreadPool *DkThumbLoadTask::pool() const
+{
+    // restoring is fast - it should not wait for full decodes
+    return (mStage == stage_exif || mStage == stage_restore) ? DkThumbsThreadPool::ioPool() : DkThumbsThreadPool::pool();
+}
+
 // DkThumbsThreadPool --------------------------------------------------------------------
 DkThumbsThreadPool::DkThumbsThreadPool()
 {
     mPool = new QThreadPool();
     mPool->setMaxThreadCount(qMax(mPool->maxThreadCount() - 2, 1));
+
+    // reading exif thumbnails mostly waits for the disk
+    mIoPool = new QThreadPool();
+    mIoPool->setMaxThreadCount(qMax(QThread::idealThreadCount() / 2, 2));
 }
 
 DkThumbsThreadPool &DkThumbsThreadPool::instance()
@@ -359,9 +603,201 @@ QThreadPool *DkThumbsThreadPool::pool()
     return instance().mPool;
 }
 
+QThreadPool *DkThumbsThreadPool::ioPool()
+{
+    return instance().mIoPool;
+}
+
+/**
+ * Removes all tasks that are not running yet.
+ * Thumbnail tasks are cancelled so that they can be fetched again later.
+ **/
 void DkThumbsThreadPool::clear()
 {
+    QSet<DkThumbLoadTask *> tasks = instance().mTasks;
+
+    for (DkThumbLoadTask *t : tasks)
+        cancel(t);
+
     pool()->clear();
+    ioPool()->clear();
+}
+
+/**
+ * Queues a thumbnail task.
+ * This function must be called from the GUI thread.
+ * @param task the task
+ * @param priority higher priorities are loaded first
+ **/
+void DkThumbsThreadPool::start(DkThumbLoadTask *task, int priority)
+{
+    instance().mTasks.insert(task);
+    task->pool()->start(task, priority);
+}
+
+/**
+ * Moves a waiting task to a new position in the queue.
+ * @param task the task
+ * @param priority the new priority
+ * @return bool false if the task is already running
+ **/
+bool DkThumbsThreadPool::reschedule(DkThumbLoadTask *task, int priority)
+{
+    if (!task->pool()->tryTake(task))
+        return false;
+
+    task->pool()->start(task, priority);
+    return true;
+}
+
+/**
+ * Removes a waiting task from the queue.
+ * @param task the task
+ * @return bool false if the task is already running
+ **/
+bool DkThumbsThreadPool::cancel(DkThumbLoadTask *task)
+{
+    if (!task->pool()->tryTake(task))
+        return false;
+
+    task->cancel();
+    return true;
+}
+
+void DkThumbsThreadPool::release(DkThumbLoadTask *task)
+{
+    instance().mTasks.remove(task);
+}
+
+// DkThumbCache --------------------------------------------------------------------
+DkThumbCache::DkThumbCache()
+{
+    mLogTimer.start();
+}
+
+DkThumbCache &DkThumbCache::instance()
+{
+    static DkThumbCache inst;
+    return inst;
+}
+
+/**
+ * Marks the thumbnail as recently used and updates its memory footprint.
+ * Least recently used thumbnails are evicted if the budget is exceeded.
+ * @param thumb the thumbnail
+ **/
+void DkThumbCache::touch(DkThumbNailT *thumb)
+{
+    if (!thumb || QThread::currentThread() != QCoreApplication::instance()->thread())
+        return;
+
+    Entry e = mEntries.value(thumb);
+    unlink(thumb, e);
+
+    e.tick = ++mTick;
+    e.bytes = thumb->getImage().sizeInBytes();
+    e.compressedBytes = thumb->compressedSize();
+
+    // nothing to keep track of
+    if (e.bytes == 0 && e.compressedBytes == 0)
+        return;
+
+    if (e.bytes > 0)
+        mResident.insert(e.tick, thumb);
+    if (e.compressedBytes > 0)
+        mCompressed.insert(e.tick, thumb);
+
+    mResidentBytes += e.bytes;
+    mCompressedBytes += e.compressedBytes;
+    mEntries.insert(thumb, e);
+
+    shrink();
+}
+
+/**
+ * Removes a thumbnail from the cache (without evicting it).
+ * @param thumb the thumbnail
+ **/
+void DkThumbCache::remove(DkThumbNailT *thumb)
+{
+    if (!mEntries.contains(thumb))
+        return;
+
+    unlink(thumb, mEntries.value(thumb));
+}
+
+int DkThumbCache::numResident() const
+{
+    return mResident.size();
+}
+
+int DkThumbCache::numCompressed() const
+{
+    return mCompressed.size();
+}
+
+int DkThumbCache::numEvictions() const
+{
+    return mNumEvictions;
+}
+
+void DkThumbCache::unlink(DkThumbNailT *thumb, const Entry &e)
+{
+    mResident.remove(e.tick);
+    mCompressed.remove(e.tick);
+    mResidentBytes -= e.bytes;
+    mCompressedBytes -= e.compressedBytes;
+    mEntries.remove(thumb);
+}
+
+void DkThumbCache::shrink()
+{
+    qint64 budget = qRound64(DkSettingsManager::param().resources().thumbMemory * 1024.0 * 1024.0);
+    qint64 compressedBudget = budget / 4;
+    int numEvictions = mNumEvictions;
+    int numDropped = mNumDropped;
+
+    // the most recent thumbnail is always kept
+    while (mResidentBytes > budget && mResident.size() > 1) {
+        auto it = mResident.begin();
+        DkThumbNailT *thumb = it.value();
+        Entry &e = mEntries[thumb];
+
+        mResident.erase(it);
+        mResidentBytes -= e.bytes;
+        e.bytes = 0;
+        thumb->evict();
+        mNumEvictions++;
+
+        if (e.compressedBytes == 0)
+            mEntries.remove(thumb);
+    }
+
+    while (mCompressedBytes > compressedBudget && mCompressed.size() > 1) {
+        auto it = mCompressed.begin();
+        DkThumbNailT *thumb = it.value();
+        Entry &e = mEntries[thumb];
+
+        mCompressed.erase(it);
+        mCompressedBytes -= e.compressedBytes;
+        e.compressedBytes = 0;
+        thumb->dropCompressed();
+        mNumDropped++;
+
+        if (e.bytes == 0)
+            mEntries.remove(thumb);
+    }
+
+    // don't flood the log while scrolling
+    if ((numEvictions != mNumEvictions || numDropped != mNumDropped) && mLogTimer.elapsed() > 1000) {
+        qInfo().noquote().nospace() << "[Thumbs] " << mResident.size() << " resident (" << DkUtils::readableByte((float)mResidentBytes) << "), "
+                                    << mCompressed.size() << " compressed (" << DkUtils::readableByte((float)mCompressedBytes) << "), " << mNumEvictions
+                          << " evictions, " << mNumDropped << " dropped";
+        mLogTimer.restart();
+    }
+
+    DK_TRACE_COUNTER("thumbnail", "resident [MB]", mResidentBytes / (1024.0 * 1024.0));
+    DK_TRACE_COUNTER("thumbnail", "compressed [MB]", mCompressedBytes / (1024.0 * 1024.0));
 }
 
 }
@@ -30,8 +30,14 @@
 #pragma warning(push, 0) // no warnings from includes - begin
 #include <QColor>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFutureWatcher>
+#include <QHash>
 #include <QImage>
+#include <QMap>
+#include <QPointer>
+#include <QRunnable>
+#include <QSet>
 #include <QSharedPointer>
 #include <QThread>
 #pragma warning(pop) // no warnings from includes - end
@@ -92,7 +98,7 @@ public:
      **/
     virtual void setImage(const QImage img);
 
-    void removeBlackBorder(QImage &img);
+    static void removeBlackBorder(QImage &img);
 
     /**
      * Returns the thumbnail.
@@ -112,6 +118,16 @@ public:
         return mFile;
     };
 
+    /**
+     * Returns the size of the last thumbnail image.
+     * The size is kept if the thumbnail was evicted from memory.
+     * @return QSize the thumbnail size
+     **/
+    QSize getImageSize() const
+    {
+        return mImgSize;
+    };
+
     void compute(int forceLoad = do_not_force);
 
     /**
@@ -155,16 +171,57 @@ public:
         force_save_thumb,
     };
 
-protected:
-    QImage computeIntern(const QString &file, QSharedPointer<QByteArray> ba, int forceLoad, int maxThumbSize);
+    static QImage computeIntern(const QString &file, QSharedPointer<QByteArray> ba, int forceLoad, int maxThumbSize, bool *needsDecode = 0);
 
+protected:
     QImage mImg;
+    QSize mImgSize;
     QString mFile;
     // int s;
     bool mImgExists;
     int mMaxThumbSize;
 };
 
+/**
+ * Loads a single thumbnail on one of the DkThumbsThreadPool pools.
+ * Reading embedded (exif) thumbnails is I/O bound and runs on the io pool,
+ * full decodes are CPU bound and run on the decode pool. So neither starves the other.
+ * The task lives in the GUI thread - it is created, (re)scheduled and deleted there.
+ **/
+class DkThumbLoadTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    enum Stage {
+        stage_exif,
+        stage_decode,
+        stage_restore,
+
+        stage_end
+    };
+
+    DkThumbLoadTask(const QString &filePath, QSharedPointer<QByteArray> ba, int forceLoad, int maxThumbSize, int stage);
+    ~DkThumbLoadTask();
+
+    void run() override;
+    void cancel();
+
+    int stage() const;
+    QThreadPool *pool() const;
+
+signals:
+    void finished(const QImage &img, const QByteArray &compressed, bool needsDecode) const;
+    void cancelled() const;
+
+protected:
+    QString mFilePath;
+    QSharedPointer<QByteArray> mBuffer;
+    int mForceLoad = DkThumbNail::do_not_force;
+    int mMaxThumbSize = max_thumb_size;
+    int mStage = stage_exif;
+};
+
 class DllCoreExport DkThumbNailT : public QObject, public DkThumbNail
 {
     Q_OBJECT
@@ -173,7 +230,14 @@ public:
     DkThumbNailT(const QString &mFile = QString(), const QImage &mImg = QImage());
     ~DkThumbNailT();
 
-    bool fetchThumb(int forceLoad = do_not_force, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
+    bool fetchThumb(int forceLoad = do_not_force, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>(), int priority = 0);
+    void setPriority(int priority);
+    void cancelFetch();
+
+    void touch();
+    void evict();
+    void dropCompressed();
+    int compressedSize() const;
 
     /**
      * Returns whether the thumbnail was loaded, or does not exist.
@@ -181,45 +245,102 @@ public:
      **/
     int hasImage() const
     {
-        if (mThumbWatcher.isRunning())
+        if (mFetching)
             return loading;
         else
             return DkThumbNail::hasImage();
     };
 
-    void setImage(const QImage img)
-    {
-        DkThumbNail::setImage(img);
-        emit thumbLoadedSignal(true);
-    };
+    void setImage(const QImage img);
 
 signals:
     void thumbLoadedSignal(bool loaded = true);
 
 protected slots:
-    void thumbLoaded();
+    void thumbLoaded(const QImage &img, const QByteArray &compressed, bool needsDecode);
+    void fetchCancelled();
 
 protected:
-    QImage computeCall(const QString &filePath, QSharedPointer<QByteArray> ba, int forceLoad, int maxThumbSize);
+    void startTask(int stage);
 
-    QFutureWatcher<QImage> mThumbWatcher;
+    QPointer<DkThumbLoadTask> mTask;
+    QSharedPointer<QByteArray> mBuffer;
+    QByteArray mCompressed;
+    QString mCacheKey; // see DkImageCache
     bool mFetching;
     int mForceLoad;
+    int mPriority = 0;
 };
 
+/**
+ * Thread pools for thumbnail loading.
+ * Thumbnail tasks are queued with a priority (higher values are loaded first),
+ * so that visible thumbnails do not wait for those that were scrolled away.
+ **/
 class DkThumbsThreadPool
 {
 public:
     static DkThumbsThreadPool &instance();
 
     static QThreadPool *pool();
+    static QThreadPool *ioPool();
     static void clear();
 
+    static void start(DkThumbLoadTask *task, int priority = 0);
+    static bool reschedule(DkThumbLoadTask *task, int priority);
+    static bool cancel(DkThumbLoadTask *task);
+    static void release(DkThumbLoadTask *task);
+
 private:
     DkThumbsThreadPool();
     DkThumbsThreadPool(const DkThumbsThreadPool &);
 
     QThreadPool *mPool;
+    QThreadPool *mIoPool;
+    QSet<DkThumbLoadTask *> mTasks;
+};
+
+/**
+ * Keeps the memory of decoded thumbnails within DkSettings::Resources::thumbMemory.
+ * Thumbnails are evicted in least recently used order. Evicted thumbnails keep
+ * a compressed copy (as long as it fits into a quarter of the budget) which is
+ * decoded much faster than the original file.
+ * The cache must only be used from the GUI thread.
+ **/
+class DllCoreExport DkThumbCache
+{
+public:
+    static DkThumbCache &instance();
+
+    void touch(DkThumbNailT *thumb);
+    void remove(DkThumbNailT *thumb);
+
+    int numResident() const;
+    int numCompressed() const;
+    int numEvictions() const;
+
+private:
+    DkThumbCache();
+    DkThumbCache(const DkThumbCache &);
+
+    struct Entry {
+        quint64 tick = 0;
+        qint64 bytes = 0;
+        qint64 compressedBytes = 0;
+    };
+
+    void shrink();
+    void unlink(DkThumbNailT *thumb, const Entry &e);
+
+    QHash<DkThumbNailT *, Entry> mEntries;
+    QMap<quint64, DkThumbNailT *> mResident; // decoded thumbnails - oldest first
+    QMap<quint64, DkThumbNailT *> mCompressed; // compressed thumbnails - oldest first
+    quint64 mTick = 0;
+    qint64 mResidentBytes = 0;
+    qint64 mCompressedBytes = 0;
+    int mNumEvictions = 0;
+    int mNumDropped = 0;
+    QElapsedTimer mLogTimer;
 };
 
 }
@@ -84,7 +84,7 @@ QDataStream &DkTimer::put(QDataStream &s) const
  * @param ct current time interval
  * @return QString the time interval as string
  **/
-QString DkTimer::stringifyTime(int ct) const
+QString DkTimer::stringifyTime(int ct)
 {
     if (ct < 2000)
         return QString::number(ct) + " ms";
@@ -69,7 +69,7 @@ public:
 
     QString getTotal() const;
     virtual QDataStream &put(QDataStream &s) const;
-    QString stringifyTime(int ct) const;
+    static QString stringifyTime(int ct);
     int elapsed() const;
     void start();
 
@@ -0,0 +1,350 @@
+/*******************************************************************************************************
+ DkTrace.cpp
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkTrace.h"
+#include "DkTimer.h"
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#pragma warning(pop) // no warnings from includes - end
+
+namespace nmc
+{
+
+// DkTraceStats --------------------------------------------------------------------
+void DkTraceStats::add(qint64 value)
+{
+    value = qMax(value, (qint64)0);
+
+    count++;
+    total += value;
+    max = qMax(max, value);
+
+    int bIdx = 0;
+    while (bIdx < buckets.size() - 1 && ((qint64)1 << (bIdx + 1)) <= value)
+        bIdx++;
+
+    buckets[bIdx]++;
+}
+
+/**
+ * Estimates a percentile from the log2 buckets.
+ * @param p the percentile [0 1] (e.g. 0.95).
+ * @return qint64 the upper bound of the bucket that contains the percentile.
+ **/
+qint64 DkTraceStats::percentile(double p) const
+{
+    if (count == 0)
+        return 0;
+
+    qint64 target = qMax((qint64)1, (qint64)(p * count + 0.5));
+    qint64 sum = 0;
+
+    for (int bIdx = 0; bIdx < buckets.size(); bIdx++) {
+        sum += buckets[bIdx];
+
+        if (sum >= target)
+            return qMin(((qint64)1 << (bIdx + 1)) - 1, max);
+    }
+
+    return max;
+}
+
+double DkTraceStats::mean() const
+{
+    return count > 0 ? (double)total / count : 0.0;
+}
+
+// DkTrace --------------------------------------------------------------------
+std::atomic<bool> DkTrace::sEnabled(qEnvironmentVariableIntValue("NOMACS_TRACE") != 0);
+
+DkTrace::DkTrace()
+{
+    mClock.start();
+}
+
+DkTrace::~DkTrace()
+{
+}
+
+DkTrace &DkTrace::instance()
+{
+    static DkTrace inst;
+    return inst;
+}
+
+void DkTrace::setEnabled(bool enabled)
+{
+    if (enabled == isEnabled())
+        return;
+
+    sEnabled.store(enabled, std::memory_order_relaxed);
+    qInfo() << "[DkTrace] tracing" << (enabled ? "enabled" : "disabled");
+}
+
+/**
+ * Returns the trace clock.
+ * @return qint64 microseconds since the trace was created.
+ **/
+qint64 DkTrace::now()
+{
+    return instance().mClock.nsecsElapsed() / 1000;
+}
+
+/**
+ * Formats a duration like DkTimer does.
+ * @param duration the duration in microseconds (see now()).
+ **/
+QString DkTrace::stringifyDuration(qint64 duration)
+{
+    return DkTimer::stringifyTime((int)(duration / 1000));
+}
+
+/**
+ * Records a span.
+ * @param category the category (e.g. decode, cache, thumbnail, paint) - it must be a string literal.
+ * @param name the span name - it must be a string literal.
+ * @param start the start time (see now()).
+ * @param end the end time (see now()).
+ * @param detail optional details (e.g. the file path).
+ **/
+void DkTrace::addSpan(const char *category, const char *name, qint64 start, qint64 end, const QString &detail)
+{
+    Event e;
+    e.category = category;
+    e.name = name;
+    e.phase = 'X';
+    e.ts = start;
+    e.dur = end - start;
+    e.value = 0.0;
+    e.detail = detail;
+
+    QMutexLocker locker(&mMutex);
+    e.tid = threadIndex();
+
+    QString key = QString::fromLatin1(category) + "/" + QString::fromLatin1(name);
+    DkTraceStats &s = mStats[key];
+
+    if (s.count == 0) {
+        s.category = QString::fromLatin1(category);
+        s.name = QString::fromLatin1(name);
+    }
+
+    s.add(e.dur);
+    addEvent(e);
+}
+
+/**
+ * Records the current value of a counter (e.g. the cache memory).
+ **/
+void DkTrace::addCounter(const char *category, const char *name, double value)
+{
+    Event e;
+    e.category = category;
+    e.name = name;
+    e.phase = 'C';
+    e.ts = now();
+    e.dur = 0;
+    e.value = value;
+
+    QMutexLocker locker(&mMutex);
+    e.tid = threadIndex();
+    mCounters.insert(QString::fromLatin1(category) + "/" + QString::fromLatin1(name), value);
+    addEvent(e);
+}
+
+/**
+ * Adds a value to a histogram (e.g. the size of decoded files).
+ * Histograms are not added to the timeline.
+ **/
+void DkTrace::addValue(const char *category, const char *name, qint64 value)
+{
+    QMutexLocker locker(&mMutex);
+
+    QString key = QString::fromLatin1(category) + "/" + QString::fromLatin1(name);
+    DkTraceStats &s = mStats[key];
+
+    if (s.count == 0) {
+        s.category = QString::fromLatin1(category);
+        s.name = QString::fromLatin1(name);
+    }
+
+    s.add(value);
+}
+
+void DkTrace::addEvent(const Event &e)
+{
+    if (mEvents.size() >= mMaxEvents) {
+        mNumDropped++;
+        return;
+    }
+
+    mEvents.append(e);
+}
+
+/**
+ * Returns a small index for the current thread (needs the mutex).
+ **/
+int DkTrace::threadIndex()
+{
+    static thread_local int tid = -1;
+
+    if (tid >= 0)
+        return tid;
+
+    QThread *t = QThread::currentThread();
+    QString name = t->objectName();
+
+    if (QCoreApplication::instance() && t == QCoreApplication::instance()->thread())
+        name = "main";
+    else if (name.isEmpty())
+        name = "worker " + QString::number(mThreadNames.size());
+
+    tid = mThreadNames.size();
+    mThreadNames << name;
+
+    return tid;
+}
+
+QVector<DkTraceStats> DkTrace::stats() const
+{
+    QMutexLocker locker(&mMutex);
+    return mStats.values().toVector();
+}
+
+QHash<QString, double> DkTrace::counters() const
+{
+    QMutexLocker locker(&mMutex);
+    return mCounters;
+}
+
+int DkTrace::numEvents() const
+{
+    QMutexLocker locker(&mMutex);
+    return mEvents.size();
+}
+
+int DkTrace::numDropped() const
+{
+    QMutexLocker locker(&mMutex);
+    return mNumDropped;
+}
+
+/**
+ * Removes all events & statistics.
+ * Thread names are kept since threads cache their index.
+ **/
+void DkTrace::clear()
+{
+    QMutexLocker locker(&mMutex);
+    mEvents.clear();
+    mStats.clear();
+    mCounters.clear();
+    mNumDropped = 0;
+}
+
+/**
+ * Writes all events in the Chrome trace event format.
+ * The file can be opened with chrome://tracing or https://ui.perfetto.dev
+ * @param filePath the json file.
+ * @return bool true if the file was written.
+ **/
+bool DkTrace::exportChromeTrace(const QString &filePath) const
+{
+    QJsonArray events;
+
+    {
+        QMutexLocker locker(&mMutex);
+
+        for (int idx = 0; idx < mThreadNames.size(); idx++) {
+            QJsonObject args;
+            args["name"] = mThreadNames[idx];
+
+            QJsonObject m;
+            m["name"] = "thread_name";
+            m["ph"] = "M";
+            m["pid"] = 1;
+            m["tid"] = idx;
+            m["args"] = args;
+            events.append(m);
+        }
+
+        for (const Event &e : mEvents) {
+            QJsonObject o;
+            o["name"] = QString::fromLatin1(e.name);
+            o["cat"] = QString::fromLatin1(e.category);
+            o["ph"] = QString(QChar(e.phase));
+            o["ts"] = e.ts;
+            o["pid"] = 1;
+            o["tid"] = e.tid;
+
+            QJsonObject args;
+
+            if (e.phase == 'X') {
+                o["dur"] = e.dur;
+
+                if (!e.detail.isEmpty())
+                    args["detail"] = e.detail;
+            } else
+                args["value"] = e.value;
+
+            if (!args.isEmpty())
+                o["args"] = args;
+
+            events.append(o);
+        }
+    }
+
+    QJsonObject trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[DkTrace] could not open" << filePath;
+        return false;
+    }
+
+    QByteArray json = QJsonDocument(trace).toJson(QJsonDocument::Compact);
+
+    if (file.write(json) != json.size() || !file.flush() || file.error() != QFileDevice::NoError) {
+        qWarning() << "[DkTrace] could not write" << filePath << "-" << file.errorString();
+        return false;
+    }
+
+    qInfo() << "[DkTrace]" << events.size() << "events exported to" << filePath;
+
+    return true;
+}
+
+}
@@ -0,0 +1,204 @@
+/*******************************************************************************************************
+ DkTrace.h
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2016 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2016 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2016 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#pragma warning(push, 0) // no warnings from includes - begin
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#pragma warning(pop) // no warnings from includes - end
+
+#pragma warning(disable : 4251) // TODO: remove
+
+#ifndef DllCoreExport
+#ifdef DK_CORE_DLL_EXPORT
+#define DllCoreExport Q_DECL_EXPORT
+#elif DK_DLL_IMPORT
+#define DllCoreExport Q_DECL_IMPORT
+#else
+#define DllCoreExport Q_DECL_IMPORT
+#endif
+#endif
+
+// scoped span: DK_TRACE_SCOPE("decode", "load");
+#define DK_TRACE_CONCAT_(a, b) a##b
+#define DK_TRACE_CONCAT(a, b) DK_TRACE_CONCAT_(a, b)
+#define DK_TRACE_SCOPE(category, name) nmc::DkTraceSpan DK_TRACE_CONCAT(dkTraceSpan, __LINE__)(category, name)
+
+// counter: DK_TRACE_COUNTER("cache", "images [MB]", imageMem);
+#define DK_TRACE_COUNTER(category, name, value)                                                                                                                \
+    do {                                                                                                                                                       \
+        if (nmc::DkTrace::isEnabled())                                                                                                                         \
+            nmc::DkTrace::instance().addCounter(category, name, (double)(value));                                                                              \
+    } while (0)
+
+namespace nmc
+{
+
+/**
+ * Aggregated durations (or values) of a span name.
+ * Values are binned into log2 buckets so that percentiles can be estimated.
+ **/
+class DllCoreExport DkTraceStats
+{
+public:
+    void add(qint64 value);
+    qint64 percentile(double p) const;
+    double mean() const;
+
+    QString category;
+    QString name;
+    qint64 count = 0;
+    qint64 total = 0;
+    qint64 max = 0;
+    QVector<qint64> buckets = QVector<qint64>(48, 0);
+};
+
+/**
+ * DkTrace records spans, counters and histograms of the hot paths
+ * (loading, decoding, caching, thumbnails, painting).
+ * Tracing is disabled by default - then a span costs a single atomic load.
+ * It can be switched at runtime (log dock) or enabled at start-up with NOMACS_TRACE=1.
+ * Recorded events can be exported as Chrome/Perfetto trace.
+ **/
+class DllCoreExport DkTrace
+{
+public:
+    static DkTrace &instance();
+    ~DkTrace();
+
+    // singleton
+    DkTrace(DkTrace const &) = delete;
+    void operator=(DkTrace const &) = delete;
+
+    static bool isEnabled()
+    {
+        return sEnabled.load(std::memory_order_relaxed);
+    };
+    static void setEnabled(bool enabled);
+    static qint64 now();
+    static QString stringifyDuration(qint64 duration);
+
+    void addSpan(const char *category, const char *name, qint64 start, qint64 end, const QString &detail = QString());
+    void addCounter(const char *category, const char *name, double value);
+    void addValue(const char *category, const char *name, qint64 value);
+
+    QVector<DkTraceStats> stats() const;
+    QHash<QString, double> counters() const;
+    int numEvents() const;
+    int numDropped() const;
+    void clear();
+
+    bool exportChromeTrace(const QString &filePath) const;
+
+private:
+    DkTrace();
+
+    struct Event {
+        const char *category;
+        const char *name;
+        char phase;
+        int tid;
+        qint64 ts;
+        qint64 dur;
+        double value;
+        QString detail;
+    };
+
+    int threadIndex();
+    void addEvent(const Event &e);
+
+    static std::atomic<bool> sEnabled;
+
+    mutable QMutex mMutex;
+    QElapsedTimer mClock;
+    QVector<Event> mEvents;
+    QHash<QString, DkTraceStats> mStats;
+    QHash<QString, double> mCounters;
+    QStringList mThreadNames;
+    int mNumDropped = 0;
+
+    static const int mMaxEvents = 1 << 20;
+};
+
+/**
+ * Records the lifetime of a scope as span.
+ * Nothing is recorded (nor the clock read) if tracing is disabled.
+ * Timed spans always read the clock so that their duration can be logged (see elapsed()).
+ **/
+class DkTraceSpan
+{
+public:
+    DkTraceSpan(const char *category, const char *name, bool timed = false)
+        : mCategory(category)
+        , mName(name)
+        , mRecord(DkTrace::isEnabled())
+        , mStart(mRecord || timed ? DkTrace::now() : -1)
+    {
+    }
+
+    ~DkTraceSpan()
+    {
+        if (mRecord)
+            DkTrace::instance().addSpan(mCategory, mName, mStart, DkTrace::now(), mDetail);
+    }
+
+    DkTraceSpan(DkTraceSpan const &) = delete;
+    void operator=(DkTraceSpan const &) = delete;
+
+    bool isActive() const
+    {
+        return mRecord;
+    };
+
+    // the duration so far (e.g. 12 ms) - for log messages
+    QString elapsed() const
+    {
+        return DkTrace::stringifyDuration(mStart >= 0 ? DkTrace::now() - mStart : 0);
+    };
+
+    void setDetail(const QString &detail)
+    {
+        if (isActive())
+            mDetail = detail;
+    };
+
+private:
+    const char *mCategory;
+    const char *mName;
+    bool mRecord;
+    qint64 mStart;
+    QString mDetail;
+};
+
+}
@@ -27,6 +27,7 @@
 
 #include "DkBatch.h"
 #include "DkActionManager.h"
+#include "DkBasicLoader.h"
 #include "DkBasicWidgets.h"
 #include "DkDialog.h"
 #include "DkImageLoader.h"
@@ -385,6 +386,11 @@ void DkBatchInput::createLayout()
             SIGNAL(updateDirSignal(QVector<QSharedPointer<DkImageContainerT>>)),
             mThumbScrollWidget,
             SLOT(updateThumbs(QVector<QSharedPointer<DkImageContainerT>>)));
+    connect(mLoader.data(),
+            SIGNAL(imageInsertedSignal(int, QSharedPointer<DkImageContainerT>)),
+            mThumbScrollWidget->getThumbWidget(),
+            SLOT(insertThumb(int, QSharedPointer<DkImageContainerT>)));
+    connect(mLoader.data(), SIGNAL(imageRemovedSignal(int)), mThumbScrollWidget->getThumbWidget(), SLOT(removeThumb(int)));
 }
 
 void DkBatchInput::applyDefault()
@@ -837,13 +843,38 @@ void DkBatchOutput::createLayout()
     mCbCompression = new QComboBox(this);
     updateCBCompression();
     mCbCompression->setEnabled(false);
+    connect(mCbCompression, SIGNAL(currentIndexChanged(int)), this, SLOT(compressionCBChanged(int)));
+
+    // the quality is searched for each image so that it fits this size
+    mSbTargetSize = new QSpinBox(this);
+    mSbTargetSize->setRange(10, 1000000);
+    mSbTargetSize->setValue(500);
+    mSbTargetSize->setSuffix(" KB");
+    mSbTargetSize->setEnabled(false);
 
     extensionLayout->addWidget(mCbExtension);
     extensionLayout->addWidget(mCbNewExtension);
     extensionLayout->addWidget(mCbCompression);
+    extensionLayout->addWidget(mSbTargetSize);
     // extensionLayout->addStretch();
     mFilenameVBLayout->addWidget(extensionWidget);
 
+    // all formats are encoded from the same image
+    QWidget *extraFormatsWidget = new QWidget(this);
+    QHBoxLayout *extraFormatsLayout = new QHBoxLayout(extraFormatsWidget);
+    extraFormatsLayout->setAlignment(Qt::AlignLeft);
+    extraFormatsLayout->setContentsMargins(0, 0, 0, 0);
+
+    mExtraFormatsEdit = new QLineEdit(this);
+    mExtraFormatsEdit->setPlaceholderText(tr("e.g. webp:80, png"));
+    mExtraFormatsEdit->setToolTip(tr("Additional formats - a quality can be appended (e.g. webp:80), otherwise the format's default is used"));
+    mExtraFormatsEdit->setFixedWidth(150);
+    connect(mExtraFormatsEdit, SIGNAL(textChanged(const QString &)), this, SIGNAL(changed()));
+
+    extraFormatsLayout->addWidget(new QLabel(tr("Also Save As:"), this));
+    extraFormatsLayout->addWidget(mExtraFormatsEdit);
+    mFilenameVBLayout->addWidget(extraFormatsWidget);
+
     QLabel *previewLabel = new QLabel(tr("Preview"), this);
     previewLabel->setObjectName("subTitle");
 
@@ -907,7 +938,10 @@ void DkBatchOutput::updateCBCompression()
         mCbCompression->insertItem(index, quality_label[index], quality[index]);
     }
 
-    if (previous_index == -1) {
+    if (extStr.contains(QRegExp("(avif|jpg|webp)", Qt::CaseInsensitive)))
+        mCbCompression->addItem(tr("Limit File Size"), DkBasicLoader::targetSizeCompression(1));
+
+    if (previous_index == -1 || previous_index >= mCbCompression->count()) {
         mCbCompression->setCurrentIndex(1);
     } else {
         mCbCompression->setCurrentIndex(previous_index);
@@ -1008,6 +1042,12 @@ void DkBatchOutput::extensionCBChanged(int index)
     parameterChanged();
 }
 
+void DkBatchOutput::compressionCBChanged(int index)
+{
+    bool targetSize = DkBasicLoader::targetSize(mCbCompression->itemData(index).toInt()) > 0;
+    mSbTargetSize->setEnabled(mCbCompression->isEnabled() && targetSize);
+}
+
 bool DkBatchOutput::hasUserInput() const
 {
     // TODO add output directory
@@ -1021,6 +1061,7 @@ void DkBatchOutput::parameterChanged()
     mCbCompression->setEnabled(extStr.contains(QRegExp("(avif|jpg|jp2|jxl|webp)", Qt::CaseInsensitive)));
 
     updateCBCompression();
+    compressionCBChanged(mCbCompression->currentIndex());
     updateFileLabelPreview();
     emit changed();
 }
@@ -1115,7 +1156,35 @@ int DkBatchOutput::getCompression() const
     if (!mCbCompression->isEnabled())
         return -1;
 
-    return mCbCompression->itemData(mCbCompression->currentIndex()).toInt();
+    int compression = mCbCompression->itemData(mCbCompression->currentIndex()).toInt();
+    if (DkBasicLoader::targetSize(compression) > 0)
+        compression = DkBasicLoader::targetSizeCompression(mSbTargetSize->value());
+
+    return compression;
+}
+
+QStringList DkBatchOutput::getExtraFormats() const
+{
+    QStringList suffixes;
+
+    for (QString s : mExtraFormatsEdit->text().split(QRegExp("[,;\\s]+"), QString::SkipEmptyParts)) {
+        s = s.remove(QRegExp("^\\*?\\.")).toLower();
+
+        // drop invalid qualities (e.g. webp:abc -> webp)
+        bool ok = false;
+        int quality = s.section(":", 1, 1).toInt(&ok);
+        s = s.section(":", 0, 0);
+
+        if (s.isEmpty() || suffixes.filter(QRegExp("^" + QRegExp::escape(s) + "(:|$)")).size() > 0)
+            continue;
+
+        if (ok && quality >= 0 && quality <= 100)
+            s += ":" + QString::number(quality);
+
+        suffixes << s;
+    }
+
+    return suffixes;
 }
 
 void DkBatchOutput::applyDefault()
@@ -1127,6 +1196,7 @@ void DkBatchOutput::applyDefault()
     mCbExtension->setCurrentIndex(0);
     mCbNewExtension->setCurrentIndex(0);
     mCbCompression->setCurrentIndex(0);
+    mExtraFormatsEdit->clear();
     mOutputDirectory = "";
     mInputDirectory = "";
     mHUserInput = false;
@@ -1157,6 +1227,16 @@ void DkBatchOutput::loadProperties(const DkBatchConfig &config)
 
     int c = si.compression();
 
+    if (DkBasicLoader::targetSize(c) > 0) {
+        mSbTargetSize->setValue(DkBasicLoader::targetSize(c));
+        c = DkBasicLoader::targetSizeCompression(1);
+    }
+
+    mExtraFormatsEdit->setText(si.extraFormats().join(", "));
+    loadFilePattern(config.getFileNamePattern());
+
+    // the extension determines the compression items
+    updateCBCompression();
     for (int idx = 0; idx < mCbCompression->count(); idx++) {
         if (mCbCompression->itemData(idx).toInt() == c) {
             mCbCompression->setCurrentIndex(idx);
@@ -1164,8 +1244,6 @@ void DkBatchOutput::loadProperties(const DkBatchConfig &config)
         }
     }
 
-    loadFilePattern(config.getFileNamePattern());
-
     parameterChanged();
 }
 
@@ -2655,6 +2733,7 @@ DkBatchConfig DkBatchWidget::createBatchConfig(bool strict) const
     si.setDeleteOriginal(outputWidget()->deleteOriginal());
     si.setInputDirIsOutputDir(outputWidget()->useInputDir());
     si.setCompression(outputWidget()->getCompression());
+    si.setExtraFormats(outputWidget()->getExtraFormats());
 
     DkBatchConfig config(inputWidget()->getSelectedFilesBatch(), outputWidget()->getOutputDirectory(), outputWidget()->getFilePattern());
     config.setSaveInfo(si);
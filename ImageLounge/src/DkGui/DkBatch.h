@@ -317,6 +317,7 @@ public:
 
     DkSaveInfo::OverwriteMode overwriteMode() const;
     int getCompression() const;
+    QStringList getExtraFormats() const;
     bool useInputDir() const;
     bool deleteOriginal() const;
     QString getOutputDirectory();
@@ -336,6 +337,7 @@ protected slots:
     void plusPressed(DkFilenameWidget *widget, const QString &tag = QString());
     void minusPressed(DkFilenameWidget *widget);
     void extensionCBChanged(int index);
+    void compressionCBChanged(int index);
     void parameterChanged();
     void updateFileLabelPreview();
     void useInputFolderChanged(bool checked);
@@ -364,6 +366,8 @@ private:
     QComboBox *mCbExtension = 0;
     QComboBox *mCbNewExtension = 0;
     QComboBox *mCbCompression = 0;
+    QSpinBox *mSbTargetSize = 0;
+    QLineEdit *mExtraFormatsEdit = 0;
     QLabel *mOldFileNameLabel = 0;
     QLabel *mNewFileNameLabel = 0;
     QString mExampleName = 0;
@@ -77,7 +77,7 @@ DkTabInfo::DkTabInfo(const QSharedPointer<DkImageContainerT> imgC, int idx, QObj
 
     if (imgC)
         mTabMode = tab_single_image;
-    mTabIdx = idx;
+    setTabIdx(idx);
     mFilePath = getFilePath();
 }
 
@@ -88,7 +88,7 @@ DkTabInfo::DkTabInfo(TabMode mode, int idx, QObject *parent)
     deactivate();
 
     mTabMode = mode;
-    mTabIdx = idx;
+    setTabIdx(idx);
 }
 
 DkTabInfo::~DkTabInfo()
@@ -159,6 +159,7 @@ QString DkTabInfo::getFilePath() const
 void DkTabInfo::setTabIdx(int tabIdx)
 {
     mTabIdx = tabIdx;
+    mImageLoader->setCacheConsumer(tr("Tab %1").arg(tabIdx + 1));
 }
 
 int DkTabInfo::getTabIdx() const
@@ -55,6 +55,8 @@ DkConnection::DkConnection(QObject *parent)
     connect(this, SIGNAL(readyRead()), this, SLOT(processReadyRead()));
 
     setReadBufferSize(MaxBufferSize);
+
+    mLatencyClock.start();
 }
 
 void DkConnection::setTitle(const QString &newTitle)
@@ -62,6 +64,15 @@ void DkConnection::setTitle(const QString &newTitle)
     mCurrentTitle = newTitle;
 }
 
+/**
+ * The smoothed round trip time of transform updates.
+ * @return double latency in ms or -1 if it was not measured yet.
+ **/
+double DkConnection::latency() const
+{
+    return mLatency;
+}
+
 void DkConnection::sendStartSynchronizeMessage()
 {
     // qDebug() << "sending Synchronize Message to " << this->peerName() << ":" << this->peerPort();
@@ -126,6 +137,11 @@ void DkConnection::sendNewPositionMessage(QRect position, bool opacity, bool ove
 
 void DkConnection::sendNewTransformMessage(QTransform transform, QTransform imgTransform, QPointF canvasSize)
 {
+    if (mPeerProtocolVersion >= 2) {
+        sendTransformFrame(transform, imgTransform, canvasSize);
+        return;
+    }
+
     // qDebug() << "sending new Transform Message to " << this->peerName() << ":" << this->peerPort();
     QByteArray ba;
     QDataStream ds(&ba, QIODevice::ReadWrite);
@@ -139,6 +155,79 @@ void DkConnection::sendNewTransformMessage(QTransform transform, QTransform imgT
     write(data);
 }
 
+/**
+ * Sends a transform as fixed-size frame (64 bytes payload).
+ * Only the affine parts are sent in single precision.
+ * The time stamp is echoed by the peer to measure the latency.
+ **/
+void DkConnection::sendTransformFrame(const QTransform &transform, const QTransform &imgTransform, const QPointF &canvasSize)
+{
+    QByteArray ba;
+    ba.reserve(64);
+
+    QDataStream ds(&ba, QIODevice::WriteOnly);
+    ds.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    ds << (qint64)(mLatencyClock.nsecsElapsed() / 1000);
+    ds << transform.m11() << transform.m12() << transform.m21() << transform.m22() << transform.dx() << transform.dy();
+    ds << imgTransform.m11() << imgTransform.m12() << imgTransform.m21() << imgTransform.m22() << imgTransform.dx() << imgTransform.dy();
+    ds << canvasSize.x() << canvasSize.y();
+
+    QByteArray data = "TRANSFORMFRAME";
+    data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
+    write(data);
+}
+
+void DkConnection::sendTransformAck(qint64 timeStamp)
+{
+    QByteArray ba;
+    QDataStream ds(&ba, QIODevice::WriteOnly);
+    ds << timeStamp;
+
+    QByteArray data = "TRANSFORMACK";
+    data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
+    write(data);
+}
+
+void DkConnection::readTransformFrame()
+{
+    qint64 timeStamp = 0;
+    double v[14];
+
+    QDataStream ds(mBuffer);
+    ds.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    ds >> timeStamp;
+
+    for (int idx = 0; idx < 14; idx++)
+        ds >> v[idx];
+
+    if (ds.status() != QDataStream::Ok)
+        return;
+
+    sendTransformAck(timeStamp);
+
+    QTransform transform(v[0], v[1], v[2], v[3], v[4], v[5]);
+    QTransform imgTransform(v[6], v[7], v[8], v[9], v[10], v[11]);
+    emit connectionNewTransform(this, transform, imgTransform, QPointF(v[12], v[13]));
+}
+
+void DkConnection::readTransformAck()
+{
+    qint64 timeStamp = 0;
+    QDataStream ds(mBuffer);
+    ds >> timeStamp;
+
+    if (ds.status() != QDataStream::Ok)
+        return;
+
+    double rtt = (mLatencyClock.nsecsElapsed() / 1000 - timeStamp) / 1000.0;
+    mLatency = mLatency < 0 ? rtt : mLatency * 0.9 + rtt * 0.1;
+
+    if (!mLatencyLogTimer.isValid() || mLatencyLogTimer.elapsed() > 5000) {
+        qDebug().nospace() << "[Sync] round trip to peer " << mPeerId << ": " << QString::number(mLatency, 'f', 2) << " ms";
+        mLatencyLogTimer.start();
+    }
+}
+
 void DkConnection::sendNewFileMessage(qint16 op, const QString &filename)
 {
     // qDebug() << "sending new File Message to " << this->peerName() << ":" << this->peerPort();
@@ -177,6 +266,8 @@ bool DkConnection::readProtocolHeader()
     QByteArray newpositionBA = QByteArray("NEWPOSITION").append(SeparatorToken);
     QByteArray newFileBA = QByteArray("NEWFILE").append(SeparatorToken);
     QByteArray goodbyeBA = QByteArray("GOODBYE").append(SeparatorToken);
+    QByteArray transformFrameBA = QByteArray("TRANSFORMFRAME").append(SeparatorToken);
+    QByteArray transformAckBA = QByteArray("TRANSFORMACK").append(SeparatorToken);
 
     if (mBuffer == greetingBA) {
         // qDebug() << "Greeting received from:" << this->peerAddress() << ":" << this->peerPort();
@@ -202,6 +293,10 @@ bool DkConnection::readProtocolHeader()
     } else if (mBuffer == goodbyeBA) {
         // qDebug() << "Goodbye received from:" << this->peerAddress() << ":" << this->peerPort();
         mCurrentDataType = GoodBye;
+    } else if (mBuffer == transformFrameBA) {
+        mCurrentDataType = transformFrame;
+    } else if (mBuffer == transformAckBA) {
+        mCurrentDataType = transformAck;
     } else {
         qDebug() << QString(mBuffer);
         qDebug() << "Undefined received from:" << this->peerAddress() << ":" << this->peerPort();
@@ -446,6 +541,14 @@ void DkConnection::processData()
         }
         break;
     }
+    case transformFrame: {
+        if (mState == Synchronized)
+            readTransformFrame();
+        break;
+    }
+    case transformAck:
+        readTransformAck();
+        break;
     case newFile: {
         if (mState == Synchronized) {
             qint16 op;
@@ -525,6 +628,7 @@ void DkLocalConnection::sendGreetingMessage(const QString &currentTitle)
     QDataStream ds(&ba, QIODevice::ReadWrite);
     ds << mLocalTcpServerPort;
     ds << mCurrentTitle;
+    ds << SyncProtocolVersion; // older versions ignore it
 
     // qDebug() << "title: " << mCurrentTitle;
     // qDebug() << "local tcp: " << mLocalTcpServerPort;
@@ -550,6 +654,10 @@ void DkLocalConnection::readGreetingMessage()
     ds >> this->mPeerServerPort;
     ds >> title;
 
+    // older peers do not send their protocol version
+    if (!ds.atEnd())
+        ds >> mPeerProtocolVersion;
+
     // qDebug() << "emitting readyForUse";
     emit connectionReadyForUse(mPeerServerPort, title, this);
 }
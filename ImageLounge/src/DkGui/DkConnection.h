@@ -28,6 +28,7 @@
 #pragma once
 
 #pragma warning(push, 0) // no warnings from includes - begin
+#include <QElapsedTimer>
 #include <QHostAddress>
 #include <QImage>
 #include <QRect>
@@ -60,6 +61,9 @@ namespace nmc
 static const int MaxBufferSize = 102400000;
 static const char SeparatorToken = '<';
 
+// version 2: compact transform frames + latency acks
+static const quint16 SyncProtocolVersion = 2;
+
 class DllCoreExport DkConnection : public QTcpSocket
 {
     Q_OBJECT
@@ -88,6 +92,7 @@ public:
         mPeerId = peerId;
     };
     void setTitle(const QString &newTitle);
+    double latency() const;
 
     bool connectionCreated;
 
@@ -115,7 +120,19 @@ public slots:
 
 protected:
     enum ConnectionState { WaitingForGreeting, ReadyForUse, Synchronized };
-    enum DataType { Greeting, startSynchronize, stopSynchronize, newTitle, newPosition, newTransform, newFile, GoodBye, Undefined };
+    enum DataType {
+        Greeting,
+        startSynchronize,
+        stopSynchronize,
+        newTitle,
+        newPosition,
+        newTransform,
+        newFile,
+        GoodBye,
+        transformFrame,
+        transformAck,
+        Undefined
+    };
 
     virtual bool readProtocolHeader();
     virtual void checkState();
@@ -130,6 +147,10 @@ protected:
     {
         return true;
     };
+    void sendTransformFrame(const QTransform &transform, const QTransform &imgTransform, const QPointF &canvasSize);
+    void sendTransformAck(qint64 timeStamp);
+    void readTransformFrame();
+    void readTransformAck();
 
     ConnectionState mState = WaitingForGreeting;
     DataType mCurrentDataType = Undefined;
@@ -140,6 +161,12 @@ protected:
     quint16 mPeerServerPort = 0;
     bool mIsGreetingMessageSent = false;
     bool mIsSynchronizeMessageSent = false;
+    quint16 mPeerProtocolVersion = 1;
+
+    // round trip times of transform frames
+    QElapsedTimer mLatencyClock;
+    QElapsedTimer mLatencyLogTimer;
+    double mLatency = -1.0;
 
 protected slots:
     virtual void processReadyRead();
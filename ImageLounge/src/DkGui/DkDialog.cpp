@@ -3345,6 +3345,7 @@ cv::Mat DkMosaicDialog::createPatch(const DkThumbNail &thumb, int patchRes)
     // load full image if we have not enough resolution
     if (thumb.getImage().isNull() || qMin(thumb.getImage().width(), thumb.getImage().height()) < patchRes) {
         DkBasicLoader loader;
+        loader.setDecodeSize(QSize(patchRes, patchRes), Qt::KeepAspectRatioByExpanding);
         loader.loadGeneral(thumb.getFilePath(), true, true);
         img = loader.image();
     } else
@@ -28,13 +28,23 @@ related links:
 
 #include "DkLogWidget.h"
 
+#include "DkTrace.h"
 #include "DkUtils.h"
 
 #pragma warning(push, 0) // no warnings from includes
 #include <QAction>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
 #include <QPushButton>
+#include <QTabWidget>
+#include <QTableWidget>
 #include <QTextEdit>
+#include <QTimer>
 #include <QVBoxLayout>
+
+#include <algorithm>
 #pragma warning(pop)
 
 namespace nmc
@@ -84,6 +94,157 @@ void DkLogWidget::createLayout()
     layout->addWidget(clearButton, 1, 1, Qt::AlignRight | Qt::AlignTop);
 }
 
+// -------------------------------------------------------------------- DkTraceWidget
+DkTraceWidget::DkTraceWidget(QWidget *parent)
+    : DkWidget(parent)
+{
+    setObjectName("traceWidget");
+    createLayout();
+
+    mUpdateTimer = new QTimer(this);
+    mUpdateTimer->setInterval(1000);
+    connect(mUpdateTimer, SIGNAL(timeout()), this, SLOT(updateStats()));
+
+    QMetaObject::connectSlotsByName(this);
+}
+
+void DkTraceWidget::createLayout()
+{
+    mTraceButton = new QPushButton(tr("Record"), this);
+    mTraceButton->setObjectName("traceButton");
+    mTraceButton->setCheckable(true);
+    mTraceButton->setChecked(DkTrace::isEnabled());
+    mTraceButton->setToolTip(tr("Record spans & counters of loading, caching, thumbnails and painting"));
+
+    QPushButton *exportButton = new QPushButton(tr("Export..."), this);
+    exportButton->setObjectName("exportButton");
+    exportButton->setToolTip(tr("Export a Chrome/Perfetto trace"));
+
+    QPushButton *clearButton = new QPushButton(tr("Clear"), this);
+    clearButton->setObjectName("clearTraceButton");
+
+    mInfoLabel = new QLabel(this);
+
+    QStringList header;
+    header << tr("Name") << tr("Count") << tr("Total [ms]") << tr("Mean [ms]") << tr("p50 [ms]") << tr("p95 [ms]") << tr("Max [ms]");
+
+    mTable = new QTableWidget(0, header.size(), this);
+    mTable->setHorizontalHeaderLabels(header);
+    mTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    mTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    mTable->verticalHeader()->hide();
+    mTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    buttonLayout->setContentsMargins(0, 0, 0, 0);
+    buttonLayout->addWidget(mTraceButton);
+    buttonLayout->addWidget(exportButton);
+    buttonLayout->addWidget(clearButton);
+    buttonLayout->addWidget(mInfoLabel);
+    buttonLayout->addStretch();
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(buttonLayout);
+    layout->addWidget(mTable);
+}
+
+void DkTraceWidget::showEvent(QShowEvent *event)
+{
+    mTraceButton->setChecked(DkTrace::isEnabled());
+    updateStats();
+    mUpdateTimer->start();
+
+    DkWidget::showEvent(event);
+}
+
+void DkTraceWidget::hideEvent(QHideEvent *event)
+{
+    mUpdateTimer->stop();
+    DkWidget::hideEvent(event);
+}
+
+void DkTraceWidget::on_traceButton_toggled(bool checked)
+{
+    DkTrace::setEnabled(checked);
+    updateStats();
+}
+
+void DkTraceWidget::on_exportButton_pressed()
+{
+    QString filePath = QFileDialog::getSaveFileName(this,
+                                                    tr("Export Trace"),
+                                                    QDir(DkUtils::getAppDataPath()).absoluteFilePath("nomacs-trace.json"),
+                                                    tr("Chrome Trace (*.json)"));
+
+    if (filePath.isEmpty())
+        return;
+
+    if (!DkTrace::instance().exportChromeTrace(filePath))
+        QMessageBox::critical(this, tr("Export Trace"), tr("Sorry, I cannot write %1").arg(filePath), QMessageBox::Ok);
+}
+
+void DkTraceWidget::on_clearTraceButton_pressed()
+{
+    DkTrace::instance().clear();
+    updateStats();
+}
+
+void DkTraceWidget::updateStats()
+{
+    DkTrace &trace = DkTrace::instance();
+
+    QVector<DkTraceStats> stats = trace.stats();
+    std::sort(stats.begin(), stats.end(), [](const DkTraceStats &a, const DkTraceStats &b) {
+        return a.total > b.total;
+    });
+
+    QHash<QString, double> counters = trace.counters();
+    QStringList counterKeys = counters.keys();
+    counterKeys.sort();
+
+    auto ms = [](double us) {
+        return QString::number(us / 1000.0, 'f', 2);
+    };
+
+    auto setItem = [&](int row, int col, const QString &text) {
+        QTableWidgetItem *item = new QTableWidgetItem(text);
+        if (col > 0)
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        mTable->setItem(row, col, item);
+    };
+
+    mTable->setRowCount(stats.size() + counterKeys.size());
+
+    int row = 0;
+    for (const DkTraceStats &s : stats) {
+        setItem(row, 0, s.category + " / " + s.name);
+        setItem(row, 1, QString::number(s.count));
+        setItem(row, 2, ms(s.total));
+        setItem(row, 3, ms(s.mean()));
+        setItem(row, 4, ms(s.percentile(0.5)));
+        setItem(row, 5, ms(s.percentile(0.95)));
+        setItem(row, 6, ms(s.max));
+        row++;
+    }
+
+    // counters show their last value only
+    for (const QString &key : counterKeys) {
+        setItem(row, 0, key.split("/").join(" / "));
+        setItem(row, 1, QString::number(counters.value(key), 'f', 1));
+
+        for (int col = 2; col < mTable->columnCount(); col++)
+            setItem(row, col, "");
+        row++;
+    }
+
+    QString info = tr("%1 events").arg(trace.numEvents());
+    if (trace.numDropped() > 0)
+        info += " " + tr("(%1 dropped)").arg(trace.numDropped());
+
+    mInfoLabel->setText(info);
+}
+
 /// <summary>
 /// Saves log messages to a temporary log file.
 /// Log messages are saved to DkUtils::instance().app().logPath() if
@@ -112,7 +273,13 @@ DkLogDock::DkLogDock(const QString &title, QWidget *parent, Qt::WindowFlags flag
 void DkLogDock::createLayout()
 {
     DkLogWidget *logWidget = new DkLogWidget(this);
-    setWidget(logWidget);
+    DkTraceWidget *traceWidget = new DkTraceWidget(this);
+
+    QTabWidget *tabs = new QTabWidget(this);
+    tabs->addTab(logWidget, tr("Log"));
+    tabs->addTab(traceWidget, tr("Trace"));
+
+    setWidget(tabs);
 }
 
 DkMessageQueuer::DkMessageQueuer()
@@ -44,6 +44,10 @@
 #endif
 
 class QTextEdit;
+class QTableWidget;
+class QLabel;
+class QPushButton;
+class QTimer;
 
 namespace nmc
 {
@@ -91,4 +95,31 @@ protected:
     QTextEdit *mTextEdit;
 };
 
+/**
+ * Shows the statistics of the hot path spans & counters recorded by DkTrace.
+ **/
+class DkTraceWidget : public DkWidget
+{
+    Q_OBJECT
+
+public:
+    DkTraceWidget(QWidget *parent = 0);
+
+public slots:
+    void on_traceButton_toggled(bool checked);
+    void on_exportButton_pressed();
+    void on_clearTraceButton_pressed();
+    void updateStats();
+
+protected:
+    void createLayout();
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+    QTableWidget *mTable;
+    QLabel *mInfoLabel;
+    QPushButton *mTraceButton;
+    QTimer *mUpdateTimer;
+};
+
 }
\ No newline at end of file
@@ -37,10 +37,14 @@
 #include <QApplication>
 #include <QDebug>
 #include <QDesktopServices>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDesktopWidget>
+#include <QGuiApplication>
 #include <QDir>
 #include <QHostInfo>
 #include <QList>
+#include <QLocalSocket>
 #include <QMessageBox>
 #include <QMimeData>
 #include <QMutex>
@@ -50,6 +54,7 @@
 #include <QNetworkInterface>
 #include <QNetworkProxyFactory>
 #include <QProcess>
+#include <QScreen>
 #include <QStringBuilder>
 #include <QTcpSocket>
 #include <QThread>
@@ -77,6 +82,9 @@ DkClientManager::DkClientManager(const QString &title, QObject *parent)
     this->mCurrentTitle = title;
     qRegisterMetaType<QList<quint16>>("QList<quint16>");
     qRegisterMetaType<QList<DkPeer *>>("QList<DkPeer*>");
+
+    mTransformTimer.setSingleShot(true);
+    connect(&mTransformTimer, SIGNAL(timeout()), this, SLOT(flushTransform()));
 }
 
 DkClientManager::~DkClientManager()
@@ -175,23 +183,66 @@ void DkClientManager::sendTitle(const QString &newTitle)
     }
 }
 
+/**
+ * Queues a transform for all synchronized peers.
+ * Updates are coalesced to the display refresh rate: only the latest
+ * absolute transform is sent, relative ones (panning) are accumulated.
+ **/
 void DkClientManager::sendTransform(QTransform transform, QTransform imgTransform, QPointF canvasSize)
 {
+    if (canvasSize.isNull()) {
+        mPendingRelative = mRelativePending ? mPendingRelative * transform : transform;
+        mRelativePending = true;
+    } else {
+        mPendingTransform = transform;
+        mPendingImgTransform = imgTransform;
+        mPendingCanvasSize = canvasSize;
+        mTransformPending = true;
+
+        // the absolute transform already contains all previous moves
+        mRelativePending = false;
+    }
+
+    if (mTransformTimer.isActive())
+        return;
+
+    int interval = frameInterval();
+    qint64 elapsed = mLastTransformSent.isValid() ? mLastTransformSent.elapsed() : interval;
+
+    if (elapsed >= interval)
+        flushTransform();
+    else
+        mTransformTimer.start(interval - (int)elapsed);
+}
+
+void DkClientManager::flushTransform()
+{
+    if (!mTransformPending && !mRelativePending)
+        return;
+
+    mLastTransformSent.start();
+
     QList<DkPeer *> synchronizedPeers = mPeerList.getSynchronizedPeers();
-    foreach (DkPeer *peer, synchronizedPeers) {
-        if (!peer)
+    for (DkPeer *peer : synchronizedPeers) {
+        if (!peer || !peer->connection)
             continue;
 
-        connect(this,
-                SIGNAL(sendNewTransformMessage(QTransform, QTransform, QPointF)),
-                peer->connection,
-                SLOT(sendNewTransformMessage(QTransform, QTransform, QPointF)));
-        emit sendNewTransformMessage(transform, imgTransform, canvasSize);
-        disconnect(this,
-                   SIGNAL(sendNewTransformMessage(QTransform, QTransform, QPointF)),
-                   peer->connection,
-                   SLOT(sendNewTransformMessage(QTransform, QTransform, QPointF)));
+        if (mTransformPending)
+            peer->connection->sendNewTransformMessage(mPendingTransform, mPendingImgTransform, mPendingCanvasSize);
+        if (mRelativePending)
+            peer->connection->sendNewTransformMessage(mPendingRelative, QTransform(), QPointF());
     }
+
+    mTransformPending = false;
+    mRelativePending = false;
+}
+
+int DkClientManager::frameInterval() const
+{
+    QScreen *screen = QGuiApplication::primaryScreen();
+    qreal hz = screen ? screen->refreshRate() : 60.0;
+
+    return qMax(qRound(1000.0 / qMax(hz, 1.0)), 1);
 }
 
 void DkClientManager::sendPosition(QRect newRect, bool overlaid)
@@ -337,9 +388,11 @@ QMimeData *DkLocalClientManager::mimeData() const
 
 void DkLocalClientManager::startServer()
 {
-    mServer = new DkLocalTcpServer(this);
+    mServer = new DkLocalTcpServer(mRegistry.ports(), this);
     connect(mServer, SIGNAL(serverReiceivedNewConnection(int)), this, SLOT(newConnection(int)));
 
+    mRegistry.registerPort(mServer->serverPort());
+
     // TODO: hook on thread
     searchForOtherClients();
 
@@ -369,13 +422,21 @@ void DkLocalClientManager::searchForOtherClients()
 {
     assert(mServer);
 
-    for (int i = local_tcp_port_start; i <= local_tcp_port_end; i++) {
-        if (i == mServer->serverPort())
+    DkTimer dt;
+
+    // list the peers after registering - so that instances which start
+    // at the same time find each other
+    QList<quint16> ports = mRegistry.ports();
+
+    for (quint16 port : ports) {
+        if (port == mServer->serverPort())
             continue;
 
         DkConnection *connection = createConnection();
-        connection->connectToHost(QHostAddress::LocalHost, (qint16)i);
+        connection->connectToHost(QHostAddress::LocalHost, port);
     }
+
+    qInfo() << "[DkPeerRegistry]" << ports.size() << "local peer(s) found in" << dt;
 }
 
 void DkLocalClientManager::connectionSynchronized(QList<quint16> synchronizedPeersOfOtherClient, DkConnection *connection)
@@ -542,15 +603,87 @@ DkLocalConnection *DkLocalClientManager::createConnection()
     return connection;
 }
 
+// DkPeerRegistry --------------------------------------------------------------------
+DkPeerRegistry::DkPeerRegistry()
+{
+    QString user = qEnvironmentVariable("USER", qEnvironmentVariable("USERNAME"));
+    mDirPath = QDir(QDir::tempPath()).absoluteFilePath("nomacs-peers-" + user);
+    QDir().mkpath(mDirPath);
+}
+
+/**
+ * Announces this instance.
+ * The lock is released (and its file removed) when the registry is destroyed.
+ * @param port the port of our local server.
+ * @return bool true if the instance was registered.
+ **/
+bool DkPeerRegistry::registerPort(quint16 port)
+{
+    if (port == 0)
+        return false;
+
+    mPort = port;
+    mLock = QSharedPointer<QLockFile>(new QLockFile(QDir(mDirPath).absoluteFilePath(QString::number(port) + ".lock")));
+
+    // only lock files of dead processes are stale
+    mLock->setStaleLockTime(0);
+
+    if (!mLock->tryLock(0)) {
+        qWarning() << "[DkPeerRegistry] could not register port" << port;
+        mLock.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Returns the server ports of all running instances (except for ours).
+ * Entries of crashed instances are removed.
+ * @return QList<quint16> the ports of the local peers.
+ **/
+QList<quint16> DkPeerRegistry::ports() const
+{
+    QList<quint16> ports;
+    QFileInfoList entries = QDir(mDirPath).entryInfoList(QStringList() << "*.lock", QDir::Files);
+
+    for (const QFileInfo &fi : entries) {
+        bool ok = false;
+        quint16 port = (quint16)fi.baseName().toUInt(&ok);
+
+        if (!ok || port == mPort)
+            continue;
+
+        QLockFile lock(fi.absoluteFilePath());
+        lock.setStaleLockTime(0);
+
+        // we got the lock -> the owner is gone
+        if (lock.tryLock(0))
+            lock.unlock();
+        else if (lock.error() == QLockFile::LockFailedError)
+            ports << port;
+    }
+
+    return ports;
+}
+
 // DkLocalTcpServer --------------------------------------------------------------------
-DkLocalTcpServer::DkLocalTcpServer(QObject *parent)
+DkLocalTcpServer::DkLocalTcpServer(const QList<quint16> &usedPorts, QObject *parent)
     : QTcpServer(parent)
 {
+    // skip ports of registered peers - no need to try them
     for (int i = local_tcp_port_start; i < local_tcp_port_end; i++) {
+        if (usedPorts.contains((quint16)i))
+            continue;
+
         if (listen(QHostAddress::LocalHost, (quint16)i)) {
             break;
         }
     }
+
+    // all ports of the range are taken - peers find us via the registry anyway
+    if (!isListening())
+        listen(QHostAddress::LocalHost);
     // qDebug() << "TCP Listening on port " << this->serverPort();
 }
 
@@ -779,4 +912,123 @@ DkClientManager *DkSyncManager::client()
     return mClient;
 }
 
+// DkInstanceServer --------------------------------------------------------------------
+DkInstanceServer::DkInstanceServer(QObject *parent)
+    : QObject(parent)
+{
+}
+
+QString DkInstanceServer::serverName()
+{
+    // one server per user
+    QString user = qEnvironmentVariable("USER", qEnvironmentVariable("USERNAME"));
+    return "nomacs-instance-" + user;
+}
+
+/**
+ * Starts listening for requests of other nomacs instances.
+ * Call this only if this is the first instance (see DkRunGuard).
+ * @return bool true if the server is listening.
+ **/
+bool DkInstanceServer::listen()
+{
+    // remove stale sockets if a previous instance crashed
+    QLocalServer::removeServer(serverName());
+
+    mServer = new QLocalServer(this);
+    mServer->setSocketOptions(QLocalServer::UserAccessOption);
+
+    if (!mServer->listen(serverName())) {
+        qWarning() << "[DkInstanceServer] cannot listen:" << mServer->errorString();
+        return false;
+    }
+
+    connect(mServer, SIGNAL(newConnection()), this, SLOT(newConnection()));
+
+    return true;
+}
+
+/**
+ * The time this instance needed to start.
+ * It is reported to new instances which logs the time saved.
+ **/
+void DkInstanceServer::setStartupTime(int ms)
+{
+    mStartupTime = ms;
+}
+
+/**
+ * Sends files to the running instance.
+ * @param files files (or directories) to be opened.
+ * @param tabs files to be opened in new tabs.
+ * @param dirPath a directory to be opened.
+ * @param launchTime the time (msecs since epoch) this process was started.
+ * @return bool true if the running instance received the request.
+ **/
+bool DkInstanceServer::forward(const QStringList &files, const QStringList &tabs, const QString &dirPath, qint64 launchTime)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+
+    if (!socket.waitForConnected(500))
+        return false;
+
+    QByteArray request;
+    QDataStream ds(&request, QIODevice::WriteOnly);
+    ds << files << tabs << dirPath;
+
+    socket.write(request);
+
+    if (!socket.waitForBytesWritten(1000) || !socket.waitForReadyRead(2000)) {
+        qWarning() << "[DkInstanceServer] no answer from the running instance";
+        return false;
+    }
+
+    qint32 startupTime = 0;
+    QDataStream rs(&socket);
+    rs >> startupTime;
+
+    socket.disconnectFromServer();
+
+    qint64 dt = QDateTime::currentMSecsSinceEpoch() - launchTime;
+    qInfo().nospace() << "[DkInstanceServer] files handed over in " << dt << " ms - " << qMax(startupTime - dt, (qint64)0) << " ms start-up time saved";
+
+    return true;
+}
+
+void DkInstanceServer::newConnection()
+{
+    while (mServer->hasPendingConnections()) {
+        QLocalSocket *socket = mServer->nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+void DkInstanceServer::readRequest()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+
+    if (!socket)
+        return;
+
+    QStringList files, tabs;
+    QString dirPath;
+
+    QDataStream ds(socket);
+    ds.startTransaction();
+    ds >> files >> tabs >> dirPath;
+
+    // wait for the complete request
+    if (!ds.commitTransaction())
+        return;
+
+    QDataStream rs(socket);
+    rs << (qint32)mStartupTime;
+    socket->flush();
+
+    qInfo() << "[DkInstanceServer] opening" << files.size() + tabs.size() + (dirPath.isEmpty() ? 0 : 1) << "file(s) from another instance";
+    emit openRequested(files, tabs, dirPath);
+}
+
 }
@@ -31,10 +31,14 @@
 #define local_tcp_port_end 45484
 
 #pragma warning(push, 0) // no warnings from includes - begin
+#include <QElapsedTimer>
+#include <QLocalServer>
+#include <QLockFile>
 #include <QMutex>
 #include <QSharedPointer>
 #include <QTcpServer>
 #include <QThread>
+#include <QTimer>
 #pragma warning(pop) // no warnings from includes - end
 
 #include "DkConnection.h"
@@ -184,17 +188,49 @@ protected slots:
     virtual void connectionReceivedGoodBye(DkConnection *connection);
     void connectionShowStatusMessage(DkConnection *connection, const QString &msg);
     void disconnected();
+    void flushTransform();
 
 protected:
     void removeConnection(DkConnection *connection);
     void connectConnection(DkConnection *connection);
     virtual DkConnection *createConnection() = 0;
     QString listConnections(QList<DkPeer *> peers, bool connected);
+    int frameInterval() const;
 
     DkPeerList mPeerList;
     QString mCurrentTitle;
     quint16 mNewPeerId;
     QList<DkConnection *> mStartUpConnections;
+
+    // transforms are sent at most once per display frame
+    QTimer mTransformTimer;
+    QElapsedTimer mLastTransformSent;
+    bool mTransformPending = false;
+    bool mRelativePending = false;
+    QTransform mPendingTransform;
+    QTransform mPendingImgTransform;
+    QPointF mPendingCanvasSize;
+    QTransform mPendingRelative;
+};
+
+/**
+ * Registry of the local nomacs instances.
+ * Each instance holds a lock file named by its server port. Hence,
+ * peers are found by listing a directory instead of probing ports.
+ * Lock files of crashed instances are stale and removed on lookup.
+ **/
+class DkPeerRegistry
+{
+public:
+    DkPeerRegistry();
+
+    bool registerPort(quint16 port);
+    QList<quint16> ports() const;
+
+private:
+    QString mDirPath;
+    quint16 mPort = 0;
+    QSharedPointer<QLockFile> mLock;
 };
 
 class DkLocalClientManager : public DkClientManager
@@ -232,6 +268,7 @@ private:
     void searchForOtherClients();
 
     DkLocalTcpServer *mServer;
+    DkPeerRegistry mRegistry;
 };
 
 class DkLocalTcpServer : public QTcpServer
@@ -239,7 +276,7 @@ class DkLocalTcpServer : public QTcpServer
     Q_OBJECT
 
 public:
-    DkLocalTcpServer(QObject *parent = 0);
+    DkLocalTcpServer(const QList<quint16> &usedPorts = QList<quint16>(), QObject *parent = 0);
 
 signals:
     void serverReiceivedNewConnection(int DkDescriptor);
@@ -265,4 +302,35 @@ private:
     DkLocalClientManager *mClient = 0;
 };
 
+/**
+ * Hands files over to a running nomacs (single-instance mode).
+ * The first instance listens on a local socket. Later launches
+ * send their command line arguments to it and quit right away
+ * instead of initializing a complete application.
+ **/
+class DllCoreExport DkInstanceServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    DkInstanceServer(QObject *parent = 0);
+
+    bool listen();
+    void setStartupTime(int ms);
+
+    static bool forward(const QStringList &files, const QStringList &tabs, const QString &dirPath, qint64 launchTime);
+    static QString serverName();
+
+signals:
+    void openRequested(const QStringList &files, const QStringList &tabs, const QString &dirPath) const;
+
+protected slots:
+    void newConnection();
+    void readRequest();
+
+protected:
+    QLocalServer *mServer = 0;
+    int mStartupTime = 0;
+};
+
 }
@@ -280,12 +280,18 @@ void DkNoMacs::createActions()
     connect(am.action(DkActionManager::menu_file_private_instance), SIGNAL(triggered()), this, SLOT(newInstance()));
     connect(am.action(DkActionManager::menu_file_find), SIGNAL(triggered()), this, SLOT(find()));
     connect(am.action(DkActionManager::menu_file_recursive), SIGNAL(triggered(bool)), this, SLOT(setRecursiveScan(bool)));
+    connect(am.action(DkActionManager::menu_file_follow_new), SIGNAL(triggered(bool)), this, SLOT(setFollowNewFiles(bool)));
     connect(am.action(DkActionManager::menu_file_exit), SIGNAL(triggered()), this, SLOT(close()));
 
     connect(am.action(DkActionManager::menu_sort_filename), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
     connect(am.action(DkActionManager::menu_sort_date_created), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
     connect(am.action(DkActionManager::menu_sort_date_modified), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
     connect(am.action(DkActionManager::menu_sort_random), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
+    connect(am.action(DkActionManager::menu_sort_sharpness), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
+    connect(am.action(DkActionManager::menu_sort_clipping), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
+    connect(am.action(DkActionManager::menu_sort_date_taken), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
+    connect(am.action(DkActionManager::menu_sort_rating), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
+    connect(am.action(DkActionManager::menu_sort_camera), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
     connect(am.action(DkActionManager::menu_sort_ascending), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
     connect(am.action(DkActionManager::menu_sort_descending), SIGNAL(triggered(bool)), this, SLOT(changeSorting(bool)));
 
@@ -725,6 +731,16 @@ void DkNoMacs::setRecursiveScan(bool recursive)
     loader->updateSubFolders(loader->getDirPath());
 }
 
+void DkNoMacs::setFollowNewFiles(bool follow)
+{
+    DkSettingsManager::param().global().followNewFiles = follow;
+
+    if (follow)
+        getTabWidget()->setInfo(tr("New files are displayed as soon as they appear"));
+    else
+        getTabWidget()->setInfo(tr("New files are not displayed automatically"));
+}
+
 void DkNoMacs::showOpacityDialog()
 {
     if (!mOpacityDialog) {
@@ -1244,6 +1260,62 @@ void DkNoMacs::loadFile(const QString &filePath)
         getTabWidget()->loadFile(filePath, false);
 }
 
+/**
+ * Opens files that were handed over by another nomacs instance.
+ * Files that are already open activate their tab, others are
+ * loaded to the current tab if it is empty or to a new tab.
+ **/
+void DkNoMacs::openRequested(const QStringList &files, const QStringList &tabs, const QString &dirPath)
+{
+    DkCentralWidget *cw = getTabWidget();
+
+    if (!cw)
+        return;
+
+    for (const QString &filePath : files) {
+        if (QFileInfo(filePath).isDir()) {
+            cw->loadDirToTab(filePath);
+            continue;
+        }
+
+        QVector<QSharedPointer<DkTabInfo>> tabInfos = cw->getTabs();
+        bool found = false;
+
+        for (int idx = 0; idx < tabInfos.size(); idx++) {
+            if (tabInfos[idx]->getFilePath() == filePath) {
+                cw->setActiveTab(idx);
+                found = true;
+                break;
+            }
+        }
+
+        if (found)
+            continue;
+
+        int activeIdx = cw->getActiveTab();
+        int mode = (activeIdx >= 0 && activeIdx < tabInfos.size()) ? tabInfos[activeIdx]->getMode() : DkTabInfo::tab_empty;
+        bool reuseTab = mode == DkTabInfo::tab_empty || mode == DkTabInfo::tab_recent_files;
+
+        if (reuseTab)
+            cw->loadFile(filePath, false);
+        else
+            cw->addTab(filePath);
+    }
+
+    if (!dirPath.isEmpty())
+        cw->loadDirToTab(dirPath);
+
+    for (const QString &filePath : tabs)
+        cw->addTab(filePath);
+
+    // bring us to front
+    if (isMinimized())
+        showNormal();
+
+    raise();
+    activateWindow();
+}
+
 // TODO: move this
 void DkNoMacs::renameFile()
 {
@@ -1357,6 +1429,16 @@ void DkNoMacs::changeSorting(bool change)
             DkSettingsManager::param().global().sortMode = DkSettings::sort_date_modified;
         else if (senderName == "menu_sort_random")
             DkSettingsManager::param().global().sortMode = DkSettings::sort_random;
+        else if (senderName == "menu_sort_sharpness")
+            DkSettingsManager::param().global().sortMode = DkSettings::sort_sharpness;
+        else if (senderName == "menu_sort_clipping")
+            DkSettingsManager::param().global().sortMode = DkSettings::sort_clipping;
+        else if (senderName == "menu_sort_date_taken")
+            DkSettingsManager::param().global().sortMode = DkSettings::sort_date_taken;
+        else if (senderName == "menu_sort_rating")
+            DkSettingsManager::param().global().sortMode = DkSettings::sort_rating;
+        else if (senderName == "menu_sort_camera")
+            DkSettingsManager::param().global().sortMode = DkSettings::sort_camera;
         else if (senderName == "menu_sort_ascending")
             DkSettingsManager::param().global().sortDir = DkSettings::sort_ascending;
         else if (senderName == "menu_sort_descending")
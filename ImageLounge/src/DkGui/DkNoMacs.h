@@ -195,6 +195,8 @@ public slots:
     void startPong() const;
     void fitFrame();
     void setRecursiveScan(bool recursive);
+    void setFollowNewFiles(bool follow);
+    void openRequested(const QStringList &files, const QStringList &tabs, const QString &dirPath);
     void openPluginManager();
     void clearFileHistory();
     void clearFolderHistory();
@@ -30,6 +30,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DkActionManager.h"
 #include "DkBasicWidgets.h"
 #include "DkDialog.h"
+#include "DkImageContainer.h"
 #include "DkImageStorage.h"
 #include "DkNoMacs.h"
 #include "DkSettings.h"
@@ -357,6 +358,11 @@ void DkGeneralPreference::createLayout()
     cbRecentFiles->setToolTip(tr("Show the History Panel on Start-Up"));
     cbRecentFiles->setChecked(DkSettingsManager::param().app().showRecentFiles);
 
+    QCheckBox *cbSingleInstance = new QCheckBox(tr("Open Files in Running Instance"), this);
+    cbSingleInstance->setObjectName("singleInstance");
+    cbSingleInstance->setToolTip(tr("If checked, files opened from the file manager are shown in the running nomacs instead of starting a new one."));
+    cbSingleInstance->setChecked(DkSettingsManager::param().app().singleInstance);
+
     QCheckBox *cbLogRecentFiles = new QCheckBox(tr("Remember Recent Files History"), this);
     cbLogRecentFiles->setObjectName("logRecentFiles");
     cbLogRecentFiles->setToolTip(tr("If checked, recent files will be saved."));
@@ -418,6 +424,7 @@ void DkGeneralPreference::createLayout()
     DkGroupWidget *generalGroup = new DkGroupWidget(tr("General"), this);
     generalGroup->addWidget(cbRecentFiles);
     generalGroup->addWidget(cbLogRecentFiles);
+    generalGroup->addWidget(cbSingleInstance);
     generalGroup->addWidget(cbCheckOpenDuplicates);
     generalGroup->addWidget(cbExtendedTabs);
     generalGroup->addWidget(cbLoopImages);
@@ -503,6 +510,12 @@ void DkGeneralPreference::on_showRecentFiles_toggled(bool checked) const
         DkSettingsManager::param().app().showRecentFiles = checked;
 }
 
+void DkGeneralPreference::on_singleInstance_toggled(bool checked) const
+{
+    if (DkSettingsManager::param().app().singleInstance != checked)
+        DkSettingsManager::param().app().singleInstance = checked;
+}
+
 void DkGeneralPreference::on_logRecentFiles_toggled(bool checked) const
 {
     if (DkSettingsManager::param().global().logRecentFiles != checked)
@@ -838,6 +851,17 @@ void DkDisplayPreference::createLayout()
     displayTimeBox->setSingleStep(.2);
     displayTimeBox->setValue(DkSettingsManager::param().slideShow().time);
 
+    QLabel *frameRateLabel = new QLabel(tr("Frame Sequences"), this);
+
+    QDoubleSpinBox *frameRateBox = new QDoubleSpinBox(this);
+    frameRateBox->setObjectName("frameRateBox");
+    frameRateBox->setToolTip(tr("Raw frames (drif, yuv) are played with this frame rate."));
+    frameRateBox->setSuffix(" fps");
+    frameRateBox->setMinimum(1.0);
+    frameRateBox->setMaximum(120);
+    frameRateBox->setSingleStep(1);
+    frameRateBox->setValue(DkSettingsManager::param().slideShow().frameRate);
+
     QCheckBox *showPlayer = new QCheckBox(tr("Show Player"), this);
     showPlayer->setObjectName("showPlayer");
     showPlayer->setChecked(DkSettingsManager::param().slideShow().showPlayer);
@@ -849,6 +873,8 @@ void DkDisplayPreference::createLayout()
     slideshowGroup->addWidget(cbAlwaysAnimate);
     slideshowGroup->addWidget(displayTimeLabel);
     slideshowGroup->addWidget(displayTimeBox);
+    slideshowGroup->addWidget(frameRateLabel);
+    slideshowGroup->addWidget(frameRateBox);
     slideshowGroup->addWidget(showPlayer);
 
     // show crop from metadata
@@ -888,6 +914,12 @@ void DkDisplayPreference::on_displayTimeBox_valueChanged(double value) const
         DkSettingsManager::param().slideShow().time = (float)value;
 }
 
+void DkDisplayPreference::on_frameRateBox_valueChanged(double value) const
+{
+    if (DkSettingsManager::param().slideShow().frameRate != value)
+        DkSettingsManager::param().slideShow().frameRate = (float)value;
+}
+
 void DkDisplayPreference::on_showPlayer_toggled(bool checked) const
 {
     if (DkSettingsManager::param().slideShow().showPlayer != checked)
@@ -1020,9 +1052,14 @@ void DkFilePreference::createLayout()
     QLabel *cLabel =
         new QLabel(tr("We recommend to set a moderate cache value around 100 MB. [%1-%2 MB]").arg(cacheBox->minimum()).arg(cacheBox->maximum()), this);
 
+    // the cache is shared by all tabs
+    QLabel *cacheUsageLabel = new QLabel(tr("Currently used: %1").arg(DkImageCache::instance().usageString()), this);
+    cacheUsageLabel->setWordWrap(true);
+
     DkGroupWidget *cacheGroup = new DkGroupWidget(tr("Maximal Cache Size"), this);
     cacheGroup->addWidget(cacheBox);
     cacheGroup->addWidget(cLabel);
+    cacheGroup->addWidget(cacheUsageLabel);
 
     // history size
     // cache size
@@ -147,6 +147,7 @@ public:
 public slots:
     void on_themeBox_currentIndexChanged(const QString &text) const;
     void on_showRecentFiles_toggled(bool checked) const;
+    void on_singleInstance_toggled(bool checked) const;
     void on_logRecentFiles_toggled(bool checked) const;
     void on_checkOpenDuplicates_toggled(bool checked) const;
     void on_extendedTabs_toggled(bool checked) const;
@@ -191,6 +192,7 @@ public slots:
     void on_iconSizeBox_valueChanged(int value) const;
     void on_fadeImageBox_valueChanged(double value) const;
     void on_displayTimeBox_valueChanged(double value) const;
+    void on_frameRateBox_valueChanged(double value) const;
     void on_showPlayer_toggled(bool checked) const;
     void on_keepZoom_buttonClicked(int buttonId) const;
     void on_invertZoom_toggled(bool checked) const;
@@ -28,7 +28,9 @@
 #include "DkThumbsWidgets.h"
 #include "DkActionManager.h"
 #include "DkImageContainer.h"
+#include "DkImageHashes.h"
 #include "DkImageLoader.h"
+#include "DkImageScores.h"
 #include "DkImageStorage.h"
 #include "DkMessageBox.h"
 #include "DkSettings.h"
@@ -44,6 +46,7 @@
 #include <QAction>
 #include <QApplication>
 #include <QClipboard>
+#include <QFontMetrics>
 #include <QGraphicsSceneMouseEvent>
 #include <QHBoxLayout>
 #include <QInputDialog>
@@ -54,6 +57,7 @@
 #include <QPushButton>
 #include <QResizeEvent>
 #include <QScrollBar>
+#include <QSet>
 #include <QStyleOptionGraphicsItem>
 #include <QThreadPool>
 #include <QTimer>
@@ -61,6 +65,8 @@
 #include <QToolButton>
 #include <QUrl>
 #include <qmath.h>
+
+#include <algorithm>
 #pragma warning(pop) // no warnings from includes - end
 
 namespace nmc
@@ -172,6 +178,7 @@ void DkFilePreview::initOrientations()
     worldMatrix.reset();
     currentDx = 0;
     scrollToCurrentImage = true;
+    thumbOffsets.clear(); // relayout
     update();
 }
 
@@ -267,88 +274,189 @@ void DkFilePreview::paintEvent(QPaintEvent *)
     isPainted = true;
 }
 
-void DkFilePreview::drawThumbs(QPainter *painter)
+/**
+ * Returns the size of an entry in the strip (aspect-correct, fitted to thumbLayout).
+ * An empty size is returned for entries that are not shown (e.g. deleted files).
+ * @param idx the folder index.
+ **/
+QSizeF DkFilePreview::thumbRectSize(int idx) const
+{
+    int thumbSize = thumbLayout.width();
+    int available = thumbLayout.height();
+
+    QSharedPointer<DkImageContainerT> imgC = mThumbs.at(idx);
+    QSharedPointer<DkThumbNailT> thumb = imgC->getThumb();
+    QSize imgSize;
+
+    // if the image is loaded draw that (it might be edited)
+    // we just need its size here - the scaled image is only requested if it is visible
+    if (imgC->hasImage()) {
+        QSize s = imgC->pixmap().size();
+        imgSize = QSize(qMax(qRound(s.width() * (double)thumbSize / qMax(s.height(), 1)), 1), thumbSize);
+    } else if (thumb->hasImage() == DkThumbNail::exists_not) {
+        return QSizeF();
+    } else if (thumb->hasImage() == DkThumbNail::loaded) {
+        imgSize = thumb->getImage().size();
+    } else {
+        // evicted thumbnails keep their size - otherwise the strip would jump
+        imgSize = thumb->getImageSize();
+    }
+
+    QSizeF r = !imgSize.isEmpty() ? QSizeF(imgSize) : QSizeF(thumbSize, thumbSize);
+    if (orientation == Qt::Horizontal && available < r.height() * 2)
+        r = QSizeF(qFloor(r.width() * (float)available / r.height()), available);
+    else if (orientation == Qt::Vertical && available < r.width() * 2)
+        r = QSizeF(available, qFloor(r.height() * (float)available / r.width()));
+
+    // check if the size is still valid
+    if (r.width() < 1 || r.height() < 1)
+        return QSizeF(); // this brings us in serious problems with the selection
+
+    return r;
+}
+
+/**
+ * Returns the space an entry takes in the strip (including the gap to the next entry).
+ * @param idx the folder index.
+ **/
+int DkFilePreview::thumbExtent(int idx) const
 {
-    // qDebug() << "drawing thumbs: " << worldMatrix.dx();
+    QSizeF s = thumbRectSize(idx);
 
-    bufferDim = (orientation == Qt::Horizontal) ? QRectF(QPointF(0, yOffset / 2), QSize(xOffset, 0)) : QRectF(QPointF(yOffset / 2, 0), QSize(0, xOffset));
-    thumbRects.clear();
+    if (s.isEmpty())
+        return 0;
 
-    DkTimer dt;
+    return qFloor(orientation == Qt::Horizontal ? s.width() : s.height()) + qCeil(xOffset / 2.0f);
+}
 
-    // mouse over effect
-    QPoint p = worldMatrix.inverted().map(mapFromGlobal(QCursor::pos()));
+/**
+ * Computes the start offsets of all entries.
+ * thumbOffsets[idx] is the position of entry idx and thumbOffsets.last() is the end of the strip.
+ * Visible entries are found with a binary search - so painting does not depend on the folder size.
+ **/
+void DkFilePreview::layoutThumbs()
+{
+    int thumbSize = DkSettingsManager::param().effectiveThumbSize(this);
+    int available = (orientation == Qt::Horizontal) ? height() - yOffset : width() - yOffset;
 
-    for (int idx = 0; idx < mThumbs.size(); idx++) {
-        QSharedPointer<DkThumbNailT> thumb = mThumbs.at(idx)->getThumb();
-        QImage img;
+    thumbLayout = QSize(thumbSize, available);
 
-        // if the image is loaded draw that (it might be edited)
-        if (mThumbs.at(idx)->hasImage()) {
-            img = mThumbs.at(idx)->imageScaledToHeight(DkSettingsManager::param().effectiveThumbSize(this));
-        } else {
-            if (thumb->hasImage() == DkThumbNail::exists_not) {
-                thumbRects.push_back(QRectF());
-                continue;
-            }
+    thumbOffsets.resize(mThumbs.size() + 1);
+    thumbOffsets[0] = xOffset;
 
-            if (thumb->hasImage() == DkThumbNail::loaded)
-                img = thumb->getImage();
-        }
+    for (int idx = 0; idx < mThumbs.size(); idx++)
+        thumbOffsets[idx + 1] = thumbOffsets[idx] + thumbExtent(idx);
+}
 
-        // if (img.width() > max_thumb_size * DkSettingsManager::param().dpiScaleFactor())
-        //	qDebug() << thumb->getFilePath() << "size:" << img.size();
+/**
+ * Moves all entries after idx if the entry's size changed (e.g. its thumbnail was loaded).
+ * @param idx the folder index.
+ * @return bool true if the layout changed.
+ **/
+bool DkFilePreview::updateThumbOffset(int idx)
+{
+    int delta = thumbExtent(idx) - (thumbOffsets[idx + 1] - thumbOffsets[idx]);
 
-        QPointF anchor = orientation == Qt::Horizontal ? bufferDim.topRight() : bufferDim.bottomLeft();
-        QRectF r = !img.isNull()
-            ? QRectF(anchor, img.size())
-            : QRectF(anchor, QSize(DkSettingsManager::param().effectiveThumbSize(this), DkSettingsManager::param().effectiveThumbSize(this)));
-        if (orientation == Qt::Horizontal && height() - yOffset < r.height() * 2)
-            r.setSize(QSizeF(qFloor(r.width() * (float)(height() - yOffset) / r.height()), height() - yOffset));
-        else if (orientation == Qt::Vertical && width() - yOffset < r.width() * 2)
-            r.setSize(QSizeF(width() - yOffset, qFloor(r.height() * (float)(width() - yOffset) / r.width())));
+    if (delta == 0)
+        return false;
 
-        // check if the size is still valid
-        if (r.width() < 1 || r.height() < 1)
-            continue; // this brings us in serious problems with the selection
+    for (int oIdx = idx + 1; oIdx < thumbOffsets.size(); oIdx++)
+        thumbOffsets[oIdx] += delta;
 
-        // center vertically
-        if (orientation == Qt::Horizontal)
-            r.moveCenter(QPoint(qFloor(r.center().x()), height() / 2));
-        else
-            r.moveCenter(QPoint(width() / 2, qFloor(r.center().y())));
+    return true;
+}
 
-        // update the buffer dim
-        if (orientation == Qt::Horizontal)
-            bufferDim.setRight(qFloor(bufferDim.right() + r.width()) + qCeil(xOffset / 2.0f));
-        else
-            bufferDim.setBottom(qFloor(bufferDim.bottom() + r.height()) + qCeil(xOffset / 2.0f));
-        thumbRects.push_back(r);
+QRectF DkFilePreview::thumbRect(int idx) const
+{
+    QSizeF s = thumbRectSize(idx);
 
-        QRectF imgWorldRect = worldMatrix.mapRect(r);
+    if (s.isEmpty())
+        return QRectF();
 
-        // update file rect for move to current file timer
-        if (scrollToCurrentImage && idx == currentFileIdx)
-            newFileRect = imgWorldRect;
+    QRectF r = (orientation == Qt::Horizontal) ? QRectF(QPointF(thumbOffsets[idx], yOffset / 2), s) : QRectF(QPointF(yOffset / 2, thumbOffsets[idx]), s);
 
-        // is the current image within the canvas?
-        if ((orientation == Qt::Horizontal && imgWorldRect.right() < 0) || (orientation == Qt::Vertical && imgWorldRect.bottom() < 0)) {
-            continue;
-        }
+    // center vertically
+    if (orientation == Qt::Horizontal)
+        r.moveCenter(QPoint(qFloor(r.center().x()), height() / 2));
+    else
+        r.moveCenter(QPoint(width() / 2, qFloor(r.center().y())));
+
+    return r;
+}
+
+void DkFilePreview::drawThumbs(QPainter *painter)
+{
+    // qDebug() << "drawing thumbs: " << worldMatrix.dx();
+
+    int thumbSize = DkSettingsManager::param().effectiveThumbSize(this);
+    int available = (orientation == Qt::Horizontal) ? height() - yOffset : width() - yOffset;
+
+    if (thumbLayout != QSize(thumbSize, available) || thumbOffsets.size() != mThumbs.size() + 1)
+        layoutThumbs();
+
+    int stripEnd = thumbOffsets.last();
+    bufferDim = (orientation == Qt::Horizontal) ? QRectF(QPointF(0, yOffset / 2), QSize(stripEnd, 0)) : QRectF(QPointF(yOffset / 2, 0), QSize(0, stripEnd));
+
+    // rects stay index-aligned for the mouse events - entries outside the canvas get an empty rect
+    thumbRects.fill(QRectF(), mThumbs.size());
+
+    // update file rect for move to current file timer
+    if (scrollToCurrentImage && currentFileIdx >= 0 && currentFileIdx < mThumbs.size()) {
+        QRectF r = thumbRect(currentFileIdx);
+        if (!r.isEmpty())
+            newFileRect = worldMatrix.mapRect(r);
+    }
+
+    // find the visible entries
+    double translation = (orientation == Qt::Horizontal) ? worldMatrix.dx() : worldMatrix.dy();
+    int extent = (orientation == Qt::Horizontal) ? width() : height();
+
+    int firstIdx = (int)(std::upper_bound(thumbOffsets.begin(), thumbOffsets.end(), -translation) - thumbOffsets.begin()) - 1;
+    int lastIdx = (int)(std::lower_bound(thumbOffsets.begin(), thumbOffsets.end(), extent - translation) - thumbOffsets.begin()) - 1;
+    firstIdx = qMax(firstIdx, 0);
+    lastIdx = qMin(lastIdx, mThumbs.size() - 1);
 
-        if (((orientation == Qt::Horizontal && imgWorldRect.left() > width()) || (orientation == Qt::Vertical && imgWorldRect.top() > height()))
-            && scrollToCurrentImage) {
+    // mouse over effect
+    QPoint p = worldMatrix.inverted().map(mapFromGlobal(QCursor::pos()));
+    bool layoutChanged = false;
+
+    for (int idx = firstIdx; idx <= lastIdx; idx++) {
+        // sizes change if thumbnails are loaded or images are edited
+        layoutChanged |= updateThumbOffset(idx);
+
+        QRectF r = thumbRect(idx);
+
+        if (r.isEmpty())
             continue;
-        } else if ((orientation == Qt::Horizontal && imgWorldRect.left() > width()) || (orientation == Qt::Vertical && imgWorldRect.top() > height())) {
-            break;
-        }
+
+        thumbRects[idx] = r;
+
+        QSharedPointer<DkImageContainerT> imgC = mThumbs.at(idx);
+        QSharedPointer<DkThumbNailT> thumb = imgC->getThumb();
+        bool imgLoaded = imgC->hasImage();
+
+        QRectF imgWorldRect = worldMatrix.mapRect(r);
 
         // only fetch thumbs if we are not moving too fast...
         if (thumb->hasImage() == DkThumbNail::not_loaded && fabs(currentDx) < 40) {
             thumb->fetchThumb();
             connect(thumb.data(), SIGNAL(thumbLoadedSignal()), this, SLOT(update()));
+        } else if (thumb->hasImage() == DkThumbNail::loaded)
+            thumb->touch();
+
+        QImage img;
+
+        // the scaled image is computed in the background - show the thumbnail until it is ready
+        if (imgLoaded) {
+            img = imgC->scaledImage(qRound(r.height()));
+
+            if (img.isNull())
+                connect(imgC.data(), SIGNAL(scaledImageReady()), this, SLOT(update()), Qt::UniqueConnection);
         }
 
+        if (img.isNull() && thumb->hasImage() == DkThumbNail::loaded)
+            img = thumb->getImage();
+
         bool isLeftGradient = (orientation == Qt::Horizontal && worldMatrix.dx() < 0 && imgWorldRect.left() < leftGradient.finalStop().x())
             || (orientation == Qt::Vertical && worldMatrix.dy() < 0 && imgWorldRect.top() < leftGradient.finalStop().y());
         bool isRightGradient = (orientation == Qt::Horizontal && imgWorldRect.right() > rightGradient.start().x())
@@ -371,6 +479,10 @@ void DkFilePreview::drawThumbs(QPainter *painter)
 
         // painter->fillRect(QRect(0,0,200, 110), leftGradient);
     }
+
+    // the following entries moved - so the visible range might be different
+    if (layoutChanged)
+        update();
 }
 
 void DkFilePreview::drawNoImgEffect(QPainter *painter, const QRectF &r)
@@ -809,6 +921,7 @@ void DkFilePreview::setFileInfo(QSharedPointer<DkImageContainerT> cImage)
 void DkFilePreview::updateThumbs(QVector<QSharedPointer<DkImageContainerT>> thumbs)
 {
     mThumbs = thumbs;
+    thumbOffsets.clear(); // relayout
 
     for (int idx = 0; idx < thumbs.size(); idx++) {
         if (thumbs.at(idx)->isSelected()) {
@@ -820,6 +933,70 @@ void DkFilePreview::updateThumbs(QVector<QSharedPointer<DkImageContainerT>> thum
     update();
 }
 
+/**
+ * Inserts a single image (e.g. a new file in the current folder) without rebuilding the strip.
+ * @param idx the folder index of the new image.
+ * @param thumb the new image.
+ **/
+void DkFilePreview::insertThumb(int idx, QSharedPointer<DkImageContainerT> thumb)
+{
+    if (idx < 0 || idx > mThumbs.size())
+        return;
+
+    bool validLayout = thumbOffsets.size() == mThumbs.size() + 1;
+    mThumbs.insert(idx, thumb);
+
+    // move the following entries
+    if (validLayout) {
+        int ext = thumbExtent(idx);
+        thumbOffsets.insert(idx + 1, thumbOffsets[idx] + ext);
+
+        for (int oIdx = idx + 2; oIdx < thumbOffsets.size(); oIdx++)
+            thumbOffsets[oIdx] += ext;
+    }
+
+    // the current image keeps its position
+    if (currentFileIdx >= idx)
+        currentFileIdx++;
+    if (oldFileIdx >= idx)
+        oldFileIdx++;
+
+    update();
+}
+
+/**
+ * Removes a single image without rebuilding the strip.
+ * @param idx the folder index of the removed image.
+ **/
+void DkFilePreview::removeThumb(int idx)
+{
+    if (idx < 0 || idx >= mThumbs.size())
+        return;
+
+    mThumbs.remove(idx);
+
+    // move the following entries
+    if (thumbOffsets.size() == mThumbs.size() + 2) {
+        int ext = thumbOffsets[idx + 1] - thumbOffsets[idx];
+        thumbOffsets.remove(idx + 1);
+
+        for (int oIdx = idx + 1; oIdx < thumbOffsets.size(); oIdx++)
+            thumbOffsets[oIdx] -= ext;
+    }
+
+    if (currentFileIdx > idx)
+        currentFileIdx--;
+    else if (currentFileIdx == idx)
+        currentFileIdx = -1;
+
+    if (oldFileIdx > idx)
+        oldFileIdx--;
+    else if (oldFileIdx == idx)
+        oldFileIdx = -1;
+
+    update();
+}
+
 void DkFilePreview::setVisible(bool visible, bool saveSettings)
 {
     emit showThumbsDockSignal(visible);
@@ -837,7 +1014,6 @@ DkThumbLabel::DkThumbLabel(QSharedPointer<DkThumbNailT> thumb, QGraphicsItem *pa
     mIsHovered = false;
 
     setThumb(thumb);
-    setFlag(ItemIsSelectable, true);
 
     setAcceptHoverEvents(true);
 }
@@ -848,15 +1024,27 @@ DkThumbLabel::~DkThumbLabel()
 
 void DkThumbLabel::setThumb(QSharedPointer<DkThumbNailT> thumb)
 {
+    // labels are recycled by the scene - so forget everything about the old thumbnail
+    if (mThumb)
+        disconnect(mThumb.data(), 0, this, 0);
+
     this->mThumb = thumb;
+    mThumbInitialized = false;
+    mFetchingThumb = false;
+    mIsHovered = false;
+    mIcon.setPixmap(QPixmap());
+    mIcon.setScale(1.0f);
+    mIcon.setPos(0, 0);
+    mText.setPlainText("");
+    mFileInfo = QFileInfo();
 
     if (thumb.isNull())
         return;
 
     connect(thumb.data(), SIGNAL(thumbLoadedSignal()), this, SLOT(updateLabel()));
-    QFileInfo fileInfo(thumb->getFilePath());
-    QString toolTipInfo = tr("Name: ") + fileInfo.fileName() + "\n" + tr("Size: ") + DkUtils::readableByte((float)fileInfo.size()) + "\n" + tr("Created: ")
-        + fileInfo.created().toString(Qt::SystemLocaleDate);
+    mFileInfo = QFileInfo(thumb->getFilePath());
+    QString toolTipInfo = tr("Name: ") + mFileInfo.fileName() + "\n" + tr("Size: ") + DkUtils::readableByte((float)mFileInfo.size()) + "\n" + tr("Created: ")
+        + mFileInfo.created().toString(Qt::SystemLocaleDate);
 
     setToolTip(toolTipInfo);
 
@@ -877,9 +1065,36 @@ QPixmap DkThumbLabel::pixmap() const
 
 void DkThumbLabel::cancelLoading()
 {
+    if (mThumb)
+        mThumb->cancelFetch();
+
     mFetchingThumb = false;
 }
 
+void DkThumbLabel::setThumbIndex(int idx)
+{
+    mThumbIdx = idx;
+}
+
+int DkThumbLabel::thumbIndex() const
+{
+    return mThumbIdx;
+}
+
+void DkThumbLabel::setThumbSelected(bool selected)
+{
+    if (mSelected == selected)
+        return;
+
+    mSelected = selected;
+    update();
+}
+
+bool DkThumbLabel::isThumbSelected() const
+{
+    return mSelected;
+}
+
 QRectF DkThumbLabel::boundingRect() const
 {
     int sz = DkSettingsManager::param().effectiveThumbPreviewSize();
@@ -913,10 +1128,7 @@ void DkThumbLabel::updateLabel()
     if (!pm.isNull()) {
         mIcon.setTransformationMode(Qt::SmoothTransformation);
         mIcon.setPixmap(pm);
-        mIcon.setFlag(ItemIsSelectable, true);
     }
-    if (pm.isNull())
-        setFlag(ItemIsSelectable, false); // if we cannot load it -> disable selection
 
     // update label
     mText.setPos(0, pm.height());
@@ -955,6 +1167,12 @@ void DkThumbLabel::updateSize()
     // update();
 }
 
+void DkThumbLabel::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    // the selection is handled by the view - but we need the press to get double clicks
+    event->accept();
+}
+
 void DkThumbLabel::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
 {
     if (mThumb.isNull())
@@ -985,6 +1203,9 @@ void DkThumbLabel::setVisible(bool visible)
 
 void DkThumbLabel::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+    if (mThumb.isNull())
+        return;
+
     if (!mFetchingThumb && mThumb->hasImage() == DkThumbNail::not_loaded) {
         mThumb->fetchThumb();
         mFetchingThumb = true;
@@ -994,6 +1215,10 @@ void DkThumbLabel::paint(QPainter *painter, const QStyleOptionGraphicsItem *opti
         return; // exit - otherwise we get paint errors
     }
 
+    // visible thumbnails should not be evicted
+    if (mThumb->hasImage() == DkThumbNail::loaded)
+        mThumb->touch();
+
     if (mIcon.pixmap().isNull() && mThumb->hasImage() == DkThumbNail::exists_not) {
         painter->setPen(mNoImagePen);
         painter->setBrush(mNoImageBrush);
@@ -1043,6 +1268,15 @@ void DkThumbLabel::paint(QPainter *painter, const QStyleOptionGraphicsItem *opti
         painter->setWorldTransform(mt);
     }
 
+    // draw quality scores
+    if (boundingRect().width() > 50 && DkSettingsManager::param().display().showThumbScores)
+        paintScore(painter);
+
+    // draw the number of collapsed images
+    DkThumbScene *ts = qobject_cast<DkThumbScene *>(scene());
+    if (boundingRect().width() > 50 && ts && ts->burstSize(mThumbIdx) > 1)
+        paintBurst(painter, ts->burstSize(mThumbIdx));
+
     // render hovered
     if (mIsHovered) {
         painter->setBrush(QColor(255, 255, 255, 60));
@@ -1052,23 +1286,134 @@ void DkThumbLabel::paint(QPainter *painter, const QStyleOptionGraphicsItem *opti
     }
 
     // render selected
-    if (isSelected()) {
+    if (mSelected) {
         painter->setBrush(mSelectBrush);
         painter->setPen(mSelectPen);
         painter->drawRect(boundingRect());
     }
 }
 
+/**
+ * Draws a badge with the sharpness relative to the sharpest image of the folder.
+ * A second badge shows the clipped pixels if more than 1% are clipped:
+ * it is white if the highlights are blown out and black if the shadows are blocked.
+ * @param painter the label's painter.
+ **/
+void DkThumbLabel::paintScore(QPainter *painter) const
+{
+    DkImageScore s = DkImageScores::instance().score(mFileInfo);
+
+    if (!s.isValid())
+        return;
+
+    DkThumbScene *ts = qobject_cast<DkThumbScene *>(scene());
+    double maxSharpness = ts ? ts->maxSharpness() : 0.0;
+    int sharpness = maxSharpness > 0.0 ? qMin(qRound(s.sharpness / maxSharpness * 100.0), 100) : 0;
+
+    QColor col;
+    if (sharpness >= 80)
+        col = QColor(60, 160, 60);
+    else if (sharpness >= 50)
+        col = QColor(200, 150, 30);
+    else
+        col = QColor(190, 50, 50);
+
+    QFont font;
+    font.setBold(true);
+    font.setPointSize(7);
+    QFontMetrics fm(font);
+
+    painter->save();
+    painter->setFont(font);
+
+    QString text = QString::number(sharpness) + "%";
+    QRectF r(4, 4, fm.horizontalAdvance(text) + 6, fm.height() + 2);
+
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(col);
+    painter->drawRect(r);
+    painter->setPen(Qt::white);
+    painter->drawText(r, Qt::AlignCenter, text);
+
+    if (s.clipping() > 0.01) {
+        bool highlights = s.clippedHighlights >= s.clippedShadows;
+
+        text = QString::number(qMax(qRound(s.clipping() * 100.0), 1)) + "%";
+        r = QRectF(r.right() + 2, r.top(), fm.horizontalAdvance(text) + 6, r.height());
+
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(highlights ? QColor(255, 255, 255) : QColor(0, 0, 0));
+        painter->drawRect(r);
+        painter->setPen(highlights ? QColor(0, 0, 0) : QColor(255, 255, 255));
+        painter->drawText(r, Qt::AlignCenter, text);
+    }
+
+    painter->restore();
+}
+
+/**
+ * Draws a badge with the number of similar images that are collapsed into this thumbnail.
+ * @param painter the label's painter.
+ * @param burstSize the number of images (including this one).
+ **/
+void DkThumbLabel::paintBurst(QPainter *painter, int burstSize) const
+{
+    QFont font;
+    font.setBold(true);
+    font.setPointSize(7);
+    QFontMetrics fm(font);
+
+    QString text = "+" + QString::number(burstSize - 1);
+    QRectF br = boundingRect();
+    int w = fm.horizontalAdvance(text) + 6;
+    QRectF r(br.right() - w - 4, br.top() + 4, w, fm.height() + 2);
+
+    painter->save();
+    painter->setFont(font);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(DkSettingsManager::param().display().highlightColor);
+    painter->drawRect(r);
+    painter->setPen(Qt::white);
+    painter->drawText(r, Qt::AlignCenter, text);
+    painter->restore();
+}
+
 // DkThumbWidget --------------------------------------------------------------------
 DkThumbScene::DkThumbScene(QWidget *parent /* = 0 */)
     : QGraphicsScene(parent)
 {
     setObjectName("DkThumbWidget");
+
+    // we position the few labels that exist ourselves - no need to maintain an index
+    setItemIndexMethod(QGraphicsScene::NoIndex);
+
+    connect(&DkImageScores::instance(), SIGNAL(updated()), this, SLOT(updateScores()));
+    connect(&DkImageHashes::instance(), SIGNAL(finished()), this, SLOT(updateHashes()));
 }
 
 void DkThumbScene::updateLayout()
 {
-    if (mThumbLabels.empty())
+    if (mThumbs.empty())
+        return;
+
+    updateGrid();
+
+    int selIdx = selectedThumbIndex(false);
+    if (selIdx != -1)
+        ensureVisible(selIdx);
+
+    updateVisibleThumbs();
+
+    mFirstLayout = false;
+}
+
+/**
+ * Computes the grid and moves existing labels to their cells.
+ * In contrast to updateLayout() the view is not scrolled to the selection.
+ **/
+void DkThumbScene::updateGrid()
+{
+    if (mThumbs.empty())
         return;
 
     QSize pSize;
@@ -1079,68 +1424,214 @@ void DkThumbScene::updateLayout()
     int psz = DkSettingsManager::param().effectiveThumbPreviewSize();
     mXOffset = 2; // qCeil(psz*0.1f);
     mNumCols = qMax(qFloor(((float)pSize.width() - mXOffset) / (psz + mXOffset)), 1);
-    mNumCols = qMin(mThumbLabels.size(), mNumCols);
-    mNumRows = qCeil((float)mThumbLabels.size() / mNumCols);
+    mNumCols = qMin(mThumbs.size(), mNumCols);
+    mNumRows = qCeil((float)mThumbs.size() / mNumCols);
 
     int tso = psz + mXOffset;
     setSceneRect(0, 0, mNumCols * tso + mXOffset, mNumRows * tso + mXOffset);
 
-    DkTimer dt;
-    int cYOffset = mXOffset;
+    for (auto it = mThumbLabels.begin(); it != mThumbLabels.end(); it++) {
+        it.value()->setPos(thumbRect(it.key()).topLeft());
+        it.value()->updateSize();
+    }
+}
+
+/**
+ * Creates labels for all thumbnails that are close to the viewport.
+ * Labels that scrolled out of the visible range are recycled.
+ * Hence, the number of graphics items does not depend on the folder size.
+ **/
+void DkThumbScene::updateVisibleThumbs()
+{
+    if (mThumbs.empty() || mNumCols <= 0 || views().empty())
+        return;
 
-    for (int rIdx = 0; rIdx < mNumRows; rIdx++) {
-        int cXOffset = mXOffset;
+    QGraphicsView *view = views().first();
+    QRectF vr = view->mapToScene(view->viewport()->rect()).boundingRect();
 
-        for (int cIdx = 0; cIdx < mNumCols; cIdx++) {
-            int tIdx = rIdx * mNumCols + cIdx;
+    int tso = DkSettingsManager::param().effectiveThumbPreviewSize() + mXOffset;
+    int firstRow = qMax(qFloor(vr.top() / tso), 0);
+    int lastRow = qMin(qFloor(vr.bottom() / tso), mNumRows - 1);
+    int margin = qMax(lastRow - firstRow + 1, 1); // keep one page above and below
 
-            if (tIdx < 0 || tIdx >= mThumbLabels.size())
-                break;
+    int fromIdx = qMax(firstRow - margin, 0) * mNumCols;
+    int toIdx = qMin((lastRow + margin + 1) * mNumCols, mThumbs.size());
 
-            DkThumbLabel *cLabel = mThumbLabels.at(tIdx);
-            cLabel->setPos(cXOffset, cYOffset);
-            cLabel->updateSize();
+    for (auto it = mThumbLabels.begin(); it != mThumbLabels.end();) {
+        if (it.key() < fromIdx || it.key() >= toIdx) {
+            releaseThumbLabel(it.value());
+            it = mThumbLabels.erase(it);
+        } else
+            it++;
+    }
 
-            cXOffset += psz + mXOffset;
-        }
+    for (int idx = fromIdx; idx < toIdx; idx++) {
+        if (mThumbLabels.contains(idx))
+            continue;
 
-        // update ypos
-        cYOffset += psz + mXOffset; // 20 for label
+        DkThumbLabel *label = acquireThumbLabel();
+        label->setThumb(mThumbs.at(idx)->getThumb());
+        label->setThumbIndex(idx);
+        label->setThumbSelected(mSelected.at(idx));
+        label->setPos(thumbRect(idx).topLeft());
+        label->show();
+
+        connect(mThumbs.at(idx).data(), SIGNAL(thumbLoadedSignal()), this, SIGNAL(thumbLoadedSignal()), Qt::UniqueConnection);
+        mThumbLabels.insert(idx, label);
     }
 
-    for (int idx = 0; idx < mThumbLabels.size(); idx++) {
-        if (mThumbLabels.at(idx)->isSelected())
-            mThumbLabels.at(idx)->ensureVisible();
+    updateThumbPriorities(vr);
+}
+
+DkThumbLabel *DkThumbScene::acquireThumbLabel()
+{
+    if (!mFreeLabels.empty())
+        return mFreeLabels.takeLast();
+
+    DkThumbLabel *label = new DkThumbLabel();
+    connect(label, SIGNAL(loadFileSignal(const QString &, bool)), this, SIGNAL(loadFileSignal(const QString &, bool)));
+    connect(label, SIGNAL(showFileSignal(const QString &)), this, SLOT(showFile(const QString &)));
+    addItem(label);
+
+    return label;
+}
+
+void DkThumbScene::releaseThumbLabel(DkThumbLabel *label)
+{
+    int idx = label->thumbIndex();
+
+    // off-screen thumbnails should not block the queue
+    label->cancelLoading();
+
+    if (idx >= 0 && idx < mThumbs.size())
+        disconnect(mThumbs.at(idx).data(), SIGNAL(thumbLoadedSignal()), this, SIGNAL(thumbLoadedSignal()));
+
+    label->hide();
+    label->setThumb(QSharedPointer<DkThumbNailT>());
+    label->setThumbIndex(-1);
+    label->setThumbSelected(false);
+    mFreeLabels << label;
+}
+
+/**
+ * Moves all labels with an index >= from by offset.
+ * @param from the first thumb index that is shifted.
+ * @param offset the number of cells the labels are moved.
+ **/
+void DkThumbScene::shiftThumbLabels(int from, int offset)
+{
+    QHash<int, DkThumbLabel *> labels;
+
+    for (auto it = mThumbLabels.begin(); it != mThumbLabels.end(); it++) {
+        int idx = it.key() < from ? it.key() : it.key() + offset;
+        it.value()->setThumbIndex(idx);
+        labels.insert(idx, it.value());
     }
 
-    mFirstLayout = false;
+    mThumbLabels = labels;
+}
+
+QRectF DkThumbScene::thumbRect(int idx) const
+{
+    if (mNumCols <= 0 || idx < 0)
+        return QRectF();
+
+    int psz = DkSettingsManager::param().effectiveThumbPreviewSize();
+    int tso = psz + mXOffset;
+
+    return QRectF(mXOffset + (idx % mNumCols) * tso, mXOffset + (idx / mNumCols) * tso, psz, psz);
 }
 
 void DkThumbScene::updateThumbs(QVector<QSharedPointer<DkImageContainerT>> thumbs)
 {
-    this->mThumbs = thumbs;
+    // already up-to-date (e.g. after incremental folder updates)
+    if (thumbs == mFolderThumbs)
+        return;
+
+    mFolderThumbs = thumbs;
+
+    if (DkImageHashes::isNeeded())
+        requestHashes();
+
+    arrangeThumbs();
+    updateScores();
     updateThumbLabels();
 }
 
+/**
+ * Adds a single thumbnail without rebuilding the scene.
+ * @param idx the position of the new thumbnail.
+ * @param thumb the image that was added to the folder.
+ **/
+void DkThumbScene::insertThumb(int idx, QSharedPointer<DkImageContainerT> thumb)
+{
+    if (idx < 0 || idx > mFolderThumbs.size())
+        return;
+
+    mFolderThumbs.insert(idx, thumb);
+
+    // the folder index does not map to the grouped thumbnails
+    if (DkImageHashes::isNeeded()) {
+        requestHashes();
+        rearrangeThumbs();
+        return;
+    }
+
+    shiftThumbLabels(idx, 1);
+    mThumbs.insert(idx, thumb);
+    mSelected.insert(idx, false);
+
+    updateGrid();
+    updateVisibleThumbs();
+    showFile();
+}
+
+/**
+ * Removes a single thumbnail without rebuilding the scene.
+ * @param idx the index of the thumbnail that was removed from the folder.
+ **/
+void DkThumbScene::removeThumb(int idx)
+{
+    if (idx < 0 || idx >= mFolderThumbs.size())
+        return;
+
+    mFolderThumbs.remove(idx);
+
+    if (DkImageHashes::isNeeded()) {
+        rearrangeThumbs();
+        return;
+    }
+
+    DkThumbLabel *label = mThumbLabels.take(idx);
+    if (label)
+        releaseThumbLabel(label);
+
+    bool wasSelected = mSelected.at(idx);
+
+    mThumbs.remove(idx);
+    mSelected.remove(idx);
+    shiftThumbLabels(idx + 1, -1);
+
+    updateGrid();
+    updateVisibleThumbs();
+    showFile();
+
+    if (wasSelected)
+        emit selectionChanged();
+}
+
 void DkThumbScene::updateThumbLabels()
 {
+    for (DkThumbLabel *label : mThumbLabels)
+        label->cancelLoading();
+
     blockSignals(true); // do not emit selection changed while clearing!
     clear(); // deletes the thumbLabels
     blockSignals(false);
 
     mThumbLabels.clear();
-
-    for (int idx = 0; idx < mThumbs.size(); idx++) {
-        DkThumbLabel *thumb = new DkThumbLabel(mThumbs.at(idx)->getThumb());
-        connect(thumb, SIGNAL(loadFileSignal(const QString &, bool)), this, SIGNAL(loadFileSignal(const QString &, bool)));
-        connect(thumb, SIGNAL(showFileSignal(const QString &)), this, SLOT(showFile(const QString &)));
-        connect(mThumbs.at(idx).data(), SIGNAL(thumbLoadedSignal()), this, SIGNAL(thumbLoadedSignal()));
-
-        // thumb->show();
-        addItem(thumb);
-        mThumbLabels.append(thumb);
-        // thumbsNotLoaded.append(thumb);
-    }
+    mFreeLabels.clear();
+    mSelected = QVector<bool>(mThumbs.size(), false);
 
     showFile();
 
@@ -1168,11 +1659,22 @@ void DkThumbScene::connectLoader(QSharedPointer<DkImageLoader> loader, bool conn
                 this,
                 SLOT(updateThumbs(QVector<QSharedPointer<DkImageContainerT>>)),
                 Qt::UniqueConnection);
+        connect(loader.data(),
+                SIGNAL(imageInsertedSignal(int, QSharedPointer<DkImageContainerT>)),
+                this,
+                SLOT(insertThumb(int, QSharedPointer<DkImageContainerT>)),
+                Qt::UniqueConnection);
+        connect(loader.data(), SIGNAL(imageRemovedSignal(int)), this, SLOT(removeThumb(int)), Qt::UniqueConnection);
     } else {
         disconnect(loader.data(),
                    SIGNAL(updateDirSignal(QVector<QSharedPointer<DkImageContainerT>>)),
                    this,
                    SLOT(updateThumbs(QVector<QSharedPointer<DkImageContainerT>>)));
+        disconnect(loader.data(),
+                   SIGNAL(imageInsertedSignal(int, QSharedPointer<DkImageContainerT>)),
+                   this,
+                   SLOT(insertThumb(int, QSharedPointer<DkImageContainerT>)));
+        disconnect(loader.data(), SIGNAL(imageRemovedSignal(int)), this, SLOT(removeThumb(int)));
     }
 }
 
@@ -1193,7 +1695,7 @@ void DkThumbScene::keyPressEvent(QKeyEvent *event)
         break;
     }
     case Qt::Key_Right: {
-        selectThumb(qMin(idx + 1, mThumbLabels.size() - 1));
+        selectThumb(qMin(idx + 1, mThumbs.size() - 1));
         break;
     }
     case Qt::Key_Up: {
@@ -1201,7 +1703,7 @@ void DkThumbScene::keyPressEvent(QKeyEvent *event)
         break;
     }
     case Qt::Key_Down: {
-        selectThumb(qMin(idx + mNumCols, mThumbLabels.size() - 1));
+        selectThumb(qMin(idx + mNumCols, mThumbs.size() - 1));
         break;
     }
     }
@@ -1217,7 +1719,7 @@ void DkThumbScene::showFile(const QString &filePath)
         if (sf > 1)
             info = QString::number(sf) + tr(" selected");
         else
-            info = QString::number(mThumbLabels.size()) + tr(" images");
+            info = QString::number(mThumbs.size()) + tr(" images");
 
         DkStatusBarManager::instance().setMessage(tr("%1 | %2").arg(info, currentDir()));
     } else
@@ -1229,14 +1731,26 @@ void DkThumbScene::ensureVisible(QSharedPointer<DkImageContainerT> img) const
     if (!img)
         return;
 
-    for (DkThumbLabel *label : mThumbLabels) {
-        if (label->getThumb()->getFilePath() == img->filePath()) {
-            label->ensureVisible();
+    for (int idx = 0; idx < mThumbs.size(); idx++) {
+        if (mThumbs.at(idx)->filePath() == img->filePath()) {
+            ensureVisible(idx);
             break;
         }
     }
 }
 
+void DkThumbScene::ensureVisible(int idx) const
+{
+    QRectF r = thumbRect(idx);
+
+    if (r.isNull())
+        return;
+
+    // the label might not exist yet - so we scroll the views
+    for (QGraphicsView *v : views())
+        v->ensureVisible(r);
+}
+
 QString DkThumbScene::currentDir() const
 {
     if (mThumbs.empty() || !mThumbs[0])
@@ -1245,17 +1759,30 @@ QString DkThumbScene::currentDir() const
     return mThumbs[0]->fileInfo().absolutePath();
 }
 
+double DkThumbScene::maxSharpness() const
+{
+    return mMaxSharpness;
+}
+
+/**
+ * Returns the number of images a thumbnail represents.
+ * @param idx the thumbnail index.
+ * @return int > 1 if similar images are collapsed into this thumbnail.
+ **/
+int DkThumbScene::burstSize(int idx) const
+{
+    if (idx < 0 || idx >= mBurstSizes.size())
+        return 1;
+
+    return mBurstSizes[idx];
+}
+
 int DkThumbScene::selectedThumbIndex(bool first)
 {
-    int selIdx = -1;
-    for (int idx = 0; idx < mThumbLabels.size(); idx++) {
-        if (first && mThumbLabels[idx]->isSelected())
-            return idx;
-        else if (mThumbLabels[idx]->isSelected())
-            selIdx = idx;
-    }
+    if (first)
+        return mSelected.indexOf(true);
 
-    return selIdx;
+    return mSelected.lastIndexOf(true);
 }
 
 void DkThumbScene::toggleThumbLabels(bool show)
@@ -1266,6 +1793,219 @@ void DkThumbScene::toggleThumbLabels(bool show)
         t->update();
 }
 
+void DkThumbScene::toggleThumbScores(bool show)
+{
+    DkSettingsManager::param().display().showThumbScores = show;
+
+    if (show && mLoader)
+        mLoader->scoreImages();
+
+    updateScores();
+
+    for (const auto t : mThumbLabels)
+        t->update();
+}
+
+/**
+ * Updates the sharpest image of the folder if new scores were computed.
+ * The badges show the sharpness relative to that image.
+ **/
+void DkThumbScene::updateScores()
+{
+    if (!DkSettingsManager::param().display().showThumbScores)
+        return;
+
+    DkImageScores &scores = DkImageScores::instance();
+    mMaxSharpness = 0.0;
+
+    for (const QSharedPointer<DkImageContainerT> &t : mThumbs)
+        mMaxSharpness = qMax(scores.score(t->fileInfo()).sharpness, mMaxSharpness);
+
+    for (const auto t : mThumbLabels)
+        t->update();
+}
+
+void DkThumbScene::toggleGroupSimilar(bool group)
+{
+    DkSettingsManager::param().display().groupSimilarThumbs = group;
+
+    if (group)
+        requestHashes();
+
+    rearrangeThumbs();
+}
+
+void DkThumbScene::toggleCollapseBursts(bool collapse)
+{
+    DkSettingsManager::param().display().collapseBursts = collapse;
+
+    if (collapse)
+        requestHashes();
+
+    rearrangeThumbs();
+}
+
+/**
+ * Selects the next thumbnail that is not similar to the (last) selected thumbnail.
+ * Thumbnails are hashed in the background if needed - so this gets more accurate while browsing.
+ **/
+void DkThumbScene::selectNextDistinct()
+{
+    if (mThumbs.empty())
+        return;
+
+    requestHashes();
+
+    QVector<int> groups = similarityGroups(mThumbs);
+    int idx = selectedThumbIndex(false);
+    int nextIdx = idx + 1;
+
+    if (idx >= 0) {
+        while (nextIdx < mThumbs.size() && groups[nextIdx] == groups[idx])
+            nextIdx++;
+    }
+
+    if (nextIdx >= mThumbs.size()) {
+        DkStatusBarManager::instance().setMessage(tr("No more distinct images"));
+        return;
+    }
+
+    selectThumbs(false);
+    selectThumb(nextIdx);
+}
+
+/**
+ * Applies grouping & collapsing once all requested images are hashed.
+ **/
+void DkThumbScene::updateHashes()
+{
+    if (!DkImageHashes::isNeeded())
+        return;
+
+    rearrangeThumbs();
+}
+
+/**
+ * Queues all images of the folder that are not hashed yet.
+ **/
+void DkThumbScene::requestHashes() const
+{
+    QList<QFileInfo> files;
+
+    for (const QSharedPointer<DkImageContainerT> &t : mFolderThumbs)
+        files << t->fileInfo();
+
+    DkImageHashes::instance().request(files);
+}
+
+/**
+ * Returns the similarity group of each thumbnail.
+ * @param thumbs the thumbnails.
+ * @return QVector<int> the index of the first similar thumbnail for each thumbnail.
+ **/
+QVector<int> DkThumbScene::similarityGroups(const QVector<QSharedPointer<DkImageContainerT>> &thumbs) const
+{
+    DkImageHashes &ih = DkImageHashes::instance();
+    QVector<DkImageHash> hashes;
+    hashes.reserve(thumbs.size());
+
+    for (const QSharedPointer<DkImageContainerT> &t : thumbs)
+        hashes << ih.hash(t->fileInfo());
+
+    return DkImageHashes::group(hashes);
+}
+
+/**
+ * Computes the displayed thumbnails from the folder.
+ * If similar images are grouped, each group is moved to its first image.
+ * If bursts are collapsed, only the first of consecutive similar images is shown.
+ **/
+void DkThumbScene::arrangeThumbs()
+{
+    mBurstSizes.clear();
+
+    if (!DkImageHashes::isNeeded()) {
+        mThumbs = mFolderThumbs;
+        return;
+    }
+
+    const DkSettings::Display &dp = DkSettingsManager::param().display();
+    QVector<int> groups = similarityGroups(mFolderThumbs);
+    QVector<int> order;
+    order.reserve(mFolderThumbs.size());
+
+    if (dp.groupSimilarThumbs) {
+        QHash<int, QVector<int>> members;
+        for (int idx = 0; idx < groups.size(); idx++)
+            members[groups[idx]] << idx;
+
+        // the group id is the index of its first image
+        for (int idx = 0; idx < groups.size(); idx++) {
+            if (groups[idx] == idx)
+                order << members.value(idx);
+        }
+    } else {
+        for (int idx = 0; idx < groups.size(); idx++)
+            order << idx;
+    }
+
+    mThumbs.clear();
+    int lastGroup = -1;
+
+    for (int idx : order) {
+        if (dp.collapseBursts && !mThumbs.empty() && groups[idx] == lastGroup) {
+            mBurstSizes.last()++;
+            continue;
+        }
+
+        mThumbs << mFolderThumbs[idx];
+        mBurstSizes << 1;
+        lastGroup = groups[idx];
+    }
+}
+
+/**
+ * Arranges the thumbnails again and keeps the selection.
+ **/
+void DkThumbScene::rearrangeThumbs()
+{
+    QVector<QSharedPointer<DkImageContainerT>> oldThumbs = mThumbs;
+    QVector<int> oldBurstSizes = mBurstSizes;
+
+    arrangeThumbs();
+
+    if (mThumbs == oldThumbs && mBurstSizes == oldBurstSizes)
+        return;
+
+    QSet<QString> selected;
+    for (const QString &fp : getSelectedFiles())
+        selected.insert(fp);
+
+    updateScores();
+    updateThumbLabels();
+
+    int firstIdx = -1;
+
+    for (int idx = 0; idx < mThumbs.size(); idx++) {
+        if (!selected.contains(mThumbs[idx]->filePath()))
+            continue;
+
+        mSelected[idx] = true;
+
+        if (mThumbLabels.contains(idx))
+            mThumbLabels.value(idx)->setThumbSelected(true);
+
+        if (firstIdx == -1)
+            firstIdx = idx;
+    }
+
+    if (firstIdx != -1) {
+        ensureVisible(firstIdx);
+        showFile();
+        emit selectionChanged();
+    }
+}
+
 void DkThumbScene::toggleSquaredThumbs(bool squares)
 {
     DkSettingsManager::param().display().displaySquaredThumbs = squares;
@@ -1309,6 +2049,35 @@ void DkThumbScene::cancelLoading()
         t->cancelLoading();
 }
 
+/**
+ * Prioritizes thumbnails by their distance to the visible rect.
+ * @param visibleRect the visible scene rect
+ **/
+void DkThumbScene::updateThumbPriorities(const QRectF &visibleRect)
+{
+    if (mThumbLabels.empty() || mNumCols <= 0)
+        return;
+
+    int tso = DkSettingsManager::param().effectiveThumbPreviewSize() + mXOffset;
+    int firstRow = qFloor(visibleRect.top() / tso);
+    int lastRow = qFloor(visibleRect.bottom() / tso);
+
+    for (DkThumbLabel *label : mThumbLabels) {
+        if (!label->getThumb() || label->getThumb()->hasImage() != DkThumbNail::loading)
+            continue;
+
+        int row = label->thumbIndex() / mNumCols;
+        int dist = 0;
+
+        if (row < firstRow)
+            dist = firstRow - row;
+        else if (row > lastRow)
+            dist = row - lastRow;
+
+        label->getThumb()->setPriority(-dist);
+    }
+}
+
 void DkThumbScene::selectAllThumbs(bool selected)
 {
     selectThumbs(selected);
@@ -1316,11 +2085,11 @@ void DkThumbScene::selectAllThumbs(bool selected)
 
 void DkThumbScene::selectThumbs(bool selected /* = true */, int from /* = 0 */, int to /* = -1 */)
 {
-    if (mThumbLabels.empty())
+    if (mThumbs.empty())
         return;
 
     if (to == -1)
-        to = mThumbLabels.size() - 1;
+        to = mThumbs.size() - 1;
 
     if (from > to) {
         int tmp = to;
@@ -1328,32 +2097,35 @@ void DkThumbScene::selectThumbs(bool selected /* = true */, int from /* = 0 */,
         from = tmp;
     }
 
-    blockSignals(true);
-    for (int idx = from; idx <= to && idx < mThumbLabels.size(); idx++) {
-        mThumbLabels.at(idx)->setSelected(selected);
+    for (int idx = qMax(from, 0); idx <= to && idx < mSelected.size(); idx++) {
+        mSelected[idx] = selected;
     }
-    blockSignals(false);
+
+    for (DkThumbLabel *label : mThumbLabels)
+        label->setThumbSelected(mSelected.at(label->thumbIndex()));
+
     emit selectionChanged();
     showFile(); // update selection label
 }
 
 void DkThumbScene::selectThumb(int idx, bool select)
 {
-    if (mThumbLabels.empty())
+    if (mThumbs.empty())
         return;
 
-    if (idx < 0 || idx >= mThumbLabels.size()) {
+    if (idx < 0 || idx >= mThumbs.size()) {
         qWarning() << "index out of bounds in selectThumbs()" << idx;
         return;
     }
 
-    blockSignals(true);
-    mThumbLabels[idx]->setSelected(select);
-    blockSignals(false);
+    mSelected[idx] = select;
+
+    if (mThumbLabels.contains(idx))
+        mThumbLabels.value(idx)->setThumbSelected(select);
 
     emit selectionChanged();
     showFile(); // update selection label
-    ensureVisible(mThumbs[idx]);
+    ensureVisible(idx);
 }
 
 void DkThumbScene::copySelected() const
@@ -1529,22 +2301,21 @@ QStringList DkThumbScene::getSelectedFiles() const
 {
     QStringList fileList;
 
-    for (int idx = 0; idx < mThumbLabels.size(); idx++) {
-        if (mThumbLabels.at(idx) && mThumbLabels.at(idx)->isSelected()) {
-            fileList.append(mThumbLabels.at(idx)->getThumb()->getFilePath());
-        }
+    for (int idx = 0; idx < mSelected.size(); idx++) {
+        if (mSelected.at(idx))
+            fileList.append(mThumbs.at(idx)->getThumb()->getFilePath());
     }
 
     return fileList;
 }
 
-QVector<DkThumbLabel *> DkThumbScene::getSelectedThumbs() const
+QVector<QSharedPointer<DkThumbNailT>> DkThumbScene::getSelectedThumbs() const
 {
-    QVector<DkThumbLabel *> selected;
+    QVector<QSharedPointer<DkThumbNailT>> selected;
 
-    for (DkThumbLabel *label : mThumbLabels) {
-        if (label->isSelected())
-            selected << label;
+    for (int idx = 0; idx < mSelected.size(); idx++) {
+        if (mSelected.at(idx))
+            selected << mThumbs.at(idx)->getThumb();
     }
 
     return selected;
@@ -1552,25 +2323,23 @@ QVector<DkThumbLabel *> DkThumbScene::getSelectedThumbs() const
 
 int DkThumbScene::findThumb(DkThumbLabel *thumb) const
 {
-    int thumbIdx = -1;
+    if (!thumb)
+        return -1;
 
-    for (int idx = 0; idx < mThumbLabels.size(); idx++) {
-        if (thumb == mThumbLabels.at(idx)) {
-            thumbIdx = idx;
-            break;
-        }
-    }
+    return thumb->thumbIndex();
+}
 
-    return thumbIdx;
+bool DkThumbScene::isThumbSelected(int idx) const
+{
+    if (idx < 0 || idx >= mSelected.size())
+        return false;
+
+    return mSelected.at(idx);
 }
 
 bool DkThumbScene::allThumbsSelected() const
 {
-    for (DkThumbLabel *label : mThumbLabels)
-        if (label->flags() & QGraphicsItem::ItemIsSelectable && !label->isSelected())
-            return false;
-
-    return true;
+    return !mSelected.contains(false);
 }
 
 // DkThumbView --------------------------------------------------------------------
@@ -1581,6 +2350,16 @@ DkThumbsView::DkThumbsView(DkThumbScene *scene, QWidget *parent /* = 0 */)
     this->scene = scene;
     connect(scene, SIGNAL(thumbLoadedSignal()), this, SLOT(fetchThumbs()));
 
+    // re-prioritize thumbnail loading while scrolling
+    mPriorityTimer = new QTimer(this);
+    mPriorityTimer->setSingleShot(true);
+    mPriorityTimer->setInterval(50);
+    connect(mPriorityTimer, SIGNAL(timeout()), this, SLOT(updateThumbPriorities()));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), mPriorityTimer, SLOT(start()));
+
+    // labels are only created for thumbnails close to the viewport
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), scene, SLOT(updateVisibleThumbs()));
+
     setResizeAnchor(QGraphicsView::AnchorUnderMouse);
     setAcceptDrops(true);
 
@@ -1608,7 +2387,20 @@ void DkThumbsView::mousePressEvent(QMouseEvent *event)
 
     qDebug() << "mouse pressed";
 
-    DkThumbLabel *itemClicked = static_cast<DkThumbLabel *>(scene->itemAt(mapToScene(event->pos()), QTransform()));
+    DkThumbLabel *itemClicked = thumbAt(event->pos());
+
+    // labels are recycled - so the scene keeps the selection and we update it here
+    if (event->button() == Qt::LeftButton) {
+        int idx = scene->findThumb(itemClicked);
+
+        if (idx != -1 && event->modifiers() & Qt::ControlModifier)
+            scene->selectThumbs(!scene->isThumbSelected(idx), idx, idx);
+        else if (idx != -1 && !(event->modifiers() & Qt::ShiftModifier && lastShiftIdx != -1) && !scene->isThumbSelected(idx)) {
+            scene->selectThumbs(false);
+            scene->selectThumbs(true, idx, idx);
+        } else if (!itemClicked && event->modifiers() == Qt::NoModifier)
+            scene->selectThumbs(false);
+    }
 
     // this is a bit of a hack
     // what we want to achieve: if the user is selecting with e.g. shift or ctrl
@@ -1636,11 +2428,11 @@ void DkThumbsView::mouseMoveEvent(QMouseEvent *event)
                 mimeData->setUrls(urls);
 
                 // create thumb image
-                QVector<DkThumbLabel *> tl = scene->getSelectedThumbs();
+                QVector<QSharedPointer<DkThumbNailT>> tl = scene->getSelectedThumbs();
                 QVector<QImage> imgs;
 
                 for (int idx = 0; idx < tl.size() && idx < 3; idx++) {
-                    imgs << tl[idx]->getThumb()->getImage();
+                    imgs << tl[idx]->getImage();
                 }
 
                 QPixmap pm = DkImage::merge(imgs).scaledToHeight(73); // 73: see https://www.youtube.com/watch?v=TIYMmbHik08
@@ -1661,16 +2453,40 @@ void DkThumbsView::mouseReleaseEvent(QMouseEvent *event)
 {
     QGraphicsView::mouseReleaseEvent(event);
 
-    DkThumbLabel *itemClicked = static_cast<DkThumbLabel *>(scene->itemAt(mapToScene(event->pos()), QTransform()));
+    DkThumbLabel *itemClicked = thumbAt(event->pos());
 
     if (lastShiftIdx != -1 && event->modifiers() & Qt::ShiftModifier && itemClicked != 0) {
         scene->selectThumbs(true, lastShiftIdx, scene->findThumb(itemClicked));
     } else if (itemClicked != 0) {
+        // a click (without dragging) on a selected thumbnail selects only this one
+        int idx = scene->findThumb(itemClicked);
+        if (event->button() == Qt::LeftButton && event->modifiers() == Qt::NoModifier
+            && QPointF(event->pos() - mousePos).manhattanLength() <= QApplication::startDragDistance()) {
+            scene->selectThumbs(false);
+            scene->selectThumbs(true, idx, idx);
+        }
+
         lastShiftIdx = scene->findThumb(itemClicked);
     } else
         lastShiftIdx = -1;
 }
 
+/**
+ * Returns the thumbnail at pos.
+ * Items of a thumbnail (e.g. its text) are resolved to the thumbnail.
+ * @param pos the position in view coordinates
+ * @return DkThumbLabel* the thumbnail or 0 if there is none
+ **/
+DkThumbLabel *DkThumbsView::thumbAt(const QPoint &pos) const
+{
+    QGraphicsItem *item = scene->itemAt(mapToScene(pos), QTransform());
+
+    while (item && !qgraphicsitem_cast<DkThumbLabel *>(item))
+        item = item->parentItem();
+
+    return qgraphicsitem_cast<DkThumbLabel *>(item);
+}
+
 void DkThumbsView::dragEnterEvent(QDragEnterEvent *event)
 {
     QGraphicsView::dragEnterEvent(event);
@@ -1755,6 +2571,11 @@ void DkThumbsView::fetchThumbs()
     }
 }
 
+void DkThumbsView::updateThumbPriorities()
+{
+    scene->updateThumbPriorities(mapToScene(viewport()->rect()).boundingRect());
+}
+
 // DkThumbScrollWidget --------------------------------------------------------------------
 DkThumbScrollWidget::DkThumbScrollWidget(QWidget *parent /* = 0 */, Qt::WindowFlags flags /* = 0 */)
     : DkFadeWidget(parent, flags)
@@ -1793,6 +2614,9 @@ void DkThumbScrollWidget::createToolbar()
     mToolbar->addAction(am.action(DkActionManager::preview_zoom_out));
     mToolbar->addAction(am.action(DkActionManager::preview_display_squares));
     mToolbar->addAction(am.action(DkActionManager::preview_show_labels));
+    mToolbar->addAction(am.action(DkActionManager::preview_show_scores));
+    mToolbar->addAction(am.action(DkActionManager::preview_group_similar));
+    mToolbar->addAction(am.action(DkActionManager::preview_collapse_bursts));
     mToolbar->addSeparator();
     mToolbar->addAction(am.action(DkActionManager::preview_copy));
     mToolbar->addAction(am.action(DkActionManager::preview_paste));
@@ -1819,6 +2643,7 @@ void DkThumbScrollWidget::createToolbar()
     // filter edit
     mFilterEdit = new QLineEdit("", this);
     mFilterEdit->setPlaceholderText(tr("Filter Files (Ctrl + F)"));
+    mFilterEdit->setToolTip(tr("Filter by file name or metadata, e.g. camera:canon lens:50 rating>=3 iso<=800 taken:2024-05 width>=4000 gps"));
     mFilterEdit->setMaximumWidth(250);
 
     // right align search filters
@@ -1836,7 +2661,7 @@ void DkThumbScrollWidget::createActions()
     for (int idx = 0; idx < actions.size(); idx++) {
         mContextMenu->addAction(actions.at(idx));
 
-        if (idx == DkActionManager::preview_show_labels)
+        if (idx == DkActionManager::preview_show_scores || idx == DkActionManager::preview_next_distinct)
             mContextMenu->addSeparator();
     }
 
@@ -1883,15 +2708,12 @@ void DkThumbScrollWidget::batchPrint() const
 
 void DkThumbScrollWidget::on_loadFile_triggered()
 {
-    auto selected = mThumbsScene->selectedItems();
+    QStringList selected = mThumbsScene->getSelectedFiles();
 
     if (selected.isEmpty())
         return;
 
-    auto thumb = dynamic_cast<DkThumbLabel *>(selected.first());
-
-    if (thumb && thumb->getThumb())
-        mThumbsScene->loadFileSignal(thumb->getThumb()->getFilePath(), false);
+    mThumbsScene->loadFileSignal(selected.first(), false);
 }
 
 void DkThumbScrollWidget::updateThumbs(QVector<QSharedPointer<DkImageContainerT>> thumbs)
@@ -1935,6 +2757,10 @@ void DkThumbScrollWidget::connectToActions(bool activate)
         connect(am.action(DkActionManager::preview_zoom_out), SIGNAL(triggered()), mThumbsScene, SLOT(decreaseThumbs()));
         connect(am.action(DkActionManager::preview_display_squares), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleSquaredThumbs(bool)));
         connect(am.action(DkActionManager::preview_show_labels), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleThumbLabels(bool)));
+        connect(am.action(DkActionManager::preview_show_scores), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleThumbScores(bool)));
+        connect(am.action(DkActionManager::preview_group_similar), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleGroupSimilar(bool)));
+        connect(am.action(DkActionManager::preview_collapse_bursts), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleCollapseBursts(bool)));
+        connect(am.action(DkActionManager::preview_next_distinct), SIGNAL(triggered()), mThumbsScene, SLOT(selectNextDistinct()));
         connect(am.action(DkActionManager::preview_filter), SIGNAL(triggered()), this, SLOT(setFilterFocus()));
         connect(am.action(DkActionManager::preview_delete), SIGNAL(triggered()), mThumbsScene, SLOT(deleteSelected()));
         connect(am.action(DkActionManager::preview_copy), SIGNAL(triggered()), mThumbsScene, SLOT(copySelected()));
@@ -1952,6 +2778,10 @@ void DkThumbScrollWidget::connectToActions(bool activate)
         disconnect(am.action(DkActionManager::preview_zoom_out), SIGNAL(triggered()), mThumbsScene, SLOT(decreaseThumbs()));
         disconnect(am.action(DkActionManager::preview_display_squares), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleSquaredThumbs(bool)));
         disconnect(am.action(DkActionManager::preview_show_labels), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleThumbLabels(bool)));
+        disconnect(am.action(DkActionManager::preview_show_scores), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleThumbScores(bool)));
+        disconnect(am.action(DkActionManager::preview_group_similar), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleGroupSimilar(bool)));
+        disconnect(am.action(DkActionManager::preview_collapse_bursts), SIGNAL(triggered(bool)), mThumbsScene, SLOT(toggleCollapseBursts(bool)));
+        disconnect(am.action(DkActionManager::preview_next_distinct), SIGNAL(triggered()), mThumbsScene, SLOT(selectNextDistinct()));
         disconnect(am.action(DkActionManager::preview_filter), SIGNAL(triggered()), this, SLOT(setFilterFocus()));
         disconnect(am.action(DkActionManager::preview_delete), SIGNAL(triggered()), mThumbsScene, SLOT(deleteSelected()));
         disconnect(am.action(DkActionManager::preview_copy), SIGNAL(triggered()), mThumbsScene, SLOT(copySelected()));
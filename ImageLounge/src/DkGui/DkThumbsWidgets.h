@@ -33,6 +33,7 @@
 #include <QGraphicsObject>
 #include <QGraphicsScene>
 #include <QGraphicsView>
+#include <QHash>
 #include <QPen>
 #include <QProcess>
 #include <QSharedPointer>
@@ -113,6 +114,8 @@ public slots:
     void moveImages();
     void updateFileIdx(int fileIdx);
     void updateThumbs(QVector<QSharedPointer<DkImageContainerT>> thumbs);
+    void insertThumb(int idx, QSharedPointer<DkImageContainerT> thumb);
+    void removeThumb(int idx);
     void setFileInfo(QSharedPointer<DkImageContainerT> cImage);
     void newPosition();
 
@@ -145,6 +148,8 @@ private:
 
     QRectF bufferDim;
     QVector<QRectF> thumbRects;
+    QVector<int> thumbOffsets; // start of every entry in the strip (prefix sum)
+    QSize thumbLayout; // (thumb size, strip height) thumbOffsets were computed for
 
     QLinearGradient leftGradient;
     QLinearGradient rightGradient;
@@ -178,6 +183,11 @@ private:
     void init();
     void initOrientations();
     void drawThumbs(QPainter *painter);
+    void layoutThumbs();
+    bool updateThumbOffset(int idx);
+    int thumbExtent(int idx) const;
+    QSizeF thumbRectSize(int idx) const;
+    QRectF thumbRect(int idx) const;
     void drawFadeOut(QLinearGradient gradient, QRectF imgRect, QImage *img);
     void drawSelectedEffect(QPainter *painter, const QRectF &r);
     void drawCurrentImgEffect(QPainter *painter, const QRectF &r);
@@ -193,6 +203,15 @@ public:
     DkThumbLabel(QSharedPointer<DkThumbNailT> thumb = QSharedPointer<DkThumbNailT>(), QGraphicsItem *parent = 0);
     ~DkThumbLabel();
 
+    // needed for qgraphicsitem_cast
+    enum {
+        Type = UserType + 1
+    };
+    int type() const override
+    {
+        return Type;
+    };
+
     void setThumb(QSharedPointer<DkThumbNailT> thumb);
     QSharedPointer<DkThumbNailT> getThumb()
     {
@@ -204,6 +223,10 @@ public:
     void setVisible(bool visible);
     QPixmap pixmap() const;
     void cancelLoading();
+    void setThumbIndex(int idx);
+    int thumbIndex() const;
+    void setThumbSelected(bool selected);
+    bool isThumbSelected() const;
 
 public slots:
     void updateLabel();
@@ -213,12 +236,16 @@ signals:
     void showFileSignal(const QString &filePath = QString()) const;
 
 protected:
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0) override;
     void hoverEnterEvent(QGraphicsSceneHoverEvent *event) override;
     void hoverLeaveEvent(QGraphicsSceneHoverEvent *event) override;
+    void paintScore(QPainter *painter) const;
+    void paintBurst(QPainter *painter, int burstSize) const;
 
     QSharedPointer<DkThumbNailT> mThumb;
+    QFileInfo mFileInfo;
     QGraphicsPixmapItem mIcon;
     QGraphicsTextItem mText;
     bool mThumbInitialized = false;
@@ -229,6 +256,8 @@ protected:
     QBrush mSelectBrush;
     bool mIsHovered = false;
     QPointF mLastMove;
+    int mThumbIdx = -1;
+    bool mSelected = false;
 };
 
 class DllCoreExport DkThumbScene : public QGraphicsScene
@@ -239,30 +268,46 @@ public:
     DkThumbScene(QWidget *parent = 0);
 
     void updateLayout();
+    void updateGrid();
     QStringList getSelectedFiles() const;
-    QVector<DkThumbLabel *> getSelectedThumbs() const;
+    QVector<QSharedPointer<DkThumbNailT>> getSelectedThumbs() const;
     int selectedThumbIndex(bool first = true);
 
     void setImageLoader(QSharedPointer<DkImageLoader> loader);
     void copyImages(const QMimeData *mimeData, const Qt::DropAction &da = Qt::CopyAction) const;
     int findThumb(DkThumbLabel *thumb) const;
     bool allThumbsSelected() const;
+    bool isThumbSelected(int idx) const;
     void ensureVisible(QSharedPointer<DkImageContainerT> img) const;
+    void ensureVisible(int idx) const;
+    QRectF thumbRect(int idx) const;
     QString currentDir() const;
+    double maxSharpness() const;
+    int burstSize(int idx) const;
 
 public slots:
     void updateThumbLabels();
+    void updateVisibleThumbs();
     void cancelLoading();
+    void updateThumbPriorities(const QRectF &visibleRect);
     void increaseThumbs();
     void decreaseThumbs();
     void toggleSquaredThumbs(bool squares);
     void toggleThumbLabels(bool show);
+    void toggleThumbScores(bool show);
+    void updateScores();
+    void toggleGroupSimilar(bool group);
+    void toggleCollapseBursts(bool collapse);
+    void selectNextDistinct();
+    void updateHashes();
     void resizeThumbs(float dx);
     void showFile(const QString &filePath = QString());
     void selectThumbs(bool select = true, int from = 0, int to = -1);
     void selectThumb(int idx, bool select = true);
     void selectAllThumbs(bool select = true);
     void updateThumbs(QVector<QSharedPointer<DkImageContainerT>> thumbs);
+    void insertThumb(int idx, QSharedPointer<DkImageContainerT> thumb);
+    void removeThumb(int idx);
     void deleteSelected() const;
     void copySelected() const;
     void pasteImages() const;
@@ -276,15 +321,30 @@ signals:
 protected:
     void connectLoader(QSharedPointer<DkImageLoader> loader, bool connectSignals = true);
     void keyPressEvent(QKeyEvent *event) override;
+    DkThumbLabel *acquireThumbLabel();
+    void releaseThumbLabel(DkThumbLabel *label);
+    void shiftThumbLabels(int from, int offset);
+    void requestHashes() const;
+    void arrangeThumbs();
+    void rearrangeThumbs();
+    QVector<int> similarityGroups(const QVector<QSharedPointer<DkImageContainerT>> &thumbs) const;
 
     int mXOffset = 0;
     int mNumRows = 0;
     int mNumCols = 0;
     bool mFirstLayout = true;
 
-    QVector<DkThumbLabel *> mThumbLabels;
+    // only labels close to the viewport exist - they are keyed by thumb index
+    QHash<int, DkThumbLabel *> mThumbLabels;
+    QVector<DkThumbLabel *> mFreeLabels;
+    QVector<bool> mSelected;
     QSharedPointer<DkImageLoader> mLoader;
     QVector<QSharedPointer<DkImageContainerT>> mThumbs;
+    double mMaxSharpness = 0.0;
+
+    // the folder as sorted by the loader - mThumbs differs if similar images are grouped or collapsed
+    QVector<QSharedPointer<DkImageContainerT>> mFolderThumbs;
+    QVector<int> mBurstSizes;
 };
 
 class DkThumbsView : public QGraphicsView
@@ -299,6 +359,7 @@ signals:
 
 public slots:
     void fetchThumbs();
+    void updateThumbPriorities();
 
 protected:
     void wheelEvent(QWheelEvent *event) override;
@@ -309,9 +370,12 @@ protected:
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
 
+    DkThumbLabel *thumbAt(const QPoint &pos) const;
+
     DkThumbScene *scene;
     QPointF mousePos;
     int lastShiftIdx;
+    QTimer *mPriorityTimer = 0;
 };
 
 class DllCoreExport DkThumbScrollWidget : public DkFadeWidget
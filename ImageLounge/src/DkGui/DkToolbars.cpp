@@ -567,9 +567,9 @@ void DkTransferToolBar::createIcons()
 
     mToolBarIcons.resize(icon_toolbar_end);
 
-    mToolBarIcons[icon_toolbar_reset] = DkImage::loadIcon(":/nomacs/img/gradient-reset.svg");
-    mToolBarIcons[icon_toolbar_pipette] = DkImage::loadIcon(":/nomacs/img/pipette.svg");
-    mToolBarIcons[icon_toolbar_save] = DkImage::loadIcon(":/nomacs/img/save.svg");
+    mToolBarIcons[icon_toolbar_reset] = DkImage::loadIconDeferred(":/nomacs/img/gradient-reset.svg");
+    mToolBarIcons[icon_toolbar_pipette] = DkImage::loadIconDeferred(":/nomacs/img/pipette.svg");
+    mToolBarIcons[icon_toolbar_save] = DkImage::loadIconDeferred(":/nomacs/img/save.svg");
 
     mToolBarActions.resize(toolbar_end);
     mToolBarActions[toolbar_reset] = new QAction(mToolBarIcons[icon_toolbar_reset], tr("Reset"), this);
@@ -41,6 +41,7 @@
 #include "DkStatusBar.h"
 #include "DkThumbsWidgets.h" // needed in the connects -> shall we move them to mController?
 #include "DkToolbars.h"
+#include "DkTrace.h"
 #include "DkUtils.h"
 #include "DkWidgets.h"
 
@@ -57,7 +58,9 @@
 #include <QMimeData>
 #include <QMovie>
 #include <QSvgRenderer>
+#include <QScreen>
 #include <QVBoxLayout>
+#include <QWindow>
 #include <QtConcurrentRun>
 
 #include <qmath.h>
@@ -78,6 +81,7 @@ DkViewPort::DkViewPort(QWidget *parent)
 {
     mRepeatZoomTimer = new QTimer(this);
     mAnimationTimer = new QTimer(this);
+    mPreScaleTimer = new QTimer(this);
 
     // try loading a custom file
     mImgBg.load(QFileInfo(QApplication::applicationDirPath(), "bg.png").absoluteFilePath());
@@ -89,9 +93,13 @@ DkViewPort::DkViewPort(QWidget *parent)
     mRepeatZoomTimer->setInterval(20);
     connect(mRepeatZoomTimer, SIGNAL(timeout()), this, SLOT(repeatZoom()));
 
-    mAnimationTimer->setInterval(5);
+    // the interval is set to the display's refresh rate once the animation starts
+    mAnimationTimer->setTimerType(Qt::PreciseTimer);
     connect(mAnimationTimer, SIGNAL(timeout()), this, SLOT(animateFade()));
 
+    mPreScaleTimer->setSingleShot(true);
+    connect(mPreScaleTimer, SIGNAL(timeout()), this, SLOT(preScaleNextImage()));
+
     // no border
     setMouseTracking(true); // receive mouse event everytime
 
@@ -177,6 +185,7 @@ DkViewPort::DkViewPort(QWidget *parent)
     // playing
     connect(mNavigationWidget, SIGNAL(previousSignal()), this, SLOT(loadPrevFileFast()));
     connect(mNavigationWidget, SIGNAL(nextSignal()), this, SLOT(loadNextFileFast()));
+    connect(mController->getPlayer(), SIGNAL(playSignal(bool)), this, SLOT(playFrameSequence(bool)));
 
     // trivial connects
     connect(this, &DkViewPort::movieLoadedSignal, [this](bool movie) {
@@ -352,9 +361,37 @@ void DkViewPort::setImage(QImage newImg)
 
     mOldImgRect = mImgRect;
 
+    if (mController->getPlayer()->isPlaying() && !isPlayingFrameSequence()) {
+        QSharedPointer<DkImageContainerT> imgC = imageContainer();
+
+        // use the slide that was scaled ahead of time (see preScaleNextImage)
+        if (imgC && imgC->hasImage() && imgC->pixmap().cacheKey() == newImg.cacheKey()) {
+            QImage scaledImg = imgC->scaledImage(fitSize(newImg.size()).height());
+
+            if (!scaledImg.isNull())
+                mImgStorage.setScaledImage(scaledImg);
+        }
+
+        // scale the next slide before it is shown
+        int interval = qRound(DkSettingsManager::param().slideShow().time * 1000);
+        mPreScaleTimer->start(qMax(interval - 1000, interval / 2));
+    }
+
     // init fading
     if (DkSettingsManager::param().display().animationDuration && DkSettingsManager::param().display().transition != DkSettingsManager::param().trans_appear
+        && !isPlayingFrameSequence()
         && (mController->getPlayer()->isPlaying() || DkUtils::getMainWindow()->isFullScreen() || DkSettingsManager::param().display().alwaysAnimate)) {
+        // pace the transition to the display's refresh rate
+        QWindow *win = window()->windowHandle();
+        QScreen *screen = win && win->screen() ? win->screen() : QGuiApplication::primaryScreen();
+        double refreshRate = screen && screen->refreshRate() > 1.0 ? screen->refreshRate() : 60.0;
+
+        mFrameInterval = 1000.0 / refreshRate;
+        mLastFrameTime = -1;
+        mAnimationFrames = 0;
+        mDroppedFrames = 0;
+
+        mAnimationTimer->setInterval(qMax(qFloor(mFrameInterval), 1));
         mAnimationTimer->start();
         mAnimationTime.start();
     } else
@@ -908,6 +945,7 @@ void DkViewPort::manipulatorApplied()
 
 void DkViewPort::paintEvent(QPaintEvent *event)
 {
+    DK_TRACE_SCOPE("paint", "viewport");
     QPainter painter(viewport());
 
     if (!mImgStorage.isEmpty()) {
@@ -925,12 +963,12 @@ void DkViewPort::paintEvent(QPaintEvent *event)
             painter.setRenderHints(QPainter::SmoothPixmapTransform | QPainter::Antialiasing);
         }
 
-        if (DkSettingsManager::param().display().transition == DkSettings::trans_swipe && !mAnimationBuffer.isNull()) {
-            double dx = mNextSwipe ? width() * (mAnimationValue) : -width() * (mAnimationValue);
+        bool swipe = DkSettingsManager::param().display().transition == DkSettings::trans_swipe && !mAnimationBuffer.isNull();
 
-            QTransform swipeTransform;
-            swipeTransform.translate(dx, 0);
-            painter.setTransform(swipeTransform);
+        // swipes move the view transform - it is kept if images are blitted without the world matrix
+        if (swipe) {
+            int dx = qRound(mNextSwipe ? width() * mAnimationValue : -width() * mAnimationValue);
+            painter.setViewport(QRect(QPoint(dx, 0), viewport()->size()));
         }
 
         // TODO: if fading is active we interpolate with background instead of the other image
@@ -943,17 +981,25 @@ void DkViewPort::paintEvent(QPaintEvent *event)
             // fade transition
             if (DkSettingsManager::param().display().transition == DkSettings::trans_fade) {
                 painter.setOpacity(mAnimationValue);
-            } else if (DkSettingsManager::param().display().transition == DkSettings::trans_swipe) {
-                double dx = mNextSwipe ? -width() * (1.0 - mAnimationValue) : width() * (1.0 - mAnimationValue);
-                QTransform swipeTransform;
-                swipeTransform.translate(dx, 0);
-                painter.setTransform(swipeTransform);
+            } else if (swipe) {
+                int dx = qRound(mNextSwipe ? -width() * (1.0 - mAnimationValue) : width() * (1.0 - mAnimationValue));
+                painter.setViewport(QRect(QPoint(dx, 0), viewport()->size()));
             }
 
-            painter.drawImage(mFadeImgViewRect, mAnimationBuffer, mAnimationBuffer.rect());
+            // the buffer has the display's resolution - so we simply blend it
+            painter.setWorldMatrixEnabled(false);
+            painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+            painter.drawImage(mFadeDisplayRect, mAnimationBuffer, mAnimationBuffer.rect());
+            painter.setWorldMatrixEnabled(true);
             painter.setOpacity(oldOp);
         }
 
+        if (swipe)
+            painter.setViewport(QRect(QPoint(), viewport()->size()));
+
+        if (mAnimationTimer->isActive())
+            countAnimationFrame();
+
         // now disable world matrix for overlay display
         painter.setWorldMatrixEnabled(false);
     } else
@@ -1490,11 +1536,105 @@ void DkViewPort::animateFade()
         mAnimationBuffer = QImage();
         mAnimationTimer->stop();
         mAnimationValue = 0;
+
+        qInfo().nospace() << "[Transition] " << mAnimationFrames << " frames in " << mAnimationTime << " @ " << qRound(1000.0 / mFrameInterval) << " Hz, "
+                          << mDroppedFrames << " dropped";
     }
 
     update();
 }
 
+/**
+ * Counts the frames of a transition.
+ * Frames are dropped if the time between two paint events exceeds the display's refresh interval.
+ **/
+void DkViewPort::countAnimationFrame()
+{
+    int t = mAnimationTime.elapsed();
+
+    if (mLastFrameTime >= 0) {
+        int missed = qRound((t - mLastFrameTime) / mFrameInterval) - 1;
+
+        if (missed > 0)
+            mDroppedFrames += missed;
+    }
+
+    mLastFrameTime = t;
+    mAnimationFrames++;
+}
+
+/**
+ * Scales the next slide to the size it will be displayed with.
+ * Hence, the transition does not need to scale the full resolution image.
+ * The image itself is decoded ahead of time by the DkImageCacher.
+ **/
+void DkViewPort::preScaleNextImage()
+{
+    if (!mController->getPlayer()->isPlaying() || !imageContainer())
+        return;
+
+    QVector<QSharedPointer<DkImageContainerT>> images = mLoader->getImages();
+    int idx = mLoader->findFileIdx(imageContainer()->filePath(), images);
+
+    if (idx == -1)
+        return;
+
+    if (++idx >= images.size()) {
+        if (!DkSettingsManager::param().global().loop)
+            return;
+        idx = 0;
+    }
+
+    QSharedPointer<DkImageContainerT> nextImg = images.at(idx);
+
+    // not decoded yet - try again soon
+    if (!nextImg->hasImage()) {
+        mPreScaleTimer->start(200);
+        return;
+    }
+
+    nextImg->scaledImage(fitSize(nextImg->pixmap().size()).height());
+}
+
+/**
+ * Plays raw frames (drif, yuv) like a video if the player is started on such a frame.
+ * The frames are then decoded at the viewport's size and requested with the target frame rate.
+ * @param playing true if the player was started
+ **/
+void DkViewPort::playFrameSequence(bool playing)
+{
+    QSharedPointer<DkImageContainerT> imgC = imageContainer();
+    bool sequence = playing && imgC && DkBasicLoader::isDrifFile(imgC->filePath());
+    float fps = sequence ? DkSettingsManager::param().slideShow().frameRate : 0.0f;
+
+    // nothing to stop
+    if (!sequence && !isPlayingFrameSequence())
+        return;
+
+    mController->getPlayer()->setFrameRate(fps);
+
+    if (mLoader)
+        mLoader->setFrameSequence(fps, sequence ? viewport()->size() * viewport()->devicePixelRatioF() : QSize());
+}
+
+bool DkViewPort::isPlayingFrameSequence() const
+{
+    return mController->getPlayer()->frameRate() > 0;
+}
+
+/**
+ * Returns the size of an image if it is fit to the viewport (e.g. in a slideshow).
+ * @param imgSize the image size
+ * @return QSize the size the image is displayed with
+ **/
+QSize DkViewPort::fitSize(const QSize &imgSize) const
+{
+    if (mViewportRect.contains(QRect(QPoint(), imgSize)))
+        return imgSize;
+
+    return imgSize.scaled(mViewportRect.size(), Qt::KeepAspectRatio);
+}
+
 void DkViewPort::togglePattern(bool show)
 {
     emit infoSignal((show) ? tr("Transparency Pattern Enabled") : tr("Transparency Pattern Disabled"));
@@ -1617,11 +1757,22 @@ void DkViewPort::setEditedImage(QSharedPointer<DkImageContainerT> img)
 
 bool DkViewPort::unloadImage(bool fileChange)
 {
-    if (DkSettingsManager::param().display().animationDuration > 0
+    if (DkSettingsManager::param().display().animationDuration > 0 && !isPlayingFrameSequence()
         && (mController->getPlayer()->isPlaying() || DkUtils::getMainWindow()->isFullScreen() || DkSettingsManager::param().display().alwaysAnimate)) {
-        QRect dr = mWorldMatrix.mapRect(mImgViewRect).toRect();
-        mAnimationBuffer = mImgStorage.image(dr.size());
-        mFadeImgViewRect = mImgViewRect;
+        // the outgoing slide is rendered once at the display's resolution
+        // the transition then just blends this buffer with the next (pre-scaled) slide
+        double dpr = viewport()->devicePixelRatioF();
+        mFadeDisplayRect = QRect(QPoint(), viewport()->size());
+        mAnimationBuffer = QImage(mFadeDisplayRect.size() * dpr, QImage::Format_ARGB32_Premultiplied);
+        mAnimationBuffer.setDevicePixelRatio(dpr);
+        mAnimationBuffer.fill(Qt::transparent);
+
+        if (!mImgStorage.isEmpty()) {
+            QPainter painter(&mAnimationBuffer);
+            painter.setWorldTransform(mWorldMatrix);
+            draw(painter, 1.0);
+        }
+
         mFadeImgRect = mImgRect;
         mAnimationValue = 1.0f;
     }
@@ -1880,6 +2031,12 @@ void DkViewPort::connectLoader(QSharedPointer<DkImageLoader> loader, bool connec
                 mController->getFilePreview(),
                 SLOT(updateThumbs(QVector<QSharedPointer<DkImageContainerT>>)),
                 Qt::UniqueConnection);
+        connect(loader.data(),
+                SIGNAL(imageInsertedSignal(int, QSharedPointer<DkImageContainerT>)),
+                mController->getFilePreview(),
+                SLOT(insertThumb(int, QSharedPointer<DkImageContainerT>)),
+                Qt::UniqueConnection);
+        connect(loader.data(), SIGNAL(imageRemovedSignal(int)), mController->getFilePreview(), SLOT(removeThumb(int)), Qt::UniqueConnection);
         connect(loader.data(),
                 SIGNAL(imageUpdatedSignal(QSharedPointer<DkImageContainerT>)),
                 mController->getFilePreview(),
@@ -1889,12 +2046,19 @@ void DkViewPort::connectLoader(QSharedPointer<DkImageLoader> loader, bool connec
         connect(loader.data(), SIGNAL(showInfoSignal(const QString &, int, int)), mController, SLOT(setInfo(const QString &, int, int)), Qt::UniqueConnection);
 
         connect(loader.data(), SIGNAL(setPlayer(bool)), mController->getPlayer(), SLOT(play(bool)), Qt::UniqueConnection);
+        connect(mController->getPlayer(), SIGNAL(playSignal(bool)), loader.data(), SLOT(setSlideshowPlaying(bool)), Qt::UniqueConnection);
 
         connect(loader.data(),
                 SIGNAL(updateDirSignal(QVector<QSharedPointer<DkImageContainerT>>)),
                 mController->getScroller(),
                 SLOT(updateDir(QVector<QSharedPointer<DkImageContainerT>>)),
                 Qt::UniqueConnection);
+        connect(loader.data(),
+                SIGNAL(imageInsertedSignal(int, QSharedPointer<DkImageContainerT>)),
+                mController->getScroller(),
+                SLOT(imageInserted(int)),
+                Qt::UniqueConnection);
+        connect(loader.data(), SIGNAL(imageRemovedSignal(int)), mController->getScroller(), SLOT(imageRemoved(int)), Qt::UniqueConnection);
         connect(loader.data(), SIGNAL(imageUpdatedSignal(int)), mController->getScroller(), SLOT(updateFile(int)), Qt::UniqueConnection);
         connect(mController->getScroller(), SIGNAL(valueChanged(int)), loader.data(), SLOT(loadFileAt(int)));
     } else {
@@ -1917,6 +2081,11 @@ void DkViewPort::connectLoader(QSharedPointer<DkImageLoader> loader, bool connec
                    SIGNAL(updateDirSignal(QVector<QSharedPointer<DkImageContainerT>>)),
                    mController->getFilePreview(),
                    SLOT(updateThumbs(QVector<QSharedPointer<DkImageContainerT>>)));
+        disconnect(loader.data(),
+                   SIGNAL(imageInsertedSignal(int, QSharedPointer<DkImageContainerT>)),
+                   mController->getFilePreview(),
+                   SLOT(insertThumb(int, QSharedPointer<DkImageContainerT>)));
+        disconnect(loader.data(), SIGNAL(imageRemovedSignal(int)), mController->getFilePreview(), SLOT(removeThumb(int)));
         disconnect(loader.data(),
                    SIGNAL(imageUpdatedSignal(QSharedPointer<DkImageContainerT>)),
                    mController->getFilePreview(),
@@ -1934,11 +2103,17 @@ void DkViewPort::connectLoader(QSharedPointer<DkImageLoader> loader, bool connec
         disconnect(loader.data(), SIGNAL(updateSpinnerSignalDelayed(bool, int)), mController, SLOT(setSpinnerDelayed(bool, int)));
 
         disconnect(loader.data(), SIGNAL(setPlayer(bool)), mController->getPlayer(), SLOT(play(bool)));
+        disconnect(mController->getPlayer(), SIGNAL(playSignal(bool)), loader.data(), SLOT(setSlideshowPlaying(bool)));
 
         disconnect(loader.data(),
                    SIGNAL(updateDirSignal(QVector<QSharedPointer<DkImageContainerT>>)),
                    mController->getScroller(),
                    SLOT(updateDir(QVector<QSharedPointer<DkImageContainerT>>)));
+        disconnect(loader.data(),
+                   SIGNAL(imageInsertedSignal(int, QSharedPointer<DkImageContainerT>)),
+                   mController->getScroller(),
+                   SLOT(imageInserted(int)));
+        disconnect(loader.data(), SIGNAL(imageRemovedSignal(int)), mController->getScroller(), SLOT(imageRemoved(int)));
         disconnect(loader.data(),
                    SIGNAL(imageUpdatedSignal(QSharedPointer<DkImageContainerT>)),
                    mController->getScroller(),
@@ -2285,25 +2460,27 @@ DkViewPortContrast::DkViewPortContrast(QWidget *parent)
     connect(ttb, SIGNAL(tFEnabled(bool)), this, SLOT(enableTF(bool)));
     connect(this, SIGNAL(tFSliderAdded(qreal)), ttb, SLOT(insertSlider(qreal)));
     connect(this, SIGNAL(imageModeSet(int)), ttb, SLOT(setImageMode(int)));
+
+    connect(&mChannelWatcher, SIGNAL(finished()), this, SLOT(falseColorComputed()));
 }
 
 DkViewPortContrast::~DkViewPortContrast()
 {
+    mChannelWatcher.blockSignals(true);
+    mChannelWatcher.waitForFinished();
 }
 
 void DkViewPortContrast::changeChannel(int channel)
 {
-    if (channel < 0 || channel >= mImgs.size())
+    if (channel < 0 || channel > 3 || (mGrayImage && channel != 0))
         return;
 
     if (!mImgStorage.isEmpty()) {
-        mFalseColorImg = mImgs[channel];
-        mFalseColorImg.setColorTable(mColorTable);
+        // the channel is computed when the image is drawn
+        mActiveChannel = channel;
         mDrawFalseColorImg = true;
 
         update();
-
-        drawImageHistogram();
     }
 }
 
@@ -2388,71 +2565,38 @@ void DkViewPortContrast::draw(QPainter &painter, double opacity)
     if (DkSettingsManager::param().display().tpPattern && img.hasAlphaChannel() && opacity == 1.0)
         drawPattern(painter);
 
-    if (mDrawFalseColorImg)
-        painter.drawImage(mImgViewRect, mFalseColorImg, mImgRect);
+    if (img.cacheKey() != mFalseColorKey || mActiveChannel != mFalseColorChannel)
+        requestFalseColorImage(img);
+
+    // we might draw a lower resolution until the current one is computed
+    if (!mFalseColorImg.isNull())
+        painter.drawImage(mImgViewRect, mFalseColorImg, QRectF(QPointF(), mFalseColorImg.size()));
+    else
+        DkBaseViewPort::draw(painter, opacity);
 }
 
 void DkViewPortContrast::setImage(QImage newImg)
 {
     DkViewPort::setImage(newImg);
 
-    if (newImg.isNull())
-        return;
+    // invalidate the false color image of the last image
+    mImageId++;
+    mFalseColorImg = QImage();
+    mFalseColorKey = 0;
 
-    if (mImgStorage.image().format() == QImage::Format_Indexed8) {
-        mImgs = QVector<QImage>(1);
-        mImgs[0] = mImgStorage.image();
-        mActiveChannel = 0;
-    }
-#ifdef WITH_OPENCV
-
-    else {
-
-        mImgs = QVector<QImage>(4);
-        std::vector<cv::Mat> planes;
-
-        cv::Mat imgUC3 = DkImage::qImage2Mat(mImgStorage.image());
-        // int format = imgQt.format();
-        // if (format == QImage::Format_RGB888)
-        //	imgUC3 = Mat(imgQt.height(), imgQt.width(), CV_8UC3, (uchar*)imgQt.bits(), imgQt.bytesPerLine());
-        // else
-        //	imgUC3 = Mat(imgQt.height(), imgQt.width(), CV_8UC4, (uchar*)imgQt.bits(), imgQt.bytesPerLine());
-        split(imgUC3, planes);
-        // Store the 3 channels in a QImage Vector.
-        // Be aware that OpenCV 'swaps' the rgb triplet, hence process it in a descending way:
-        int idx = 1;
-        for (int i = 2; i >= 0; i--) {
-            // dirty hack
-            if (i >= (int)planes.size())
-                i = 0;
-            mImgs[idx] = QImage((const unsigned char *)planes[i].data, (int)planes[i].cols, (int)planes[i].rows, (int)planes[i].step, QImage::Format_Indexed8);
-            mImgs[idx] = mImgs[idx].copy();
-            idx++;
-        }
-        // The first element in the vector contains the gray scale 'average' of the 3 channels:
-        cv::Mat grayMat;
-        cv::cvtColor(imgUC3, grayMat, CV_BGR2GRAY);
-        mImgs[0] = QImage((const unsigned char *)grayMat.data, (int)grayMat.cols, (int)grayMat.rows, (int)grayMat.step, QImage::Format_Indexed8);
-        mImgs[0] = mImgs[0].copy();
-        planes.clear();
-    }
-#else
-
-    else {
-        mDrawFalseColorImg = false;
-        emit imageModeSet(mode_invalid_format);
+    if (newImg.isNull())
         return;
-    }
 
-#endif
+    // channels are not computed here - draw() requests the active one in display resolution
+    mGrayImage = mImgStorage.image().format() == QImage::Format_Indexed8;
 
-    mFalseColorImg = mImgs[mActiveChannel];
-    mFalseColorImg.setColorTable(mColorTable);
+    if (mGrayImage)
+        mActiveChannel = 0;
 
     // images with valid color table return img.isGrayScale() false...
     if (mSvg || mMovie)
         emit imageModeSet(mode_invalid_format);
-    else if (mImgs.size() == 1)
+    else if (mGrayImage)
         emit imageModeSet(mode_gray);
     else
         emit imageModeSet(mode_rgb);
@@ -2460,6 +2604,76 @@ void DkViewPortContrast::setImage(QImage newImg)
     update();
 }
 
+/**
+ * Computes the active channel of the (scaled) image in the background.
+ * @param img the image as it is currently displayed.
+ **/
+void DkViewPortContrast::requestFalseColorImage(const QImage &img)
+{
+    // we are called again (by update) once the current job is finished
+    if (mChannelWatcher.isRunning() || img.isNull())
+        return;
+
+    mJobKey = img.cacheKey();
+    mJobChannel = mActiveChannel;
+    mJobImageId = mImageId;
+
+    mChannelWatcher.setFuture(QtConcurrent::run(&DkViewPortContrast::channelImage, img, mActiveChannel));
+}
+
+void DkViewPortContrast::falseColorComputed()
+{
+    // the image changed in the meantime
+    if (mJobImageId != mImageId) {
+        update();
+        return;
+    }
+
+    mFalseColorImg = mChannelWatcher.result();
+    mFalseColorImg.setColorTable(mColorTable);
+    mFalseColorKey = mJobKey;
+    mFalseColorChannel = mJobChannel;
+
+    update();
+    drawImageHistogram();
+}
+
+/**
+ * Extracts a single channel.
+ * @param img the source image.
+ * @param channel 0: gray, 1: red, 2: green, 3: blue.
+ * @return QImage an 8 bit indexed image.
+ **/
+QImage DkViewPortContrast::channelImage(const QImage &img, int channel)
+{
+    QImage src = img.convertToFormat(QImage::Format_RGB32);
+    QImage dst(src.size(), QImage::Format_Indexed8);
+
+    for (int y = 0; y < src.height(); y++) {
+        const QRgb *sp = reinterpret_cast<const QRgb *>(src.constScanLine(y));
+        uchar *dp = dst.scanLine(y);
+
+        for (int x = 0; x < src.width(); x++)
+            dp[x] = (uchar)channelValue(sp[x], channel);
+    }
+
+    return dst;
+}
+
+int DkViewPortContrast::channelValue(QRgb pixel, int channel)
+{
+    switch (channel) {
+    case 1:
+        return qRed(pixel);
+    case 2:
+        return qGreen(pixel);
+    case 3:
+        return qBlue(pixel);
+    default:
+        return qGray(pixel);
+    }
+}
+
 void DkViewPortContrast::pickColor(bool enable)
 {
     mIsColorPickerActive = enable;
@@ -2502,7 +2716,7 @@ void DkViewPortContrast::mouseReleaseEvent(QMouseEvent *event)
             isPointValid = false;
 
         if (isPointValid) {
-            int colorIdx = mImgs[mActiveChannel].pixelIndex(xy);
+            int colorIdx = channelValue(mImgStorage.imageConst().pixel(xy), mActiveChannel);
             qreal normedPos = (qreal)colorIdx / 255;
             emit tFSliderAdded(normedPos);
         }
@@ -2526,9 +2740,12 @@ void DkViewPortContrast::keyPressEvent(QKeyEvent *event)
 
 QImage DkViewPortContrast::getImage() const
 {
-    if (mDrawFalseColorImg)
-        return mFalseColorImg;
-    else
+    // the full resolution is only computed if it is requested (e.g. for saving)
+    if (mDrawFalseColorImg) {
+        QImage img = channelImage(mImgStorage.imageConst(), mActiveChannel);
+        img.setColorTable(mColorTable);
+        return img;
+    } else
         return imageContainer() ? imageContainer()->image() : QImage();
 }
 
@@ -2536,7 +2753,7 @@ QImage DkViewPortContrast::getImage() const
 void DkViewPortContrast::drawImageHistogram()
 {
     if (mController->getHistogram() && mController->getHistogram()->isVisible()) {
-        if (mDrawFalseColorImg)
+        if (mDrawFalseColorImg && !mFalseColorImg.isNull())
             mController->getHistogram()->drawHistogram(mFalseColorImg);
         else
             mController->getHistogram()->drawHistogram(getImage());
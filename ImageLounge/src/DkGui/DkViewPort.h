@@ -204,6 +204,8 @@ public slots:
     void nextMovieFrame();
     void previousMovieFrame();
     void animateFade();
+    void preScaleNextImage();
+    void playFrameSequence(bool playing);
     virtual void togglePattern(bool show) override;
 
 protected:
@@ -229,9 +231,14 @@ protected:
     DkTimer mAnimationTime;
     QImage mAnimationBuffer;
     double mAnimationValue;
-    QRectF mFadeImgViewRect;
+    QRect mFadeDisplayRect;
     QRectF mFadeImgRect;
     bool mNextSwipe = true;
+    QTimer *mPreScaleTimer;
+    double mFrameInterval = 1000.0 / 60.0; // ms
+    int mLastFrameTime = -1;
+    int mAnimationFrames = 0;
+    int mDroppedFrames = 0;
 
     QImage mImgBg;
 
@@ -256,6 +263,9 @@ protected:
     void drawPolygon(QPainter &painter, const QPolygon &polygon);
     virtual void drawBackground(QPainter &painter);
     void updateImageMatrix() override;
+    QSize fitSize(const QSize &imgSize) const;
+    bool isPlayingFrameSequence() const;
+    void countAnimationFrame();
     void showZoom();
     void toggleLena(bool fullscreen);
     void getPixelInfo(const QPoint &pos);
@@ -324,17 +334,33 @@ protected:
     virtual void mouseReleaseEvent(QMouseEvent *event) override;
     virtual void keyPressEvent(QKeyEvent *event) override;
 
+protected slots:
+    void falseColorComputed();
+
 private:
+    // the false color image has display resolution
     QImage mFalseColorImg;
+    qint64 mFalseColorKey = 0;
+    int mFalseColorChannel = -1;
+
     bool mDrawFalseColorImg = false;
     bool mIsColorPickerActive = false;
+    bool mGrayImage = false;
     int mActiveChannel = 0;
+    int mImageId = 0;
+
+    QFutureWatcher<QImage> mChannelWatcher;
+    qint64 mJobKey = 0;
+    int mJobChannel = -1;
+    int mJobImageId = 0;
 
-    QVector<QImage> mImgs;
     QVector<QRgb> mColorTable;
 
     // functions
     void drawImageHistogram();
+    void requestFalseColorImage(const QImage &img);
+    static QImage channelImage(const QImage &img, int channel);
+    static int channelValue(QRgb pixel, int channel);
 };
 
 }
@@ -149,6 +149,33 @@ void DkFolderScrollBar::updateDir(QVector<QSharedPointer<DkImageContainerT>> ima
     setMaximum(images.size() - 1);
 }
 
+/**
+ * Keeps the slider at the current file if a file is inserted before it.
+ * @param idx the index of the new file
+ **/
+void DkFolderScrollBar::imageInserted(int idx)
+{
+    int cIdx = value();
+    setMaximum(maximum() + 1);
+
+    if (idx <= cIdx)
+        updateFile(cIdx + 1);
+}
+
+/**
+ * Keeps the slider at the current file if a file before it is removed.
+ * If the current file is removed, the loader loads its neighbor which updates the slider.
+ * @param idx the index of the removed file
+ **/
+void DkFolderScrollBar::imageRemoved(int idx)
+{
+    int cIdx = value();
+    setMaximum(maximum() - 1);
+
+    if (idx < cIdx)
+        updateFile(cIdx - 1);
+}
+
 void DkFolderScrollBar::updateFile(int idx)
 {
     if (mMouseDown)
@@ -1409,6 +1436,8 @@ void DkPlayer::play(bool play)
         hideTimer->start();
     } else
         displayTimer->stop();
+
+    emit playSignal(play);
 }
 
 void DkPlayer::togglePlay()
@@ -1420,7 +1449,10 @@ void DkPlayer::togglePlay()
 
 void DkPlayer::startTimer()
 {
-    if (playing) {
+    // frame sequences: the timer keeps running - we just count the frame
+    if (playing && mFrameRate > 0) {
+        frameShown();
+    } else if (playing) {
         displayTimer->setInterval(qRound(DkSettingsManager::param().slideShow().time * 1000)); // if it was updated...
         displayTimer->start();
     }
@@ -1428,9 +1460,71 @@ void DkPlayer::startTimer()
 
 void DkPlayer::autoNext()
 {
+    // the last frame is not displayed yet - wait for it (but not longer than a second)
+    if (mFrameRate > 0 && mFramePending && ++mPendingTicks < qCeil(mFrameRate)) {
+        mFramesLate++;
+        return;
+    }
+
+    mFramePending = mFrameRate > 0;
+    mPendingTicks = 0;
+
     emit nextSignal();
 }
 
+/**
+ * Plays frame sequences (e.g. drif dumps) like videos.
+ * The next frame is requested with the target frame rate - unless the last frame is not displayed yet.
+ * @param fps the target frame rate - 0 switches back to the slideshow
+ **/
+void DkPlayer::setFrameRate(float fps)
+{
+    mFrameRate = fps;
+    mFramePending = false;
+    mPendingTicks = 0;
+    mFramesShown = 0;
+    mFramesLate = 0;
+    mFrameTime.start();
+
+    displayTimer->setSingleShot(fps <= 0);
+    displayTimer->setTimerType(fps > 0 ? Qt::PreciseTimer : Qt::CoarseTimer);
+    displayTimer->setInterval(fps > 0 ? qRound(1000.0f / fps) : qRound(DkSettingsManager::param().slideShow().time * 1000));
+
+    if (playing)
+        displayTimer->start();
+
+    if (fps <= 0)
+        DkStatusBarManager::instance().setMessage("", DkStatusBar::status_fps_info);
+}
+
+float DkPlayer::frameRate() const
+{
+    return mFrameRate;
+}
+
+/**
+ * Counts the frames that are displayed and reports the achieved frame rate every second.
+ **/
+void DkPlayer::frameShown()
+{
+    mFramePending = false;
+    mFramesShown++;
+
+    qint64 elapsed = mFrameTime.elapsed();
+
+    if (elapsed < 1000)
+        return;
+
+    float fps = mFramesShown * 1000.0f / elapsed;
+
+    qInfo().nospace() << "[Player] " << fps << " fps (target: " << mFrameRate << " fps, " << mFramesLate << " ticks without a new frame)";
+    DkStatusBarManager::instance().setMessage(tr("%1 fps").arg(fps, 0, 'f', 1), DkStatusBar::status_fps_info);
+
+    mFramesShown = 0;
+    mFramesLate = 0;
+    mFrameTime.restart();
+}
+
 void DkPlayer::next()
 {
     hideTimer->stop();
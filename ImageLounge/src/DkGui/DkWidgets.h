@@ -29,6 +29,7 @@
 
 #pragma warning(push, 0) // no warnings from includes - begin
 #include <QDockWidget>
+#include <QElapsedTimer>
 #include <QFileSystemModel>
 #include <QFutureWatcher>
 #include <QLineEdit>
@@ -242,10 +243,13 @@ public:
     ~DkPlayer(){};
 
     void setTimeToDisplay(int ms = 1000);
+    void setFrameRate(float fps);
+    float frameRate() const;
 
 signals:
     void nextSignal();
     void previousSignal();
+    void playSignal(bool playing);
 
 public slots:
     void play(bool play);
@@ -260,9 +264,18 @@ public slots:
 protected:
     void init();
     void createLayout();
+    void frameShown();
 
     bool playing = false;
 
+    // frame sequences (see setFrameRate)
+    float mFrameRate = 0.0f;
+    bool mFramePending = false;
+    int mPendingTicks = 0;
+    int mFramesShown = 0;
+    int mFramesLate = 0;
+    QElapsedTimer mFrameTime;
+
     int timeToDisplay;
     QTimer *displayTimer;
     QTimer *hideTimer;
@@ -313,6 +326,8 @@ public:
 
 public slots:
     void updateDir(QVector<QSharedPointer<DkImageContainerT>> images);
+    void imageInserted(int idx);
+    void imageRemoved(int idx);
 
     virtual void show(bool saveSettings = true);
     virtual void hide(bool saveSettings = true);
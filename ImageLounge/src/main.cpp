@@ -53,6 +53,8 @@
 #include <QDesktopServices>
 #include <QCommandLineParser>
 #include <QMessageBox>
+#include <QDateTime>
+#include <QScopedPointer>
 #pragma warning(pop)	// no warnings from includes - end
 
 #include "DkNoMacs.h"
@@ -62,10 +64,15 @@
 #include "DkPong.h"
 #include "DkUtils.h"
 #include "DkProcess.h"
+#include "DkNetwork.h"
 #include "DkPluginManager.h"
 
 #include "DkDependencyResolver.h"
 #include "DkMetaData.h"
+#include "DkImageStorage.h"
+#include "DkImageScores.h"
+#include "DkImageHashes.h"
+#include "DkMetaDataIndex.h"
 
 #include "DkVersion.h"
 
@@ -82,6 +89,9 @@ int main(int argc, wchar_t *argv[]) {
 int main(int argc, char *argv[]) {
 #endif
 
+	// measures the start-up time that is saved if files are handed over to a running instance
+	qint64 launchTime = QDateTime::currentMSecsSinceEpoch();
+
     QCoreApplication::setOrganizationName("nomacs");
     QCoreApplication::setOrganizationDomain("https://nomacs.org");
     QCoreApplication::setApplicationName("Image Lounge");
@@ -100,15 +110,6 @@ int main(int argc, char *argv[]) {
 	nmc::DefaultSettings settings;
 	int mode = settings.value("AppSettings/appMode", nmc::DkSettingsManager::param().app().appMode).toInt();
 
-	// uncomment this for the single instance feature...
-	//// check for single instance
-	//nmc::DkRunGuard guard;
-	//
-	//if (!guard.tryRunning()) {
-	//	qDebug() << "nomacs is already running - quitting...";
-	//	return 0;
-	//}
-
 	// CMD parser --------------------------------------------------------------------
 	QCommandLineParser parser;
 	
@@ -199,6 +200,41 @@ int main(int argc, char *argv[]) {
 	if (noUI)
 		return 0;
 
+	// single instance: hand the files over to a running nomacs
+	QScopedPointer<nmc::DkRunGuard> guard;
+	bool firstInstance = false;
+
+	if (nmc::DkSettingsManager::param().app().singleInstance &&
+		!parser.isSet(privateOpt) && !parser.isSet(pongOpt) && !parser.isSet(modeOpt)) {
+
+		guard.reset(new nmc::DkRunGuard());
+		firstInstance = guard->tryRunning();
+
+		if (!firstInstance) {
+
+			QStringList files;
+			for (const QString& arg : parser.positionalArguments()) {
+				if (!arg.trimmed().isEmpty())
+					files << QFileInfo(arg.trimmed()).absoluteFilePath();
+			}
+
+			QStringList tabs;
+			for (const QString& filePath : parser.values(tabOpt))
+				tabs << QFileInfo(filePath).absoluteFilePath();
+
+			QString dirPath = parser.value(sourceDirOpt).trimmed();
+			if (!dirPath.isEmpty())
+				dirPath = QFileInfo(dirPath).absoluteFilePath();
+
+			if (nmc::DkInstanceServer::forward(files, tabs, dirPath, launchTime))
+				return 0;
+
+			// take over the server - otherwise every later launch waits for the unresponsive instance
+			qInfo() << "the running nomacs did not answer - starting a new instance";
+			firstInstance = true;
+		}
+	}
+
 	//install translations
 	QString translationName = "nomacs_" + 
 		settings.value("GlobalSettings/language", nmc::DkSettingsManager::param().global().language).toString() + ".qm";
@@ -267,6 +303,15 @@ int main(int argc, char *argv[]) {
 
 	qInfo() << "Initialization takes: " << dt;
 
+	nmc::DkInstanceServer instanceServer;
+
+	// the first instance (or the one that replaces an unresponsive instance) serves the others
+	if (firstInstance && instanceServer.listen()) {
+		instanceServer.setStartupTime((int)(QDateTime::currentMSecsSinceEpoch() - launchTime));
+		QObject::connect(&instanceServer, SIGNAL(openRequested(const QStringList&, const QStringList&, const QString&)),
+			w, SLOT(openRequested(const QStringList&, const QStringList&, const QString&)));
+	}
+
 	nmc::DkCentralWidget* cw = w->getTabWidget();
 
 	bool loading = false;
@@ -336,6 +381,14 @@ int main(int argc, char *argv[]) {
 	// restore message handler, workaround for: https://github.com/nomacs/nomacs/issues/874
 	qInstallMessageHandler(0);
 
+	// keep rendered icons for the next start
+	nmc::DkIconCache::instance().save();
+
+	// keep image scores, hashes & the metadata index for the next start
+	nmc::DkImageScores::instance().save();
+	nmc::DkImageHashes::instance().save();
+	nmc::DkMetaDataIndex::instance().save();
+
 	if (w)
 		delete w;	// we need delete so that settings are saved (from destructors)
 	if (pw)